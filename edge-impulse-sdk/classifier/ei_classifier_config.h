@@ -95,6 +95,34 @@
     #define ESP_NN                                  1
 #endif
 
+// SSE4.1/AVX2/NEON int8 kernels for the reference TFLM path on desktop/Linux hosts,
+// the instruction set is picked at runtime
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD
+#if (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)) && defined(__GNUC__) && \
+    EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN == 0 && EI_CLASSIFIER_TFLITE_ENABLE_ARC == 0 && !defined(ESP_NN)
+#define EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD       1
+#else
+#define EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD       0
+#endif
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD
+
+// SSE2/AVX2/NEON squared distance kernel of the K-means anomaly block on
+// desktop/Linux hosts, the instruction set is picked at runtime
+#ifndef EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD
+#if (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)) && defined(__GNUC__)
+#define EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD      1
+#else
+#define EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD      0
+#endif
+#endif // EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD
+
+// run_classifier_continuous() streams MFE (version 3 and up) and MFCC blocks: every
+// frame is computed once and written as a row into the continuous feature window,
+// instead of re-running the per slice extraction
+#ifndef EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+#define EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING    1
+#endif // EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+
 // no include checks in the compiler? then just include metadata and then ops_define (optional if on EON model)
 #ifndef __has_include
     #include "model-parameters/model_metadata.h"
@@ -39,6 +39,7 @@
 // needed for standalone C example
 #include "model-parameters/model_metadata.h"
 #include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 
 #ifndef EI_CLASSIFIER_MAX_OBJECT_DETECTION_COUNT
 #define EI_CLASSIFIER_MAX_OBJECT_DETECTION_COUNT 10
@@ -217,6 +218,37 @@ typedef struct {
      * `EI_CLASSIFIER_HAS_ANOMALY == 1`.
      */
     int64_t anomaly_us;
+
+    /**
+     * Amount of time (in microseconds) the request waited in the queue before the
+     * worker started on it. Only set by `run_classifier_async()`.
+     */
+    int64_t queue_us;
+
+    /**
+     * Amount of time (in microseconds) the worker spent running the request (DSP,
+     * inference and post-processing). Only set by `run_classifier_async()`.
+     */
+    int64_t execution_us;
+
+    /**
+     * Amount of time (in microseconds) from the arrival of the newest sample of the
+     * slice to the result. Only set by `run_classifier_continuous_ring()`.
+     */
+    int64_t latency_us;
+
+    /**
+     * Wall-clock, thread CPU time and hardware counters spent in the preprocessing
+     * (DSP) blocks. Only set on ports with `EI_PORTING_HAS_TIMER_SAMPLE` (POSIX), the
+     * counters only after `ei_timer_enable_counters()` on the calling thread.
+     */
+    ei_timer_sample_t dsp_sample;
+
+    /**
+     * Same as `dsp_sample` for the inference blocks (and for the preprocessing too on
+     * quantized image models, which fill the input tensor while running the impulse).
+     */
+    ei_timer_sample_t classification_sample;
 } ei_impulse_result_timing_t;
 
 /**
@@ -36,6 +36,8 @@
 #define _EDGE_IMPULSE_MODEL_TYPES_H_
 
 #include <stdint.h>
+#include <string.h>
+#include <new>
 
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 #include "edge-impulse-sdk/dsp/ei_dsp_handle.h"
@@ -438,6 +440,151 @@ public:
     }
 };
 
+/**
+ * Buffers used by process_impulse() and process_impulse_continuous(). Sized once from
+ * the impulse's blocks (see init_impulse()) and reused for every inference afterwards,
+ * so a steady-state run_classifier() call does not touch the heap for these.
+ */
+class ei_impulse_workspace_t {
+public:
+    ei_feature_t *raw_outputs;       // learning blocks (+ extra outputs for SSD)
+    uint32_t raw_outputs_size;
+    ei_feature_t *features;          // dsp blocks + learning blocks
+    uint32_t features_size;
+    ei::matrix_t *dsp_matrices;      // one per dsp block, n_output_features wide
+    float *dsp_buffer;
+    float *continuous_buffer;        // sliding window for run_classifier_continuous()
+    ei::ei_dsp_scratch_arena_t dsp_scratch; // EI_DSP_MATRIX temporaries of the dsp blocks
+    uint32_t *dsp_scratch_peak;      // per dsp block, peak scratch bytes of any run
+
+    ei_impulse_workspace_t()
+        : raw_outputs(nullptr), raw_outputs_size(0), features(nullptr), features_size(0),
+          dsp_matrices(nullptr), dsp_buffer(nullptr), continuous_buffer(nullptr),
+          dsp_scratch_peak(nullptr) {
+        ei::ei_dsp_scratch_init(&dsp_scratch);
+    }
+
+    /**
+     * Allocate the output and feature arrays, and (if with_dsp_matrices) one output
+     * matrix per dsp block. Calling this again with the same or smaller sizes is a
+     * no-op, larger sizes grow the arrays.
+     */
+    bool init(const ei_impulse_t *impulse, uint32_t num_raw_outputs, bool with_dsp_matrices)
+    {
+        const uint32_t num_features = impulse->dsp_blocks_size + impulse->learning_blocks_size;
+        if (raw_outputs && (num_raw_outputs > raw_outputs_size || num_features > features_size)) {
+            // allocated for fewer outputs than this caller writes, start over
+            clear_raw_outputs();
+            ei_free(raw_outputs);
+            ei_free(features);
+            raw_outputs = nullptr;
+            features = nullptr;
+            raw_outputs_size = 0;
+            features_size = 0;
+        }
+
+        if (!raw_outputs) {
+            // never ask for 0 bytes (DSP only impulses), some allocators return nullptr for that
+            raw_outputs = (ei_feature_t*)ei_calloc(num_raw_outputs > 0 ? num_raw_outputs : 1, sizeof(ei_feature_t));
+            features_size = num_features;
+            features = (ei_feature_t*)ei_calloc(features_size > 0 ? features_size : 1, sizeof(ei_feature_t));
+            if (!dsp_scratch_peak) {
+                dsp_scratch_peak = (uint32_t*)ei_calloc(impulse->dsp_blocks_size > 0 ? impulse->dsp_blocks_size : 1, sizeof(uint32_t));
+            }
+            if (!raw_outputs || !features || !dsp_scratch_peak) {
+                reset();
+                return false;
+            }
+            raw_outputs_size = num_raw_outputs;
+        }
+
+        if (with_dsp_matrices && !dsp_matrices) {
+            size_t total_features = 0;
+            for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
+                total_features += impulse->dsp_blocks[ix].n_output_features;
+            }
+            dsp_buffer = (float*)ei_malloc(total_features * sizeof(float));
+            dsp_matrices = (ei::matrix_t*)ei_malloc(impulse->dsp_blocks_size * sizeof(ei::matrix_t));
+            if ((total_features > 0 && !dsp_buffer) || (impulse->dsp_blocks_size > 0 && !dsp_matrices)) {
+                ei_free(dsp_buffer);
+                ei_free(dsp_matrices);
+                dsp_buffer = nullptr;
+                dsp_matrices = nullptr;
+                return false;
+            }
+            dsp_blocks_size = impulse->dsp_blocks_size;
+            size_t offset = 0;
+            for (size_t ix = 0; ix < dsp_blocks_size; ix++) {
+                const uint32_t n = impulse->dsp_blocks[ix].n_output_features;
+                ::new (&dsp_matrices[ix]) ei::matrix_t(1, n, dsp_buffer + offset);
+                offset += n;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Allocate the sliding feature window for continuous classification (zero-filled)
+     */
+    bool init_continuous(const ei_impulse_t *impulse)
+    {
+        if (!continuous_buffer) {
+            continuous_buffer = (float*)ei_calloc(impulse->nn_input_frame_size, sizeof(float));
+        }
+        return continuous_buffer != nullptr;
+    }
+
+    /**
+     * Free the raw outputs a failed run left behind (they would pin the scratch
+     * arena) and zero them, call before every run
+     */
+    void clear_raw_outputs()
+    {
+        for (size_t ix = 0; raw_outputs && ix < raw_outputs_size; ix++) {
+            ei_feature_free_matrix(&raw_outputs[ix]);
+        }
+        if (raw_outputs) {
+            memset(raw_outputs, 0, sizeof(ei_feature_t) * raw_outputs_size);
+        }
+    }
+
+    void reset()
+    {
+        clear_raw_outputs();
+        for (size_t ix = 0; dsp_matrices && ix < dsp_blocks_size; ix++) {
+            dsp_matrices[ix].~ei_matrix();
+        }
+        ei_free(dsp_matrices);
+        ei_free(dsp_buffer);
+        ei_free(continuous_buffer);
+        ei_free(features);
+        ei_free(raw_outputs);
+        ei_free(dsp_scratch_peak);
+        ei::ei_dsp_scratch_release(&dsp_scratch);
+        dsp_matrices = nullptr;
+        dsp_buffer = nullptr;
+        continuous_buffer = nullptr;
+        features = nullptr;
+        raw_outputs = nullptr;
+        dsp_scratch_peak = nullptr;
+        raw_outputs_size = 0;
+        features_size = 0;
+        dsp_blocks_size = 0;
+    }
+
+    ~ei_impulse_workspace_t()
+    {
+        reset();
+    }
+
+    // owns its buffers, a copy would free them twice
+    ei_impulse_workspace_t(const ei_impulse_workspace_t&) = delete;
+    ei_impulse_workspace_t& operator=(const ei_impulse_workspace_t&) = delete;
+
+private:
+    uint32_t dsp_blocks_size = 0;
+};
+
 class ei_impulse_handle_t {
 public:
     ei_impulse_handle_t(const ei_impulse_t *impulse)
@@ -445,6 +592,7 @@ public:
     ei_impulse_state_t state;
     const ei_impulse_t *impulse;
     void** post_processing_state;
+    ei_impulse_workspace_t workspace;
 };
 
 typedef struct {
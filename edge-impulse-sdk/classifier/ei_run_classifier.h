@@ -41,6 +41,7 @@
 #include "ei_run_dsp.h"
 #include "ei_classifier_types.h"
 #include "ei_signal_with_axes.h"
+#include "ei_trace.h"
 #include "postprocessing/ei_postprocessing.h"
 #include "edge-impulse-sdk/classifier/ei_data_normalization.h"
 
@@ -201,8 +202,11 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     ei_impulse_result_t *result,
     bool debug = false)
 {
+    EI_TRACE_SCOPE("inference", -1);
+
     auto& impulse = handle->impulse;
     for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+        EI_TRACE_SCOPE("learn_block", (int16_t)ix);
 
         ei_learning_block_t block = impulse->learning_blocks[ix];
 
@@ -236,6 +240,70 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Size the handle's workspace (raw outputs, features and one output matrix
+ *             per DSP block) for its impulse. Only allocates the first time, afterwards
+ *             process_impulse() and process_impulse_continuous() reuse the buffers.
+ *
+ * @param      handle      Impulse handle
+ * @param[in]  continuous  Also allocate the sliding feature window for continuous mode
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR init_impulse_workspace(ei_impulse_handle_t *handle, bool continuous = false)
+{
+    // currently only SSD has multiple outputs
+    // need to be refactored to something more generic
+#if (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_SSD)
+    uint32_t num_results = handle->impulse->learning_blocks_size + 3;
+#else
+    uint32_t num_results = handle->impulse->learning_blocks_size;
+#endif
+
+    bool with_dsp_matrices = true;
+#if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON)
+    // quantized image models skip the float features, so don't reserve them
+    if (!continuous &&
+        can_run_classifier_image_quantized(handle->impulse, handle->impulse->learning_blocks[0]) == EI_IMPULSE_OK) {
+        with_dsp_matrices = false;
+    }
+#endif
+
+    if (!handle->workspace.init(handle->impulse, num_results, with_dsp_matrices)) {
+        ei_printf("ERR: Out of memory, can't allocate impulse workspace\n");
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    if (continuous && !handle->workspace.init_continuous(handle->impulse)) {
+        ei_printf("ERR: Out of memory, can't allocate continuous features\n");
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Keep the largest scratch arena use of every DSP block (see ei_dsp_scratch.h)
+ */
+static inline void record_dsp_scratch_peak(ei_impulse_workspace_t *workspace, size_t block_ix, size_t peak)
+{
+    if (peak > workspace->dsp_scratch_peak[block_ix]) {
+        workspace->dsp_scratch_peak[block_ix] = (uint32_t)peak;
+    }
+}
+
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+/**
+ * The timer samples are accumulated into, so start them at zero even when the
+ * result isn't cleared (EI_DSP_RESULT_OVERRIDE)
+ */
+static inline void ei_reset_timer_samples(ei_impulse_result_t *result)
+{
+    memset(&result->timing.dsp_sample, 0, sizeof(ei_timer_sample_t));
+    memset(&result->timing.classification_sample, 0, sizeof(ei_timer_sample_t));
+}
+#endif // EI_PORTING_HAS_TIMER_SAMPLE == 1
+
 /**
  * @brief      Process a complete impulse
  *
@@ -256,30 +324,40 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
+    EI_TRACE_SCOPE("process_impulse", -1);
+
 #ifndef EI_DSP_RESULT_OVERRIDE
     // Don't wipe in CI, as we store a pointer
     memset(result, 0, sizeof(ei_impulse_result_t));
 #endif
-
-    // smart pointer to results array
-    // currently only SSD has multiple outputs
-    // need to be refactored to something more generic
-#if (EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER == EI_CLASSIFIER_LAST_LAYER_SSD)
-    uint32_t num_results = handle->impulse->learning_blocks_size + 3;
-#else
-    uint32_t num_results = handle->impulse->learning_blocks_size;
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_reset_timer_samples(result);
 #endif
 
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[num_results]);
+    EI_IMPULSE_ERROR ws_res = init_impulse_workspace(handle);
+    if (ws_res != EI_IMPULSE_OK) {
+        return ws_res;
+    }
+    ei_impulse_workspace_t *workspace = &handle->workspace;
 
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * num_results);
+    workspace->clear_raw_outputs();
+    result->_raw_outputs = workspace->raw_outputs;
 
 #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ONNX_TIDL) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_ATON)
     // Shortcut for quantized image models
     ei_learning_block_t block = handle->impulse->learning_blocks[0];
     if (can_run_classifier_image_quantized(handle->impulse, block) == EI_IMPULSE_OK) {
+        // the image read buffer, the output tensor list and the raw outputs come from the scratch arena
+        ei::EiDspScratchScope scratch(&workspace->dsp_scratch);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_timer_sample_t classification_start;
+        ei_read_timer_sample(&classification_start);
+#endif
         EI_IMPULSE_ERROR res = run_classifier_image_quantized(handle->impulse, signal, result, debug);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        // after the call, it clears the result
+        ei_timer_sample_accumulate(&classification_start, &result->timing.classification_sample);
+#endif
         if (res != EI_IMPULSE_OK) {
             return res;
         }
@@ -290,47 +368,30 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 
     uint32_t block_num = handle->impulse->dsp_blocks_size;
 
-    // smart pointer to features array
-    std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-    ei_feature_t* features = features_ptr.get();
-
-    if (features == nullptr) {
-        ei_printf("ERR: Out of memory, can't allocate features\n");
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
-
-    memset(features, 0, sizeof(ei_feature_t) * block_num);
-
-    // have it outside of the loop to avoid going out of scope
-    std::unique_ptr<std::unique_ptr<ei::matrix_t>[]> matrix_ptrs_ptr(new std::unique_ptr<ei::matrix_t>[block_num]);
-    std::unique_ptr<ei::matrix_t> *matrix_ptrs = matrix_ptrs_ptr.get();
-
-    if (matrix_ptrs == nullptr) {
-        delete[] matrix_ptrs;
-        ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
+    ei_feature_t* features = workspace->features;
+    memset(features, 0, sizeof(ei_feature_t) * workspace->features_size);
 
+    EI_TRACE_SCOPE_VAR(dsp_trace, "dsp", -1);
     uint64_t dsp_start_us = ei_read_timer_us();
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_t dsp_start;
+    ei_read_timer_sample(&dsp_start);
+#endif
 
     size_t out_features_index = 0;
 
     for (size_t ix = 0; ix < handle->impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = handle->impulse->dsp_blocks[ix];
+        EI_TRACE_SCOPE("dsp_block", (int16_t)ix);
 
-        matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-        if (matrix_ptrs[ix] == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-
-        if (matrix_ptrs[ix]->buffer == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-            delete[] matrix_ptrs;
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
+        // extract functions reshape their output, so restore it (and the zeroed
+        // contents a freshly allocated matrix would have)
+        ei::matrix_t *matrix = &workspace->dsp_matrices[ix];
+        matrix->rows = 1;
+        matrix->cols = block.n_output_features;
+        memset(matrix->buffer, 0, block.n_output_features * sizeof(float));
 
-        features[ix].matrix = matrix_ptrs[ix].get();
+        features[ix].matrix = matrix;
         features[ix].blockId = block.blockId;
 
         if (out_features_index + block.n_output_features > handle->impulse->nn_input_frame_size) {
@@ -349,6 +410,9 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
         auto internal_signal = swa.get_signal();
 #endif
 
+        // EI_DSP_MATRIX temporaries of the block come from the workspace's scratch arena
+        ei::EiDspScratchScope scratch(&workspace->dsp_scratch);
+
         int ret;
         if (block.factory) { // ie, if we're using state
             // Msg user
@@ -375,6 +439,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
             ret = block.extract_fn(internal_signal, features[ix].matrix, block.config, handle->impulse->frequency);
         }
 
+        record_dsp_scratch_peak(workspace, ix, scratch.end());
+
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
             return EI_IMPULSE_DSP_ERROR;
@@ -397,6 +463,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 
     result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_accumulate(&dsp_start, &result->timing.dsp_sample);
+#endif
+    EI_TRACE_SCOPE_END(dsp_trace);
 
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
@@ -410,6 +480,9 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
             }
             ei_printf("\n");
         }
+        for (size_t ix = 0; ix < block_num; ix++) {
+            ei_printf("DSP block %u scratch peak: %u bytes\n", (unsigned)ix, (unsigned)workspace->dsp_scratch_peak[ix]);
+        }
     }
 
     if (debug) {
@@ -419,7 +492,16 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 #if EI_CLASSIFIER_DSP_ONLY
     return EI_IMPULSE_OK;
 #else
+    // the output tensor list and the raw outputs come from the scratch arena
+    ei::EiDspScratchScope scratch(&workspace->dsp_scratch);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_t classification_start;
+    ei_read_timer_sample(&classification_start);
+#endif
     EI_IMPULSE_ERROR res = run_inference(handle, features, result, debug);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_accumulate(&classification_start, &result->timing.classification_sample);
+#endif
     if (res != EI_IMPULSE_OK) {
         return res;
     } else {
@@ -440,7 +522,8 @@ extern "C" EI_IMPULSE_ERROR init_impulse(ei_impulse_handle_t *handle) {
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
     handle->state.reset();
-    return EI_IMPULSE_OK;
+    // the continuous feature window is only allocated by the first process_impulse_continuous()
+    return init_impulse_workspace(handle);
 }
 
 /**
@@ -462,27 +545,39 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         return EI_IMPULSE_INFERENCE_ERROR;
     }
 
+    EI_TRACE_SCOPE("process_impulse_continuous", -1);
+
     memset(result, 0, sizeof(ei_impulse_result_t));
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_reset_timer_samples(result);
+#endif
 
-    // smart pointer to results array
-    std::unique_ptr<ei_feature_t[]> raw_results_ptr(new ei_feature_t[handle->impulse->learning_blocks_size]);
-    result->_raw_outputs = raw_results_ptr.get();
-    memset(result->_raw_outputs, 0, sizeof(ei_feature_t) * handle->impulse->learning_blocks_size);
+    EI_IMPULSE_ERROR ws_res = init_impulse_workspace(handle, true);
+    if (ws_res != EI_IMPULSE_OK) {
+        return ws_res;
+    }
+    ei_impulse_workspace_t *workspace = &handle->workspace;
+
+    workspace->clear_raw_outputs();
+    result->_raw_outputs = workspace->raw_outputs;
 
     auto impulse = handle->impulse;
-    static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
-    if (!static_features_matrix.buffer) {
-        return EI_IMPULSE_ALLOC_FAILED;
-    }
+    float *continuous_features = workspace->continuous_buffer;
 
     EI_IMPULSE_ERROR ei_impulse_error = EI_IMPULSE_OK;
 
+    EI_TRACE_SCOPE_VAR(dsp_trace, "dsp", -1);
     uint64_t dsp_start_us = ei_read_timer_us();
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_t dsp_start;
+    ei_read_timer_sample(&dsp_start);
+#endif
 
     size_t out_features_index = 0;
 
     for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = impulse->dsp_blocks[ix];
+        EI_TRACE_SCOPE("dsp_block", (int16_t)ix);
 
         if (out_features_index + block.n_output_features > impulse->nn_input_frame_size) {
             ei_printf("ERR: Would write outside feature buffer\n");
@@ -490,7 +585,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
         }
 
         ei::matrix_t fm(1, block.n_output_features,
-                        static_features_matrix.buffer + out_features_index);
+                        continuous_features + out_features_index);
 
         int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
 
@@ -516,11 +611,26 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
             return EI_IMPULSE_DSP_ERROR;
         }
-        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = signal;
 #else
         SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
-        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written);
+        signal_t *block_signal = swa.get_signal();
+#endif
+
+        ei::EiDspScratchScope scratch(&workspace->dsp_scratch);
+
+        int ret;
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+        if (audio_stream_supported(&block)) {
+            ret = extract_audio_stream_features(workspace, block_signal, &fm, &block, impulse->frequency, &features_written);
+        }
+        else
 #endif
+        {
+            ret = extract_fn_slice(block_signal, &fm, block.config, impulse->frequency, &features_written);
+        }
+
+        record_dsp_scratch_peak(workspace, ix, scratch.end());
 
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -538,6 +648,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
     result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_accumulate(&dsp_start, &result->timing.dsp_sample);
+#endif
+    EI_TRACE_SCOPE_END(dsp_trace);
 
     for (int i = 0; i < impulse->label_count; i++) {
         // set label correctly in the result struct if we have no results (otherwise is nullptr)
@@ -545,49 +659,40 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
     }
 
     if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
+        EI_TRACE_SCOPE_VAR(normalize_trace, "dsp_normalize", -1);
         dsp_start_us = ei_read_timer_us();
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_read_timer_sample(&dsp_start);
+#endif
 
         uint32_t block_num = impulse->dsp_blocks_size + impulse->learning_blocks_size;
 
-        // smart pointer to features array
-        std::unique_ptr<ei_feature_t[]> features_ptr(new ei_feature_t[block_num]);
-        ei_feature_t* features = features_ptr.get();
-        if (features == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate features\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
+        ei_feature_t* features = workspace->features;
         memset(features, 0, sizeof(ei_feature_t) * block_num);
 
-        // have it outside of the loop to avoid going out of scope
-        std::unique_ptr<ei::matrix_t> *matrix_ptrs = new std::unique_ptr<ei::matrix_t>[block_num];
-        if (matrix_ptrs == nullptr) {
-            ei_printf("ERR: Out of memory, can't allocate matrix_ptrs\n");
-            return EI_IMPULSE_ALLOC_FAILED;
-        }
-
         out_features_index = 0;
         // iterate over every dsp block and run normalization
         for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
             ei_model_dsp_t block = impulse->dsp_blocks[ix];
-            matrix_ptrs[ix] = std::unique_ptr<ei::matrix_t>(new ei::matrix_t(1, block.n_output_features));
-
-            if (matrix_ptrs[ix] == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                return EI_IMPULSE_ALLOC_FAILED;
-            }
 
-            if (matrix_ptrs[ix]->buffer == nullptr) {
-                ei_printf("ERR: Out of memory, can't allocate matrix_ptrs[%lu]\n", (unsigned long)ix);
-                delete[] matrix_ptrs;
-                return EI_IMPULSE_ALLOC_FAILED;
-            }
+            // normalization reshapes the matrix, so restore it
+            ei::matrix_t *matrix = &workspace->dsp_matrices[ix];
+            matrix->rows = 1;
+            matrix->cols = block.n_output_features;
 
-            features[ix].matrix = matrix_ptrs[ix].get();
+            features[ix].matrix = matrix;
             features[ix].blockId = block.blockId;
 
             /* Create a copy of the matrix for normalization */
-            for (size_t m_ix = 0; m_ix < block.n_output_features; m_ix++) {
-                features[ix].matrix->buffer[m_ix] = static_features_matrix.buffer[out_features_index + m_ix];
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+            // streamed blocks write their window as a ring buffer, unroll it
+            if (!ei_dsp_copy_audio_stream_window(workspace, block.config, continuous_features + out_features_index,
+                    block.n_output_features, features[ix].matrix->buffer))
+#endif
+            {
+                for (size_t m_ix = 0; m_ix < block.n_output_features; m_ix++) {
+                    features[ix].matrix->buffer[m_ix] = continuous_features[out_features_index + m_ix];
+                }
             }
 
             if (block.extract_fn == extract_mfcc_features) {
@@ -604,6 +709,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
 
         result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
         result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_timer_sample_accumulate(&dsp_start, &result->timing.dsp_sample);
+#endif
+        EI_TRACE_SCOPE_END(normalize_trace);
 
         if (debug) {
             ei_printf("Feature Matrix: \n");
@@ -615,8 +724,15 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             ei_printf("Running impulse...\n");
         }
 
+        ei::EiDspScratchScope scratch(&workspace->dsp_scratch);
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_timer_sample_t classification_start;
+        ei_read_timer_sample(&classification_start);
+#endif
         ei_impulse_error = run_inference(handle, features, result, debug);
-        delete[] matrix_ptrs;
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_timer_sample_accumulate(&classification_start, &result->timing.classification_sample);
+#endif
         ei_impulse_error = run_postprocessing(handle, result);
     }
 
@@ -653,8 +769,9 @@ __attribute__((unused)) static EI_IMPULSE_ERROR can_run_classifier_image_quantiz
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
-    // And if we have one DSP block which operates on images...
-    if (impulse->dsp_blocks_size != 1 || impulse->dsp_blocks[0].extract_fn != extract_image_features) {
+    // And if we have one DSP block which operates on images (or an MFE / spectrogram block with fixed point features)...
+    if (impulse->dsp_blocks_size != 1 ||
+        (impulse->dsp_blocks[0].extract_fn != extract_image_features && !can_run_fixed_point_features(impulse))) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
@@ -674,6 +791,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
     ei_impulse_result_t *result,
     bool debug = false)
 {
+    EI_TRACE_SCOPE("inference", -1);
+
     return run_nn_inference_image_quantized(impulse, signal, 0, result, impulse->learning_blocks[0].config, debug);
 }
 
@@ -880,15 +999,27 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
  */
 extern "C" void run_classifier_deinit(void)
 {
+#if defined(EI_CLASSIFIER_HAS_TFLITE_SESSION)
+    inference_tflite_release_session();
+#endif
     deinit_postprocessing(&ei_default_impulse);
+    ei_dsp_clear_continuous_audio_streams(&ei_default_impulse.workspace);
+    ei_default_impulse.workspace.reset();
 }
 
 __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
 {
+#if defined(EI_CLASSIFIER_HAS_TFLITE_SESSION)
+    // only if the session is this impulse's, another handle may own it
+    inference_tflite_release_session(handle->impulse);
+#endif
     deinit_postprocessing(handle);
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     deinit_data_normalization(handle);
 #endif
+    // the streams are keyed by the workspace, a new handle at this address mustn't inherit them
+    ei_dsp_clear_continuous_audio_streams(&handle->workspace);
+    handle->workspace.reset();
 }
 
 /**
@@ -0,0 +1,464 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EDGE_IMPULSE_RUN_CLASSIFIER_ASYNC_H_
+#define _EDGE_IMPULSE_RUN_CLASSIFIER_ASYNC_H_
+
+#include "ei_run_classifier.h"
+#include <atomic>
+
+/**
+ * Asynchronous front end for run_classifier(): requests are queued to a
+ * dedicated inference worker (a FreeRTOS task on ESP-IDF, a std::thread on the
+ * POSIX port) and a callback is invoked once the result is ready, so the caller
+ * can keep servicing the camera or the network meanwhile.
+ *
+ * The queue is bounded. When it is full the oldest pending request is dropped
+ * in favour of the new one (latest-wins, for real-time feeds), or with
+ * EI_CLASSIFIER_ASYNC_LATEST_WINS=0 the new request is refused.
+ *
+ * On other platforms the request runs synchronously in the caller.
+ */
+
+// the worker needs the port's cancellation support (EI_PORTING_HAS_CANCEL_WORKER)
+#if EI_PORTING_ESPRESSIF == 1 && EI_PORTING_HAS_CANCEL_WORKER == 1
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#define EI_CLASSIFIER_HAS_ASYNC_WORKER              1
+#elif EI_PORTING_POSIX == 1 && EI_PORTING_HAS_CANCEL_WORKER == 1
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#define EI_CLASSIFIER_HAS_ASYNC_WORKER              1
+#else
+#define EI_CLASSIFIER_HAS_ASYNC_WORKER              0
+#endif
+
+// Maximum number of requests waiting for the worker (not counting the one it runs)
+#ifndef EI_CLASSIFIER_ASYNC_QUEUE_SIZE
+#define EI_CLASSIFIER_ASYNC_QUEUE_SIZE              2
+#endif // EI_CLASSIFIER_ASYNC_QUEUE_SIZE
+
+// When the queue is full drop the oldest request (1) or refuse the new one (0)
+#ifndef EI_CLASSIFIER_ASYNC_LATEST_WINS
+#define EI_CLASSIFIER_ASYNC_LATEST_WINS             1
+#endif // EI_CLASSIFIER_ASYNC_LATEST_WINS
+
+#if EI_PORTING_ESPRESSIF == 1
+#ifndef EI_CLASSIFIER_ASYNC_TASK_STACK_SIZE
+#define EI_CLASSIFIER_ASYNC_TASK_STACK_SIZE         8192
+#endif // EI_CLASSIFIER_ASYNC_TASK_STACK_SIZE
+
+#ifndef EI_CLASSIFIER_ASYNC_TASK_PRIORITY
+#define EI_CLASSIFIER_ASYNC_TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
+#endif // EI_CLASSIFIER_ASYNC_TASK_PRIORITY
+
+#ifndef EI_CLASSIFIER_ASYNC_TASK_CORE
+#define EI_CLASSIFIER_ASYNC_TASK_CORE               tskNO_AFFINITY
+#endif // EI_CLASSIFIER_ASYNC_TASK_CORE
+#endif // EI_PORTING_ESPRESSIF == 1
+
+/**
+ * @brief      Called when an asynchronous request completes.
+ *
+ * Runs on the worker, except for requests that are dropped before they started
+ * (overwritten by a newer request, or canceled), which complete with
+ * EI_IMPULSE_CANCELED on the thread that dropped them. Once the callback
+ * returns, `signal` and `result` are no longer used by the classifier.
+ */
+typedef void (*ei_classifier_async_callback_t)(EI_IMPULSE_ERROR res,
+                                               signal_t *signal,
+                                               ei_impulse_result_t *result,
+                                               void *user_data);
+
+typedef struct {
+    ei_impulse_handle_t *handle;
+    signal_t *signal;
+    ei_impulse_result_t *result;
+    ei_classifier_async_callback_t callback;
+    void *user_data;
+    bool debug;
+    uint64_t submit_us;
+} ei_classifier_async_job_t;
+
+#if EI_CLASSIFIER_HAS_ASYNC_WORKER == 1
+
+static ei_classifier_async_job_t ei_async_queue[EI_CLASSIFIER_ASYNC_QUEUE_SIZE];
+static size_t ei_async_queue_head = 0;
+static size_t ei_async_queue_count = 0;
+static bool ei_async_job_running = false;
+static bool ei_async_stopping = false;
+// read without the lock by run_classifier_async_cancel() / _stop()
+static std::atomic<bool> ei_async_started(false);
+
+#if EI_PORTING_ESPRESSIF == 1
+static TaskHandle_t ei_async_task = NULL;
+static SemaphoreHandle_t ei_async_mutex = NULL;
+static SemaphoreHandle_t ei_async_exited = NULL;
+
+static void ei_async_lock() { xSemaphoreTake(ei_async_mutex, portMAX_DELAY); }
+static void ei_async_unlock() { xSemaphoreGive(ei_async_mutex); }
+static void ei_async_notify() { xTaskNotifyGive(ei_async_task); }
+#else
+static std::thread ei_async_thread;
+static std::mutex ei_async_mutex;
+static std::condition_variable ei_async_cv;
+
+static void ei_async_lock() { ei_async_mutex.lock(); }
+static void ei_async_unlock() { ei_async_mutex.unlock(); }
+static void ei_async_notify() { ei_async_cv.notify_one(); }
+#endif
+
+/**
+ * Remove all pending requests, they are returned in `dropped` (oldest first).
+ * Must be called with the lock held.
+ */
+static size_t ei_async_drain(ei_classifier_async_job_t *dropped)
+{
+    size_t count = ei_async_queue_count;
+    for (size_t ix = 0; ix < count; ix++) {
+        dropped[ix] = ei_async_queue[(ei_async_queue_head + ix) % EI_CLASSIFIER_ASYNC_QUEUE_SIZE];
+    }
+    ei_async_queue_head = 0;
+    ei_async_queue_count = 0;
+    return count;
+}
+
+static void ei_async_complete_dropped(ei_classifier_async_job_t *jobs, size_t count)
+{
+    uint64_t now_us = ei_read_timer_us();
+    for (size_t ix = 0; ix < count; ix++) {
+        jobs[ix].result->timing.queue_us = now_us - jobs[ix].submit_us;
+        jobs[ix].result->timing.execution_us = 0;
+        jobs[ix].callback(EI_IMPULSE_CANCELED, jobs[ix].signal, jobs[ix].result, jobs[ix].user_data);
+    }
+}
+
+/**
+ * Block until there's a request (true) or the worker should exit (false).
+ * Marks the request as running, any stale cancel request is cleared. Requests
+ * still queued when the worker exits complete with EI_IMPULSE_CANCELED, they'd
+ * otherwise run on the next worker, after the caller gave up on them.
+ */
+static bool ei_async_next_job(ei_classifier_async_job_t *job)
+{
+#if EI_PORTING_ESPRESSIF == 1
+    ei_async_lock();
+    while (ei_async_queue_count == 0 && !ei_async_stopping) {
+        ei_async_unlock();
+        // notifications are counted, so a submission between unlock and take isn't lost
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ei_async_lock();
+    }
+#else
+    std::unique_lock<std::mutex> lock(ei_async_mutex);
+    ei_async_cv.wait(lock, [] { return ei_async_queue_count > 0 || ei_async_stopping; });
+    lock.release();
+#endif
+
+    if (ei_async_stopping) {
+        ei_classifier_async_job_t dropped[EI_CLASSIFIER_ASYNC_QUEUE_SIZE];
+        size_t dropped_count = ei_async_drain(dropped);
+        ei_async_unlock();
+        ei_async_complete_dropped(dropped, dropped_count);
+        return false;
+    }
+
+    *job = ei_async_queue[ei_async_queue_head];
+    ei_async_queue_head = (ei_async_queue_head + 1) % EI_CLASSIFIER_ASYNC_QUEUE_SIZE;
+    ei_async_queue_count--;
+    ei_async_job_running = true;
+    ei_run_impulse_cancel_request(false);
+    ei_async_unlock();
+    return true;
+}
+
+static void ei_async_worker_loop()
+{
+    ei_run_impulse_cancel_set_worker();
+
+    ei_classifier_async_job_t job;
+    while (ei_async_next_job(&job)) {
+        uint64_t start_us = ei_read_timer_us();
+        EI_IMPULSE_ERROR res = process_impulse(job.handle, job.signal, job.result, job.debug);
+        uint64_t end_us = ei_read_timer_us();
+
+        // process_impulse() wipes the result, so fill these in afterwards
+        job.result->timing.queue_us = start_us - job.submit_us;
+        job.result->timing.execution_us = end_us - start_us;
+
+        ei_async_lock();
+        ei_async_job_running = false;
+        ei_run_impulse_cancel_request(false);
+        ei_async_unlock();
+
+        job.callback(res, job.signal, job.result, job.user_data);
+    }
+}
+
+#if EI_PORTING_ESPRESSIF == 1
+static void ei_async_task_fn(void *arg)
+{
+    (void)arg;
+    ei_async_worker_loop();
+    xSemaphoreGive(ei_async_exited);
+    vTaskDelete(NULL);
+}
+#endif
+
+/**
+ * Create the synchronization primitives. Not thread safe, the first
+ * run_classifier_async() must not race with another one.
+ */
+static EI_IMPULSE_ERROR ei_async_init_sync()
+{
+#if EI_PORTING_ESPRESSIF == 1
+    if (!ei_async_mutex) {
+        ei_async_mutex = xSemaphoreCreateMutex();
+        ei_async_exited = xSemaphoreCreateBinary();
+        if (!ei_async_mutex || !ei_async_exited) {
+            ei_printf("ERR: Failed to create async classifier semaphores\n");
+            // delete both, so the next call tries again instead of running with a NULL one
+            if (ei_async_mutex) {
+                vSemaphoreDelete(ei_async_mutex);
+                ei_async_mutex = NULL;
+            }
+            if (ei_async_exited) {
+                vSemaphoreDelete(ei_async_exited);
+                ei_async_exited = NULL;
+            }
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
+    }
+#endif
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Start the worker, called with the lock held
+ */
+static EI_IMPULSE_ERROR ei_async_start()
+{
+    ei_async_stopping = false;
+
+#if EI_PORTING_ESPRESSIF == 1
+    BaseType_t res = xTaskCreatePinnedToCore(ei_async_task_fn, "ei_classifier",
+        EI_CLASSIFIER_ASYNC_TASK_STACK_SIZE, NULL, EI_CLASSIFIER_ASYNC_TASK_PRIORITY,
+        &ei_async_task, EI_CLASSIFIER_ASYNC_TASK_CORE);
+    if (res != pdPASS) {
+        ei_printf("ERR: Failed to start async classifier task\n");
+        ei_async_task = NULL;
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+#else
+    ei_async_thread = std::thread(ei_async_worker_loop);
+#endif
+
+    ei_async_started = true;
+    return EI_IMPULSE_OK;
+}
+
+#endif // EI_CLASSIFIER_HAS_ASYNC_WORKER == 1
+
+/**
+ * @addtogroup ei_functions
+ * @{
+ */
+
+/**
+ * @brief Queue a classification on the inference worker and return immediately.
+ *
+ * `callback` is called with the outcome once the worker is done (see
+ * ei_classifier_async_callback_t). `signal` and `result` must stay valid until
+ * then. In `result->timing`, `queue_us` holds the time the request waited for
+ * the worker and `execution_us` the time it took to run.
+ *
+ * The worker is started on the first call. Requests from several handles may
+ * be mixed, they run one at a time in submission order.
+ *
+ * @param[in]  handle     Impulse handle
+ * @param[in]  signal     Input signal
+ * @param[out] result     Filled in by the worker
+ * @param[in]  callback   Completion callback
+ * @param[in]  user_data  Passed to `callback`
+ * @param[in]  debug      Print internal preprocessing and inference debugging information
+ *
+ * @return EI_IMPULSE_OK if the request was queued (or, without worker support, ran),
+ *  EI_IMPULSE_QUEUE_FULL if the queue is full and latest-wins is disabled,
+ *  EI_IMPULSE_CANCELED if run_classifier_async_stop() is in progress. `callback`
+ *  isn't called when the request wasn't queued.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_async(
+    ei_impulse_handle_t *handle,
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    ei_classifier_async_callback_t callback,
+    void *user_data = nullptr,
+    bool debug = false)
+{
+    if (!handle || !signal || !result || !callback) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+#if EI_CLASSIFIER_HAS_ASYNC_WORKER == 1
+    ei_classifier_async_job_t job = { handle, signal, result, callback, user_data, debug, ei_read_timer_us() };
+    ei_classifier_async_job_t dropped;
+    size_t dropped_count = 0;
+
+    EI_IMPULSE_ERROR res = ei_async_init_sync();
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    ei_async_lock();
+    // run_classifier_async_stop() is waiting for the worker to exit
+    if (ei_async_stopping) {
+        ei_async_unlock();
+        return EI_IMPULSE_CANCELED;
+    }
+
+    if (!ei_async_started) {
+        res = ei_async_start();
+        if (res != EI_IMPULSE_OK) {
+            ei_async_unlock();
+            return res;
+        }
+    }
+
+    if (ei_async_queue_count == EI_CLASSIFIER_ASYNC_QUEUE_SIZE) {
+#if EI_CLASSIFIER_ASYNC_LATEST_WINS == 1
+        dropped = ei_async_queue[ei_async_queue_head];
+        ei_async_queue_head = (ei_async_queue_head + 1) % EI_CLASSIFIER_ASYNC_QUEUE_SIZE;
+        ei_async_queue_count--;
+        dropped_count = 1;
+#else
+        ei_async_unlock();
+        return EI_IMPULSE_QUEUE_FULL;
+#endif
+    }
+
+    ei_async_queue[(ei_async_queue_head + ei_async_queue_count) % EI_CLASSIFIER_ASYNC_QUEUE_SIZE] = job;
+    ei_async_queue_count++;
+    ei_async_unlock();
+    ei_async_notify();
+
+    ei_async_complete_dropped(&dropped, dropped_count);
+    return EI_IMPULSE_OK;
+#else
+    uint64_t start_us = ei_read_timer_us();
+    EI_IMPULSE_ERROR res = process_impulse(handle, signal, result, debug);
+    result->timing.queue_us = 0;
+    result->timing.execution_us = ei_read_timer_us() - start_us;
+    callback(res, signal, result, user_data);
+    return EI_IMPULSE_OK;
+#endif
+}
+
+/**
+ * @brief Queue a classification of the default impulse, see run_classifier_async() above
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_async(
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    ei_classifier_async_callback_t callback,
+    void *user_data = nullptr,
+    bool debug = false)
+{
+    return run_classifier_async(&ei_default_impulse, signal, result, callback, user_data, debug);
+}
+
+/**
+ * @brief Cancel all asynchronous requests.
+ *
+ * Pending requests complete with EI_IMPULSE_CANCELED from this call. The
+ * running one is aborted at its next ei_run_impulse_check_canceled() point
+ * (unless the application overrides that function) and completes with
+ * EI_IMPULSE_CANCELED from the worker.
+ */
+__attribute__((unused)) void run_classifier_async_cancel(void)
+{
+#if EI_CLASSIFIER_HAS_ASYNC_WORKER == 1
+    if (!ei_async_started) {
+        return;
+    }
+
+    ei_classifier_async_job_t dropped[EI_CLASSIFIER_ASYNC_QUEUE_SIZE];
+    ei_async_lock();
+    size_t dropped_count = ei_async_drain(dropped);
+    if (ei_async_job_running) {
+        ei_run_impulse_cancel_request(true);
+    }
+    ei_async_unlock();
+
+    ei_async_complete_dropped(dropped, dropped_count);
+#endif
+}
+
+/**
+ * @brief Cancel all asynchronous requests and stop the worker. Returns once the
+ *  worker has exited, the next run_classifier_async() starts a new one.
+ *  Must not be called from a completion callback.
+ */
+__attribute__((unused)) void run_classifier_async_stop(void)
+{
+#if EI_CLASSIFIER_HAS_ASYNC_WORKER == 1
+    if (!ei_async_started) {
+        return;
+    }
+
+    run_classifier_async_cancel();
+
+    ei_async_lock();
+    ei_async_stopping = true;
+    ei_async_unlock();
+    ei_async_notify();
+
+#if EI_PORTING_ESPRESSIF == 1
+    xSemaphoreTake(ei_async_exited, portMAX_DELAY);
+    ei_async_task = NULL;
+#else
+    ei_async_thread.join();
+#endif
+
+    ei_async_lock();
+    ei_async_started = false;
+    ei_async_stopping = false;
+    ei_async_unlock();
+#endif
+}
+
+/** @} */
+
+#endif // _EDGE_IMPULSE_RUN_CLASSIFIER_ASYNC_H_
@@ -36,7 +36,960 @@
 #define _EDGE_IMPULSE_RUN_CLASSIFIER_IMAGE_H_
 
 #include "ei_run_classifier.h"
+#include "edge-impulse-sdk/dsp/image/processing.hpp"
 
+/**
+ * @brief A packed RGB888 frame
+ */
+typedef struct {
+    const uint8_t *rgb888;
+    uint32_t width;
+    uint32_t height;
+} ei_image_frame_t;
+
+/**
+ * Crops of a frame that a second model runs on, shared by the crop stage below and
+ * the cascades of the scheduler (ei_run_classifier_scheduler.h): detections are
+ * mapped onto the frame, filtered, capped (most confident first), then cropped,
+ * resized to the model input and handed over one by one until the time budget
+ * of the frame is spent.
+ */
+
+/**
+ * @brief A detection mapped onto the frame
+ */
+typedef struct {
+    ei_impulse_result_bounding_box_t *bb;   // detection the crop comes from, nullptr for the whole frame
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} ei_image_crop_t;
+
+/**
+ * @brief Maps model input coordinates onto the frame: frame = frame_offset + (input - input_offset) * scale
+ */
+typedef struct {
+    float scale_x;          // frame pixels per model input pixel
+    float scale_y;
+    float input_x;          // where the frame starts in the model input (fit longest letterbox)
+    float input_y;
+    float frame_x;          // where the model input starts in the frame (fit shortest center crop)
+    float frame_y;
+} ei_image_box_mapping_t;
+
+/**
+ * @brief Mapping for a frame that was resized to the model input with `resize_mode`
+ * (EI_CLASSIFIER_RESIZE_*), same geometry as resize_image_using_mode()
+ */
+static void ei_image_box_mapping_init(
+    ei_image_box_mapping_t *mapping,
+    uint32_t frame_width,
+    uint32_t frame_height,
+    uint32_t input_width,
+    uint32_t input_height,
+    int resize_mode)
+{
+    memset(mapping, 0, sizeof(ei_image_box_mapping_t));
+
+    // part of the frame the model sees, and the part of the input it ends up in
+    int region_width = frame_width, region_height = frame_height;
+    int resized_width = input_width, resized_height = input_height;
+
+    if (resize_mode == EI_CLASSIFIER_RESIZE_FIT_SHORTEST) {
+        ei::image::processing::calculate_crop_dims(
+            frame_width, frame_height, input_width, input_height, region_width, region_height);
+        mapping->frame_x = (float)((int)frame_width - region_width) / 2;
+        mapping->frame_y = (float)((int)frame_height - region_height) / 2;
+    }
+    else if (resize_mode == EI_CLASSIFIER_RESIZE_FIT_LONGEST) {
+        float frame_aspect = (float)frame_width / frame_height;
+        float input_aspect = (float)input_width / input_height;
+        if (frame_aspect > input_aspect) {
+            resized_height = (int)(input_width / frame_aspect);
+        }
+        else {
+            resized_width = (int)(input_height * frame_aspect);
+        }
+        mapping->input_x = (float)(((int)input_width - resized_width) / 2);
+        mapping->input_y = (float)(((int)input_height - resized_height) / 2);
+    }
+    // squash stretches the whole frame over the whole input
+
+    mapping->scale_x = (float)region_width / resized_width;
+    mapping->scale_y = (float)region_height / resized_height;
+}
+
+/**
+ * @brief Map a detection onto the frame, grown by `padding` (a fraction of its size) on
+ * every side and clipped to the frame. Returns false if the crop is too small to resize.
+ */
+static bool ei_image_map_box(
+    const ei_image_box_mapping_t *mapping,
+    ei_impulse_result_bounding_box_t *bb,
+    float padding,
+    uint32_t frame_width,
+    uint32_t frame_height,
+    ei_image_crop_t *crop)
+{
+    float x1 = mapping->frame_x + ((float)bb->x - padding * bb->width - mapping->input_x) * mapping->scale_x;
+    float y1 = mapping->frame_y + ((float)bb->y - padding * bb->height - mapping->input_y) * mapping->scale_y;
+    float x2 = mapping->frame_x + ((float)(bb->x + bb->width) + padding * bb->width - mapping->input_x) * mapping->scale_x;
+    float y2 = mapping->frame_y + ((float)(bb->y + bb->height) + padding * bb->height - mapping->input_y) * mapping->scale_y;
+
+    x1 = std::max(x1, 0.0f);
+    y1 = std::max(y1, 0.0f);
+    x2 = std::min(x2, (float)frame_width);
+    y2 = std::min(y2, (float)frame_height);
+
+    crop->bb = bb;
+    crop->x = (uint32_t)x1;
+    crop->y = (uint32_t)y1;
+    crop->width = x2 > x1 ? (uint32_t)(x2 - x1) : 0;
+    crop->height = y2 > y1 ? (uint32_t)(y2 - y1) : 0;
+    crop->width = std::min(crop->width, frame_width - std::min(crop->x, frame_width));
+    crop->height = std::min(crop->height, frame_height - std::min(crop->y, frame_height));
+
+    // resize_image() needs at least 2x2 pixels
+    return crop->width >= 2 && crop->height >= 2;
+}
+
+/**
+ * @brief Pick the detections to crop: those with `label` (nullptr for any) and at least
+ * `threshold` confidence that map onto 2x2 frame pixels or more, at most `max_crops`,
+ * most confident first.
+ *
+ * @param[out] crops        Room for `max_crops` crops, sorted by confidence
+ * @param[out] skipped_cap  Matching detections left out because of `max_crops`
+ *
+ * @return Number of crops
+ */
+static uint32_t ei_image_select_crops(
+    ei_impulse_result_bounding_box_t *boxes,
+    uint32_t boxes_count,
+    const char *label,
+    float threshold,
+    float padding,
+    const ei_image_box_mapping_t *mapping,
+    const ei_image_frame_t *frame,
+    ei_image_crop_t *crops,
+    uint32_t max_crops,
+    uint32_t *skipped_cap)
+{
+    uint32_t crops_count = 0;
+    *skipped_cap = 0;
+
+    for (uint32_t ix = 0; ix < boxes_count; ix++) {
+        ei_impulse_result_bounding_box_t *bb = &boxes[ix];
+        if (bb->value == 0 || bb->value < threshold || (label && strcmp(bb->label, label) != 0)) {
+            continue;
+        }
+
+        ei_image_crop_t crop;
+        if (!ei_image_map_box(mapping, bb, padding, frame->width, frame->height, &crop)) {
+            continue;
+        }
+
+        if (crops_count == max_crops) {
+            (*skipped_cap)++;
+            if (max_crops == 0 || crops[crops_count - 1].bb->value >= bb->value) {
+                continue;
+            }
+            crops_count--;
+        }
+        uint32_t pos = crops_count++;
+        while (pos > 0 && crops[pos - 1].bb->value < bb->value) {
+            crops[pos] = crops[pos - 1];
+            pos--;
+        }
+        crops[pos] = crop;
+    }
+
+    return crops_count;
+}
+
+/**
+ * @brief Crop a region of the frame and resize it to the model input
+ *
+ * @param[in] crop_buffer     Room for the crop (width * height * 3), used when it needs a resize
+ * @param[in] input_buffer    Room for the model input (input_width * input_height * 3)
+ * @param[in] resize_scratch  resize_image_scratch_size(input_width, RGB888_B_SIZE) bytes
+ *
+ * @return The packed RGB888 model input, the frame itself when it already fits
+ */
+static const uint8_t *ei_image_crop_to_input(
+    const ei_image_frame_t *frame,
+    const ei_image_crop_t *crop,
+    uint32_t input_width,
+    uint32_t input_height,
+    uint8_t *crop_buffer,
+    uint8_t *input_buffer,
+    uint8_t *resize_scratch)
+{
+    const bool whole_frame = crop->x == 0 && crop->y == 0 &&
+        crop->width == frame->width && crop->height == frame->height;
+    const bool resize = crop->width != input_width || crop->height != input_height;
+
+    const uint8_t *src = frame->rgb888;
+    if (!whole_frame) {
+        uint8_t *dst = resize ? crop_buffer : input_buffer;
+        ei::image::processing::crop_image_rgb888_packed(
+            frame->rgb888, frame->width, frame->height, crop->x, crop->y, dst, crop->width, crop->height);
+        src = dst;
+    }
+    if (resize) {
+        ei::image::processing::resize_image_with_scratch(
+            src, crop->width, crop->height, input_buffer, input_width, input_height,
+            ei::image::processing::RGB888_B_SIZE, resize_scratch);
+        src = input_buffer;
+    }
+    return src;
+}
+
+/**
+ * @brief Called for every crop with the model input, `start_us` is when the crop was started
+ */
+typedef EI_IMPULSE_ERROR (*ei_image_crop_fn_t)(const ei_image_crop_t *crop, const uint8_t *input,
+                                               uint64_t start_us, void *user_data);
+
+/**
+ * @brief Crop and resize the crops one after the other and hand them to `fn`, until `fn`
+ * fails or `budget_us` (0 for no budget) after `budget_start_us` is spent.
+ *
+ * @param[out] skipped_budget  Crops left out because the budget ran out
+ *
+ * @return The first error of `fn`, EI_IMPULSE_OK otherwise
+ */
+static EI_IMPULSE_ERROR ei_image_run_crops(
+    const ei_image_frame_t *frame,
+    const ei_image_crop_t *crops,
+    uint32_t crops_count,
+    uint32_t input_width,
+    uint32_t input_height,
+    uint8_t *crop_buffer,
+    uint8_t *input_buffer,
+    uint8_t *resize_scratch,
+    uint64_t budget_start_us,
+    uint64_t budget_us,
+    ei_image_crop_fn_t fn,
+    void *user_data,
+    uint32_t *skipped_budget)
+{
+    *skipped_budget = 0;
+
+    for (uint32_t ix = 0; ix < crops_count; ix++) {
+        uint64_t start_us = ei_read_timer_us();
+        if (budget_us > 0 && start_us - budget_start_us >= budget_us) {
+            *skipped_budget = crops_count - ix;
+            break;
+        }
+
+        const uint8_t *input = ei_image_crop_to_input(frame, &crops[ix], input_width, input_height,
+            crop_buffer, input_buffer, resize_scratch);
+        EI_IMPULSE_ERROR res = fn(&crops[ix], input, start_us, user_data);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+#if (EI_CLASSIFIER_OBJECT_DETECTION == 1) && (EI_CLASSIFIER_INPUT_WIDTH > 0) && (EI_CLASSIFIER_INPUT_HEIGHT > 0)
+
+/**
+ * Tiled inference: run an object detection model over a grid of crops of a
+ * larger frame (so small objects don't disappear when the frame is squeezed
+ * into the model input), and merge the detections back into frame space.
+ */
+
+// Maximum number of (merged) bounding boxes returned per frame
+#ifndef EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES
+#define EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES      32
+#endif // EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES
+
+/**
+ * @brief How a frame is cut into tiles. All tiles have the same size, and
+ * neighbouring tiles share `overlap` pixels. Every tile is resized to the
+ * model input.
+ */
+typedef struct {
+    uint32_t cols;
+    uint32_t rows;
+    uint32_t overlap;
+} ei_image_tile_grid_t;
+
+/**
+ * @brief Detections of a single frame, in frame coordinates
+ */
+typedef struct {
+    ei_impulse_result_bounding_box_t bounding_boxes[EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES];
+    uint32_t bounding_boxes_count;
+} ei_tiled_result_t;
+
+/**
+ * @brief Timing over all frames passed to `run_classifier_tiled()`
+ */
+typedef struct {
+    uint32_t tiles;             // number of tiles (inferences) that were run
+    uint64_t total_us;          // wall time, including cropping, resizing and merging
+    uint64_t classification_us; // time spent in the DSP + NN + postprocessing
+    float tiles_per_second;
+} ei_tiled_timing_t;
+
+static const uint8_t *tiled_input_buffer = nullptr;
+
+static int tiled_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    size_t pixel_ix = offset * 3;
+
+    for (size_t ix = 0; ix < length; ix++) {
+        out_ptr[ix] = (tiled_input_buffer[pixel_ix] << 16) +
+            (tiled_input_buffer[pixel_ix + 1] << 8) + tiled_input_buffer[pixel_ix + 2];
+        pixel_ix += 3;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get position and size of a tile, the last tile in a row/column is
+ * aligned with the edge of the frame
+ */
+static void tiled_get_tile(
+    const ei_image_frame_t *frame,
+    const ei_image_tile_grid_t *grid,
+    uint32_t col,
+    uint32_t row,
+    uint32_t *x,
+    uint32_t *y,
+    uint32_t *width,
+    uint32_t *height)
+{
+    *width = (frame->width + (grid->cols - 1) * grid->overlap) / grid->cols;
+    *height = (frame->height + (grid->rows - 1) * grid->overlap) / grid->rows;
+
+    *x = col * (*width - grid->overlap);
+    if (*x + *width > frame->width) {
+        *x = frame->width - *width;
+    }
+    *y = row * (*height - grid->overlap);
+    if (*y + *height > frame->height) {
+        *y = frame->height - *height;
+    }
+}
+
+static bool tiled_boxes_touch(
+    const ei_impulse_result_bounding_box_t *a,
+    const ei_impulse_result_bounding_box_t *b)
+{
+    return a->x <= b->x + b->width && b->x <= a->x + a->width &&
+        a->y <= b->y + b->height && b->y <= a->y + a->height;
+}
+
+/**
+ * @brief Merge boxes of the same label from different tiles that overlap or touch,
+ * i.e. the same object seen twice in the overlap, or cut in two at a tile border.
+ *
+ * @param      result  Boxes of a single frame
+ * @param      tiles   Tile index of every box, -1 once boxes of several tiles were merged
+ */
+static void tiled_merge_boxes(ei_tiled_result_t *result, int *tiles)
+{
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint32_t i = 0; i < result->bounding_boxes_count; i++) {
+            for (uint32_t j = i + 1; j < result->bounding_boxes_count; j++) {
+                ei_impulse_result_bounding_box_t *a = &result->bounding_boxes[i];
+                ei_impulse_result_bounding_box_t *b = &result->bounding_boxes[j];
+
+                if ((tiles[i] == tiles[j] && tiles[i] != -1) ||
+                    strcmp(a->label, b->label) != 0 ||
+                    !tiled_boxes_touch(a, b)) {
+                    continue;
+                }
+
+                uint32_t x1 = std::min(a->x, b->x);
+                uint32_t y1 = std::min(a->y, b->y);
+                uint32_t x2 = std::max(a->x + a->width, b->x + b->width);
+                uint32_t y2 = std::max(a->y + a->height, b->y + b->height);
+                a->x = x1;
+                a->y = y1;
+                a->width = x2 - x1;
+                a->height = y2 - y1;
+                a->value = std::max(a->value, b->value);
+                tiles[i] = -1;
+
+                // move the last box into the free slot
+                result->bounding_boxes_count--;
+                result->bounding_boxes[j] = result->bounding_boxes[result->bounding_boxes_count];
+                tiles[j] = tiles[result->bounding_boxes_count];
+                j--;
+                merged = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run the impulse over a grid of tiles of one or more frames.
+ *
+ * Tiles are cropped from the frame, resized to the model input and classified back to
+ * back. The model is kept initialized (arena, weights and prepared kernels) across all
+ * tiles of all frames, so passing several frames at once amortizes the setup cost.
+ * Detections are scaled back into frame coordinates and merged across tile borders.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in]  frames        Packed RGB888 frames
+ * @param[in]  frames_count  Number of frames
+ * @param[in]  grid          Tile grid, the same for all frames
+ * @param[out] results       Detections, one per frame
+ * @param[out] timing        Timing and throughput over all frames (optional)
+ * @param[in]  debug         Print internal preprocessing and inference debugging information
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR run_classifier_tiled(
+    const ei_image_frame_t *frames,
+    size_t frames_count,
+    const ei_image_tile_grid_t *grid,
+    ei_tiled_result_t *results,
+    ei_tiled_timing_t *timing = nullptr,
+    bool debug = false)
+{
+    uint64_t start_us = ei_read_timer_us();
+    uint64_t classification_us = 0;
+    uint32_t tiles_count = 0;
+
+    if (grid->cols == 0 || grid->rows == 0) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    // find the largest tile so the buffers can be shared by all frames
+    size_t tile_buffer_size = 0;
+    for (size_t ix = 0; ix < frames_count; ix++) {
+        const ei_image_frame_t *frame = &frames[ix];
+        uint32_t x, y, width, height;
+        if (frame->width < grid->cols || frame->height < grid->rows) {
+            return EI_IMPULSE_INVALID_SIZE;
+        }
+        tiled_get_tile(frame, grid, 0, 0, &x, &y, &width, &height);
+        if (width <= grid->overlap || height <= grid->overlap || height < 2) {
+            return EI_IMPULSE_INVALID_SIZE;
+        }
+        tile_buffer_size = std::max(tile_buffer_size, (size_t)width * height * 3);
+    }
+
+    const size_t input_buffer_size = EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT * 3;
+    ei_unique_ptr_t tile_buffer(ei_malloc(tile_buffer_size), ei_free);
+    ei_unique_ptr_t input_buffer(ei_malloc(input_buffer_size), ei_free);
+    ei_unique_ptr_t resize_scratch(ei_malloc(ei::image::processing::resize_image_scratch_size(
+        EI_CLASSIFIER_INPUT_WIDTH, ei::image::processing::RGB888_B_SIZE)), ei_free);
+    int *tiles = (int*)ei_malloc(EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES * sizeof(int));
+    ei_unique_ptr_t tiles_ptr(tiles, ei_free);
+    if (!tile_buffer || !input_buffer || !resize_scratch || !tiles) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    signal_t signal;
+    signal.total_length = EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT;
+    signal.get_data = &tiled_get_data;
+
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    // keep the model initialized over all tiles, then restore what the caller had set
+    const bool keep_alive = inference_tflite_get_keep_alive();
+    inference_tflite_keep_alive(true);
+#endif
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+
+    for (size_t frame_ix = 0; frame_ix < frames_count && res == EI_IMPULSE_OK; frame_ix++) {
+        const ei_image_frame_t *frame = &frames[frame_ix];
+        ei_tiled_result_t *frame_result = &results[frame_ix];
+        frame_result->bounding_boxes_count = 0;
+
+        for (uint32_t row = 0; row < grid->rows && res == EI_IMPULSE_OK; row++) {
+            for (uint32_t col = 0; col < grid->cols; col++) {
+                uint32_t x, y, width, height;
+                tiled_get_tile(frame, grid, col, row, &x, &y, &width, &height);
+
+                uint8_t *tile = (uint8_t*)tile_buffer.get();
+                uint8_t *input = (uint8_t*)input_buffer.get();
+                bool resize = width != EI_CLASSIFIER_INPUT_WIDTH || height != EI_CLASSIFIER_INPUT_HEIGHT;
+
+                ei::image::processing::crop_image_rgb888_packed(
+                    frame->rgb888, frame->width, frame->height, x, y,
+                    resize ? tile : input, width, height);
+                if (resize) {
+                    ei::image::processing::resize_image_with_scratch(
+                        tile, width, height, input,
+                        EI_CLASSIFIER_INPUT_WIDTH, EI_CLASSIFIER_INPUT_HEIGHT,
+                        ei::image::processing::RGB888_B_SIZE, (uint8_t*)resize_scratch.get());
+                }
+                tiled_input_buffer = input;
+
+                ei_impulse_result_t result;
+                memset(&result, 0, sizeof(ei_impulse_result_t));
+
+                uint64_t tile_start_us = ei_read_timer_us();
+                res = run_classifier(&signal, &result, debug);
+                classification_us += ei_read_timer_us() - tile_start_us;
+                tiles_count++;
+
+                if (res != EI_IMPULSE_OK) {
+                    break;
+                }
+
+                for (uint32_t bb_ix = 0; bb_ix < result.bounding_boxes_count; bb_ix++) {
+                    const ei_impulse_result_bounding_box_t *bb = &result.bounding_boxes[bb_ix];
+                    if (bb->value == 0) {
+                        continue;
+                    }
+                    if (frame_result->bounding_boxes_count == EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES) {
+                        EI_LOGD("Too many bounding boxes, increase EI_CLASSIFIER_TILED_MAX_BOUNDING_BOXES\n");
+                        break;
+                    }
+
+                    ei_impulse_result_bounding_box_t *out =
+                        &frame_result->bounding_boxes[frame_result->bounding_boxes_count];
+                    out->label = bb->label;
+                    out->value = bb->value;
+                    out->x = x + (bb->x * width) / EI_CLASSIFIER_INPUT_WIDTH;
+                    out->y = y + (bb->y * height) / EI_CLASSIFIER_INPUT_HEIGHT;
+                    out->width = (bb->width * width) / EI_CLASSIFIER_INPUT_WIDTH;
+                    out->height = (bb->height * height) / EI_CLASSIFIER_INPUT_HEIGHT;
+                    tiles[frame_result->bounding_boxes_count] = row * grid->cols + col;
+                    frame_result->bounding_boxes_count++;
+                }
+            }
+        }
+
+        tiled_merge_boxes(frame_result, tiles);
+    }
+
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    inference_tflite_keep_alive(keep_alive);
+#endif
+
+    uint64_t total_us = ei_read_timer_us() - start_us;
+    float tiles_per_second = total_us > 0 ? (float)tiles_count * 1000000.0f / (float)total_us : 0.0f;
+
+    if (timing) {
+        timing->tiles = tiles_count;
+        timing->total_us = total_us;
+        timing->classification_us = classification_us;
+        timing->tiles_per_second = tiles_per_second;
+    }
+
+    if (debug) {
+        ei_printf("Tiled inference: %u tiles in %u ms. (", (unsigned int)tiles_count, (unsigned int)(total_us / 1000));
+        ei_printf_float(tiles_per_second);
+        ei_printf(" tiles/s)\n");
+    }
+
+    return res;
+}
+
+/**
+ * Crop stage: refine the detections of the object detection model with a second,
+ * small image classifier. Every selected bounding box is cropped from the
+ * full resolution frame, resized to the classifier input and classified; the
+ * top label and its confidence are written back into the bounding box.
+ */
+
+// Maximum number of crops classified per frame
+#ifndef EI_CLASSIFIER_CROP_STAGE_MAX_CROPS
+#define EI_CLASSIFIER_CROP_STAGE_MAX_CROPS          8
+#endif // EI_CLASSIFIER_CROP_STAGE_MAX_CROPS
+
+/**
+ * @brief Which detections are refined, and how
+ */
+typedef struct {
+    ei_impulse_handle_t *classifier;    // image classification impulse that runs on the crops (not
+                                        // object detection, it would overwrite the detector's boxes)
+    const char *label;                  // only refine boxes with this label, nullptr for any
+    float threshold;                    // only refine boxes with at least this confidence
+    float min_confidence;               // keep the detector label when the classifier is less sure
+    float padding;                      // grow boxes by this fraction of their size on every side
+                                        // (FOMO boxes are centroids on a coarse grid)
+    uint32_t max_crops;                 // crops per frame, 0 for EI_CLASSIFIER_CROP_STAGE_MAX_CROPS
+    uint64_t budget_us;                 // time budget per frame, 0 for no budget
+} ei_crop_stage_config_t;
+
+/**
+ * @brief What the crop stage did on a frame
+ */
+typedef struct {
+    uint32_t crops;             // crops that were classified
+    uint32_t refined;           // bounding boxes that got a new label
+    uint32_t skipped_cap;       // matching boxes left out because of `max_crops`
+    uint32_t skipped_budget;    // matching boxes left out because the budget ran out
+    uint64_t total_us;          // wall time, including cropping and resizing
+} ei_crop_stage_timing_t;
+
+typedef struct {
+    const ei_crop_stage_config_t *config;
+    signal_t *signal;
+    ei_crop_stage_timing_t *stats;
+    bool debug;
+} ei_crop_stage_state_t;
+
+/**
+ * @brief Classify one crop and relabel its bounding box
+ */
+static EI_IMPULSE_ERROR crop_stage_classify(const ei_image_crop_t *crop, const uint8_t *input,
+                                            uint64_t start_us, void *user_data)
+{
+    (void)start_us;
+    ei_crop_stage_state_t *state = (ei_crop_stage_state_t*)user_data;
+    const ei_impulse_t *classifier = state->config->classifier->impulse;
+
+    tiled_input_buffer = input;
+
+    ei_impulse_result_t crop_result;
+    memset(&crop_result, 0, sizeof(ei_impulse_result_t));
+
+    EI_IMPULSE_ERROR res = run_classifier(state->config->classifier, state->signal, &crop_result, state->debug);
+    state->stats->crops++;
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    uint32_t top = 0;
+    for (uint32_t label_ix = 1; label_ix < classifier->label_count; label_ix++) {
+        if (crop_result.classification[label_ix].value > crop_result.classification[top].value) {
+            top = label_ix;
+        }
+    }
+    if (classifier->label_count > 0 &&
+        crop_result.classification[top].value >= state->config->min_confidence) {
+        crop->bb->label = crop_result.classification[top].label;
+        crop->bb->value = crop_result.classification[top].value;
+        state->stats->refined++;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief Refine the detections of a frame with an image classifier.
+ *
+ * Selects up to `max_crops` bounding boxes (highest confidence first) that match the
+ * label and threshold of the config, crops them from the full resolution frame, and
+ * classifies them back to back with the classifier kept initialized. When the
+ * classifier's top label reaches `min_confidence`, label and confidence of the box
+ * are replaced; other boxes are left as they are. Once `budget_us` is spent the
+ * remaining crops are skipped, so the latency stays bounded in crowded scenes.
+ * Boxes are mapped onto the frame for EI_CLASSIFIER_RESIZE_MODE, the way the
+ * frame was resized to the detector input.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in]     config   Classifier and selection of the boxes
+ * @param[in]     frame    Packed RGB888 frame the detections were made on, before it
+ *                         was resized to the detector input
+ * @param[in,out] result   Result of the object detection model (`run_classifier()`)
+ * @param[out]    timing   What was classified and skipped (optional)
+ * @param[in]     debug    Print internal preprocessing and inference debugging information
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR run_classifier_crop_stage(
+    const ei_crop_stage_config_t *config,
+    const ei_image_frame_t *frame,
+    ei_impulse_result_t *result,
+    ei_crop_stage_timing_t *timing = nullptr,
+    bool debug = false)
+{
+    uint64_t start_us = ei_read_timer_us();
+    ei_crop_stage_timing_t stats = { 0 };
+
+    const ei_impulse_t *classifier = config->classifier->impulse;
+    if (classifier->input_width == 0 || classifier->input_height == 0) {
+        ei_printf("ERR: Crop stage needs an image classifier\n");
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+    if (classifier->label_count > EI_CLASSIFIER_LABEL_COUNT) {
+        ei_printf("ERR: Crop stage classifier has more labels (%u) than the result can hold (%u)\n",
+            (unsigned int)classifier->label_count, (unsigned int)EI_CLASSIFIER_LABEL_COUNT);
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    uint32_t max_crops = config->max_crops;
+    if (max_crops == 0 || max_crops > EI_CLASSIFIER_CROP_STAGE_MAX_CROPS) {
+        max_crops = EI_CLASSIFIER_CROP_STAGE_MAX_CROPS;
+    }
+
+    ei_image_box_mapping_t mapping;
+    ei_image_box_mapping_init(&mapping, frame->width, frame->height,
+        EI_CLASSIFIER_INPUT_WIDTH, EI_CLASSIFIER_INPUT_HEIGHT, EI_CLASSIFIER_RESIZE_MODE);
+
+    ei_image_crop_t crops[EI_CLASSIFIER_CROP_STAGE_MAX_CROPS];
+    uint32_t crops_count = ei_image_select_crops(result->bounding_boxes, result->bounding_boxes_count,
+        config->label, config->threshold, config->padding, &mapping, frame, crops, max_crops,
+        &stats.skipped_cap);
+
+    size_t crop_buffer_size = 0;
+    for (uint32_t ix = 0; ix < crops_count; ix++) {
+        crop_buffer_size = std::max(crop_buffer_size, (size_t)crops[ix].width * crops[ix].height * 3);
+    }
+    const size_t input_buffer_size = classifier->input_width * classifier->input_height * 3;
+    ei_unique_ptr_t crop_buffer(ei_malloc(std::max(crop_buffer_size, (size_t)1)), ei_free);
+    ei_unique_ptr_t input_buffer(ei_malloc(input_buffer_size), ei_free);
+    ei_unique_ptr_t resize_scratch(ei_malloc(ei::image::processing::resize_image_scratch_size(
+        classifier->input_width, ei::image::processing::RGB888_B_SIZE)), ei_free);
+    if (!crop_buffer || !input_buffer || !resize_scratch) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    signal_t signal;
+    signal.total_length = classifier->input_width * classifier->input_height;
+    signal.get_data = &tiled_get_data;
+
+    ei_crop_stage_state_t state = { config, &signal, &stats, debug };
+
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    // the classifier displaces a detector the caller kept alive, but the caller's
+    // setting is restored so the detector is kept again from its next inference
+    const bool keep_alive = inference_tflite_get_keep_alive();
+    inference_tflite_keep_alive(true);
+#endif
+
+    EI_IMPULSE_ERROR res = ei_image_run_crops(frame, crops, crops_count,
+        classifier->input_width, classifier->input_height,
+        (uint8_t*)crop_buffer.get(), (uint8_t*)input_buffer.get(), (uint8_t*)resize_scratch.get(),
+        start_us, config->budget_us, &crop_stage_classify, &state, &stats.skipped_budget);
+
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    inference_tflite_keep_alive(keep_alive);
+#endif
+
+    stats.total_us = ei_read_timer_us() - start_us;
+    if (timing) {
+        *timing = stats;
+    }
+
+    if (debug) {
+        ei_printf("Crop stage: %u crops, %u refined, %u skipped (cap), %u skipped (budget) in %u ms.\n",
+            (unsigned int)stats.crops, (unsigned int)stats.refined, (unsigned int)stats.skipped_cap,
+            (unsigned int)stats.skipped_budget, (unsigned int)(stats.total_us / 1000));
+    }
+
+    return res;
+}
+
+#endif // (EI_CLASSIFIER_OBJECT_DETECTION == 1) && (EI_CLASSIFIER_INPUT_WIDTH > 0) && (EI_CLASSIFIER_INPUT_HEIGHT > 0)
+
+#if defined(EI_CLASSIFIER_HAS_IMAGE_QUANTIZED_FILL) && (EI_CLASSIFIER_INPUT_WIDTH > 0) && (EI_CLASSIFIER_INPUT_HEIGHT > 0)
+
+/**
+ * Fused image preprocessing: crop, resize, colour conversion, scaling and
+ * quantization of a camera frame in one pass, written straight into the input
+ * tensor (no RGB888 copy of the frame, no float features). The frame is read a
+ * few rows at a time, e.g. as camera DMA buffers fill up, and every row of the
+ * model input is quantized as soon as the rows it's interpolated from arrived.
+ * Gives the same input tensor as resizing the frame with
+ * resize_image_using_mode() and running run_classifier().
+ */
+
+/**
+ * @brief A frame that is read row by row
+ */
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    ei::image::processing::IMAGE_FORMAT format;
+    /**
+     * Point `rows` to the next whole rows of the frame (waiting until they are
+     * available), and return the number of rows. 0 or less aborts the inference.
+     */
+    int (*read_rows)(const uint8_t **rows, void *user_data);
+    void *user_data;
+} ei_image_source_t;
+
+typedef struct {
+    int8_t *features;
+    int width;
+    int pixel_size;             // of the resized rows (1 for grayscale sources)
+    int channels;               // of the model input
+    bool luma_fixed_point;      // integer luma transform (grayscale, default quantization)
+    float scale;
+    float zero_point;
+    int8_t quantized[3][256];   // RGB: quantized value of every channel value
+    float scaled[3][256];       // grayscale: scaled channel values, before the luma transform
+} image_source_quantizer_t;
+
+static void image_source_quantizer_init(
+    image_source_quantizer_t *q,
+    float scale,
+    float zero_point,
+    int image_scaling)
+{
+    // same quantization as extract_image_features_quantized(), through lookup tables
+    const bool fast = ei_image_quantization_is_default(scale, zero_point, image_scaling);
+
+    q->scale = scale;
+    q->zero_point = zero_point;
+    q->luma_fixed_point = fast;
+
+    for (int channel = 0; channel < 3; channel++) {
+        for (int value = 0; value < 256; value++) {
+            float v = ei_image_scale_channel(static_cast<float>(value), channel, image_scaling);
+            q->scaled[channel][value] = v;
+            q->quantized[channel][value] = fast ?
+                static_cast<int8_t>(value + zero_point) :
+                ei_image_quantize(v, scale, zero_point);
+        }
+    }
+}
+
+// Quantize a resized row into the input tensor
+static void image_source_quantize_row(const uint8_t *row, int y, void *user_data)
+{
+    image_source_quantizer_t *q = (image_source_quantizer_t*)user_data;
+    int8_t *out = q->features + y * q->width * q->channels;
+    const int step = q->pixel_size;
+    // grayscale sources read the same byte for all channels
+    const int g = step == 3 ? 1 : 0;
+    const int b = step == 3 ? 2 : 0;
+
+    if (q->channels == 3) {
+        for (int x = 0; x < q->width; x++) {
+            out[0] = q->quantized[0][row[0]];
+            out[1] = q->quantized[1][row[g]];
+            out[2] = q->quantized[2][row[b]];
+            out += 3;
+            row += step;
+        }
+        return;
+    }
+
+    if (q->luma_fixed_point) {
+        const int32_t zero_point = (int32_t)q->zero_point;
+        for (int x = 0; x < q->width; x++) {
+            *out++ = ei_image_luma_default_quantized(row[0], row[g], row[b], zero_point);
+            row += step;
+        }
+    }
+    else {
+        for (int x = 0; x < q->width; x++) {
+            float v = ei_image_luma(q->scaled[0][row[0]], q->scaled[1][row[g]], q->scaled[2][row[b]]);
+            *out++ = ei_image_quantize(v, q->scale, q->zero_point);
+            row += step;
+        }
+    }
+}
+
+// Fill function of run_nn_inference_image_quantized_fill(), user_data is the ei_image_source_t
+static int image_source_fill(const ei_impulse_t *impulse, ei::matrix_i8_t *features, float scale, float zero_point,
+                             void *user_data)
+{
+    const ei_image_source_t *source = (const ei_image_source_t*)user_data;
+    const ei_dsp_config_image_t *config = (const ei_dsp_config_image_t*)impulse->dsp_blocks[0].config;
+    const int channels = strcmp(config->channels, "Grayscale") == 0 ? 1 : 3;
+
+    if (features->rows * features->cols != impulse->input_width * impulse->input_height * channels) {
+        return EIDSP_MATRIX_SIZE_MISMATCH;
+    }
+
+    image_source_quantizer_t *q = (image_source_quantizer_t*)ei_malloc(sizeof(image_source_quantizer_t));
+    if (!q) {
+        return EIDSP_OUT_OF_MEM;
+    }
+    image_source_quantizer_init(q, scale, zero_point, impulse->learning_blocks[0].image_scaling);
+    q->features = features->buffer;
+    q->width = impulse->input_width;
+    q->channels = channels;
+
+    ei::image::processing::resize_stream_t *stream = ei::image::processing::resize_stream_create(
+        source->width, source->height, source->format, impulse->input_width, impulse->input_height,
+        EI_CLASSIFIER_RESIZE_MODE, image_source_quantize_row, q);
+    if (!stream) {
+        ei_free(q);
+        return EIDSP_PARAMETER_INVALID;
+    }
+    q->pixel_size = ei::image::processing::resize_stream_pixel_size(stream);
+
+    int res = EIDSP_OK;
+    while (!ei::image::processing::resize_stream_done(stream)) {
+        const uint8_t *rows = nullptr;
+        int row_count = source->read_rows(&rows, source->user_data);
+        if (row_count <= 0 || !rows) {
+            ei_printf("ERR: Image source stopped before the end of the frame\n");
+            res = EIDSP_SIGNAL_SIZE_MISMATCH;
+            break;
+        }
+        res = ei::image::processing::resize_stream_push_rows(stream, rows, row_count);
+        if (res != EIDSP_OK) {
+            break;
+        }
+    }
+
+    ei::image::processing::resize_stream_free(stream);
+    ei_free(q);
+    return res;
+}
+
+/**
+ * @brief Run the classifier on a frame that is read row by row (e.g. from camera
+ * DMA buffers), with the fused preprocessing described above. Only for impulses
+ * where 'can_run_classifier_image_quantized' returns EI_IMPULSE_OK (one image DSP
+ * block and a quantized model), the frame is resized with EI_CLASSIFIER_RESIZE_MODE.
+ *
+ * @param handle Impulse handle
+ * @param source Frame geometry, pixel format and row reader
+ * @param result Output classifier results
+ * @param debug Debug output enable
+ *
+ * @return The ei impulse error.
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR run_classifier_image_source(
+    ei_impulse_handle_t *handle,
+    const ei_image_source_t *source,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    if (!handle || !handle->impulse || !source || !source->read_rows || !result) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    const ei_impulse_t *impulse = handle->impulse;
+    if (can_run_classifier_image_quantized(impulse, impulse->learning_blocks[0]) != EI_IMPULSE_OK ||
+        impulse->dsp_blocks[0].extract_fn != extract_image_features) {
+        ei_printf("ERR: Image source needs a quantized image impulse\n");
+        return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
+    }
+
+    memset(result, 0, sizeof(ei_impulse_result_t));
+
+    EI_IMPULSE_ERROR res = init_impulse_workspace(handle);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+    handle->workspace.clear_raw_outputs();
+    result->_raw_outputs = handle->workspace.raw_outputs;
+
+    // the image read buffer, the output tensor list and the raw outputs come from the scratch arena
+    ei::EiDspScratchScope scratch(&handle->workspace.dsp_scratch);
+    res = run_nn_inference_image_quantized_fill(impulse, image_source_fill, (void*)source, 0, result,
+        impulse->learning_blocks[0].config, debug);
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    return run_postprocessing(handle, result);
+}
+
+__attribute__((unused)) static EI_IMPULSE_ERROR run_classifier_image_source(
+    const ei_image_source_t *source,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_image_source(&ei_default_impulse, source, result, debug);
+}
 
+#endif // defined(EI_CLASSIFIER_HAS_IMAGE_QUANTIZED_FILL) && (EI_CLASSIFIER_INPUT_WIDTH > 0) && (EI_CLASSIFIER_INPUT_HEIGHT > 0)
 
 #endif // _EDGE_IMPULSE_RUN_CLASSIFIER_IMAGE_H_
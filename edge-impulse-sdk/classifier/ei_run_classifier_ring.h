@@ -0,0 +1,444 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EDGE_IMPULSE_RUN_CLASSIFIER_RING_H_
+#define _EDGE_IMPULSE_RUN_CLASSIFIER_RING_H_
+
+#include "ei_run_classifier.h"
+#include "edge-impulse-sdk/dsp/ei_signal_view.h"
+#include <atomic>
+
+/**
+ * Continuous classification fed by a lock-free single producer / single
+ * consumer ring buffer of int16 samples (PCM audio, interleaved IMU axes).
+ *
+ * The producer (a DMA / I2S callback, an ISR or a sensor task) calls
+ * ei_sample_ring_push(), which never blocks, allocates or takes a lock. The
+ * consumer (the inference task) calls run_classifier_continuous_ring(), which
+ * hands the oldest complete slice to run_classifier_continuous() as a view into
+ * the ring (signal_from_int16_ring(), no copy) and frees it afterwards.
+ *
+ * A push that doesn't fit is dropped as a whole and counted as an overrun. Every
+ * slice is timestamped when its last sample arrives, so the latency from sample
+ * to result is reported per slice.
+ *
+ * The ring holds the slice being classified until the result is ready: size it
+ * for at least two slices plus the samples that arrive during one inference.
+ */
+
+#if EI_PORTING_ESPRESSIF == 1
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+// callable from IRAM-safe ISRs (use ei_sample_ring_push_at() with esp_timer_get_time() there)
+#define EI_SAMPLE_RING_ISR_ATTR                     IRAM_ATTR
+#else
+#define EI_SAMPLE_RING_ISR_ATTR
+#endif
+
+/**
+ * Called by the producer (in its context, e.g. the ISR) when a slice completes
+ */
+typedef void (*ei_sample_ring_slice_ready_t)(void *user_data);
+
+typedef struct {
+    // producer side
+    uint32_t samples_pushed;
+    uint32_t samples_dropped;
+    uint32_t overruns;              // pushes dropped because the ring was full
+    // consumer side
+    uint32_t slices_classified;     // slices classified without error, the latency covers these
+    uint32_t slices_failed;         // slices released after an error of run_classifier_continuous()
+    uint32_t slices_pending;        // complete slices waiting in the ring
+    int64_t latency_last_us;        // newest sample of the slice to the result
+    int64_t latency_min_us;
+    int64_t latency_max_us;
+    int64_t latency_avg_us;
+} ei_sample_ring_stats_t;
+
+typedef struct {
+    int16_t *buffer;
+    uint32_t slots;                 // capacity + 1, one slot always stays empty
+    uint32_t slice_size;            // samples (frames * axes)
+    uint16_t axes;
+    const float *axis_scale;
+    uint64_t *slice_us;             // arrival time of the last sample, per slice
+    uint32_t slice_slots;
+    ei_sample_ring_slice_ready_t slice_ready;
+    void *user_data;
+
+    std::atomic<uint32_t> write_ix; // written by the producer only
+    std::atomic<uint32_t> read_ix;  // written by the consumer only
+
+    // producer only
+    uint32_t slice_fill;
+    uint32_t slices_written;
+    std::atomic<uint32_t> samples_pushed;
+    std::atomic<uint32_t> samples_dropped;
+    std::atomic<uint32_t> overruns;
+
+    // consumer only
+    uint32_t slices_read;
+    uint32_t slices_classified;
+    uint32_t slices_failed;
+    int64_t latency_last_us;
+    int64_t latency_min_us;
+    int64_t latency_max_us;
+    int64_t latency_total_us;
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+    signal_t slice_signal;
+#endif
+} ei_sample_ring_t;
+
+/**
+ * @addtogroup ei_functions
+ * @{
+ */
+
+/**
+ * The producer may run in an IRAM ISR, when the flash cache (and with it PSRAM)
+ * is disabled, so on the ESP32 the ring lives in internal RAM
+ */
+static inline void *ei_sample_ring_alloc(size_t size)
+{
+#if EI_PORTING_ESPRESSIF == 1
+    return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    return ei_malloc(size);
+#endif
+}
+
+static inline void ei_sample_ring_dealloc(void *ptr)
+{
+#if EI_PORTING_ESPRESSIF == 1
+    heap_caps_free(ptr);
+#else
+    ei_free(ptr);
+#endif
+}
+
+/**
+ * @brief Free the buffers of a sample ring
+ */
+__attribute__((unused)) static void ei_sample_ring_free(ei_sample_ring_t *ring)
+{
+    ei_sample_ring_dealloc(ring->buffer);
+    ei_sample_ring_dealloc(ring->slice_us);
+    ring->buffer = nullptr;
+    ring->slice_us = nullptr;
+}
+
+/**
+ * @brief Allocate and reset a sample ring. Not thread safe, call it before
+ * the producer starts. The ring must not move afterwards (the slice signal
+ * refers to it).
+ *
+ * @param ring        Ring to initialize
+ * @param capacity    Samples the ring holds (frames * axes), at least one slice
+ * @param slice_size  Samples per slice, e.g. EI_CLASSIFIER_SLICE_SIZE
+ * @param axes        Interleaved axes per frame
+ * @param axis_scale  Factor per axis from raw value to the unit the impulse was
+ *  trained on (`axes` entries, kept by pointer), or null for raw values
+ * @param slice_ready Optional, called by the producer whenever a slice completes
+ * @param user_data   Passed to `slice_ready`
+ *
+ * @return EI_IMPULSE_OK, EI_IMPULSE_INVALID_SIZE or EI_IMPULSE_ALLOC_FAILED
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR ei_sample_ring_init(
+    ei_sample_ring_t *ring,
+    uint32_t capacity,
+    uint32_t slice_size,
+    uint16_t axes = 1,
+    const float *axis_scale = nullptr,
+    ei_sample_ring_slice_ready_t slice_ready = nullptr,
+    void *user_data = nullptr)
+{
+    if (slice_size == 0 || axes == 0 || slice_size % axes != 0 || capacity < slice_size) {
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    ring->buffer = (int16_t *)ei_sample_ring_alloc((capacity + 1) * sizeof(int16_t));
+    // every complete slice in the ring, and the one that's filling up
+    ring->slice_slots = capacity / slice_size + 1;
+    ring->slice_us = (uint64_t *)ei_sample_ring_alloc(ring->slice_slots * sizeof(uint64_t));
+    if (!ring->buffer || !ring->slice_us) {
+        ei_sample_ring_free(ring);
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+    memset(ring->slice_us, 0, ring->slice_slots * sizeof(uint64_t));
+
+    ring->slots = capacity + 1;
+    ring->slice_size = slice_size;
+    ring->axes = axes;
+    ring->axis_scale = axis_scale;
+    ring->slice_ready = slice_ready;
+    ring->user_data = user_data;
+    ring->write_ix.store(0, std::memory_order_relaxed);
+    ring->read_ix.store(0, std::memory_order_relaxed);
+    ring->slice_fill = 0;
+    ring->slices_written = 0;
+    ring->samples_pushed.store(0, std::memory_order_relaxed);
+    ring->samples_dropped.store(0, std::memory_order_relaxed);
+    ring->overruns.store(0, std::memory_order_relaxed);
+    ring->slices_read = 0;
+    ring->slices_classified = 0;
+    ring->slices_failed = 0;
+    ring->latency_last_us = 0;
+    ring->latency_min_us = 0;
+    ring->latency_max_us = 0;
+    ring->latency_total_us = 0;
+
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+    // one pointer in the capture, so std::function doesn't allocate
+    ring->slice_signal.total_length = 0;
+    ring->slice_signal.get_data = [ring](size_t offset, size_t length, float *out_ptr) {
+        return ei::signal_view_get_data(&ring->slice_signal.view, offset, length, out_ptr);
+    };
+#endif
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief Append samples to the ring (producer side), stamped with `timestamp_us`.
+ *
+ * Lock-free and allocation free, safe from an ISR. Only one producer may push.
+ * When the ring can't hold all `count` samples nothing is written and the push
+ * counts as an overrun.
+ *
+ * @return true if the samples were appended
+ */
+EI_SAMPLE_RING_ISR_ATTR __attribute__((unused)) static bool ei_sample_ring_push_at(
+    ei_sample_ring_t *ring,
+    const int16_t *samples,
+    uint32_t count,
+    uint64_t timestamp_us)
+{
+    const uint32_t slots = ring->slots;
+    const uint32_t write_ix = ring->write_ix.load(std::memory_order_relaxed);
+    // acquire: the consumer is done reading the slots it released
+    const uint32_t read_ix = ring->read_ix.load(std::memory_order_acquire);
+    const uint32_t used = write_ix >= read_ix ? write_ix - read_ix : write_ix + slots - read_ix;
+
+    if (count > slots - 1 - used) {
+        ring->overruns.fetch_add(1, std::memory_order_relaxed);
+        ring->samples_dropped.fetch_add(count, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint32_t first = slots - write_ix < count ? slots - write_ix : count;
+    memcpy(ring->buffer + write_ix, samples, first * sizeof(int16_t));
+    memcpy(ring->buffer, samples + first, (count - first) * sizeof(int16_t));
+
+    bool slice_complete = false;
+    ring->slice_fill += count;
+    while (ring->slice_fill >= ring->slice_size) {
+        ring->slice_us[ring->slices_written % ring->slice_slots] = timestamp_us;
+        ring->slices_written++;
+        ring->slice_fill -= ring->slice_size;
+        slice_complete = true;
+    }
+
+    ring->samples_pushed.fetch_add(count, std::memory_order_relaxed);
+    // release: samples and slice timestamps are visible before the new write index
+    ring->write_ix.store(write_ix + count >= slots ? write_ix + count - slots : write_ix + count,
+        std::memory_order_release);
+
+    if (slice_complete && ring->slice_ready) {
+        ring->slice_ready(ring->user_data);
+    }
+    return true;
+}
+
+/**
+ * @brief Append samples to the ring (producer side), stamped with the current
+ * time, see ei_sample_ring_push_at()
+ */
+__attribute__((unused)) static bool ei_sample_ring_push(ei_sample_ring_t *ring, const int16_t *samples, uint32_t count)
+{
+    return ei_sample_ring_push_at(ring, samples, count, ei_read_timer_us());
+}
+
+/**
+ * @brief Number of complete slices waiting in the ring (consumer side)
+ */
+__attribute__((unused)) static uint32_t ei_sample_ring_slices_pending(ei_sample_ring_t *ring)
+{
+    const uint32_t write_ix = ring->write_ix.load(std::memory_order_acquire);
+    const uint32_t read_ix = ring->read_ix.load(std::memory_order_relaxed);
+    const uint32_t used = write_ix >= read_ix ? write_ix - read_ix : write_ix + ring->slots - read_ix;
+    return used / ring->slice_size;
+}
+
+/**
+ * @brief Counters of the producer and latency of the consumer. The producer
+ * counters may be a push behind when read while the producer runs.
+ */
+__attribute__((unused)) static void ei_sample_ring_get_stats(ei_sample_ring_t *ring, ei_sample_ring_stats_t *stats)
+{
+    stats->samples_pushed = ring->samples_pushed.load(std::memory_order_relaxed);
+    stats->samples_dropped = ring->samples_dropped.load(std::memory_order_relaxed);
+    stats->overruns = ring->overruns.load(std::memory_order_relaxed);
+    stats->slices_classified = ring->slices_classified;
+    stats->slices_failed = ring->slices_failed;
+    stats->slices_pending = ei_sample_ring_slices_pending(ring);
+    stats->latency_last_us = ring->latency_last_us;
+    stats->latency_min_us = ring->latency_min_us;
+    stats->latency_max_us = ring->latency_max_us;
+    stats->latency_avg_us = ring->slices_classified > 0 ?
+        ring->latency_total_us / (int64_t)ring->slices_classified : 0;
+}
+
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+
+/**
+ * @brief Oldest complete slice as a signal (consumer side), reading the ring in
+ * place. The slice stays reserved until ei_sample_ring_release_slice().
+ *
+ * @param ring      Ring
+ * @param slice_us  Optional, arrival time of the last sample of the slice
+ *
+ * @return The slice, or nullptr if no slice is complete yet
+ */
+__attribute__((unused)) static signal_t *ei_sample_ring_acquire_slice(ei_sample_ring_t *ring, uint64_t *slice_us = nullptr)
+{
+    if (ei_sample_ring_slices_pending(ring) == 0) {
+        return nullptr;
+    }
+
+    const uint32_t read_ix = ring->read_ix.load(std::memory_order_relaxed);
+    signal_view_t *view = &ring->slice_signal.view;
+    view->format = SIGNAL_VIEW_INT16;
+    view->data = ring->buffer + read_ix;
+    view->length = ring->slots - read_ix < ring->slice_size ? ring->slots - read_ix : ring->slice_size;
+    view->wrap = ring->buffer;
+    view->wrap_length = ring->slice_size - view->length;
+    view->axes = ring->axes;
+    view->axis_scale = ring->axis_scale;
+    ring->slice_signal.total_length = ring->slice_size;
+
+    if (slice_us) {
+        *slice_us = ring->slice_us[ring->slices_read % ring->slice_slots];
+    }
+    return &ring->slice_signal;
+}
+
+/**
+ * @brief Hand the slice from ei_sample_ring_acquire_slice() back to the producer
+ */
+__attribute__((unused)) static void ei_sample_ring_release_slice(ei_sample_ring_t *ring)
+{
+    const uint32_t read_ix = ring->read_ix.load(std::memory_order_relaxed);
+    const uint32_t next = read_ix + ring->slice_size;
+    ring->slices_read++;
+    // release: done reading the slice before the producer may overwrite it
+    ring->read_ix.store(next >= ring->slots ? next - ring->slots : next, std::memory_order_release);
+}
+
+/**
+ * @brief Run continuous classification on the oldest complete slice of a
+ * sample ring.
+ *
+ * The slice goes through run_classifier_continuous() without being copied and
+ * is released once the result is ready. `result->timing.latency_us` holds the
+ * time from the arrival of the newest sample of the slice to the result, also
+ * summarized by ei_sample_ring_get_stats(). A slice that fails is released as
+ * well, but only counted in `slices_failed`. Returns immediately with
+ * EI_IMPULSE_NO_DATA when no slice is complete, e.g. wait on the
+ * `slice_ready` callback and call it again. Slices are classified in order, one
+ * per call.
+ *
+ * `run_classifier_init()` must be called first, as for run_classifier_continuous().
+ *
+ * @param[in]  handle  Impulse handle
+ * @param[in]  ring    Ring filled by the producer
+ * @param[out] result  Output classifier results
+ * @param[in]  debug   Print internal preprocessing and inference debugging information
+ *
+ * @return EI_IMPULSE_NO_DATA if no slice is complete, otherwise the result of
+ *  run_classifier_continuous()
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous_ring(
+    ei_impulse_handle_t *handle,
+    ei_sample_ring_t *ring,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    if (!handle || !ring || !ring->buffer || !result) {
+        return EI_IMPULSE_INFERENCE_ERROR;
+    }
+
+    uint64_t slice_us;
+    signal_t *slice = ei_sample_ring_acquire_slice(ring, &slice_us);
+    if (!slice) {
+        return EI_IMPULSE_NO_DATA;
+    }
+
+    EI_IMPULSE_ERROR res = process_impulse_continuous(handle, slice, result, debug);
+    ei_sample_ring_release_slice(ring);
+    if (res != EI_IMPULSE_OK) {
+        ring->slices_failed++;
+        return res;
+    }
+
+    const int64_t latency_us = (int64_t)(ei_read_timer_us() - slice_us);
+    result->timing.latency_us = latency_us;
+    if (ring->slices_classified == 0 || latency_us < ring->latency_min_us) {
+        ring->latency_min_us = latency_us;
+    }
+    if (ring->slices_classified == 0 || latency_us > ring->latency_max_us) {
+        ring->latency_max_us = latency_us;
+    }
+    ring->latency_last_us = latency_us;
+    ring->latency_total_us += latency_us;
+    ring->slices_classified++;
+
+    return res;
+}
+
+/**
+ * @brief Run continuous classification of the default impulse on the oldest
+ * complete slice of a sample ring, see run_classifier_continuous_ring() above
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous_ring(
+    ei_sample_ring_t *ring,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier_continuous_ring(&ei_default_impulse, ring, result, debug);
+}
+
+#endif // EIDSP_SIGNAL_C_FN_POINTER == 0
+
+/** @} */
+
+#endif // _EDGE_IMPULSE_RUN_CLASSIFIER_RING_H_
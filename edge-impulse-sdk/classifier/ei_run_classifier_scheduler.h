@@ -0,0 +1,531 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EDGE_IMPULSE_RUN_CLASSIFIER_SCHEDULER_H_
+#define _EDGE_IMPULSE_RUN_CLASSIFIER_SCHEDULER_H_
+
+#include "ei_run_classifier_image.h"
+
+/**
+ * Run several image impulses next to each other with one tensor arena.
+ *
+ * Every model normally allocates an arena of its own. The scheduler instead
+ * hands all of them the same buffer, one model at a time: the arena only has
+ * to be as large as the largest model needs, not the sum. A model runs either
+ * on the full frame, or as a cascade on crops of the detections of another
+ * model (e.g. a plate-region classifier on the vehicles found by FOMO).
+ * Per model there's a priority, a rate limit and a cap on crops per frame,
+ * and per frame an optional time budget.
+ *
+ * Requires models with a heap allocated arena (the default, i.e. not built
+ * with EI_CLASSIFIER_ALLOCATION_STATIC), as the arena is handed out through
+ * inference_tflite_set_arena_allocator().
+ */
+
+#if defined(EI_CLASSIFIER_HAS_ARENA_ALLOCATOR)
+
+#ifndef EI_SCHEDULER_MAX_MODELS
+#define EI_SCHEDULER_MAX_MODELS                     4
+#endif // EI_SCHEDULER_MAX_MODELS
+
+// Detections kept per model per frame, i.e. the maximum number of crops a cascaded model gets
+#ifndef EI_SCHEDULER_MAX_DETECTIONS
+#define EI_SCHEDULER_MAX_DETECTIONS                 16
+#endif // EI_SCHEDULER_MAX_DETECTIONS
+
+/**
+ * @brief How and when a model runs
+ */
+typedef struct {
+    ei_impulse_handle_t *handle;
+    int priority;               // higher runs first, a cascade always runs after its parent
+    uint32_t min_interval_ms;   // rate limit, 0 to run on every frame
+    int parent;                 // model that provides the crops, -1 to run on the full frame
+    const char *parent_label;   // only crop detections with this label, nullptr for any
+    float parent_threshold;     // only crop detections with at least this confidence
+    uint32_t max_crops;         // crops per frame, 0 for EI_SCHEDULER_MAX_DETECTIONS
+} ei_scheduler_model_config_t;
+
+/**
+ * @brief Latency and memory of a model
+ */
+typedef struct {
+    uint32_t runs;              // inferences, i.e. frames or crops
+    uint32_t skipped_rate;      // frames skipped because of the rate limit
+    uint32_t skipped_budget;    // frames or crops skipped because the frame budget ran out
+    uint64_t last_us;           // latency of the last inference (crop, resize and impulse)
+    uint64_t max_us;
+    uint64_t total_us;
+    size_t arena_bytes;         // part of the shared arena the model occupies, 0 until it was set up
+                                // (or when it shares its compiled graph with another entry)
+} ei_scheduler_model_stats_t;
+
+typedef struct {
+    ei_scheduler_model_config_t config;
+    ei_scheduler_model_stats_t stats;
+    uint64_t last_start_us;
+    bool ran;                   // ran on this frame
+    ei_impulse_result_bounding_box_t detections[EI_SCHEDULER_MAX_DETECTIONS]; // in frame coordinates
+    uint32_t detections_count;
+} ei_scheduler_model_t;
+
+typedef struct {
+    ei_scheduler_model_t models[EI_SCHEDULER_MAX_MODELS];
+    size_t models_count;
+    uint8_t *arena;
+    size_t arena_size;
+    bool arena_owned;
+    size_t arena_used;          // most any model asked for
+    uint64_t frame_budget_us;   // 0 for no budget
+    int running;                // model that owns the arena right now, -1 if none
+    uint8_t *crop_buffer;
+    size_t crop_buffer_size;
+    uint8_t *input_buffer;
+    size_t input_buffer_size;
+    uint8_t *resize_scratch;    // resize_image_with_scratch() rows, for the widest model input
+    size_t resize_scratch_size;
+} ei_scheduler_t;
+
+/**
+ * @brief Called for every inference the scheduler runs
+ *
+ * @param      model_ix   Index of the model (order of ei_scheduler_add_model())
+ * @param      crop       Detection of the parent model that was classified (frame
+ *                        coordinates), nullptr when the model ran on the full frame
+ * @param      result     Result of the impulse, bounding boxes are in model input coordinates
+ * @param      user_data  As passed to ei_scheduler_run()
+ */
+typedef void (*ei_scheduler_result_cb_t)(int model_ix,
+                                         const ei_impulse_result_bounding_box_t *crop,
+                                         ei_impulse_result_t *result,
+                                         void *user_data);
+
+static ei_scheduler_t *scheduler_active = nullptr;
+static const uint8_t *scheduler_input = nullptr;
+
+static void *scheduler_arena_alloc(size_t align, size_t size)
+{
+    ei_scheduler_t *s = scheduler_active;
+    if (!s || align > 16) {
+        return nullptr;
+    }
+    if (size > s->arena_size) {
+        ei_printf("ERR: Shared arena too small, model needs %u bytes, arena is %u bytes\n",
+            (unsigned int)size, (unsigned int)s->arena_size);
+        return nullptr;
+    }
+    if (s->running >= 0) {
+        s->models[s->running].stats.arena_bytes = size;
+    }
+    s->arena_used = std::max(s->arena_used, size);
+    memset(s->arena, 0, size);
+    return s->arena;
+}
+
+static void scheduler_arena_free(void *ptr)
+{
+    // the arena is released by ei_scheduler_deinit()
+    (void)ptr;
+}
+
+static int scheduler_get_data(size_t offset, size_t length, float *out_ptr)
+{
+    size_t pixel_ix = offset * 3;
+
+    for (size_t ix = 0; ix < length; ix++) {
+        out_ptr[ix] = (scheduler_input[pixel_ix] << 16) +
+            (scheduler_input[pixel_ix + 1] << 8) + scheduler_input[pixel_ix + 2];
+        pixel_ix += 3;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Grow a scheduler owned buffer, never shrinks
+ */
+static bool scheduler_reserve(uint8_t **buffer, size_t *buffer_size, size_t size)
+{
+    if (*buffer_size >= size) {
+        return true;
+    }
+    ei_free(*buffer);
+    *buffer = (uint8_t*)ei_malloc(size);
+    *buffer_size = *buffer ? size : 0;
+    return *buffer != nullptr;
+}
+
+/**
+ * @brief Set up a scheduler
+ *
+ * @param[out] s           Scheduler
+ * @param[in]  arena       16-byte aligned arena shared by the models, nullptr to allocate one
+ * @param[in]  arena_size  Size of the arena, at least what the largest model needs
+ *                         (kTensorArenaSize in the EON compiled model)
+ *
+ * @return EI_IMPULSE_OK if successful
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR ei_scheduler_init(ei_scheduler_t *s, void *arena, size_t arena_size)
+{
+    memset(s, 0, sizeof(ei_scheduler_t));
+    s->running = -1;
+
+    if (arena) {
+        if (((uintptr_t)arena & 15) != 0) {
+            ei_printf("ERR: Shared arena must be 16-byte aligned\n");
+            return EI_IMPULSE_INVALID_SIZE;
+        }
+        s->arena = (uint8_t*)arena;
+    }
+    else {
+        s->arena = (uint8_t*)ei_aligned_calloc(16, arena_size);
+        if (!s->arena) {
+            ei_printf("ERR: Failed to allocate shared arena (%u bytes)\n", (unsigned int)arena_size);
+            return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+        s->arena_owned = true;
+    }
+    s->arena_size = arena_size;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief Release the buffers of a scheduler (and the arena if it allocated it)
+ */
+__attribute__((unused)) static void ei_scheduler_deinit(ei_scheduler_t *s)
+{
+    if (s->arena_owned) {
+        ei_aligned_free(s->arena);
+    }
+    ei_free(s->crop_buffer);
+    ei_free(s->input_buffer);
+    ei_free(s->resize_scratch);
+    memset(s, 0, sizeof(ei_scheduler_t));
+    s->running = -1;
+}
+
+/**
+ * @brief Add a model to the scheduler. A cascaded model must be added after its parent.
+ *
+ * @return Index of the model, or -1 if the configuration is invalid or there's no room
+ */
+__attribute__((unused)) static int ei_scheduler_add_model(ei_scheduler_t *s, const ei_scheduler_model_config_t *config)
+{
+    if (s->models_count == EI_SCHEDULER_MAX_MODELS || !config->handle) {
+        return -1;
+    }
+    const ei_impulse_t *impulse = config->handle->impulse;
+    if (impulse->input_width == 0 || impulse->input_height == 0) {
+        ei_printf("ERR: Scheduler only supports image impulses\n");
+        return -1;
+    }
+    if (config->parent >= (int)s->models_count) {
+        ei_printf("ERR: Parent model must be added before the cascaded model\n");
+        return -1;
+    }
+
+    size_t input_size = impulse->input_width * impulse->input_height * 3;
+    if (!scheduler_reserve(&s->input_buffer, &s->input_buffer_size, input_size)) {
+        return -1;
+    }
+    size_t resize_size = ei::image::processing::resize_image_scratch_size(
+        impulse->input_width, ei::image::processing::RGB888_B_SIZE);
+    if (!scheduler_reserve(&s->resize_scratch, &s->resize_scratch_size, resize_size)) {
+        return -1;
+    }
+
+    ei_scheduler_model_t *model = &s->models[s->models_count];
+    memset(model, 0, sizeof(ei_scheduler_model_t));
+    model->config = *config;
+    if (model->config.max_crops == 0 || model->config.max_crops > EI_SCHEDULER_MAX_DETECTIONS) {
+        model->config.max_crops = EI_SCHEDULER_MAX_DETECTIONS;
+    }
+    return (int)s->models_count++;
+}
+
+/**
+ * @brief Get latency and arena use of a model
+ */
+__attribute__((unused)) static const ei_scheduler_model_stats_t *ei_scheduler_get_stats(ei_scheduler_t *s, int model_ix)
+{
+    if (model_ix < 0 || model_ix >= (int)s->models_count) {
+        return nullptr;
+    }
+    return &s->models[model_ix].stats;
+}
+
+/**
+ * @brief Pick the next model to run: highest priority first, a cascade only after its parent
+ */
+static int scheduler_next_model(ei_scheduler_t *s, const bool *done)
+{
+    int best = -1;
+    for (size_t ix = 0; ix < s->models_count; ix++) {
+        const ei_scheduler_model_config_t *config = &s->models[ix].config;
+        if (done[ix] || (config->parent >= 0 && !done[config->parent])) {
+            continue;
+        }
+        if (best < 0 || config->priority > s->models[best].config.priority) {
+            best = (int)ix;
+        }
+    }
+    return best;
+}
+
+typedef struct {
+    ei_scheduler_t *s;
+    int model_ix;
+    const ei_image_frame_t *frame;
+    ei_impulse_result_t *result;
+    ei_scheduler_result_cb_t callback;
+    void *user_data;
+    bool debug;
+} ei_scheduler_run_state_t;
+
+/**
+ * @brief Keep the detections of a model (in frame coordinates) as crops for its cascades
+ */
+static void scheduler_store_detections(
+    ei_scheduler_model_t *model,
+    ei_impulse_result_t *result,
+    const ei_image_frame_t *frame,
+    const ei_image_crop_t *region)
+{
+    const ei_impulse_t *impulse = model->config.handle->impulse;
+
+    // regions are resized with resize_image(), i.e. squashed into the model input
+    ei_image_box_mapping_t mapping;
+    ei_image_box_mapping_init(&mapping, region->width, region->height,
+        impulse->input_width, impulse->input_height, EI_CLASSIFIER_RESIZE_SQUASH);
+    mapping.frame_x += region->x;
+    mapping.frame_y += region->y;
+
+    for (uint32_t ix = 0; ix < result->bounding_boxes_count; ix++) {
+        ei_impulse_result_bounding_box_t *bb = &result->bounding_boxes[ix];
+        if (bb->value == 0) {
+            continue;
+        }
+        if (model->detections_count == EI_SCHEDULER_MAX_DETECTIONS) {
+            EI_LOGD("Too many detections, increase EI_SCHEDULER_MAX_DETECTIONS\n");
+            break;
+        }
+
+        ei_image_crop_t crop;
+        ei_image_map_box(&mapping, bb, 0.0f, frame->width, frame->height, &crop);
+
+        ei_impulse_result_bounding_box_t *out = &model->detections[model->detections_count++];
+        out->label = bb->label;
+        out->value = bb->value;
+        out->x = crop.x;
+        out->y = crop.y;
+        out->width = crop.width;
+        out->height = crop.height;
+    }
+}
+
+/**
+ * @brief Run the impulse of a model on a region of the frame (resized to the model input)
+ */
+static EI_IMPULSE_ERROR scheduler_run_region(const ei_image_crop_t *region, const uint8_t *input,
+                                             uint64_t start_us, void *user_data)
+{
+    ei_scheduler_run_state_t *state = (ei_scheduler_run_state_t*)user_data;
+    ei_scheduler_t *s = state->s;
+    ei_scheduler_model_t *model = &s->models[state->model_ix];
+    const ei_impulse_t *impulse = model->config.handle->impulse;
+
+    if (!model->ran) {
+        model->last_start_us = start_us;
+        model->ran = true;
+    }
+
+    scheduler_input = input;
+
+    signal_t signal;
+    signal.total_length = impulse->input_width * impulse->input_height;
+    signal.get_data = &scheduler_get_data;
+
+    memset(state->result, 0, sizeof(ei_impulse_result_t));
+    s->running = state->model_ix;
+    EI_IMPULSE_ERROR res = process_impulse(model->config.handle, &signal, state->result, state->debug);
+    s->running = -1;
+
+    uint64_t elapsed_us = ei_read_timer_us() - start_us;
+    model->stats.runs++;
+    model->stats.last_us = elapsed_us;
+    model->stats.max_us = std::max(model->stats.max_us, elapsed_us);
+    model->stats.total_us += elapsed_us;
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    scheduler_store_detections(model, state->result, state->frame, region);
+    state->callback(state->model_ix, region->bb, state->result, state->user_data);
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief Run all models that are due on a frame
+ *
+ * Models run one after the other in the shared arena, highest priority first.
+ * A model on the full frame is skipped when its rate limit hasn't expired; a
+ * cascaded model runs once per matching detection of its parent (up to
+ * `max_crops`, most confident first), and not at all if the parent didn't run.
+ * Once the frame budget is spent the remaining models and crops are skipped.
+ * Selection, cap and budget are the ones of run_classifier_crop_stage().
+ * A model the application kept alive (inference_tflite_keep_alive()) is
+ * released, as the arena is switched to the scheduler's; it's initialized again
+ * on its next `run_classifier()`. The keep alive setting itself is restored.
+ *
+ * **Blocking**: yes
+ *
+ * @param[in]  s          Scheduler
+ * @param[in]  frame      Packed RGB888 frame
+ * @param[in]  callback   Called with the result of every inference
+ * @param[in]  user_data  Passed to `callback`
+ * @param[in]  debug      Print internal preprocessing and inference debugging information
+ *
+ * @return Error code as defined by `EI_IMPULSE_ERROR` enum
+ */
+__attribute__((unused)) static EI_IMPULSE_ERROR ei_scheduler_run(
+    ei_scheduler_t *s,
+    const ei_image_frame_t *frame,
+    ei_scheduler_result_cb_t callback,
+    void *user_data = nullptr,
+    bool debug = false)
+{
+    uint64_t frame_start_us = ei_read_timer_us();
+    bool done[EI_SCHEDULER_MAX_MODELS] = { false };
+
+    for (size_t ix = 0; ix < s->models_count; ix++) {
+        s->models[ix].ran = false;
+        s->models[ix].detections_count = 0;
+    }
+
+    scheduler_active = s;
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    const bool keep_alive = inference_tflite_get_keep_alive();
+#endif
+    // releases a model the caller kept alive, it's initialized again on its next inference
+    inference_tflite_set_arena_allocator(&scheduler_arena_alloc, &scheduler_arena_free);
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    // a model stays initialized over all of its crops, switching models releases it
+    inference_tflite_keep_alive(true);
+#endif
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+    ei_impulse_result_t result;
+    ei_scheduler_run_state_t state = { s, -1, frame, &result, callback, user_data, debug };
+
+    int model_ix;
+    while (res == EI_IMPULSE_OK && (model_ix = scheduler_next_model(s, done)) >= 0) {
+        done[model_ix] = true;
+        ei_scheduler_model_t *model = &s->models[model_ix];
+        const ei_scheduler_model_config_t *config = &model->config;
+        const ei_impulse_t *impulse = config->handle->impulse;
+        state.model_ix = model_ix;
+
+        ei_image_crop_t crops[EI_SCHEDULER_MAX_DETECTIONS];
+        uint32_t crops_count;
+
+        if (config->parent < 0) {
+            if (model->stats.runs > 0 &&
+                ei_read_timer_us() - model->last_start_us < (uint64_t)config->min_interval_ms * 1000) {
+                model->stats.skipped_rate++;
+                continue;
+            }
+            crops[0] = { nullptr, 0, 0, frame->width, frame->height };
+            crops_count = 1;
+        }
+        else {
+            ei_scheduler_model_t *parent = &s->models[config->parent];
+            if (!parent->ran) {
+                continue;
+            }
+
+            // the detections are in frame coordinates already
+            ei_image_box_mapping_t identity = { 1.0f, 1.0f, 0, 0, 0, 0 };
+            uint32_t skipped_cap;
+            crops_count = ei_image_select_crops(parent->detections, parent->detections_count,
+                config->parent_label, config->parent_threshold, 0.0f, &identity, frame,
+                crops, config->max_crops, &skipped_cap);
+
+            size_t crop_size = 0;
+            for (uint32_t ix = 0; ix < crops_count; ix++) {
+                crop_size = std::max(crop_size, (size_t)crops[ix].width * crops[ix].height * 3);
+            }
+            if (!scheduler_reserve(&s->crop_buffer, &s->crop_buffer_size, crop_size)) {
+                res = EI_IMPULSE_ALLOC_FAILED;
+                break;
+            }
+        }
+
+        uint32_t skipped_budget;
+        res = ei_image_run_crops(frame, crops, crops_count, impulse->input_width, impulse->input_height,
+            s->crop_buffer, s->input_buffer, s->resize_scratch, frame_start_us, s->frame_budget_us,
+            &scheduler_run_region, &state, &skipped_budget);
+        model->stats.skipped_budget += skipped_budget;
+    }
+
+    // the last model lives in the scheduler arena, release it before restoring the
+    // caller's keep alive setting
+    inference_tflite_set_arena_allocator(nullptr, nullptr);
+#if defined(EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE)
+    inference_tflite_keep_alive(keep_alive);
+#endif
+    scheduler_active = nullptr;
+
+    return res;
+}
+
+/**
+ * @brief Print latency and arena use of every model
+ */
+__attribute__((unused)) static void ei_scheduler_print_stats(ei_scheduler_t *s)
+{
+    ei_printf("Scheduler: shared arena %u bytes, %u used\n",
+        (unsigned int)s->arena_size, (unsigned int)s->arena_used);
+    for (size_t ix = 0; ix < s->models_count; ix++) {
+        const ei_scheduler_model_stats_t *stats = &s->models[ix].stats;
+        ei_printf("  %u: %s, runs %u, last %u us, avg %u us, max %u us, arena %u bytes, skipped %u (rate) %u (budget)\n",
+            (unsigned int)ix, s->models[ix].config.handle->impulse->impulse_name,
+            (unsigned int)stats->runs, (unsigned int)stats->last_us,
+            (unsigned int)(stats->runs ? stats->total_us / stats->runs : 0), (unsigned int)stats->max_us,
+            (unsigned int)stats->arena_bytes, (unsigned int)stats->skipped_rate, (unsigned int)stats->skipped_budget);
+    }
+}
+
+#endif // defined(EI_CLASSIFIER_HAS_ARENA_ALLOCATOR)
+
+#endif // _EDGE_IMPULSE_RUN_CLASSIFIER_SCHEDULER_H_
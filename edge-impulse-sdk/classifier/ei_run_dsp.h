@@ -35,11 +35,14 @@
 #ifndef _EDGE_IMPULSE_RUN_DSP_H_
 #define _EDGE_IMPULSE_RUN_DSP_H_
 
+#include <new>
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
 #include "edge-impulse-sdk/dsp/ei_flatten.h"
+#include "edge-impulse-sdk/dsp/ei_signal_view.h"
 #include "model-parameters/model_metadata.h"
 
 #if EI_CLASSIFIER_HR_ENABLED
@@ -77,6 +80,21 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+#ifndef EI_DSP_CONTINUOUS_MAX_STREAMS
+#define EI_DSP_CONTINUOUS_MAX_STREAMS 2
+#endif
+
+// streaming MFE / MFCC state for continuous audio, one per DSP block of an impulse
+// handle (keyed by the handle's workspace and the block's config)
+typedef struct {
+    const void *owner;
+    const void *config;
+    speechpy::feature_stream *stream;
+} ei_dsp_cont_stream_t;
+static ei_dsp_cont_stream_t ei_dsp_cont_streams[EI_DSP_CONTINUOUS_MAX_STREAMS];
+#endif // EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+
 __attribute__((unused)) int extract_hr_features(
     signal_t *signal,
     matrix_t *output_matrix,
@@ -103,7 +121,7 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     ei_dsp_config_spectral_analysis_t *config = (ei_dsp_config_spectral_analysis_t *)config_ptr;
 
     // input matrix from the raw signal
-    matrix_t input_matrix(signal->total_length / config->axes, config->axes);
+    EI_DSP_MATRIX(input_matrix, signal->total_length / config->axes, config->axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
@@ -765,6 +783,9 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
     else {
         // preemphasis class to preprocess the audio...
         class speechpy::processing::preemphasis *pre = new class speechpy::processing::preemphasis(signal, 1, 0.98f, true);
+        if (!pre) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
         preemphasis = pre;
 
         preemphasized_audio_signal.total_length = signal->total_length;
@@ -937,6 +958,9 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     else {
         // preemphasis class to preprocess the audio...
         class speechpy::processing::preemphasis *pre = new class speechpy::processing::preemphasis(signal, 1, 0.98f, true);
+        if (!pre) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
         preemphasis = pre;
         preemphasized_audio_signal.total_length = signal->total_length;
         preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
@@ -1112,6 +1136,191 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
 #endif
 }
 
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+/**
+ * Whether process_impulse_continuous() runs this DSP block through extract_audio_stream_features().
+ * MFCC and MFE (version 3 and up) are streamed, spectrogram and older MFE use the per slice functions.
+ */
+__attribute__((unused)) static bool audio_stream_supported(const ei_model_dsp_t *block) {
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+    return false;
+#else
+    if (block->extract_fn == extract_mfcc_features) {
+        return true;
+    }
+    if (block->extract_fn == extract_mfe_features) {
+        return ((ei_dsp_config_mfe_t*)block->config)->implementation_version >= 3;
+    }
+    return false;
+#endif
+}
+
+/**
+ * Stream for a DSP block of owner, created on first use (or again if the config changed)
+ */
+__attribute__((unused)) static speechpy::feature_stream *get_audio_stream(const void *owner, const ei_model_dsp_t *block, const float sampling_frequency) {
+    const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
+
+    float frame_length, frame_stride;
+    uint16_t num_filters, fft_length, num_cepstral, version;
+    uint32_t low_frequency, high_frequency;
+
+    if (block->extract_fn == extract_mfcc_features) {
+        ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t*)block->config;
+        if (config->axes != 1 || config->num_cepstral <= 0) {
+            return nullptr;
+        }
+        frame_length = config->frame_length;
+        frame_stride = config->frame_stride;
+        num_filters = config->num_filters;
+        fft_length = config->fft_length;
+        low_frequency = config->low_frequency;
+        high_frequency = config->high_frequency;
+        num_cepstral = config->num_cepstral;
+        // for continuous use v2 stack frame calculations
+        version = config->implementation_version == 1 ? 2 : config->implementation_version;
+    }
+    else {
+        ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t*)block->config;
+        if (config->axes != 1) {
+            return nullptr;
+        }
+        frame_length = config->frame_length;
+        frame_stride = config->frame_stride;
+        num_filters = config->num_filters;
+        fft_length = config->fft_length;
+        low_frequency = config->low_frequency;
+        high_frequency = config->high_frequency;
+        num_cepstral = 0;
+        version = config->implementation_version;
+    }
+
+    ei_dsp_cont_stream_t *slot = nullptr;
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_STREAMS; ix++) {
+        if (ei_dsp_cont_streams[ix].owner == owner && ei_dsp_cont_streams[ix].config == block->config) {
+            slot = &ei_dsp_cont_streams[ix];
+            break;
+        }
+        if (!slot && !ei_dsp_cont_streams[ix].config) {
+            slot = &ei_dsp_cont_streams[ix];
+        }
+    }
+    if (!slot) {
+        ei_printf("ERR: More than %d continuous audio blocks, increase EI_DSP_CONTINUOUS_MAX_STREAMS\n",
+            EI_DSP_CONTINUOUS_MAX_STREAMS);
+        return nullptr;
+    }
+
+    if (slot->stream && slot->stream->matches(frequency, frame_length, frame_stride, num_filters, fft_length,
+            low_frequency, high_frequency, num_cepstral, version)) {
+        return slot->stream;
+    }
+
+    if (!slot->stream) {
+        slot->stream = new (std::nothrow) speechpy::feature_stream();
+        if (!slot->stream) {
+            return nullptr;
+        }
+    }
+    slot->owner = owner;
+    slot->config = block->config;
+
+    int ret = slot->stream->init(frequency, frame_length, frame_stride, num_filters, fft_length,
+        low_frequency, high_frequency, num_cepstral, version);
+    if (ret != EIDSP_OK) {
+        delete slot->stream;
+        slot->stream = nullptr;
+        slot->owner = nullptr;
+        slot->config = nullptr;
+        return nullptr;
+    }
+
+    return slot->stream;
+}
+
+/**
+ * Continuous version of extract_mfcc_features() / extract_mfe_features() (see audio_stream_supported()).
+ * Every frame is computed once, new rows are written into output_matrix, which is
+ * used as a ring buffer; read it back with ei_dsp_copy_audio_stream_window().
+ * owner identifies the caller's stream state (the impulse handle's workspace), so two
+ * handles of the same impulse don't share frames.
+ */
+__attribute__((unused)) int extract_audio_stream_features(const void *owner, signal_t *signal, matrix_t *output_matrix, const ei_model_dsp_t *block, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+    ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
+    EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+#else
+    if (signal->total_length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    speechpy::feature_stream *stream = get_audio_stream(owner, block, sampling_frequency);
+    if (!stream) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const size_t row_size = stream->row_size();
+    const size_t n_values = output_matrix->rows * output_matrix->cols;
+    if (n_values % row_size != 0) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    // same preemphasis as the per slice functions, the first sample of the slice
+    // is preemphasized against the end of the same slice
+    class speechpy::processing::preemphasis *pre;
+    if (block->extract_fn == extract_mfcc_features) {
+        ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t*)block->config;
+        pre = new class speechpy::processing::preemphasis(signal, config->pre_shift, config->pre_cof, false);
+    }
+    else {
+        pre = new class speechpy::processing::preemphasis(signal, 1, 0.98f, true);
+    }
+    if (!pre) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    preemphasis = pre;
+
+    signal_t preemphasized_audio_signal;
+    preemphasized_audio_signal.total_length = signal->total_length;
+    preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
+
+    size_t rows = 0;
+    int ret = stream->push(&preemphasized_audio_signal, 0, signal->total_length,
+        output_matrix->buffer, n_values / row_size, &rows);
+
+    delete pre;
+    preemphasis = nullptr;
+
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Streaming %s failed (%d)\n",
+            block->extract_fn == extract_mfcc_features ? "MFCC" : "MFE", ret);
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = rows;
+    matrix_size_out->cols = rows > 0 ? row_size : 0;
+
+    return EIDSP_OK;
+#endif
+}
+
+/**
+ * Copy the feature window of a streamed DSP block of owner to out, oldest row first
+ * @returns false if the block is not streamed (the window is already linear)
+ */
+__attribute__((unused)) static bool ei_dsp_copy_audio_stream_window(const void *owner, const void *config_ptr, const float *window, size_t window_size, float *out) {
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_STREAMS; ix++) {
+        if (ei_dsp_cont_streams[ix].owner == owner && ei_dsp_cont_streams[ix].config == config_ptr &&
+                ei_dsp_cont_streams[ix].stream) {
+            speechpy::feature_stream *stream = ei_dsp_cont_streams[ix].stream;
+            stream->copy_window(window, window_size / stream->row_size(), out);
+            return true;
+        }
+    }
+    return false;
+}
+#endif // EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+
 __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
 
@@ -1119,46 +1328,53 @@ __attribute__((unused)) int extract_image_features(signal_t *signal, matrix_t *o
 
     size_t output_ix = 0;
 
+    auto pixel_to_features = [&](uint32_t pixel_r, uint32_t pixel_g, uint32_t pixel_b) {
+        // rgb to 0..1
+        float r = static_cast<float>(pixel_r) / 255.0f;
+        float g = static_cast<float>(pixel_g) / 255.0f;
+        float b = static_cast<float>(pixel_b) / 255.0f;
+
+        if (channel_count == 3) {
+            output_matrix->buffer[output_ix++] = r;
+            output_matrix->buffer[output_ix++] = g;
+            output_matrix->buffer[output_ix++] = b;
+        }
+        else {
+            // ITU-R 601-2 luma transform
+            // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
+            float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
+            output_matrix->buffer[output_ix++] = v;
+        }
+    };
+
+    // typed frame (signal_from_rgb888() etc.), read the pixels in place
+    if (signal_has_image_view(signal)) {
+        signal_view_for_each_pixel(&signal->view, 0, signal->total_length, pixel_to_features);
+        return EIDSP_OK;
+    }
+
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
     const size_t page_size = EI_DSP_IMAGE_BUFFER_STATIC_SIZE;
 #else
     const size_t page_size = 1024;
 #endif
 
-    // buffered read from the signal
+    // buffered read from the signal, through one page buffer
+#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
+    matrix_t input_matrix(page_size, config.axes, ei_dsp_image_buffer);
+#else
+    EI_DSP_MATRIX(input_matrix, page_size, config.axes);
+#endif
+
     size_t bytes_left = signal->total_length;
     for (size_t ix = 0; ix < signal->total_length; ix += page_size) {
         size_t elements_to_read = bytes_left > page_size ? page_size : bytes_left;
 
-#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
-        matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
-#else
-        matrix_t input_matrix(elements_to_read, config.axes);
-#endif
-        if (!input_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
         signal->get_data(ix, elements_to_read, input_matrix.buffer);
 
         for (size_t jx = 0; jx < elements_to_read; jx++) {
             uint32_t pixel = static_cast<uint32_t>(input_matrix.buffer[jx]);
-
-            // rgb to 0..1
-            float r = static_cast<float>(pixel >> 16 & 0xff) / 255.0f;
-            float g = static_cast<float>(pixel >> 8 & 0xff) / 255.0f;
-            float b = static_cast<float>(pixel & 0xff) / 255.0f;
-
-            if (channel_count == 3) {
-                output_matrix->buffer[output_ix++] = r;
-                output_matrix->buffer[output_ix++] = g;
-                output_matrix->buffer[output_ix++] = b;
-            }
-            else {
-                // ITU-R 601-2 luma transform
-                // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
-                output_matrix->buffer[output_ix++] = v;
-            }
+            pixel_to_features(pixel >> 16 & 0xff, pixel >> 8 & 0xff, pixel & 0xff);
         }
 
         bytes_left -= elements_to_read;
@@ -1185,19 +1401,17 @@ __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, m
     const size_t page_size = 1024;
 #endif
 
-    // buffered read from the signal
+    // buffered read from the signal, through one page buffer
+#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
+    matrix_t input_matrix(page_size, config.axes, ei_dsp_image_buffer);
+#else
+    EI_DSP_MATRIX(input_matrix, page_size, config.axes);
+#endif
+
     size_t bytes_left = signal->total_length;
     for (size_t ix = 0; ix < signal->total_length; ix += page_size) {
         size_t elements_to_read = bytes_left > page_size ? page_size : bytes_left;
 
-#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
-        matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
-#else
-        matrix_t input_matrix(elements_to_read, config.axes);
-#endif
-        if (!input_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
         signal->get_data(ix, elements_to_read, input_matrix.buffer);
 
         for (size_t jx = 0; jx < elements_to_read; jx++) {
@@ -1233,6 +1447,63 @@ __attribute__((unused)) int extract_drpai_features_quantized(signal_t *signal, m
 
 #if (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
+/**
+ * Whether the input tensor uses the default image quantization (scale 1/255, zero point
+ * -128, no scaling), where a channel value maps onto its quantized value without floats
+ */
+static inline bool ei_image_quantization_is_default(float scale, float zero_point, int image_scaling) {
+    return scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE;
+}
+
+/**
+ * Scaling of a channel value (0..255) of channel 0..2 (R, G, B) before quantization,
+ * per EI_CLASSIFIER_IMAGE_SCALING_*
+ */
+static inline float ei_image_scale_channel(float v, int channel, int image_scaling) {
+    static const float torch_mean[] = { 0.485, 0.456, 0.406 };
+    static const float torch_std[] = { 0.229, 0.224, 0.225 };
+
+    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
+        v /= 255.0f;
+    }
+    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
+        v /= 255.0f;
+        v = (v - torch_mean[channel]) / torch_std[channel];
+    }
+    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
+        v -= 128.0f;
+    }
+    return v;
+}
+
+static inline int8_t ei_image_quantize(float v, float scale, float zero_point) {
+    return static_cast<int8_t>(round(v / scale) + zero_point);
+}
+
+/**
+ * ITU-R 601-2 luma transform of scaled channel values
+ * see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
+ */
+static inline float ei_image_luma(float r, float g, float b) {
+    return (0.299f * r) + (0.587f * g) + (0.114f * b);
+}
+
+/**
+ * ITU-R 601-2 luma transform in fixed point, quantized with the default image quantization
+ */
+static inline int8_t ei_image_luma_default_quantized(int32_t r, int32_t g, int32_t b, int32_t zero_point) {
+    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
+    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
+    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+
+    int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
+    gray >>= 16; // scale down to int8_t
+    gray += zero_point;
+    if (gray < - 128) gray = -128;
+    else if (gray > 127) gray = 127;
+    return static_cast<int8_t>(gray);
+}
+
 __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency,
                                                              int image_scaling) {
     ei_dsp_config_image_t config = *((ei_dsp_config_image_t*)config_ptr);
@@ -1241,12 +1512,46 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 
     size_t output_ix = 0;
 
-    const int32_t iRedToGray = (int32_t)(0.299f * 65536.0f);
-    const int32_t iGreenToGray = (int32_t)(0.587f * 65536.0f);
-    const int32_t iBlueToGray = (int32_t)(0.114f * 65536.0f);
+    const bool default_quantization = ei_image_quantization_is_default(scale, zero_point, image_scaling);
 
-    static const float torch_mean[] = { 0.485, 0.456, 0.406 };
-    static const float torch_std[] = { 0.229, 0.224, 0.225 };
+    auto pixel_to_features = [&](uint32_t pixel_r, uint32_t pixel_g, uint32_t pixel_b) {
+        // fast code path
+        if (default_quantization) {
+            int32_t r = static_cast<int32_t>(pixel_r);
+            int32_t g = static_cast<int32_t>(pixel_g);
+            int32_t b = static_cast<int32_t>(pixel_b);
+
+            if (channel_count == 3) {
+                output_matrix->buffer[output_ix++] = static_cast<int8_t>(r + zero_point);
+                output_matrix->buffer[output_ix++] = static_cast<int8_t>(g + zero_point);
+                output_matrix->buffer[output_ix++] = static_cast<int8_t>(b + zero_point);
+            }
+            else {
+                output_matrix->buffer[output_ix++] = ei_image_luma_default_quantized(r, g, b, (int32_t)zero_point);
+            }
+            return;
+        }
+
+        // slow code path
+        float r = ei_image_scale_channel(static_cast<float>(pixel_r), 0, image_scaling);
+        float g = ei_image_scale_channel(static_cast<float>(pixel_g), 1, image_scaling);
+        float b = ei_image_scale_channel(static_cast<float>(pixel_b), 2, image_scaling);
+
+        if (channel_count == 3) {
+            output_matrix->buffer[output_ix++] = ei_image_quantize(r, scale, zero_point);
+            output_matrix->buffer[output_ix++] = ei_image_quantize(g, scale, zero_point);
+            output_matrix->buffer[output_ix++] = ei_image_quantize(b, scale, zero_point);
+        }
+        else {
+            output_matrix->buffer[output_ix++] = ei_image_quantize(ei_image_luma(r, g, b), scale, zero_point);
+        }
+    };
+
+    // typed frame (signal_from_rgb888() etc.), read the pixels in place
+    if (signal_has_image_view(signal)) {
+        signal_view_for_each_pixel(&signal->view, 0, signal->total_length, pixel_to_features);
+        return EIDSP_OK;
+    }
 
 #if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
     const size_t page_size = EI_DSP_IMAGE_BUFFER_STATIC_SIZE;
@@ -1254,114 +1559,22 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
     const size_t page_size = 1024;
 #endif
 
-    // buffered read from the signal
+    // buffered read from the signal, through one page buffer
+#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
+    matrix_t input_matrix(page_size, config.axes, ei_dsp_image_buffer);
+#else
+    EI_DSP_MATRIX(input_matrix, page_size, config.axes);
+#endif
+
     size_t bytes_left = signal->total_length;
     for (size_t ix = 0; ix < signal->total_length; ix += page_size) {
         size_t elements_to_read = bytes_left > page_size ? page_size : bytes_left;
 
-#if defined(EI_DSP_IMAGE_BUFFER_STATIC_SIZE)
-        matrix_t input_matrix(elements_to_read, config.axes, ei_dsp_image_buffer);
-#else
-        matrix_t input_matrix(elements_to_read, config.axes);
-#endif
-        if (!input_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
         signal->get_data(ix, elements_to_read, input_matrix.buffer);
 
         for (size_t jx = 0; jx < elements_to_read; jx++) {
             uint32_t pixel = static_cast<uint32_t>(input_matrix.buffer[jx]);
-
-            if (channel_count == 3) {
-                // fast code path
-                if (scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(r + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(g + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(b + zero_point);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff);
-                    float g = static_cast<float>(pixel >> 8 & 0xff);
-                    float b = static_cast<float>(pixel & 0xff);
-
-                    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-
-                        r = (r - torch_mean[0]) / torch_std[0];
-                        g = (g - torch_mean[1]) / torch_std[1];
-                        b = (b - torch_mean[2]) / torch_std[2];
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
-                        r -= 128.0f;
-                        g -= 128.0f;
-                        b -= 128.0f;
-                    }
-
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(r / scale) + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(g / scale) + zero_point);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(b / scale) + zero_point);
-                }
-            }
-            else {
-                // fast code path
-                if (scale == 0.003921568859368563f && zero_point == -128 && image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                    int32_t r = static_cast<int32_t>(pixel >> 16 & 0xff);
-                    int32_t g = static_cast<int32_t>(pixel >> 8 & 0xff);
-                    int32_t b = static_cast<int32_t>(pixel & 0xff);
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    int32_t gray = (iRedToGray * r) + (iGreenToGray * g) + (iBlueToGray * b);
-                    gray >>= 16; // scale down to int8_t
-                    gray += zero_point;
-                    if (gray < - 128) gray = -128;
-                    else if (gray > 127) gray = 127;
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(gray);
-                }
-                // slow code path
-                else {
-                    float r = static_cast<float>(pixel >> 16 & 0xff);
-                    float g = static_cast<float>(pixel >> 8 & 0xff);
-                    float b = static_cast<float>(pixel & 0xff);
-
-                    if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_NONE) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_TORCH) {
-                        r /= 255.0f;
-                        g /= 255.0f;
-                        b /= 255.0f;
-
-                        r = (r - torch_mean[0]) / torch_std[0];
-                        g = (g - torch_mean[1]) / torch_std[1];
-                        b = (b - torch_mean[2]) / torch_std[2];
-                    }
-                    else if (image_scaling == EI_CLASSIFIER_IMAGE_SCALING_MIN128_127) {
-                        r -= 128.0f;
-                        g -= 128.0f;
-                        b -= 128.0f;
-                    }
-
-                    // ITU-R 601-2 luma transform
-                    // see: https://pillow.readthedocs.io/en/stable/reference/Image.html#PIL.Image.Image.convert
-                    float v = (0.299f * r) + (0.587f * g) + (0.114f * b);
-                    output_matrix->buffer[output_ix++] = static_cast<int8_t>(round(v / scale) + zero_point);
-                }
-            }
+            pixel_to_features(pixel >> 16 & 0xff, pixel >> 8 & 0xff, pixel & 0xff);
         }
 
         bytes_left -= elements_to_read;
@@ -1369,8 +1582,136 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
     }
     return EIDSP_OK;
 }
+
+#if EIDSP_SPEECHPY_FIXED_POINT == 1
+static speechpy::fixed_point_features_config_t fixed_point_config_mfe(const ei_dsp_config_mfe_t *config, const float frequency) {
+    speechpy::fixed_point_features_config_t fixed;
+    memset(&fixed, 0, sizeof(fixed));
+    fixed.type = speechpy::FIXED_POINT_MFE;
+    fixed.sampling_frequency = static_cast<uint32_t>(frequency);
+    fixed.frame_length = config->frame_length;
+    fixed.frame_stride = config->frame_stride;
+    fixed.fft_length = config->fft_length;
+    fixed.num_filters = config->num_filters;
+    fixed.low_frequency = config->low_frequency;
+    fixed.high_frequency = config->high_frequency;
+    fixed.noise_floor_db = config->noise_floor_db;
+    fixed.version = config->implementation_version;
+    return fixed;
+}
+
+static speechpy::fixed_point_features_config_t fixed_point_config_spectrogram(const ei_dsp_config_spectrogram_t *config, const float frequency) {
+    speechpy::fixed_point_features_config_t fixed;
+    memset(&fixed, 0, sizeof(fixed));
+    fixed.type = speechpy::FIXED_POINT_SPECTROGRAM;
+    fixed.sampling_frequency = static_cast<uint32_t>(frequency);
+    fixed.frame_length = config->frame_length;
+    fixed.frame_stride = config->frame_stride;
+    fixed.fft_length = config->fft_length;
+    fixed.noise_floor_db = config->noise_floor_db;
+    fixed.version = config->implementation_version;
+    return fixed;
+}
+
+/**
+ * extract_mfe_features() in fixed point, quantized with the scale and zero point of the input
+ * tensor (see speechpy/feature_fixed.h)
+ */
+__attribute__((unused)) int extract_mfe_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency) {
+    ei_dsp_config_mfe_t *config = (ei_dsp_config_mfe_t*)config_ptr;
+
+    if (config->axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    speechpy::fixed_point_features_config_t fixed = fixed_point_config_mfe(config, frequency);
+    int ret = speechpy::fixed_point_features(&fixed, signal, output_matrix, scale, static_cast<int32_t>(zero_point));
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: MFE failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    return EIDSP_OK;
+}
+
+/**
+ * extract_spectrogram_features() in fixed point, quantized with the scale and zero point of the
+ * input tensor (see speechpy/feature_fixed.h)
+ */
+__attribute__((unused)) int extract_spectrogram_features_quantized(signal_t *signal, matrix_i8_t *output_matrix, void *config_ptr, float scale, float zero_point, const float frequency) {
+    ei_dsp_config_spectrogram_t *config = (ei_dsp_config_spectrogram_t*)config_ptr;
+
+    if (config->axes != 1) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    speechpy::fixed_point_features_config_t fixed = fixed_point_config_spectrogram(config, frequency);
+    int ret = speechpy::fixed_point_features(&fixed, signal, output_matrix, scale, static_cast<int32_t>(zero_point));
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Spectrogram failed (%d)\n", ret);
+        EIDSP_ERR(ret);
+    }
+
+    return EIDSP_OK;
+}
+#endif // EIDSP_SPEECHPY_FIXED_POINT == 1
+
+/**
+ * Writes the quantized features of an image impulse straight into the input tensor
+ * (wrapped by 'features'), see run_nn_inference_image_quantized_fill()
+ */
+typedef int (*ei_fill_image_quantized_fn_t)(const ei_impulse_t *impulse, matrix_i8_t *features, float scale, float zero_point,
+                                             void *user_data);
+
+/**
+ * Fill function of run_nn_inference_image_quantized(), user_data is the signal_t
+ */
+__attribute__((unused)) static int fill_image_quantized_from_signal(const ei_impulse_t *impulse, matrix_i8_t *features, float scale,
+                                                                    float zero_point, void *user_data) {
+#if EIDSP_SPEECHPY_FIXED_POINT == 1
+    if (impulse->dsp_blocks[0].extract_fn == extract_mfe_features) {
+        return extract_mfe_features_quantized((signal_t*)user_data, features, impulse->dsp_blocks[0].config, scale, zero_point,
+            impulse->frequency);
+    }
+    if (impulse->dsp_blocks[0].extract_fn == extract_spectrogram_features) {
+        return extract_spectrogram_features_quantized((signal_t*)user_data, features, impulse->dsp_blocks[0].config, scale,
+            zero_point, impulse->frequency);
+    }
+#endif // EIDSP_SPEECHPY_FIXED_POINT == 1
+    return extract_image_features_quantized((signal_t*)user_data, features, impulse->dsp_blocks[0].config, scale, zero_point,
+        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+}
 #endif // (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
+/**
+ * Whether the only DSP block of the impulse is an MFE or spectrogram block that can run through
+ * the fixed point features (EIDSP_SPEECHPY_FIXED_POINT), see fill_image_quantized_from_signal()
+ */
+__attribute__((unused)) static bool can_run_fixed_point_features(const ei_impulse_t *impulse) {
+#if EIDSP_SPEECHPY_FIXED_POINT == 1 && (EI_CLASSIFIER_QUANTIZATION_ENABLED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
+    // only the TFLite engines fill the input tensor through fill_image_quantized_from_signal()
+    if (impulse->inferencing_engine != EI_CLASSIFIER_TFLITE || impulse->dsp_blocks_size != 1) {
+        return false;
+    }
+
+    const ei_model_dsp_t *block = &impulse->dsp_blocks[0];
+    speechpy::fixed_point_features_config_t fixed;
+    if (block->extract_fn == extract_mfe_features) {
+        fixed = fixed_point_config_mfe((ei_dsp_config_mfe_t*)block->config, impulse->frequency);
+    }
+    else if (block->extract_fn == extract_spectrogram_features) {
+        fixed = fixed_point_config_spectrogram((ei_dsp_config_spectrogram_t*)block->config, impulse->frequency);
+    }
+    else {
+        return false;
+    }
+    return speechpy::fixed_point_features_supported(&fixed);
+#else
+    (void)impulse;
+    return false;
+#endif
+}
+
 /**
  * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
  */
@@ -1383,9 +1724,39 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_STREAMS; ix++) {
+        delete ei_dsp_cont_streams[ix].stream;
+        ei_dsp_cont_streams[ix].stream = nullptr;
+        ei_dsp_cont_streams[ix].owner = nullptr;
+        ei_dsp_cont_streams[ix].config = nullptr;
+    }
+#endif
+
     return EIDSP_OK;
 }
 
+/**
+ * Release the continuous audio streams of owner (see extract_audio_stream_features()),
+ * so a retired impulse handle doesn't hold on to its slots. Streams of other owners
+ * are left alone.
+ */
+__attribute__((unused)) static void ei_dsp_clear_continuous_audio_streams(const void *owner) {
+#if EI_CLASSIFIER_CONTINUOUS_AUDIO_STREAMING
+    for (size_t ix = 0; ix < EI_DSP_CONTINUOUS_MAX_STREAMS; ix++) {
+        if (ei_dsp_cont_streams[ix].owner != owner) {
+            continue;
+        }
+        delete ei_dsp_cont_streams[ix].stream;
+        ei_dsp_cont_streams[ix].stream = nullptr;
+        ei_dsp_cont_streams[ix].owner = nullptr;
+        ei_dsp_cont_streams[ix].config = nullptr;
+    }
+#else
+    (void)owner;
+#endif
+}
+
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
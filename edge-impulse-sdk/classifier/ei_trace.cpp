@@ -0,0 +1,383 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/classifier/ei_trace.h"
+
+#if EI_CLASSIFIER_TRACE == 1
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#define EI_TRACE_RING_MASK      (EI_TRACE_RING_EVENTS - 1)
+#define EI_TRACE_NO_NAME        0xffff
+
+namespace {
+
+typedef struct {
+    // total events written by the owner thread, slot is head & mask
+    std::atomic<uint32_t> head;
+    const char *thread_name;
+    ei_trace_event_t events[EI_TRACE_RING_EVENTS];
+} ei_trace_ring_t;
+
+ei_trace_ring_t rings[EI_TRACE_MAX_THREADS];
+std::atomic<uint32_t> rings_claimed(0);
+std::atomic<uint32_t> events_dropped(0);
+
+thread_local ei_trace_ring_t *thread_ring = nullptr;
+thread_local bool thread_ring_full = false;
+
+ei_trace_ring_t *get_thread_ring() {
+    if (thread_ring == nullptr && !thread_ring_full) {
+        uint32_t ix = rings_claimed.fetch_add(1, std::memory_order_relaxed);
+        if (ix < EI_TRACE_MAX_THREADS) {
+            thread_ring = &rings[ix];
+        }
+        else {
+            rings_claimed.store(EI_TRACE_MAX_THREADS, std::memory_order_relaxed);
+            thread_ring_full = true;
+        }
+    }
+    return thread_ring;
+}
+
+uint32_t ring_count() {
+    uint32_t n = rings_claimed.load(std::memory_order_acquire);
+    return n > EI_TRACE_MAX_THREADS ? EI_TRACE_MAX_THREADS : n;
+}
+
+/**
+ * Copy event 'ix' of a ring, false if the owner overwrote (or is overwriting)
+ * it in the meantime
+ */
+bool read_event(ei_trace_ring_t *ring, uint32_t ix, ei_trace_event_t *out) {
+    *out = ring->events[ix & EI_TRACE_RING_MASK];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    return (head - ix) < EI_TRACE_RING_EVENTS;
+}
+
+uint32_t ring_first(uint32_t head) {
+    return head > EI_TRACE_RING_EVENTS ? head - EI_TRACE_RING_EVENTS : 0;
+}
+
+// rebuild the 64-bit timestamp, valid for events of the last ~71 minutes
+uint64_t unwrap_ts(uint64_t now, uint32_t ts_us) {
+    return now - (uint32_t)((uint32_t)now - ts_us);
+}
+
+class TraceWriter {
+public:
+    TraceWriter(ei_trace_write_fn_t write_fn, void *ctx) : _write_fn(write_fn), _ctx(ctx), _len(0) { }
+
+    ~TraceWriter() {
+        flush();
+    }
+
+    void write(const void *data, size_t len) {
+        const uint8_t *bytes = (const uint8_t *)data;
+        while (len > 0) {
+            size_t n = sizeof(_buffer) - _len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(_buffer + _len, bytes, n);
+            _len += n;
+            bytes += n;
+            len -= n;
+            if (_len == sizeof(_buffer)) {
+                flush();
+            }
+        }
+    }
+
+    void write_str(const char *str) {
+        write(str, strlen(str));
+    }
+
+    void write_u8(uint8_t v) {
+        write(&v, 1);
+    }
+
+    void write_u16(uint16_t v) {
+        uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+        write(b, sizeof(b));
+    }
+
+    void write_u32(uint32_t v) {
+        uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+        write(b, sizeof(b));
+    }
+
+    void flush() {
+        if (_len > 0) {
+            _write_fn(_buffer, _len, _ctx);
+            _len = 0;
+        }
+    }
+
+private:
+    ei_trace_write_fn_t _write_fn;
+    void *_ctx;
+    uint8_t _buffer[128];
+    size_t _len;
+};
+
+class TraceNames {
+public:
+    TraceNames() : _count(0) { }
+
+    // returns the index of the name, adding it if there's room
+    uint16_t add(const char *name) {
+        uint16_t ix = find(name);
+        if (ix == EI_TRACE_NO_NAME && _count < EI_TRACE_MAX_NAMES) {
+            _names[_count] = name;
+            ix = _count++;
+        }
+        return ix;
+    }
+
+    uint16_t find(const char *name) const {
+        if (name == nullptr) {
+            return EI_TRACE_NO_NAME;
+        }
+        for (uint16_t ix = 0; ix < _count; ix++) {
+            if (_names[ix] == name || strcmp(_names[ix], name) == 0) {
+                return ix;
+            }
+        }
+        return EI_TRACE_NO_NAME;
+    }
+
+    uint16_t count() const {
+        return _count;
+    }
+
+    const char *get(uint16_t ix) const {
+        return _names[ix];
+    }
+
+private:
+    const char *_names[EI_TRACE_MAX_NAMES];
+    uint16_t _count;
+};
+
+} // namespace
+
+volatile bool ei_trace_enabled = false;
+
+void ei_trace_enable(bool enable) {
+    ei_trace_enabled = enable;
+}
+
+void ei_trace_record(const char *name, int16_t arg, uint8_t phase) {
+    ei_trace_ring_t *ring = get_thread_ring();
+    if (ring == nullptr) {
+        events_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    ei_trace_event_t *event = &ring->events[head & EI_TRACE_RING_MASK];
+    event->ts_us = (uint32_t)ei_read_timer_us();
+    event->name = name;
+    event->arg = arg;
+    event->phase = phase;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void ei_trace_set_thread_name(const char *name) {
+    ei_trace_ring_t *ring = get_thread_ring();
+    if (ring != nullptr) {
+        ring->thread_name = name;
+    }
+}
+
+void ei_trace_clear() {
+    for (uint32_t ix = 0; ix < ring_count(); ix++) {
+        rings[ix].head.store(0, std::memory_order_release);
+    }
+    events_dropped.store(0, std::memory_order_relaxed);
+}
+
+void ei_trace_stats(uint32_t *recorded, uint32_t *dropped) {
+    uint32_t total = 0;
+    uint32_t lost = events_dropped.load(std::memory_order_relaxed);
+    for (uint32_t ix = 0; ix < ring_count(); ix++) {
+        uint32_t head = rings[ix].head.load(std::memory_order_acquire);
+        total += head;
+        lost += ring_first(head);
+    }
+    if (recorded) {
+        *recorded = total;
+    }
+    if (dropped) {
+        *dropped = lost;
+    }
+}
+
+size_t ei_trace_export_chrome_json(ei_trace_write_fn_t write_fn, void *ctx) {
+    TraceWriter writer(write_fn, ctx);
+    char line[160];
+    size_t written = 0;
+    bool first = true;
+    uint64_t now = ei_read_timer_us();
+
+    writer.write_str("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (uint32_t tid = 0; tid < ring_count(); tid++) {
+        ei_trace_ring_t *ring = &rings[tid];
+
+        if (ring->thread_name) {
+            snprintf(line, sizeof(line),
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",", (unsigned)tid, ring->thread_name);
+            writer.write_str(line);
+            first = false;
+        }
+
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+        for (uint32_t ix = ring_first(head); ix < head; ix++) {
+            ei_trace_event_t event;
+            if (!read_event(ring, ix, &event)) {
+                continue;
+            }
+
+            int len = snprintf(line, sizeof(line),
+                "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+                first ? "" : ",", event.name ? event.name : "?", (char)event.phase,
+                (unsigned long long)unwrap_ts(now, event.ts_us), (unsigned)tid);
+            if (event.arg >= 0 && len > 0 && len < (int)sizeof(line)) {
+                snprintf(line + len, sizeof(line) - len, ",\"args\":{\"ix\":%d}", (int)event.arg);
+            }
+            writer.write_str(line);
+            writer.write_str("}");
+            first = false;
+            written++;
+        }
+    }
+
+    writer.write_str("\n]}\n");
+    return written;
+}
+
+size_t ei_trace_export_binary(ei_trace_write_fn_t write_fn, void *ctx) {
+    TraceWriter writer(write_fn, ctx);
+    TraceNames names;
+    uint32_t heads[EI_TRACE_MAX_THREADS];
+    uint32_t threads = ring_count();
+    size_t written = 0;
+
+    // only export up to the current head, so every name is in the table
+    for (uint32_t tid = 0; tid < threads; tid++) {
+        ei_trace_ring_t *ring = &rings[tid];
+        heads[tid] = ring->head.load(std::memory_order_acquire);
+        if (ring->thread_name) {
+            names.add(ring->thread_name);
+        }
+        for (uint32_t ix = ring_first(heads[tid]); ix < heads[tid]; ix++) {
+            ei_trace_event_t event;
+            if (read_event(ring, ix, &event)) {
+                names.add(event.name);
+            }
+        }
+    }
+
+    writer.write("EITR", 4);
+    writer.write_u8(1);
+    writer.write_u8((uint8_t)threads);
+    writer.write_u16(names.count());
+    for (uint16_t ix = 0; ix < names.count(); ix++) {
+        size_t len = strlen(names.get(ix));
+        if (len > 255) {
+            len = 255;
+        }
+        writer.write_u8((uint8_t)len);
+        writer.write(names.get(ix), len);
+    }
+
+    for (uint32_t tid = 0; tid < threads; tid++) {
+        ei_trace_ring_t *ring = &rings[tid];
+        uint16_t thread_name = names.find(ring->thread_name);
+
+        // skip the events the owner thread overwrote since the head was read
+        uint32_t first = ring_first(heads[tid]);
+        ei_trace_event_t event;
+        while (first < heads[tid] && !read_event(ring, first, &event)) {
+            first++;
+        }
+
+        writer.write_u8((uint8_t)tid);
+        writer.write_u8(thread_name == EI_TRACE_NO_NAME ? 0xff : (uint8_t)thread_name);
+        writer.write_u32(heads[tid] - first);
+
+        for (uint32_t ix = first; ix < heads[tid]; ix++) {
+            if (!read_event(ring, ix, &event)) {
+                // overwritten while exporting, written with phase 0 to keep the count
+                event.ts_us = 0;
+                event.name = nullptr;
+                event.arg = -1;
+                event.phase = 0;
+            }
+            writer.write_u32(event.ts_us);
+            writer.write_u16(names.find(event.name));
+            writer.write_u16((uint16_t)event.arg);
+            writer.write_u8(event.phase);
+            written++;
+        }
+    }
+
+    return written;
+}
+
+#if EI_PORTING_POSIX == 1
+static void ei_trace_write_file(const void *data, size_t len, void *ctx) {
+    fwrite(data, 1, len, (FILE *)ctx);
+}
+
+int ei_trace_write_chrome_json_file(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) {
+        ei_printf("ERR: Failed to open trace file %s\n", path);
+        return -1;
+    }
+    ei_trace_export_chrome_json(&ei_trace_write_file, f);
+    int res = ferror(f) ? -1 : 0;
+    fclose(f);
+    return res;
+}
+#endif // EI_PORTING_POSIX == 1
+
+#endif // EI_CLASSIFIER_TRACE == 1
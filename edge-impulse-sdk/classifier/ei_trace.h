@@ -0,0 +1,211 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_TRACE_H_
+#define _EI_TRACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+/**
+ * Event trace of the inference path (run_classifier stages, every DSP block,
+ * every node of the compiled model and the postprocessing blocks), exported
+ * as Chrome trace JSON (chrome://tracing, ui.perfetto.dev) or as a compact
+ * binary stream for devices that flush over a serial console or network.
+ *
+ * Every thread that records gets its own ring buffer, so recording takes no
+ * lock: the owner thread is the only writer, the oldest events are
+ * overwritten once the ring is full. Compiled out unless EI_CLASSIFIER_TRACE
+ * is 1, and a single load of ei_trace_enabled when compiled in but disabled.
+ */
+
+#ifndef EI_CLASSIFIER_TRACE
+#define EI_CLASSIFIER_TRACE                 0
+#endif
+
+// events per thread, power of two
+#ifndef EI_TRACE_RING_EVENTS
+#define EI_TRACE_RING_EVENTS                512
+#endif
+
+// threads that can record, events from any further thread are dropped
+#ifndef EI_TRACE_MAX_THREADS
+#define EI_TRACE_MAX_THREADS                4
+#endif
+
+// distinct event names in one export
+#ifndef EI_TRACE_MAX_NAMES
+#define EI_TRACE_MAX_NAMES                  64
+#endif
+
+#if EI_CLASSIFIER_TRACE == 1
+
+#if (EI_TRACE_RING_EVENTS & (EI_TRACE_RING_EVENTS - 1)) != 0
+#error "EI_TRACE_RING_EVENTS must be a power of two"
+#endif
+
+#define EI_TRACE_PHASE_BEGIN                'B'
+#define EI_TRACE_PHASE_END                  'E'
+
+typedef struct {
+    uint32_t ts_us;         // low 32 bits of ei_read_timer_us()
+    const char *name;       // string literal, only the pointer is stored
+    int16_t arg;            // block / node index, -1 when unused
+    uint8_t phase;          // EI_TRACE_PHASE_BEGIN or EI_TRACE_PHASE_END
+} ei_trace_event_t;
+
+/**
+ * Sink for the exporters, called with consecutive chunks of the output
+ */
+typedef void (*ei_trace_write_fn_t)(const void *data, size_t len, void *ctx);
+
+extern volatile bool ei_trace_enabled;
+
+/**
+ * Start or stop recording, the rings keep their events
+ */
+void ei_trace_enable(bool enable);
+
+/**
+ * Append an event to the ring of the calling thread
+ */
+void ei_trace_record(const char *name, int16_t arg, uint8_t phase);
+
+/**
+ * Name shown for the calling thread in the Chrome trace (string literal)
+ */
+void ei_trace_set_thread_name(const char *name);
+
+/**
+ * Drop all recorded events. Only call while no thread is recording.
+ */
+void ei_trace_clear();
+
+/**
+ * Number of events recorded and of events lost (ring overwrites, too many
+ * threads) since the last ei_trace_clear()
+ */
+void ei_trace_stats(uint32_t *recorded, uint32_t *dropped);
+
+/**
+ * Write the events as Chrome trace JSON ({"traceEvents": [...]}), one "B" /
+ * "E" pair per stage. Safe while other threads record; events overwritten
+ * during the export are skipped.
+ * @returns number of events written
+ */
+size_t ei_trace_export_chrome_json(ei_trace_write_fn_t write_fn, void *ctx);
+
+/**
+ * Write the events in the binary format:
+ *   "EITR", u8 version (1), u8 thread count, u16 name count
+ *   names:   u8 length, bytes
+ *   threads: u8 thread id, u8 name index (0xff: unnamed), u32 event count
+ *   events:  u32 ts_us, u16 name index, i16 arg, u8 phase
+ * Little endian, packed (9 bytes per event). Events overwritten during the
+ * export have phase 0.
+ * @returns number of events written
+ */
+size_t ei_trace_export_binary(ei_trace_write_fn_t write_fn, void *ctx);
+
+#if EI_PORTING_POSIX == 1
+/**
+ * Write the Chrome trace JSON to a file
+ * @returns 0 on success
+ */
+int ei_trace_write_chrome_json_file(const char *path);
+#endif
+
+namespace ei {
+
+/**
+ * Records begin on construction and end when leaving the scope, so early
+ * returns still close the event
+ */
+class EiTraceScope {
+public:
+    EiTraceScope(const char *name, int16_t arg = -1) : _name(name), _arg(arg) {
+        _active = ei_trace_enabled;
+        if (_active) {
+            ei_trace_record(_name, _arg, EI_TRACE_PHASE_BEGIN);
+        }
+    }
+
+    ~EiTraceScope() {
+        end();
+    }
+
+    // close the event before the end of the scope
+    void end() {
+        if (_active) {
+            ei_trace_record(_name, _arg, EI_TRACE_PHASE_END);
+            _active = false;
+        }
+    }
+
+    EiTraceScope(const EiTraceScope&) = delete;
+    EiTraceScope& operator=(const EiTraceScope&) = delete;
+
+private:
+    const char *_name;
+    int16_t _arg;
+    bool _active;
+};
+
+} // namespace ei
+
+#define EI_TRACE_CONCAT_(a, b)              a##b
+#define EI_TRACE_CONCAT(a, b)               EI_TRACE_CONCAT_(a, b)
+
+#define EI_TRACE_SCOPE(name, arg) \
+    ei::EiTraceScope EI_TRACE_CONCAT(_ei_trace_scope_, __LINE__)(name, arg)
+#define EI_TRACE_SCOPE_VAR(var, name, arg) \
+    ei::EiTraceScope var(name, arg)
+#define EI_TRACE_SCOPE_END(var)             var.end()
+#define EI_TRACE_BEGIN(name, arg) \
+    do { if (ei_trace_enabled) { ei_trace_record(name, arg, EI_TRACE_PHASE_BEGIN); } } while (0)
+#define EI_TRACE_END(name, arg) \
+    do { if (ei_trace_enabled) { ei_trace_record(name, arg, EI_TRACE_PHASE_END); } } while (0)
+
+#else
+
+#define EI_TRACE_SCOPE(name, arg)           do { } while (0)
+#define EI_TRACE_SCOPE_VAR(var, name, arg)  do { } while (0)
+#define EI_TRACE_SCOPE_END(var)             do { } while (0)
+#define EI_TRACE_BEGIN(name, arg)           do { } while (0)
+#define EI_TRACE_END(name, arg)             do { } while (0)
+
+#endif // EI_CLASSIFIER_TRACE == 1
+
+#endif // _EI_TRACE_H_
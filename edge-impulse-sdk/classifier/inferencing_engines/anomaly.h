@@ -47,63 +47,7 @@
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/engines.h"
-
-#ifdef __cplusplus
-namespace {
-#endif // __cplusplus
-
-/**
- * Standard scaler, scales all values in the input vector
- * Note that this *modifies* the array in place!
- * @param input Array of input values
- * @param scale Array of scale values (obtain from StandardScaler in Python)
- * @param mean Array of mean values (obtain from StandardScaler in Python)
- * @param input_size Size of input, scale and mean arrays
- */
-void standard_scaler(float *input, const float *scale, const float *mean, size_t input_size) {
-    for (size_t ix = 0; ix < input_size; ix++) {
-        input[ix] = (input[ix] - mean[ix]) / scale[ix];
-    }
-}
-
-/**
- * Calculate the distance between input vector and the cluster
- * @param input Array of input values (already scaled by standard_scaler)
- * @param input_size Size of the input array
- * @param cluster A cluster (number of centroids should match input_size)
- */
-float calculate_cluster_distance(float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
-    // todo: check input_size and centroid size?
-
-    float dist = 0.0f;
-    for (size_t ix = 0; ix < input_size; ix++) {
-        dist += pow(input[ix] - cluster->centroid[ix], 2);
-    }
-    return sqrt(dist) - cluster->max_error;
-}
-
-/**
- * Get minimum distance to a cluster
- * @param input Array of input values (already scaled by standard_scaler)
- * @param input_size Size of the input array
- * @param clusters Array of clusters
- * @param cluster_size Size of cluster array
- */
-float get_min_distance_to_cluster(float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
-    float min = 1000.0f;
-    for (size_t ix = 0; ix < cluster_size; ix++) {
-        float dist = calculate_cluster_distance(input, input_size, &clusters[ix]);
-        if (dist < min) {
-            min = dist;
-        }
-    }
-    return min;
-}
-
-#ifdef __cplusplus
-}
-#endif // __cplusplus
-
+#include "edge-impulse-sdk/classifier/inferencing_engines/anomaly_kmeans.h"
 
 /**
  * Extracts the input values from the feature matrix based on the anomaly axes.
@@ -181,17 +125,21 @@ EI_IMPULSE_ERROR run_kmeans_anomaly(
 
     uint64_t anomaly_start_us = ei_read_timer_us();
 
-    float *input = (float*)ei_malloc(block_config->anom_axes_size * sizeof(float));
-    if (!input) {
-        ei_printf("Failed to allocate memory for anomaly input buffer");
-        return EI_IMPULSE_OUT_OF_MEMORY;
+    // prepared once per block: reciprocal scales, contiguous centroids, input buffer
+    ei::EiDspCacheLock plan_lock;
+    ei_kmeans_plan_t temp_plan;
+    ei_kmeans_plan_t *plan = kmeans_get_plan(block_config);
+    if (!plan) {
+        if (!kmeans_plan_init(&temp_plan, block_config)) {
+            ei_printf("Failed to allocate memory for anomaly input buffer");
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
+        plan = &temp_plan;
     }
 
-    extract_anomaly_input_values(fmatrix, input_block_ids, input_block_ids_size, block_config->anom_axes_size, block_config->anom_axis, input);
+    extract_anomaly_input_values(fmatrix, input_block_ids, input_block_ids_size, block_config->anom_axes_size, block_config->anom_axis, plan->input);
 
-    standard_scaler(input, block_config->anom_scale, block_config->anom_mean, block_config->anom_axes_size);
-    float anomaly = get_min_distance_to_cluster(
-        input, block_config->anom_axes_size, block_config->anom_clusters, block_config->anom_cluster_count);
+    float anomaly = kmeans_plan_score(plan);
 
     uint64_t anomaly_end_us = ei_read_timer_us();
 
@@ -204,7 +152,9 @@ EI_IMPULSE_ERROR run_kmeans_anomaly(
     result->timing.anomaly_us = anomaly_end_us - anomaly_start_us;
     result->timing.anomaly = (int)(result->timing.anomaly_us/1000);
     result->anomaly = anomaly;
-    ei_free(input);
+    if (plan == &temp_plan) {
+        kmeans_plan_free(&temp_plan);
+    }
 
     return EI_IMPULSE_OK;
 }
@@ -235,11 +185,20 @@ EI_IMPULSE_ERROR run_gmm_anomaly(
         .graph_config = block_config->graph_config
     };
 
-    std::unique_ptr<ei::matrix_t> matrix_ptr(new ei::matrix_t(1, block_config->anom_axes_size));
-    std::unique_ptr<ei_feature_t[]> input_ptr(new ei_feature_t[1]);
-    ei_feature_t* input = input_ptr.get();
+    // input matrix is kept between calls (reallocated when the block size changes)
+    static std::unique_ptr<ei::matrix_t> gmm_input_matrix;
+    if (!gmm_input_matrix || gmm_input_matrix->cols != block_config->anom_axes_size) {
+        gmm_input_matrix.reset(new ei::matrix_t(1, block_config->anom_axes_size));
+        if (!gmm_input_matrix->buffer) {
+            gmm_input_matrix.reset();
+            ei_printf("Failed to allocate memory for anomaly input buffer");
+            return EI_IMPULSE_OUT_OF_MEMORY;
+        }
+    }
 
-    input[0].matrix = matrix_ptr.get();
+    ei_feature_t input[1];
+    memset(input, 0, sizeof(input));
+    input[0].matrix = gmm_input_matrix.get();
     input[0].blockId = 0;
 
     extract_anomaly_input_values(fmatrix, input_block_ids, input_block_ids_size, block_config->anom_axes_size, block_config->anom_axis, input[0].matrix->buffer);
@@ -0,0 +1,392 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EDGE_IMPULSE_INFERENCING_ANOMALY_KMEANS_H_
+#define _EDGE_IMPULSE_INFERENCING_ANOMALY_KMEANS_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+
+#if EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD == 1
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EI_ANOMALY_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define EI_ANOMALY_SIMD_NEON 1
+#endif
+#endif // EI_CLASSIFIER_ANOMALY_ENABLE_HOST_SIMD == 1
+
+// Number of K-means blocks whose prepared clusters are kept around
+#ifndef EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS
+#define EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS      2
+#endif // EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS
+
+// Vectors are padded (with zeros) to a multiple of this many floats
+#define EI_ANOMALY_KMEANS_ALIGN_FLOATS              8
+
+#ifdef __cplusplus
+namespace {
+#endif // __cplusplus
+
+/**
+ * Standard scaler, scales all values in the input vector
+ * Note that this *modifies* the array in place!
+ * @param input Array of input values
+ * @param scale Array of scale values (obtain from StandardScaler in Python)
+ * @param mean Array of mean values (obtain from StandardScaler in Python)
+ * @param input_size Size of input, scale and mean arrays
+ */
+void standard_scaler(float *input, const float *scale, const float *mean, size_t input_size) {
+    for (size_t ix = 0; ix < input_size; ix++) {
+        input[ix] = (input[ix] - mean[ix]) / scale[ix];
+    }
+}
+
+/**
+ * Calculate the distance between input vector and the cluster
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param input_size Size of the input array
+ * @param cluster A cluster (number of centroids should match input_size)
+ */
+float calculate_cluster_distance(float *input, size_t input_size, const ei_classifier_anom_cluster_t *cluster) {
+    // todo: check input_size and centroid size?
+
+    float dist = 0.0f;
+    for (size_t ix = 0; ix < input_size; ix++) {
+        dist += pow(input[ix] - cluster->centroid[ix], 2);
+    }
+    return sqrt(dist) - cluster->max_error;
+}
+
+/**
+ * Get minimum distance to a cluster
+ * @param input Array of input values (already scaled by standard_scaler)
+ * @param input_size Size of the input array
+ * @param clusters Array of clusters
+ * @param cluster_size Size of cluster array
+ */
+float get_min_distance_to_cluster(float *input, size_t input_size, const ei_classifier_anom_cluster_t *clusters, size_t cluster_size) {
+    float min = 1000.0f;
+    for (size_t ix = 0; ix < cluster_size; ix++) {
+        float dist = calculate_cluster_distance(input, input_size, &clusters[ix]);
+        if (dist < min) {
+            min = dist;
+        }
+    }
+    return min;
+}
+
+/**
+ * Squared distance kernels. `count` is a multiple of EI_ANOMALY_KMEANS_ALIGN_FLOATS,
+ * both vectors are aligned to it. The kernels stop early (and return the partial
+ * sum) once the sum reaches `limit`, as the cluster can't be the closest anymore.
+ */
+typedef struct {
+    const char *name;
+    float (*squared_distance)(const float *a, const float *b, size_t count, float limit);
+} ei_anomaly_kernels_t;
+
+float anomaly_squared_distance_scalar(const float *a, const float *b, size_t count, float limit) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (size_t ix = 0; ix < count; ix += 8) {
+        float d0 = a[ix + 0] - b[ix + 0];
+        float d1 = a[ix + 1] - b[ix + 1];
+        float d2 = a[ix + 2] - b[ix + 2];
+        float d3 = a[ix + 3] - b[ix + 3];
+        float d4 = a[ix + 4] - b[ix + 4];
+        float d5 = a[ix + 5] - b[ix + 5];
+        float d6 = a[ix + 6] - b[ix + 6];
+        float d7 = a[ix + 7] - b[ix + 7];
+        s0 += d0 * d0 + d4 * d4;
+        s1 += d1 * d1 + d5 * d5;
+        s2 += d2 * d2 + d6 * d6;
+        s3 += d3 * d3 + d7 * d7;
+        if ((ix & 15) == 8 && (s0 + s1) + (s2 + s3) >= limit) {
+            break;
+        }
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+const ei_anomaly_kernels_t anomaly_scalar_kernels = { "scalar", anomaly_squared_distance_scalar };
+
+#if defined(EI_ANOMALY_SIMD_X86)
+
+inline float anomaly_hsum_sse(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse2")))
+float anomaly_squared_distance_sse(const float *a, const float *b, size_t count, float limit) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t ix = 0; ix < count; ix += 8) {
+        __m128 d0 = _mm_sub_ps(_mm_load_ps(a + ix), _mm_load_ps(b + ix));
+        __m128 d1 = _mm_sub_ps(_mm_load_ps(a + ix + 4), _mm_load_ps(b + ix + 4));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+        if ((ix & 31) == 24 && anomaly_hsum_sse(_mm_add_ps(acc0, acc1)) >= limit) {
+            break;
+        }
+    }
+    return anomaly_hsum_sse(_mm_add_ps(acc0, acc1));
+}
+
+__attribute__((target("avx2,fma")))
+float anomaly_squared_distance_avx2(const float *a, const float *b, size_t count, float limit) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t ix = 0;
+    for (; ix + 16 <= count; ix += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a + ix), _mm256_load_ps(b + ix));
+        __m256 d1 = _mm256_sub_ps(_mm256_load_ps(a + ix + 8), _mm256_load_ps(b + ix + 8));
+        acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+        acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+        if ((ix & 63) == 48) {
+            __m256 s = _mm256_add_ps(acc0, acc1);
+            float sum = anomaly_hsum_sse(_mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+            if (sum >= limit) {
+                return sum;
+            }
+        }
+    }
+    if (ix < count) {
+        __m256 d0 = _mm256_sub_ps(_mm256_load_ps(a + ix), _mm256_load_ps(b + ix));
+        acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    }
+    __m256 s = _mm256_add_ps(acc0, acc1);
+    return anomaly_hsum_sse(_mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+}
+
+const ei_anomaly_kernels_t anomaly_sse_kernels = { "sse2", anomaly_squared_distance_sse };
+const ei_anomaly_kernels_t anomaly_avx2_kernels = { "avx2", anomaly_squared_distance_avx2 };
+
+inline const ei_anomaly_kernels_t *anomaly_detect_kernels() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return &anomaly_avx2_kernels;
+    }
+    return &anomaly_sse_kernels;
+}
+
+#elif defined(EI_ANOMALY_SIMD_NEON)
+
+float anomaly_squared_distance_neon(const float *a, const float *b, size_t count, float limit) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t ix = 0; ix < count; ix += 8) {
+        float32x4_t d0 = vsubq_f32(vld1q_f32(a + ix), vld1q_f32(b + ix));
+        float32x4_t d1 = vsubq_f32(vld1q_f32(a + ix + 4), vld1q_f32(b + ix + 4));
+        acc0 = vfmaq_f32(acc0, d0, d0);
+        acc1 = vfmaq_f32(acc1, d1, d1);
+        if ((ix & 31) == 24 && vaddvq_f32(vaddq_f32(acc0, acc1)) >= limit) {
+            break;
+        }
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1));
+}
+
+const ei_anomaly_kernels_t anomaly_neon_kernels = { "neon", anomaly_squared_distance_neon };
+
+inline const ei_anomaly_kernels_t *anomaly_detect_kernels() {
+    return &anomaly_neon_kernels;
+}
+
+#else
+
+inline const ei_anomaly_kernels_t *anomaly_detect_kernels() {
+    return &anomaly_scalar_kernels;
+}
+
+#endif // EI_ANOMALY_SIMD_X86 / EI_ANOMALY_SIMD_NEON
+
+inline const ei_anomaly_kernels_t *anomaly_get_kernels() {
+    static const ei_anomaly_kernels_t *kernels = anomaly_detect_kernels();
+    return kernels;
+}
+
+/**
+ * K-means block prepared for scoring: reciprocal scales, the centroids in one
+ * contiguous (padded, aligned) matrix, and the input buffer reused between calls.
+ */
+typedef struct {
+    const ei_learning_block_config_anomaly_kmeans_t *config;
+    size_t axes;
+    size_t stride;              // axes rounded up to EI_ANOMALY_KMEANS_ALIGN_FLOATS
+    size_t clusters;
+    float *inv_scale;
+    float *mean;
+    float *input;               // write the (unscaled) features here, see kmeans_plan_score()
+    float *centroids;           // clusters x stride
+    float *max_error;
+    size_t last_best;           // scanned first, consecutive samples tend to hit the same cluster
+    uint64_t skipped;           // distances cut short, for profiling
+    void *buffer;
+} ei_kmeans_plan_t;
+
+/**
+ * Prepare a K-means block for kmeans_plan_score()
+ * @return false when out of memory
+ */
+bool kmeans_plan_init(ei_kmeans_plan_t *plan, const ei_learning_block_config_anomaly_kmeans_t *config) {
+    const size_t align = EI_ANOMALY_KMEANS_ALIGN_FLOATS;
+    const size_t axes = config->anom_axes_size;
+    const size_t stride = (axes + align - 1) / align * align;
+    const size_t clusters = config->anom_cluster_count;
+
+    memset(plan, 0, sizeof(ei_kmeans_plan_t));
+    plan->buffer = ei_aligned_calloc(align * sizeof(float),
+        (3 * stride + clusters * stride + clusters) * sizeof(float));
+    if (!plan->buffer) {
+        return false;
+    }
+
+    plan->config = config;
+    plan->axes = axes;
+    plan->stride = stride;
+    plan->clusters = clusters;
+    plan->inv_scale = (float*)plan->buffer;
+    plan->mean = plan->inv_scale + stride;
+    plan->input = plan->mean + stride;
+    plan->centroids = plan->input + stride;
+    plan->max_error = plan->centroids + clusters * stride;
+
+    // padding stays zero, so it adds nothing to the distances
+    for (size_t ix = 0; ix < axes; ix++) {
+        plan->inv_scale[ix] = 1.0f / config->anom_scale[ix];
+        plan->mean[ix] = config->anom_mean[ix];
+    }
+    for (size_t cx = 0; cx < clusters; cx++) {
+        memcpy(plan->centroids + cx * stride, config->anom_clusters[cx].centroid, axes * sizeof(float));
+        plan->max_error[cx] = config->anom_clusters[cx].max_error;
+    }
+    return true;
+}
+
+void kmeans_plan_free(ei_kmeans_plan_t *plan) {
+    if (plan->buffer) {
+        ei_aligned_free(plan->buffer);
+    }
+    memset(plan, 0, sizeof(ei_kmeans_plan_t));
+}
+
+/**
+ * Scale plan->input and return the distance to the closest cluster, like
+ * standard_scaler() + get_min_distance_to_cluster() (up to float rounding).
+ * Clusters are skipped as soon as their partial distance shows they can't beat
+ * the closest one found so far.
+ */
+float kmeans_plan_score(ei_kmeans_plan_t *plan) {
+    float *input = plan->input;
+    for (size_t ix = 0; ix < plan->stride; ix++) {
+        input[ix] = (input[ix] - plan->mean[ix]) * plan->inv_scale[ix];
+    }
+
+    const ei_anomaly_kernels_t *kernels = anomaly_get_kernels();
+    float min = 1000.0f;
+    const size_t first = plan->last_best < plan->clusters ? plan->last_best : 0;
+    size_t best = first;
+
+    for (size_t ix = 0; ix < plan->clusters; ix++) {
+        // start at the last closest cluster, for a tight bound early on
+        size_t cx = ix == 0 ? first : (ix <= first ? ix - 1 : ix);
+        const float max_error = plan->max_error[cx];
+
+        // sqrt(d) - max_error < min  <=>  d < (min + max_error)^2
+        const float bound = min + max_error;
+        if (bound <= 0.0f) {
+            plan->skipped++;
+            continue;
+        }
+        const float limit = bound * bound;
+        const float d = kernels->squared_distance(input, plan->centroids + cx * plan->stride, plan->stride, limit);
+        if (d >= limit) {
+            plan->skipped++;
+            continue;
+        }
+        const float dist = sqrtf(d) - max_error;
+        if (dist < min) {
+            min = dist;
+            best = cx;
+        }
+    }
+
+    plan->last_best = best;
+    return min;
+}
+
+/**
+ * Prepared plan of a K-means block, created on first use. nullptr when out of
+ * memory or all EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS slots are taken.
+ * Hold an ei::EiDspCacheLock until done with the plan, its input buffer and
+ * last_best are written while scoring.
+ */
+ei_kmeans_plan_t *kmeans_get_plan(const ei_learning_block_config_anomaly_kmeans_t *config) {
+    static ei_kmeans_plan_t plans[EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS];
+
+    for (size_t ix = 0; ix < EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS; ix++) {
+        if (plans[ix].config == config) {
+            return &plans[ix];
+        }
+    }
+    for (size_t ix = 0; ix < EI_CLASSIFIER_ANOMALY_KMEANS_MAX_PLANS; ix++) {
+        if (!plans[ix].config) {
+            return kmeans_plan_init(&plans[ix], config) ? &plans[ix] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Name of the squared distance kernel ("avx2", "sse2", "neon" or "scalar")
+ */
+const char *kmeans_kernels_name() {
+    return anomaly_get_kernels()->name;
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _EDGE_IMPULSE_INFERENCING_ANOMALY_KMEANS_H_
@@ -41,9 +41,73 @@
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
 
+#define EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE          1
+#define EI_CLASSIFIER_HAS_ARENA_ALLOCATOR           1
+
+// Allocator of the model arena (heap allocated models only)
+static void *(*eon_arena_alloc)(size_t, size_t) = ei_aligned_calloc;
+static void (*eon_arena_free)(void*) = ei_aligned_free;
+
+// When set the model stays initialized between inferences (arena, persistent
+// buffers and prepared kernels), e.g. when running over many tiles of a frame.
+static bool eon_keep_alive = false;
+static ei_config_tflite_eon_graph_t *eon_graph_alive = nullptr;
+
+/**
+ * Keep the model initialized between inferences, or release it
+ *
+ * @param      keep_alive  true to keep the arena around after the next inference,
+ *                         false to free it (immediately if it was kept)
+ */
+__attribute__((unused)) static void inference_tflite_keep_alive(bool keep_alive) {
+    eon_keep_alive = keep_alive;
+    if (!keep_alive && eon_graph_alive) {
+        eon_graph_alive->model_reset(eon_arena_free);
+        eon_graph_alive = nullptr;
+    }
+}
+
+/**
+ * Whether the model is kept initialized between inferences, so a caller that
+ * enables inference_tflite_keep_alive() for a batch can restore the state after
+ */
+__attribute__((unused)) static bool inference_tflite_get_keep_alive() {
+    return eon_keep_alive;
+}
+
+/**
+ * Allocate the model arena through other functions, e.g. to time-multiplex one
+ * buffer between several impulses (see ei_run_classifier_scheduler.h). A model
+ * that is kept alive is released first.
+ *
+ * @param      alloc_fnc  Allocator (alignment, size), nullptr for the heap
+ * @param      free_fnc   Matching free function, nullptr for the heap
+ */
+__attribute__((unused)) static void inference_tflite_set_arena_allocator(
+    void *(*alloc_fnc)(size_t, size_t),
+    void (*free_fnc)(void*)) {
+    if (eon_graph_alive) {
+        eon_graph_alive->model_reset(eon_arena_free);
+        eon_graph_alive = nullptr;
+    }
+    eon_arena_alloc = alloc_fnc ? alloc_fnc : ei_aligned_calloc;
+    eon_arena_free = free_fnc ? free_fnc : ei_aligned_free;
+}
+
+/**
+ * Release the model after an inference, unless it's kept alive
+ */
+static TfLiteStatus inference_tflite_reset(ei_config_tflite_eon_graph_t *graph_config) {
+    if (eon_keep_alive) {
+        return kTfLiteOk;
+    }
+    return graph_config->model_reset(eon_arena_free);
+}
+
 /**
  * Setup the TFLite runtime
  *
@@ -65,10 +129,22 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 
     *ctx_start_us = ei_read_timer_us();
 
-    TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc);
-    if (init_status != kTfLiteOk) {
-        ei_printf("Failed to initialize the model (error code %d)\n", init_status);
-        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    if (eon_graph_alive != graph_config) {
+        // another graph was kept alive (multiple learn blocks), release it first
+        if (eon_graph_alive) {
+            eon_graph_alive->model_reset(eon_arena_free);
+            eon_graph_alive = nullptr;
+        }
+
+        TfLiteStatus init_status = graph_config->model_init(eon_arena_alloc);
+        if (init_status != kTfLiteOk) {
+            ei_printf("Failed to initialize the model (error code %d)\n", init_status);
+            return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+
+        if (eon_keep_alive) {
+            eon_graph_alive = graph_config;
+        }
     }
 
     TfLiteStatus status;
@@ -111,7 +187,10 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
-    if (graph_config->model_invoke() != kTfLiteOk) {
+    EI_TRACE_BEGIN("invoke", -1);
+    TfLiteStatus invoke_status = graph_config->model_invoke();
+    EI_TRACE_END("invoke", -1);
+    if (invoke_status != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -129,6 +208,75 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Copy the output tensors into the raw outputs of the result, as one scratch
+ * block per output (freed by run_postprocessing())
+ */
+static EI_IMPULSE_ERROR inference_tflite_copy_outputs(
+    ei_learning_block_config_tflite_graph_t *block_config,
+    TfLiteTensor *outputs,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result) {
+
+    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
+        TfLiteTensor* output = &outputs[output_ix];
+        ei_feature_t *raw_output = &result->_raw_outputs[learn_block_index + output_ix];
+        // calculate the size of the output by iterating through dims
+        size_t output_size = 1;
+        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
+            output_size *= output->dims->data[dim_num];
+        }
+
+        switch (output->type) {
+            case kTfLiteFloat32: {
+                if (!ei_feature_scratch_matrix<matrix_t, float>(raw_output, 1, output_size)) {
+                    return EI_IMPULSE_ALLOC_FAILED;
+                }
+                memcpy(raw_output->matrix->buffer, output->data.f, output->bytes);
+                break;
+            }
+            case kTfLiteInt8: {
+                if (block_config->dequantize_output) {
+                    if (!ei_feature_scratch_matrix<matrix_t, float>(raw_output, 1, output_size)) {
+                        return EI_IMPULSE_ALLOC_FAILED;
+                    }
+                    fill_output_matrix_from_tensor(output, raw_output->matrix);
+                }
+                else {
+                    if (!ei_feature_scratch_matrix<matrix_i8_t, int8_t>(raw_output, 1, output_size)) {
+                        return EI_IMPULSE_ALLOC_FAILED;
+                    }
+                    memcpy(raw_output->matrix_i8->buffer, output->data.int8, output->bytes);
+                }
+                break;
+            }
+            case kTfLiteUInt8: {
+                if (block_config->dequantize_output) {
+                    if (!ei_feature_scratch_matrix<matrix_t, float>(raw_output, 1, output_size)) {
+                        return EI_IMPULSE_ALLOC_FAILED;
+                    }
+                    fill_output_matrix_from_tensor(output, raw_output->matrix);
+                }
+                else {
+                    if (!ei_feature_scratch_matrix<matrix_u8_t, uint8_t>(raw_output, 1, output_size)) {
+                        return EI_IMPULSE_ALLOC_FAILED;
+                    }
+                    memcpy(raw_output->matrix_u8->buffer, output->data.uint8, output->bytes);
+                }
+                break;
+            }
+            default: {
+                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
+                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
+            }
+        }
+
+        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * @brief      Do neural network inferencing over a signal (from the DSP)
  *
@@ -153,6 +301,10 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
+    // the graph config of a DSP block only lives for this call, never keep it alive
+    const bool keep_alive = eon_keep_alive;
+    eon_keep_alive = false;
+
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
         &ctx_start_us,
@@ -160,6 +312,8 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         &outputs,
         p_tensor_arena);
 
+    eon_keep_alive = keep_alive;
+
     if (init_res != EI_IMPULSE_OK) {
         return init_res;
     }
@@ -179,7 +333,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    if (graph_config->model_reset(ei_aligned_free) != kTfLiteOk) {
+    if (graph_config->model_reset(eon_arena_free) != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
     ei_free(outputs);
@@ -212,8 +366,12 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor input;
     TfLiteTensor *outputs;
 
-    // allocate outputs
-    outputs = (TfLiteTensor*)ei_malloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    // allocate outputs, from the scratch arena while process_impulse() has a scope open
+    outputs = (TfLiteTensor*)ei::ei_dsp_scratch_calloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    if (!outputs) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+    ei_unique_ptr_t p_outputs(outputs, ei::ei_dsp_scratch_free);
 
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
@@ -250,53 +408,12 @@ EI_IMPULSE_ERROR run_nn_inference(
         &outputs,
         tensor_arena, result, debug);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
-
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
-
-        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    EI_IMPULSE_ERROR output_res = inference_tflite_copy_outputs(block_config, outputs, learn_block_index, result);
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
     }
 
-    graph_config->model_reset(ei_aligned_free);
-    ei_free(outputs);
+    inference_tflite_reset(graph_config);
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -306,14 +423,17 @@ EI_IMPULSE_ERROR run_nn_inference(
 }
 
 #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
+#define EI_CLASSIFIER_HAS_IMAGE_QUANTIZED_FILL      1
+
 /**
- * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
- * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
- * returns EI_IMPULSE_OK.
+ * Run the classifier on an image impulse with a quantized input, the input tensor is written by
+ * 'fill_fn' (with the input scale and zero point) instead of going through a features matrix.
+ * This only works if 'can_run_classifier_image_quantized' returns EI_IMPULSE_OK.
  */
-EI_IMPULSE_ERROR run_nn_inference_image_quantized(
+EI_IMPULSE_ERROR run_nn_inference_image_quantized_fill(
     const ei_impulse_t *impulse,
-    signal_t *signal,
+    ei_fill_image_quantized_fn_t fill_fn,
+    void *fill_user_data,
     uint32_t learn_block_index,
     ei_impulse_result_t *result,
     void *config_ptr,
@@ -326,8 +446,12 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     TfLiteTensor input;
     TfLiteTensor *outputs;
 
-    // allocate outputs
-    outputs = (TfLiteTensor*)ei_malloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    // allocate outputs, from the scratch arena while process_impulse() has a scope open
+    outputs = (TfLiteTensor*)ei::ei_dsp_scratch_calloc(block_config->output_tensors_size * sizeof(TfLiteTensor));
+    if (!outputs) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+    ei_unique_ptr_t p_outputs(outputs, ei::ei_dsp_scratch_free);
 
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
@@ -352,8 +476,9 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input.data.int8);
 
     // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input.params.scale, input.params.zero_point,
-        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    EI_TRACE_BEGIN("dsp", -1);
+    int ret = fill_fn(impulse, &features_matrix, input.params.scale, input.params.zero_point, fill_user_data);
+    EI_TRACE_END("dsp", -1);
 
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -387,53 +512,12 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         result,
         debug);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
-
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
-
-        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    EI_IMPULSE_ERROR output_res = inference_tflite_copy_outputs(block_config, outputs, learn_block_index, result);
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
     }
 
-    graph_config->model_reset(ei_aligned_free);
-    ei_free(outputs);
+    inference_tflite_reset(graph_config);
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -441,6 +525,23 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     return EI_IMPULSE_OK;
 }
+
+/**
+ * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
+ * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
+ * returns EI_IMPULSE_OK.
+ */
+EI_IMPULSE_ERROR run_nn_inference_image_quantized(
+    const ei_impulse_t *impulse,
+    signal_t *signal,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    return run_nn_inference_image_quantized_fill(impulse, fill_image_quantized_from_signal, signal, learn_block_index,
+        result, config_ptr, debug);
+}
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 
 __attribute__((unused)) int extract_tflite_eon_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
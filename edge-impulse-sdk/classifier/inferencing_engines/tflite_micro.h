@@ -46,6 +46,7 @@
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
@@ -88,6 +89,207 @@
 #define DEFINE_SECTION(x) __attribute__((section(x)))
 #endif
 
+#define EI_CLASSIFIER_HAS_MEMORY_PLAN_CACHE         1
+#define EI_CLASSIFIER_HAS_ARENA_ALLOCATOR           1
+#define EI_CLASSIFIER_HAS_MODEL_KEEP_ALIVE          1
+#define EI_CLASSIFIER_HAS_TFLITE_SESSION            1
+
+// Keep the interpreter of the learn block (arena, planned tensors and prepared
+// kernels) between inferences by default, instead of building it on every call.
+// Can also be toggled at runtime with inference_tflite_session().
+#ifndef EI_CLASSIFIER_TFLITE_KEEP_SESSION
+#define EI_CLASSIFIER_TFLITE_KEEP_SESSION           0
+#endif
+
+// Allocator of the interpreter arena (unless EI_CLASSIFIER_ALLOCATION_STATIC)
+static void *(*tflite_arena_alloc)(size_t, size_t) = ei_aligned_calloc;
+static void (*tflite_arena_free)(void*) = ei_aligned_free;
+
+/**
+ * Interpreter that is kept between inferences. While it's alive the raw outputs
+ * of the learn block are views into its arena (or into 'dequantized'), they're
+ * valid until the next inference or until the session is released.
+ */
+typedef struct {
+    ei_config_tflite_graph_t *graph_config;
+    tflite::MicroInterpreter *interpreter;
+    void *profiler;
+    uint8_t *arena;
+    void (*arena_free)(void*);      // nullptr for the static arena
+    float *dequantized;             // dequantized outputs
+    size_t dequantized_size;        // in floats
+} ei_tflite_session_t;
+
+static ei_tflite_session_t tflite_session = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0 };
+static bool tflite_session_enabled = EI_CLASSIFIER_TFLITE_KEEP_SESSION == 1;
+// set for a batch of inferences (tiles, crops), see inference_tflite_keep_alive()
+static bool tflite_keep_alive = false;
+
+/**
+ * Release the kept interpreter and its arena (no-op if there's none)
+ */
+__attribute__((unused)) static void inference_tflite_release_session() {
+    if (!tflite_session.interpreter) {
+        return;
+    }
+    delete tflite_session.interpreter;
+#ifdef EI_CLASSIFIER_ENABLE_PROFILER
+    delete (tflite::MicroProfiler*)tflite_session.profiler;
+#endif
+    if (tflite_session.arena_free) {
+        tflite_session.arena_free(tflite_session.arena);
+    }
+    if (tflite_session.dequantized) {
+        ei_free(tflite_session.dequantized);
+    }
+    tflite_session = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0 };
+}
+
+/**
+ * Keep the interpreter of the learn block alive between all inferences, or
+ * release it. Overrides EI_CLASSIFIER_TFLITE_KEEP_SESSION.
+ *
+ * @param      enable  true to keep the session after the next inference,
+ *                     false to free it (immediately if it was kept)
+ */
+__attribute__((unused)) static void inference_tflite_session(bool enable) {
+    tflite_session_enabled = enable;
+    if (!enable && !tflite_keep_alive) {
+        inference_tflite_release_session();
+    }
+}
+
+/**
+ * Keep the model initialized between inferences, or release it (unless the
+ * session is enabled with inference_tflite_session())
+ *
+ * @param      keep_alive  true to keep the arena around after the next inference,
+ *                         false to free it (immediately if it was kept)
+ */
+__attribute__((unused)) static void inference_tflite_keep_alive(bool keep_alive) {
+    tflite_keep_alive = keep_alive;
+    if (!keep_alive && !tflite_session_enabled) {
+        inference_tflite_release_session();
+    }
+}
+
+/**
+ * Whether the model is kept initialized between inferences, so a caller that
+ * enables inference_tflite_keep_alive() for a batch can restore the state after
+ */
+__attribute__((unused)) static bool inference_tflite_get_keep_alive() {
+    return tflite_keep_alive;
+}
+
+/**
+ * Allocate the interpreter arena through other functions, e.g. to time-multiplex
+ * one buffer between several impulses (see ei_run_classifier_scheduler.h). A
+ * session that is kept alive is released first.
+ *
+ * @param      alloc_fnc  Allocator (alignment, size), nullptr for the heap
+ * @param      free_fnc   Matching free function, nullptr for the heap
+ */
+__attribute__((unused)) static void inference_tflite_set_arena_allocator(
+    void *(*alloc_fnc)(size_t, size_t),
+    void (*free_fnc)(void*)) {
+    inference_tflite_release_session();
+    tflite_arena_alloc = alloc_fnc ? alloc_fnc : ei_aligned_calloc;
+    tflite_arena_free = free_fnc ? free_fnc : ei_aligned_free;
+}
+
+/**
+ * Free the interpreter after an inference, unless it's the kept session
+ */
+static void inference_tflite_reset(tflite::MicroInterpreter *interpreter, void *micro_profiler) {
+    if (interpreter == tflite_session.interpreter) {
+        return;
+    }
+    delete interpreter;
+#ifdef EI_CLASSIFIER_ENABLE_PROFILER
+    delete (tflite::MicroProfiler*)micro_profiler;
+#endif
+}
+
+// Size of the buffer that holds the arena memory plan of the model (28 bytes + 16 bytes
+// per planned tensor or scratch buffer), set to 0 to plan the arena on every inference
+#ifndef EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE
+#define EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE 2048
+#endif
+
+/**
+ * Time spent in inference_tflite_setup (interpreter creation and AllocateTensors)
+ * and in Invoke
+ */
+typedef struct {
+    uint64_t cold_start_us;     // first setup since boot
+    uint64_t planned_setup_us;  // last setup that ran the memory planner
+    uint64_t cached_setup_us;   // last setup that used the cached memory plan
+    bool memory_plan_cached;    // whether the last setup used the cached memory plan
+    uint64_t last_setup_us;     // last setup, ~0 if it reused the session
+    uint64_t last_invoke_us;    // last Invoke
+    bool session_reused;        // whether the last setup reused the session
+} ei_tflite_setup_timing_t;
+
+static ei_tflite_setup_timing_t tflite_setup_timing = { 0, 0, 0, false, 0, 0, false };
+
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+// The plan is kept for the first model that runs (the learn block), TFLite models
+// used by DSP blocks are planned on every inference.
+static uint32_t tflite_memory_plan_buffer[EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE / 4];
+static tflite::MicroMemoryPlanCache tflite_memory_plan_cache(
+    (uint8_t*)tflite_memory_plan_buffer, sizeof(tflite_memory_plan_buffer));
+static const unsigned char *tflite_memory_plan_model = nullptr;
+static bool tflite_memory_plan_enabled = true;
+#endif
+
+/**
+ * Get the memory plan of the model, e.g. to store it in flash and load it with
+ * inference_tflite_load_memory_plan() after the next boot
+ *
+ * @param      data  Serialized plan
+ * @param      size  Size of the plan in bytes
+ *
+ * @return     false if there's no plan (yet)
+ */
+__attribute__((unused)) static bool inference_tflite_get_memory_plan(const uint8_t **data, size_t *size) {
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+    if (!tflite_memory_plan_cache.IsValid()) {
+        return false;
+    }
+    *data = tflite_memory_plan_cache.data();
+    *size = tflite_memory_plan_cache.size();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Load a memory plan stored earlier. The plan is checked against a hash of the
+ * model and against the buffers the kernels request, a stale plan is dropped
+ * and the arena is planned again.
+ *
+ * @param      data  Serialized plan from inference_tflite_get_memory_plan()
+ * @param      size  Size of the plan in bytes
+ *
+ * @return     false if the plan is malformed, too large or for another model
+ */
+__attribute__((unused)) static bool inference_tflite_load_memory_plan(const uint8_t *data, size_t size) {
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+    return tflite_memory_plan_cache.Load(data, size);
+#else
+    return false;
+#endif
+}
+
+/**
+ * Get the setup times with and without the cached memory plan or session, and
+ * the last invoke time
+ */
+__attribute__((unused)) static const ei_tflite_setup_timing_t *inference_tflite_get_setup_timing() {
+    return &tflite_setup_timing;
+}
+
 /**
  * Setup the TFLite runtime
  *
@@ -112,18 +314,45 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 
     ei_config_tflite_graph_t *graph_config = (ei_config_tflite_graph_t*)block_config->graph_config;
 
+    if (tflite_session.interpreter && tflite_session.graph_config == graph_config) {
+        tflite::MicroInterpreter *interpreter = tflite_session.interpreter;
+        *micro_interpreter = interpreter;
+#ifdef EI_CLASSIFIER_ENABLE_PROFILER
+        *micro_profiler = tflite_session.profiler;
+#endif
+        *input = interpreter->input(0);
+        for (uint8_t i = 0; i < block_config->output_tensors_size; i++) {
+            outputs[i] = interpreter->output(block_config->output_tensors_indices[i]);
+        }
+        tflite_setup_timing.session_reused = true;
+        tflite_setup_timing.last_setup_us = ei_read_timer_us() - *ctx_start_us;
+        return EI_IMPULSE_OK;
+    }
+
+    // only the learn block keeps its session, graphs that run from a DSP block
+    // (session disabled by the caller) get a temporary interpreter next to it
+    const bool keep_session = tflite_session_enabled || tflite_keep_alive;
+#ifdef EI_CLASSIFIER_ALLOCATION_STATIC
+    // ... unless they'd share the static arena
+    inference_tflite_release_session();
+#else
+    if (keep_session) {
+        inference_tflite_release_session();
+    }
+#endif
+
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
     // Assign a no-op lambda to the "free" function in case of static arena
     static uint8_t tensor_arena[EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE] ALIGN(16) DEFINE_SECTION(STRINGIZE_VALUE_OF(EI_TENSOR_ARENA_LOCATION));
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, [](void*){});
 #else
     // Create an area of memory to use for input, output, and intermediate arrays.
-    uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc(16, graph_config->arena_size);
+    uint8_t *tensor_arena = (uint8_t*)tflite_arena_alloc(16, graph_config->arena_size);
     if (tensor_arena == NULL) {
         ei_printf("Failed to allocate TFLite arena (%zu bytes)\n", graph_config->arena_size);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
-    p_tensor_arena = ei_unique_ptr_t(tensor_arena, ei_aligned_free);
+    p_tensor_arena = ei_unique_ptr_t(tensor_arena, tflite_arena_free);
 #endif
 
     static bool tflite_first_run = true;
@@ -174,18 +403,60 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
         model, resolver, tensor_arena, graph_config->arena_size, nullptr, nullptr);
 
-    micro_profiler = nullptr;
+    *micro_profiler = nullptr;
 #endif
 
     *micro_interpreter = interpreter;
 
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+    if (tflite_memory_plan_enabled && tflite_memory_plan_model == nullptr) {
+        tflite_memory_plan_model = graph_config->model;
+        tflite_memory_plan_cache.SetModelHash(
+            tflite::MicroMemoryPlanCache::HashModel(graph_config->model, graph_config->model_size));
+    }
+    if (tflite_memory_plan_enabled && tflite_memory_plan_model == graph_config->model) {
+        interpreter->SetMemoryPlanCache(&tflite_memory_plan_cache);
+    }
+#endif
+
     // Allocate memory from the tensor_arena for the model's tensors.
     TfLiteStatus allocate_status = interpreter->AllocateTensors(true);
     if (allocate_status != kTfLiteOk) {
         ei_printf("AllocateTensors() failed");
+        inference_tflite_reset(interpreter, *micro_profiler);
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
+    if (keep_session) {
+        // the session owns the arena from now on
+        tflite_session.graph_config = graph_config;
+        tflite_session.interpreter = interpreter;
+        tflite_session.profiler = *micro_profiler;
+        tflite_session.arena = tensor_arena;
+#ifdef EI_CLASSIFIER_ALLOCATION_STATIC
+        tflite_session.arena_free = nullptr;
+#else
+        tflite_session.arena_free = tflite_arena_free;
+#endif
+        (void)p_tensor_arena.release();
+    }
+
+    uint64_t setup_us = ei_read_timer_us() - *ctx_start_us;
+    tflite_setup_timing.session_reused = false;
+    tflite_setup_timing.last_setup_us = setup_us;
+    if (tflite_setup_timing.cold_start_us == 0) {
+        tflite_setup_timing.cold_start_us = setup_us;
+    }
+    tflite_setup_timing.memory_plan_cached = interpreter->used_cached_memory_plan();
+    if (tflite_setup_timing.memory_plan_cached) {
+        tflite_setup_timing.cached_setup_us = setup_us;
+    }
+    else {
+        tflite_setup_timing.planned_setup_us = setup_us;
+    }
+    EI_LOGD("TFLite setup took %u us (%s memory plan)\n", (unsigned int)setup_us,
+        tflite_setup_timing.memory_plan_cached ? "cached" : "new");
+
     // Obtain pointers to the model's input and output tensors.
     *input = interpreter->input(0);
     for (uint8_t i = 0; i < block_config->output_tensors_size; i++) {
@@ -217,15 +488,19 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     ei_impulse_result_t *result,
     void* micro_profiler) {
 
-    // Run inference, and report any error
+    uint64_t invoke_start_us = ei_read_timer_us();
+
+    // Run inference, and report any error (the caller frees the interpreter)
+    EI_TRACE_BEGIN("invoke", -1);
     TfLiteStatus invoke_status = interpreter->Invoke();
+    EI_TRACE_END("invoke", -1);
     if (invoke_status != kTfLiteOk) {
-        delete interpreter;
         ei_printf("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     uint64_t ctx_end_us = ei_read_timer_us();
+    tflite_setup_timing.last_invoke_us = ctx_end_us - invoke_start_us;
 
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
@@ -252,6 +527,107 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 }
 
 
+/**
+ * Store the output tensors of a learn block in the raw outputs of the result.
+ * Outputs of the kept session are views into its arena (dequantized outputs into
+ * a buffer of the session), valid until the next inference. Otherwise they're
+ * copied, as the arena is freed after the inference.
+ */
+static EI_IMPULSE_ERROR inference_tflite_fill_outputs(
+    const ei_impulse_t *impulse,
+    ei_learning_block_config_tflite_graph_t *block_config,
+    tflite::MicroInterpreter *interpreter,
+    TfLiteTensor *outputs,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result)
+{
+    // another learn block would release the session before these outputs are used
+    const bool views = interpreter == tflite_session.interpreter && impulse->learning_blocks_size == 1;
+
+    size_t dequantized_size = 0;
+    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
+        TfLiteTensor* output = &outputs[output_ix];
+        if (block_config->dequantize_output && output->type != kTfLiteFloat32) {
+            dequantized_size += output->bytes;
+        }
+    }
+    if (views && dequantized_size > tflite_session.dequantized_size) {
+        if (tflite_session.dequantized) {
+            ei_free(tflite_session.dequantized);
+        }
+        tflite_session.dequantized = (float*)ei_malloc(dequantized_size * sizeof(float));
+        if (!tflite_session.dequantized) {
+            tflite_session.dequantized_size = 0;
+            return EI_IMPULSE_ALLOC_FAILED;
+        }
+        tflite_session.dequantized_size = dequantized_size;
+    }
+    float *dequantized = tflite_session.dequantized;
+
+    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
+        TfLiteTensor* output = &outputs[output_ix];
+        ei_feature_t *raw_output = &result->_raw_outputs[learn_block_index + output_ix];
+        // calculate the size of the output by iterating through dims
+        size_t output_size = 1;
+        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
+            output_size *= output->dims->data[dim_num];
+        }
+
+        switch (output->type) {
+            case kTfLiteFloat32: {
+                if (views) {
+                    raw_output->matrix = new matrix_t(1, output_size, output->data.f);
+                }
+                else {
+                    raw_output->matrix = new matrix_t(1, output_size);
+                    memcpy(raw_output->matrix->buffer, output->data.f, output->bytes);
+                }
+                break;
+            }
+            case kTfLiteInt8:
+            case kTfLiteUInt8: {
+                if (block_config->dequantize_output) {
+                    if (views) {
+                        raw_output->matrix = new matrix_t(1, output_size, dequantized);
+                        dequantized += output_size;
+                    }
+                    else {
+                        raw_output->matrix = new matrix_t(1, output_size);
+                    }
+                    fill_output_matrix_from_tensor(output, raw_output->matrix);
+                }
+                else if (output->type == kTfLiteInt8) {
+                    if (views) {
+                        raw_output->matrix_i8 = new matrix_i8_t(1, output_size, output->data.int8);
+                    }
+                    else {
+                        raw_output->matrix_i8 = new matrix_i8_t(1, output_size);
+                        memcpy(raw_output->matrix_i8->buffer, output->data.int8, output->bytes);
+                    }
+                }
+                else {
+                    if (views) {
+                        raw_output->matrix_u8 = new matrix_u8_t(1, output_size, output->data.uint8);
+                    }
+                    else {
+                        raw_output->matrix_u8 = new matrix_u8_t(1, output_size);
+                        memcpy(raw_output->matrix_u8->buffer, output->data.uint8, output->bytes);
+                    }
+                }
+                break;
+            }
+            default: {
+                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
+                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
+            }
+        }
+
+        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
 /**
  * @brief      Do neural network inferencing over a signal (from the DSP)
  *
@@ -278,6 +654,16 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     void* profiler = nullptr;
 #endif
 
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+    // the plan cache is reserved for the learn block's model
+    tflite_memory_plan_enabled = false;
+#endif
+    // the graph config of a DSP block only lives for this call, never keep it alive
+    const bool session_enabled = tflite_session_enabled;
+    const bool keep_alive = tflite_keep_alive;
+    tflite_session_enabled = false;
+    tflite_keep_alive = false;
+
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         config,
         &ctx_start_us,
@@ -287,30 +673,37 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         p_tensor_arena,
         (void**)&profiler);
 
+    tflite_session_enabled = session_enabled;
+    tflite_keep_alive = keep_alive;
+#if EI_CLASSIFIER_TFLITE_MEMORY_PLAN_CACHE_SIZE > 0
+    tflite_memory_plan_enabled = true;
+#endif
+
     if (init_res != EI_IMPULSE_OK) {
         return init_res;
     }
 
     auto input_res = fill_input_tensor_from_signal(signal, input);
     if (input_res != EI_IMPULSE_OK) {
+        inference_tflite_reset(interpreter, profiler);
         return input_res;
     }
 
     // Run inference, and report any error
+    EI_TRACE_BEGIN("invoke", -1);
     TfLiteStatus invoke_status = interpreter->Invoke();
+    EI_TRACE_END("invoke", -1);
     if (invoke_status != kTfLiteOk) {
         ei_printf("Invoke failed (%d)\n", invoke_status);
+        inference_tflite_reset(interpreter, profiler);
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     auto output_res = fill_output_matrix_from_tensor(&outputs[0], output_matrix);
-    if (output_res != EI_IMPULSE_OK) {
-        return output_res;
-    }
 
-    delete interpreter;
+    inference_tflite_reset(interpreter, profiler);
 
-    return EI_IMPULSE_OK;
+    return output_res;
 }
 
 /**
@@ -367,6 +760,7 @@ EI_IMPULSE_ERROR run_nn_inference(
                                                    impulse->dsp_blocks_size,
                                                    impulse->learning_blocks_size);
     if (input_res != EI_IMPULSE_OK) {
+        inference_tflite_reset(interpreter, profiler);
         return input_res;
     }
 
@@ -376,53 +770,15 @@ EI_IMPULSE_ERROR run_nn_inference(
         result,
         profiler);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
+    EI_IMPULSE_ERROR output_res = inference_tflite_fill_outputs(
+        impulse, block_config, interpreter, outputs, learn_block_index, result);
 
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
+    inference_tflite_reset(interpreter, profiler);
 
-        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
     }
 
-    delete interpreter;
-
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
     }
@@ -430,15 +786,40 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Release the kept interpreter only if it runs a learn block of impulse, so
+ * deinitializing one impulse handle doesn't evict the session of another
+ */
+__attribute__((unused)) static void inference_tflite_release_session(const ei_impulse_t *impulse) {
+    if (!tflite_session.interpreter) {
+        return;
+    }
+    for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
+        const ei_learning_block_t *block = &impulse->learning_blocks[ix];
+        if (block->infer_fn != run_nn_inference) {
+            continue;
+        }
+        ei_learning_block_config_tflite_graph_t *block_config =
+            (ei_learning_block_config_tflite_graph_t*)block->config;
+        if (block_config->graph_config == tflite_session.graph_config) {
+            inference_tflite_release_session();
+            return;
+        }
+    }
+}
+
 #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
+#define EI_CLASSIFIER_HAS_IMAGE_QUANTIZED_FILL      1
+
 /**
- * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
- * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
- * returns EI_IMPULSE_OK.
+ * Run the classifier on an image impulse with a quantized input, the input tensor is written by
+ * 'fill_fn' (with the input scale and zero point) instead of going through a features matrix.
+ * This only works if 'can_run_classifier_image_quantized' returns EI_IMPULSE_OK.
  */
-EI_IMPULSE_ERROR run_nn_inference_image_quantized(
+EI_IMPULSE_ERROR run_nn_inference_image_quantized_fill(
     const ei_impulse_t *impulse,
-    signal_t *signal,
+    ei_fill_image_quantized_fn_t fill_fn,
+    void *fill_user_data,
     uint32_t learn_block_index,
     ei_impulse_result_t *result,
     void *config_ptr,
@@ -474,6 +855,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     }
 
     if (input->type != TfLiteType::kTfLiteInt8 && input->type != TfLiteType::kTfLiteUInt8) {
+        inference_tflite_reset(interpreter, profiler);
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
@@ -483,14 +865,17 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input->data.int8);
 
     // run DSP process and quantize automatically
-    int ret = extract_image_features_quantized(signal, &features_matrix, impulse->dsp_blocks[0].config, input->params.scale, input->params.zero_point,
-        impulse->frequency, impulse->learning_blocks[0].image_scaling);
+    EI_TRACE_BEGIN("dsp", -1);
+    int ret = fill_fn(impulse, &features_matrix, input->params.scale, input->params.zero_point, fill_user_data);
+    EI_TRACE_END("dsp", -1);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+        inference_tflite_reset(interpreter, profiler);
         return EI_IMPULSE_DSP_ERROR;
     }
 
     if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+        inference_tflite_reset(interpreter, profiler);
         return EI_IMPULSE_CANCELED;
     }
 
@@ -514,59 +899,38 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         result,
         profiler);
 
-    for (uint32_t output_ix = 0; output_ix < block_config->output_tensors_size; output_ix++) {
-        TfLiteTensor* output = &outputs[output_ix];
-        // calculate the size of the output by iterating through dims
-        size_t output_size = 1;
-        for (int dim_num = 0; dim_num < output->dims->size; dim_num++) {
-            output_size *= output->dims->data[dim_num];
-        }
+    EI_IMPULSE_ERROR output_res = inference_tflite_fill_outputs(
+        impulse, block_config, interpreter, outputs, learn_block_index, result);
 
-        switch (output->type) {
-            case kTfLiteFloat32: {
-                result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix->buffer, output->data.f, output->bytes);
-                break;
-            }
-            case kTfLiteInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_i8 = new matrix_i8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_i8->buffer, output->data.int8, output->bytes);
-                }
-                break;
-            }
-            case kTfLiteUInt8: {
-                if (block_config->dequantize_output) {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix = new matrix_t(1, output_size);
-                    fill_output_matrix_from_tensor(output, result->_raw_outputs[learn_block_index + output_ix].matrix);
-                }
-                else {
-                    result->_raw_outputs[learn_block_index + output_ix].matrix_u8 = new matrix_u8_t(1, output_size);
-                    memcpy(result->_raw_outputs[learn_block_index + output_ix].matrix_u8->buffer, output->data.uint8, output->bytes);
-                }
-                break;
-            }
-            default: {
-                ei_printf("ERR: Cannot handle output type (%d)\n", output->type);
-                return EI_IMPULSE_OUTPUT_TENSOR_WAS_NULL;
-            }
-        }
+    inference_tflite_reset(interpreter, profiler);
 
-        result->_raw_outputs[learn_block_index].blockId = block_config->block_id;
+    if (output_res != EI_IMPULSE_OK) {
+        return output_res;
     }
 
-    delete interpreter;
-
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
     }
 
     return EI_IMPULSE_OK;
 }
+
+/**
+ * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
+ * that allocates a lot less memory by quantizing in place. This only works if 'can_run_classifier_image_quantized'
+ * returns EI_IMPULSE_OK.
+ */
+EI_IMPULSE_ERROR run_nn_inference_image_quantized(
+    const ei_impulse_t *impulse,
+    signal_t *signal,
+    uint32_t learn_block_index,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    return run_nn_inference_image_quantized_fill(impulse, fill_image_quantized_from_signal, signal, learn_block_index,
+        result, config_ptr, debug);
+}
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 
 __attribute__((unused)) int extract_tflite_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
@@ -36,6 +36,7 @@
 #define EI_POSTPROCESSING_H
 
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
 
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
 #include "edge-impulse-sdk/classifier/postprocessing/ei_performance_calibration.h"
@@ -104,9 +105,11 @@ extern "C" EI_IMPULSE_ERROR run_postprocessing(ei_impulse_handle_t *handle,
     if (!handle) {
         return EI_IMPULSE_OUT_OF_MEMORY;
     }
+    EI_TRACE_SCOPE("postprocessing", -1);
     auto impulse = handle->impulse;
 
     for (size_t ix = 0; ix < impulse->postprocessing_blocks_size; ix++) {
+        EI_TRACE_SCOPE("postprocess_block", (int16_t)ix);
         void* state = NULL;
         if (handle->post_processing_state != NULL) {
             state = handle->post_processing_state[ix];
@@ -125,10 +128,7 @@ extern "C" EI_IMPULSE_ERROR run_postprocessing(ei_impulse_handle_t *handle,
 
     // free raw results
     for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
-        if (result->_raw_outputs[ix].matrix) {
-            delete result->_raw_outputs[ix].matrix;
-            result->_raw_outputs[ix].matrix = nullptr;
-        }
+        ei_feature_free_matrix(&result->_raw_outputs[ix]);
     }
 
     return EI_IMPULSE_OK;
@@ -87,6 +87,20 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
+// Store the weights of the sparse mel filterbank (speechpy/sparse_filterbank.h) as Q15
+// instead of float, halves its memory at a small loss in precision
+#ifndef EIDSP_SPARSE_FILTERBANK_INT16
+#define EIDSP_SPARSE_FILTERBANK_INT16 0
+#endif // EIDSP_SPARSE_FILTERBANK_INT16
+
+// Quantized (int8) models with one MFE or spectrogram block (version 3 and up) compute
+// their features in fixed point (speechpy/feature_fixed.h), straight into the input tensor.
+// A memory optimization only: it drops the float feature matrix (4 bytes per feature),
+// but is not faster than the float path (the spectrogram is slower), so it stays off
+#ifndef EIDSP_SPEECHPY_FIXED_POINT
+#define EIDSP_SPEECHPY_FIXED_POINT      0
+#endif // EIDSP_SPEECHPY_FIXED_POINT
+
 // prints buffer allocations to stdout, useful when debugging
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
@@ -98,9 +112,50 @@
 #define EIDSP_PRINT_ALLOCATIONS      1
 #endif
 
+// EI_DSP_MATRIX temporaries come from a LIFO scratch arena (ei_dsp_scratch.h) while
+// process_impulse() runs a DSP block, instead of a heap allocation per matrix
+// (ei_scratch_vector and the preemphasis buffers always use the arena)
+#ifndef EIDSP_SCRATCH_ARENA
+#define EIDSP_SCRATCH_ARENA          1
+#endif // EIDSP_SCRATCH_ARENA
+
+// Spread the axes of the spectral analysis block over both cores of the ESP32-S3,
+// needs the ESP-NN worker task (EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE=1)
+#ifndef EIDSP_SPECTRAL_MULTICORE
+#define EIDSP_SPECTRAL_MULTICORE     0
+#endif // EIDSP_SPECTRAL_MULTICORE
+
 #ifndef EIDSP_SIGNAL_C_FN_POINTER
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
 
+// SSE4.1/AVX2/NEON versions of the image resize and colour conversion functions
+// on desktop/Linux hosts, the instruction set is picked at runtime
+#ifndef EIDSP_IMAGE_ENABLE_HOST_SIMD
+#if (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)) && defined(__GNUC__)
+#define EIDSP_IMAGE_ENABLE_HOST_SIMD 1
+#else
+#define EIDSP_IMAGE_ENABLE_HOST_SIMD 0
+#endif
+#endif // EIDSP_IMAGE_ENABLE_HOST_SIMD
+
+// SSE2/NEON butterflies of the real FFT (fft/ei_rfft.cpp) on desktop/Linux hosts
+#ifndef EIDSP_FFT_ENABLE_HOST_SIMD
+#if (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)) && defined(__GNUC__)
+#define EIDSP_FFT_ENABLE_HOST_SIMD 1
+#else
+#define EIDSP_FFT_ENABLE_HOST_SIMD 0
+#endif
+#endif // EIDSP_FFT_ENABLE_HOST_SIMD
+
+// SSE2/NEON lanes of the IIR filter bank (filter/ei_filter_bank.cpp) on desktop/Linux hosts
+#ifndef EIDSP_FILTER_ENABLE_HOST_SIMD
+#if (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)) && defined(__GNUC__)
+#define EIDSP_FILTER_ENABLE_HOST_SIMD 1
+#else
+#define EIDSP_FILTER_ENABLE_HOST_SIMD 0
+#endif
+#endif // EIDSP_FILTER_ENABLE_HOST_SIMD
+
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
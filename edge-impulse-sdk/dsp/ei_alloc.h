@@ -82,6 +82,34 @@ template <class T, class U>
 bool operator==(const EiAlloc<T> &, const EiAlloc<U> &) { return true; }
 template <class T, class U>
 bool operator!=(const EiAlloc<T> &, const EiAlloc<U> &) { return false; }
+
+/**
+ * Allocator for the per-run temporaries of DSP blocks, from the DSP scratch
+ * arena while a scratch scope is open (see ei_dsp_scratch.h), else the heap
+ */
+template <class T>
+struct EiScratchAlloc
+{
+    typedef T value_type;
+    EiScratchAlloc() = default;
+    template <class U>
+    constexpr EiScratchAlloc(const EiScratchAlloc<U> &) noexcept {}
+
+    T *allocate(size_t n)
+    {
+        return (T *)ei_dsp_scratch_calloc(n * sizeof(T));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        ei_dsp_scratch_free(p);
+    }
+};
+
+template <class T, class U>
+bool operator==(const EiScratchAlloc<T> &, const EiScratchAlloc<U> &) { return true; }
+template <class T, class U>
+bool operator!=(const EiScratchAlloc<T> &, const EiScratchAlloc<U> &) { return false; }
 }
 
 #endif //!__EI_ALLOC__H__
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SCRATCH_H_
+#define _EIDSP_SCRATCH_H_
+
+// clang-format off
+#include <stddef.h>
+#include <stdint.h>
+#include "config.hpp"
+
+namespace ei {
+
+/**
+ * LIFO scratch arena for the per-run temporaries of DSP blocks (EI_DSP_MATRIX,
+ * ei_scratch_vector, EiDspScratchBuffer).
+ *
+ * process_impulse() opens a scope on the workspace's arena around every DSP
+ * block; inside it every temporary is a bump allocation, released in
+ * reverse order when it goes out of scope. Blocks that don't fit
+ * fall back to the heap, and their size still counts towards the peak, so
+ * the first run calibrates the arena: the next scope reallocates it to the
+ * largest peak seen and a steady-state DSP run does not touch the heap
+ * anymore. Outside of a scope the temporaries use the heap.
+ */
+typedef struct {
+    uint8_t *buffer;
+    size_t size;            // bytes in the arena
+    size_t top;             // bytes in use, from the start of the buffer
+    size_t last;            // offset of the last block, EI_DSP_SCRATCH_NONE when empty
+    size_t in_use;          // live bytes (arena and heap fallback) of the scope
+    size_t peak;            // arena bytes needed by the current or last scope (live bytes plus holes)
+    size_t required;        // largest peak seen, the size of the next reallocation
+    uint32_t heap_allocs;   // allocations that fell back to the heap in the scope
+} ei_dsp_scratch_arena_t;
+
+#define EI_DSP_SCRATCH_NONE     ((size_t)-1)
+
+/**
+ * Zero-initialize an arena, it allocates on the first scope (or ei_dsp_scratch_reserve())
+ */
+void ei_dsp_scratch_init(ei_dsp_scratch_arena_t *arena);
+
+/**
+ * Free the arena's buffer, only call while no scratch matrices are alive
+ */
+void ei_dsp_scratch_release(ei_dsp_scratch_arena_t *arena);
+
+/**
+ * Size the arena up front, e.g. from the peak of a calibration run on another handle
+ * @returns false if out of memory
+ */
+bool ei_dsp_scratch_reserve(ei_dsp_scratch_arena_t *arena, size_t bytes);
+
+/**
+ * Route the EI_DSP_MATRIX allocations of the calling thread to the arena, growing
+ * it to the largest peak seen first
+ * @returns false if a scope is already open on this thread (the outer one is kept)
+ */
+bool ei_dsp_scratch_begin(ei_dsp_scratch_arena_t *arena);
+
+/**
+ * Close the scope opened by ei_dsp_scratch_begin()
+ * @returns peak scratch bytes of the scope
+ */
+size_t ei_dsp_scratch_end(ei_dsp_scratch_arena_t *arena);
+
+/**
+ * Zeroed scratch memory, from the open scope's arena or the heap
+ */
+void *ei_dsp_scratch_calloc(size_t bytes);
+
+/**
+ * Release memory from ei_dsp_scratch_calloc()
+ */
+void ei_dsp_scratch_free(void *ptr);
+
+/**
+ * Opens a scratch scope for the lifetime of the object
+ */
+class EiDspScratchScope {
+public:
+    EiDspScratchScope(ei_dsp_scratch_arena_t *arena) : _arena(arena) {
+        _open = ei_dsp_scratch_begin(_arena);
+    }
+
+    ~EiDspScratchScope() {
+        end();
+    }
+
+    /**
+     * Close the scope early
+     * @returns peak scratch bytes of the scope, 0 if it was nested in another one
+     */
+    size_t end() {
+        size_t peak = 0;
+        if (_open) {
+            peak = ei_dsp_scratch_end(_arena);
+            _open = false;
+        }
+        return peak;
+    }
+
+    EiDspScratchScope(const EiDspScratchScope&) = delete;
+    EiDspScratchScope& operator=(const EiDspScratchScope&) = delete;
+
+private:
+    ei_dsp_scratch_arena_t *_arena;
+    bool _open;
+};
+
+} // namespace ei
+
+// clang-format on
+#endif // _EIDSP_SCRATCH_H_
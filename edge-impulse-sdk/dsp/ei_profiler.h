@@ -42,15 +42,50 @@ public:
     void reset()
     {
         timestamp = ei_read_timer_ms();
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+        ei_read_timer_sample(&start);
+#endif
     }
     void report(const char *message)
     {
         ei_printf("%s took %llu\r\n", message, ei_read_timer_ms() - timestamp);
-        timestamp = ei_read_timer_ms(); //read again to not count printf time
+        reset(); //read again to not count printf time
     }
 
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    /**
+     * Wall-clock, thread CPU time and (if enabled) hardware counters since the last reset
+     */
+    ei_timer_sample_t elapsed()
+    {
+        ei_timer_sample_t sample = { 0, 0, 0, 0, 0, false };
+        ei_timer_sample_accumulate(&start, &sample);
+        return sample;
+    }
+
+    /**
+     * Like report(), with every timing backend of the port
+     */
+    void report_all(const char *message)
+    {
+        ei_timer_sample_t sample = elapsed();
+        ei_printf("%s took %llu us wall, %llu us cpu", message,
+            (unsigned long long)sample.wall_us, (unsigned long long)sample.thread_cpu_us);
+        if (sample.counters_valid) {
+            ei_printf(", %llu cycles, %llu instructions, %llu cache misses",
+                (unsigned long long)sample.cycles, (unsigned long long)sample.instructions,
+                (unsigned long long)sample.cache_misses);
+        }
+        ei_printf("\r\n");
+        reset(); //read again to not count printf time
+    }
+#endif
+
 private:
     uint64_t timestamp;
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+    ei_timer_sample_t start;
+#endif
 };
 
 #endif  //!__EIPROFILER__H__
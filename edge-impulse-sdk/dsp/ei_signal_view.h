@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SIGNAL_VIEW_H_
+#define _EIDSP_SIGNAL_VIEW_H_
+
+// clang-format off
+#include <stddef.h>
+#include <stdint.h>
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+
+/**
+ * Typed signal sources: a signal_t over a uint8 image (RGB888, RGB565,
+ * grayscale) or int16 samples (mono, interleaved axes, or a window of a ring
+ * buffer) that keeps a signal_view_t of the buffer next to get_data(). Blocks
+ * that understand the layout read the buffer in place, every other block gets
+ * the same floats as from a hand written get_data():
+ *
+ *  - images: one float per pixel, packed as 0xRRGGBB
+ *  - int16: the sample, times axis_scale[axis] if set
+ */
+
+namespace ei {
+
+/**
+ * Number of samples in the view
+ */
+static inline size_t signal_view_length(const signal_view_t *view)
+{
+    return view->length + view->wrap_length;
+}
+
+/**
+ * Whether `signal` has a typed view of `format` that covers exactly its
+ * samples (signals resized by a wrapper or by stack_frames() fall back to
+ * get_data())
+ */
+static inline bool signal_has_view(const signal_t *signal, signal_view_format_t format)
+{
+    return signal->view.format == format && signal->view.data != nullptr &&
+        signal_view_length(&signal->view) == signal->total_length;
+}
+
+/**
+ * Bytes per sample of a view format
+ */
+static inline size_t signal_view_sample_size(signal_view_format_t format)
+{
+    switch (format) {
+        case SIGNAL_VIEW_RGB888: return 3;
+        case SIGNAL_VIEW_RGB565: return 2;
+        case SIGNAL_VIEW_GRAYSCALE: return 1;
+        case SIGNAL_VIEW_INT16: return sizeof(int16_t);
+        default: return 0;
+    }
+}
+
+/**
+ * Contiguous run of the view starting at sample `offset`
+ * @param ptr Out, first byte of sample `offset`
+ * @returns Number of samples in the run, 0 if `offset` is past the end
+ */
+static inline size_t signal_view_span(const signal_view_t *view, size_t offset, const uint8_t **ptr)
+{
+    const size_t sample_size = signal_view_sample_size(view->format);
+    if (offset < view->length) {
+        *ptr = (const uint8_t *)view->data + offset * sample_size;
+        return view->length - offset;
+    }
+    offset -= view->length;
+    if (offset < view->wrap_length) {
+        *ptr = (const uint8_t *)view->wrap + offset * sample_size;
+        return view->wrap_length - offset;
+    }
+    *ptr = nullptr;
+    return 0;
+}
+
+/**
+ * RGB565 pixel to R, G, B, 5 and 6 bit channels are expanded by repeating
+ * their top bits (as image::processing::rgb565_to_rgb888())
+ */
+static inline void signal_view_rgb565_to_rgb(const uint8_t *in, bool big_endian, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    const uint16_t v = big_endian ? (uint16_t)((in[0] << 8) | in[1]) : (uint16_t)((in[1] << 8) | in[0]);
+
+    *r = (uint8_t)(((v >> 8) & 0xf8) | (v >> 13));
+    *g = (uint8_t)(((v >> 3) & 0xfc) | ((v >> 9) & 0x03));
+    *b = (uint8_t)(((v << 3) & 0xf8) | ((v >> 2) & 0x07));
+}
+
+/**
+ * Whether `signal` has a typed view of an image format (RGB888, RGB565 or
+ * grayscale) that covers exactly its pixels
+ */
+static inline bool signal_has_image_view(const signal_t *signal)
+{
+    return signal_has_view(signal, SIGNAL_VIEW_RGB888) || signal_has_view(signal, SIGNAL_VIEW_RGB565) ||
+        signal_has_view(signal, SIGNAL_VIEW_GRAYSCALE);
+}
+
+/**
+ * Call fn(r, g, b) for `count` pixels of an image view from pixel `offset`,
+ * grayscale pixels give r = g = b
+ */
+template <typename F>
+static inline void signal_view_for_each_pixel(const signal_view_t *view, size_t offset, size_t count, F fn)
+{
+    while (count > 0) {
+        const uint8_t *in;
+        size_t run = signal_view_span(view, offset, &in);
+        if (run == 0) {
+            return;
+        }
+        run = run < count ? run : count;
+
+        switch (view->format) {
+            case SIGNAL_VIEW_RGB888:
+                for (size_t ix = 0; ix < run; ix++, in += 3) {
+                    fn(in[0], in[1], in[2]);
+                }
+                break;
+            case SIGNAL_VIEW_RGB565:
+                for (size_t ix = 0; ix < run; ix++, in += 2) {
+                    uint8_t r, g, b;
+                    signal_view_rgb565_to_rgb(in, view->big_endian, &r, &g, &b);
+                    fn(r, g, b);
+                }
+                break;
+            case SIGNAL_VIEW_GRAYSCALE:
+                for (size_t ix = 0; ix < run; ix++) {
+                    fn(in[ix], in[ix], in[ix]);
+                }
+                break;
+            default:
+                return;
+        }
+
+        offset += run;
+        count -= run;
+    }
+}
+
+/**
+ * get_data() of a typed signal, converts `length` samples from `offset` to float
+ */
+__attribute__((unused)) static int signal_view_get_data(const signal_view_t *view, size_t offset, size_t length, float *out_ptr)
+{
+    if (offset + length > signal_view_length(view)) {
+        return EIDSP_OUT_OF_BOUNDS;
+    }
+
+    if (view->format != SIGNAL_VIEW_INT16) {
+        if (signal_view_sample_size(view->format) == 0) {
+            return EIDSP_NOT_SUPPORTED;
+        }
+        signal_view_for_each_pixel(view, offset, length, [&out_ptr](uint32_t r, uint32_t g, uint32_t b) {
+            *out_ptr++ = static_cast<float>((r << 16) + (g << 8) + b);
+        });
+        return EIDSP_OK;
+    }
+
+    while (length > 0) {
+        const uint8_t *in;
+        size_t count = signal_view_span(view, offset, &in);
+        count = count < length ? count : length;
+        const int16_t *samples = (const int16_t *)in;
+
+        if (!view->axis_scale) {
+            for (size_t ix = 0; ix < count; ix++) {
+                out_ptr[ix] = static_cast<float>(samples[ix]);
+            }
+        }
+        else {
+            size_t axis = offset % view->axes;
+            for (size_t ix = 0; ix < count; ix++) {
+                out_ptr[ix] = static_cast<float>(samples[ix]) * view->axis_scale[axis];
+                axis = axis + 1 == view->axes ? 0 : axis + 1;
+            }
+        }
+
+        offset += count;
+        length -= count;
+        out_ptr += count;
+    }
+
+    return EIDSP_OK;
+}
+
+#if EIDSP_SIGNAL_C_FN_POINTER == 0
+
+/**
+ * Create a signal structure from a typed view, get_data() converts from the
+ * view. Keep the buffers behind the view alive while the signal is used.
+ * @returns EIDSP_OK if ok
+ */
+__attribute__((unused)) static int signal_from_view(const signal_view_t *view, signal_t *signal)
+{
+    if (!view->data || signal_view_sample_size(view->format) == 0 || view->axes == 0 ||
+            (view->wrap_length > 0 && !view->wrap)) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+
+    signal->view = *view;
+    signal->total_length = signal_view_length(view);
+#ifdef __MBED__
+    // refers to the view in the signal, don't copy the signal_t
+    signal->get_data = mbed::callback(&signal_view_get_data, &signal->view);
+#else
+    const signal_view_t v = *view;
+    signal->get_data = [v](size_t offset, size_t length, float *out_ptr) {
+        return signal_view_get_data(&v, offset, length, out_ptr);
+    };
+#endif
+    return EIDSP_OK;
+}
+
+/**
+ * Create a signal structure from an RGB888 frame (R, G, B bytes per pixel)
+ * @param data Frame, make sure to keep this pointer alive
+ * @param pixels Width * height
+ * @param signal Output signal
+ * @returns EIDSP_OK if ok
+ */
+__attribute__((unused)) static int signal_from_rgb888(const uint8_t *data, size_t pixels, signal_t *signal)
+{
+    signal_view_t view;
+    view.format = SIGNAL_VIEW_RGB888;
+    view.data = data;
+    view.length = pixels;
+    return signal_from_view(&view, signal);
+}
+
+/**
+ * Create a signal structure from an RGB565 frame
+ * @param big_endian High byte of every pixel first (as delivered by most camera drivers)
+ * @copydetails signal_from_rgb888()
+ */
+__attribute__((unused)) static int signal_from_rgb565(const uint8_t *data, size_t pixels, signal_t *signal, bool big_endian = true)
+{
+    signal_view_t view;
+    view.format = SIGNAL_VIEW_RGB565;
+    view.data = data;
+    view.length = pixels;
+    view.big_endian = big_endian;
+    return signal_from_view(&view, signal);
+}
+
+/**
+ * Create a signal structure from a grayscale frame (one byte per pixel)
+ * @copydetails signal_from_rgb888()
+ */
+__attribute__((unused)) static int signal_from_grayscale(const uint8_t *data, size_t pixels, signal_t *signal)
+{
+    signal_view_t view;
+    view.format = SIGNAL_VIEW_GRAYSCALE;
+    view.data = data;
+    view.length = pixels;
+    return signal_from_view(&view, signal);
+}
+
+/**
+ * Create a signal structure from int16 samples: mono PCM or interleaved axes
+ * (e.g. raw accelerometer / gyroscope readings)
+ * @param data Samples, make sure to keep this pointer alive
+ * @param length Number of samples (frames * axes)
+ * @param signal Output signal
+ * @param axes Interleaved axes per frame
+ * @param axis_scale Factor per axis from raw value to the unit the impulse was
+ *     trained on (`axes` entries, kept by pointer), or null for raw values
+ * @returns EIDSP_OK if ok
+ */
+__attribute__((unused)) static int signal_from_int16(const int16_t *data, size_t length, signal_t *signal, uint16_t axes = 1,
+    const float *axis_scale = nullptr)
+{
+    signal_view_t view;
+    view.format = SIGNAL_VIEW_INT16;
+    view.data = data;
+    view.length = length;
+    view.axes = axes;
+    view.axis_scale = axis_scale;
+    return signal_from_view(&view, signal);
+}
+
+/**
+ * Create a signal structure from a window of an int16 ring buffer, without
+ * unrolling it
+ * @param buffer Ring buffer, make sure to keep this pointer alive
+ * @param capacity Size of the ring buffer in samples
+ * @param start Index of the oldest sample of the window in the ring buffer
+ * @param length Number of samples in the window (frames * axes)
+ * @copydetails signal_from_int16()
+ */
+__attribute__((unused)) static int signal_from_int16_ring(const int16_t *buffer, size_t capacity, size_t start, size_t length,
+    signal_t *signal, uint16_t axes = 1, const float *axis_scale = nullptr)
+{
+    if (start >= capacity || length > capacity) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+
+    signal_view_t view;
+    view.format = SIGNAL_VIEW_INT16;
+    view.data = buffer + start;
+    view.length = capacity - start < length ? capacity - start : length;
+    view.wrap = buffer;
+    view.wrap_length = length - view.length;
+    view.axes = axes;
+    view.axis_scale = axis_scale;
+    return signal_from_view(&view, signal);
+}
+
+#endif // EIDSP_SIGNAL_C_FN_POINTER == 0
+
+} // namespace ei
+
+// clang-format on
+#endif // _EIDSP_SIGNAL_VIEW_H_
@@ -37,4 +37,8 @@
 template<class T>
 using ei_vector = std::vector<T, ei::EiAlloc<T>>;
 
+// for temporaries that live within one DSP block run, reserve() up front
+template<class T>
+using ei_scratch_vector = std::vector<T, ei::EiScratchAlloc<T>>;
+
 #endif  //!__EI_VECTOR__H__
\ No newline at end of file
@@ -0,0 +1,382 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/dsp/fft/ei_rfft.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/dsp/kissfft/kiss_fftr.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#if EIDSP_FFT_ENABLE_HOST_SIMD == 1
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define EI_RFFT_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define EI_RFFT_SIMD_NEON 1
+#endif
+#endif // EIDSP_FFT_ENABLE_HOST_SIMD == 1
+
+namespace ei {
+namespace fft {
+
+/**
+ * A real FFT of n points is computed as a complex FFT of n / 2 points over the
+ * even (real) and odd (imaginary) samples, and then split into the spectrum of
+ * the real signal. The complex FFT is an iterative radix-2 decimation in time
+ * transform in split (separate real / imaginary arrays) layout, with the first
+ * two stages fused into one radix-4 pass that reads the input in bit reversed
+ * order. The split layout makes every butterfly stage from span 4 onwards a
+ * straight vector loop.
+ */
+struct rfft_plan {
+    size_t n_fft;
+    size_t half;                // length of the complex transform, n_fft / 2
+    uint32_t *bitrev;           // half entries
+    float *tw_re;               // twiddles of the stage with span h at [h - 1 .. 2h - 2]
+    float *tw_im;
+    float *post_re;             // e^(-2 pi i k / n_fft), k = 0 .. half / 2
+    float *post_im;
+    kiss_fftr_cfg kiss;         // sizes that aren't a power of two
+    size_t kiss_bytes;
+    size_t bytes;               // allocation of the plan and its tables
+};
+
+
+static bool is_power_of_two(size_t n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+bool rfft_size_is_native(size_t n_fft)
+{
+    return n_fft >= 8 && is_power_of_two(n_fft);
+}
+
+rfft_plan_t *rfft_plan_create(size_t n_fft)
+{
+    if (n_fft < 2 || n_fft % 2 != 0) {
+        return nullptr;
+    }
+
+    if (!rfft_size_is_native(n_fft)) {
+        rfft_plan_t *plan = (rfft_plan_t *)ei_calloc(1, sizeof(rfft_plan_t));
+        if (!plan) {
+            return nullptr;
+        }
+        plan->n_fft = n_fft;
+        plan->half = n_fft / 2;
+        plan->kiss = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &plan->kiss_bytes);
+        if (!plan->kiss) {
+            ei_free(plan);
+            return nullptr;
+        }
+        plan->bytes = sizeof(rfft_plan_t);
+        ei_dsp_register_alloc(plan->bytes, plan);
+        ei_dsp_register_alloc(plan->kiss_bytes, plan->kiss);
+        return plan;
+    }
+
+    const size_t half = n_fft / 2;
+    const size_t post = half / 2 + 1;
+    // tables live in the same allocation as the plan
+    const size_t bytes = sizeof(rfft_plan_t) + half * sizeof(uint32_t) +
+        2 * half * sizeof(float) + 2 * post * sizeof(float);
+    uint8_t *buffer = (uint8_t *)ei_calloc(1, bytes);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    ei_dsp_register_alloc(bytes, buffer);
+
+    rfft_plan_t *plan = (rfft_plan_t *)buffer;
+    plan->bytes = bytes;
+    plan->n_fft = n_fft;
+    plan->half = half;
+    plan->bitrev = (uint32_t *)(buffer + sizeof(rfft_plan_t));
+    plan->tw_re = (float *)(plan->bitrev + half);
+    plan->tw_im = plan->tw_re + half;
+    plan->post_re = plan->tw_im + half;
+    plan->post_im = plan->post_re + post;
+
+    size_t bits = 0;
+    while (((size_t)1 << bits) < half) {
+        bits++;
+    }
+    for (size_t ix = 0; ix < half; ix++) {
+        uint32_t rev = 0;
+        for (size_t b = 0; b < bits; b++) {
+            rev |= ((ix >> b) & 1) << (bits - 1 - b);
+        }
+        plan->bitrev[ix] = rev;
+    }
+
+    // twiddles in double, so large sizes don't accumulate rounding errors
+    for (size_t h = 1; h < half; h <<= 1) {
+        for (size_t j = 0; j < h; j++) {
+            const double angle = -M_PI * (double)j / (double)h;
+            plan->tw_re[h - 1 + j] = (float)cos(angle);
+            plan->tw_im[h - 1 + j] = (float)sin(angle);
+        }
+    }
+    for (size_t k = 0; k < post; k++) {
+        const double angle = -2.0 * M_PI * (double)k / (double)n_fft;
+        plan->post_re[k] = (float)cos(angle);
+        plan->post_im[k] = (float)sin(angle);
+    }
+
+    return plan;
+}
+
+void rfft_plan_free(rfft_plan_t *plan)
+{
+    if (!plan) {
+        return;
+    }
+    if (plan->kiss) {
+        kiss_fftr_free(plan->kiss);
+        ei_dsp_register_free(plan->kiss_bytes, plan->kiss);
+    }
+    ei_dsp_register_free(plan->bytes, plan);
+    ei_free(plan);
+}
+
+/**
+ * Radix-2 butterflies of one block: top[j] +/- w[j] * bottom[j], j < span
+ */
+#if defined(EI_RFFT_SIMD_SSE)
+
+static const char *butterfly_kernels_name = "sse2";
+
+static void butterflies(float *top_re, float *top_im, float *bot_re, float *bot_im,
+    const float *w_re, const float *w_im, size_t span)
+{
+    for (size_t j = 0; j < span; j += 4) {
+        const __m128 wr = _mm_loadu_ps(w_re + j);
+        const __m128 wi = _mm_loadu_ps(w_im + j);
+        const __m128 br = _mm_loadu_ps(bot_re + j);
+        const __m128 bi = _mm_loadu_ps(bot_im + j);
+        const __m128 ar = _mm_loadu_ps(top_re + j);
+        const __m128 ai = _mm_loadu_ps(top_im + j);
+        const __m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+        const __m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+        _mm_storeu_ps(top_re + j, _mm_add_ps(ar, tr));
+        _mm_storeu_ps(top_im + j, _mm_add_ps(ai, ti));
+        _mm_storeu_ps(bot_re + j, _mm_sub_ps(ar, tr));
+        _mm_storeu_ps(bot_im + j, _mm_sub_ps(ai, ti));
+    }
+}
+
+#elif defined(EI_RFFT_SIMD_NEON)
+
+static const char *butterfly_kernels_name = "neon";
+
+static void butterflies(float *top_re, float *top_im, float *bot_re, float *bot_im,
+    const float *w_re, const float *w_im, size_t span)
+{
+    for (size_t j = 0; j < span; j += 4) {
+        const float32x4_t wr = vld1q_f32(w_re + j);
+        const float32x4_t wi = vld1q_f32(w_im + j);
+        const float32x4_t br = vld1q_f32(bot_re + j);
+        const float32x4_t bi = vld1q_f32(bot_im + j);
+        const float32x4_t ar = vld1q_f32(top_re + j);
+        const float32x4_t ai = vld1q_f32(top_im + j);
+        const float32x4_t tr = vsubq_f32(vmulq_f32(br, wr), vmulq_f32(bi, wi));
+        const float32x4_t ti = vaddq_f32(vmulq_f32(br, wi), vmulq_f32(bi, wr));
+        vst1q_f32(top_re + j, vaddq_f32(ar, tr));
+        vst1q_f32(top_im + j, vaddq_f32(ai, ti));
+        vst1q_f32(bot_re + j, vsubq_f32(ar, tr));
+        vst1q_f32(bot_im + j, vsubq_f32(ai, ti));
+    }
+}
+
+#else
+
+static const char *butterfly_kernels_name = "scalar";
+
+static void butterflies(float *top_re, float *top_im, float *bot_re, float *bot_im,
+    const float *w_re, const float *w_im, size_t span)
+{
+    for (size_t j = 0; j < span; j++) {
+        const float tr = bot_re[j] * w_re[j] - bot_im[j] * w_im[j];
+        const float ti = bot_re[j] * w_im[j] + bot_im[j] * w_re[j];
+        const float ar = top_re[j];
+        const float ai = top_im[j];
+        top_re[j] = ar + tr;
+        top_im[j] = ai + ti;
+        bot_re[j] = ar - tr;
+        bot_im[j] = ai - ti;
+    }
+}
+
+#endif // EI_RFFT_SIMD_SSE / EI_RFFT_SIMD_NEON
+
+int rfft_execute(const rfft_plan_t *plan, float *input, fft_complex_t *output)
+{
+    if (plan->kiss) {
+        kiss_fftr(plan->kiss, input, (kiss_fft_cpx *)output);
+        return EIDSP_OK;
+    }
+
+    const size_t half = plan->half;
+    // the complex transform runs in the output buffer (n_fft of its n_fft + 2 floats)
+    float *re = (float *)output;
+    float *im = re + half;
+
+    // z[k] = input[2k] + i input[2k + 1], in bit reversed order, through spans 1 and 2
+    const uint32_t *bitrev = plan->bitrev;
+    for (size_t k = 0; k < half; k += 4) {
+        const float *z0 = input + 2 * bitrev[k];
+        const float *z1 = input + 2 * bitrev[k + 1];
+        const float *z2 = input + 2 * bitrev[k + 2];
+        const float *z3 = input + 2 * bitrev[k + 3];
+        const float a0r = z0[0] + z1[0], a0i = z0[1] + z1[1];
+        const float a1r = z0[0] - z1[0], a1i = z0[1] - z1[1];
+        const float a2r = z2[0] + z3[0], a2i = z2[1] + z3[1];
+        const float a3r = z2[0] - z3[0], a3i = z2[1] - z3[1];
+        // span 2 twiddles are 1 and -i
+        re[k] = a0r + a2r;
+        im[k] = a0i + a2i;
+        re[k + 2] = a0r - a2r;
+        im[k + 2] = a0i - a2i;
+        re[k + 1] = a1r + a3i;
+        im[k + 1] = a1i - a3r;
+        re[k + 3] = a1r - a3i;
+        im[k + 3] = a1i + a3r;
+    }
+
+    for (size_t span = 4; span < half; span <<= 1) {
+        const float *w_re = plan->tw_re + span - 1;
+        const float *w_im = plan->tw_im + span - 1;
+        for (size_t block = 0; block < half; block += 2 * span) {
+            butterflies(re + block, im + block, re + block + span, im + block + span, w_re, w_im, span);
+        }
+    }
+
+    // split Z into the spectrum of the real signal, reading from a copy as
+    // X[k] and X[half - k] overwrite the split layout
+    memcpy(input, re, 2 * half * sizeof(float));
+    const float *zr = input;
+    const float *zi = input + half;
+
+    output[0].r = zr[0] + zi[0];
+    output[0].i = 0.0f;
+    output[half].r = zr[0] - zi[0];
+    output[half].i = 0.0f;
+
+    for (size_t k = 1; k <= half / 2; k++) {
+        // even part (Z[k] + conj(Z[half - k])) / 2, odd part -i (Z[k] - conj(Z[half - k])) / 2
+        const float ar = zr[k], ai = zi[k];
+        const float br = zr[half - k], bi = -zi[half - k];
+        const float even_r = 0.5f * (ar + br);
+        const float even_i = 0.5f * (ai + bi);
+        const float odd_r = 0.5f * (ai - bi);
+        const float odd_i = -0.5f * (ar - br);
+        const float tr = plan->post_re[k] * odd_r - plan->post_im[k] * odd_i;
+        const float ti = plan->post_re[k] * odd_i + plan->post_im[k] * odd_r;
+        output[k].r = even_r + tr;
+        output[k].i = even_i + ti;
+        output[half - k].r = even_r - tr;
+        output[half - k].i = ti - even_i;
+    }
+
+    return EIDSP_OK;
+}
+
+static rfft_plan_t *plans[EIDSP_FFT_MAX_PLANS];
+
+const rfft_plan_t *rfft_get_plan(size_t n_fft)
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        if (plans[ix] && plans[ix]->n_fft == n_fft) {
+            return plans[ix];
+        }
+    }
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        if (!plans[ix]) {
+            plans[ix] = rfft_plan_create(n_fft);
+            return plans[ix];
+        }
+    }
+    return nullptr;
+}
+
+void rfft_clear_plans()
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        rfft_plan_free(plans[ix]);
+        plans[ix] = nullptr;
+    }
+}
+
+int rfft(float *input, fft_complex_t *output, size_t n_fft)
+{
+    const rfft_plan_t *plan;
+    {
+        EiDspCacheLock lock;
+        plan = rfft_get_plan(n_fft);
+        // kissfft configs keep a scratch buffer, so those run under the lock
+        if (plan && plan->kiss) {
+            return rfft_execute(plan, input, output);
+        }
+    }
+    if (plan) {
+        return rfft_execute(plan, input, output);
+    }
+
+    rfft_plan_t *temp_plan = rfft_plan_create(n_fft);
+    if (!temp_plan) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    int ret = rfft_execute(temp_plan, input, output);
+    rfft_plan_free(temp_plan);
+    return ret;
+}
+
+const char *rfft_kernels_name()
+{
+    return butterfly_kernels_name;
+}
+
+} // namespace fft
+} // namespace ei
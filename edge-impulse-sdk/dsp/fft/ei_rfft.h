@@ -0,0 +1,105 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _EIDSP_FFT_RFFT_H_
+#define _EIDSP_FFT_RFFT_H_
+
+#include <stddef.h>
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+
+// number of FFT sizes whose plan is kept between calls, other sizes get a
+// temporary plan for every call
+#ifndef EIDSP_FFT_MAX_PLANS
+#define EIDSP_FFT_MAX_PLANS     4
+#endif // EIDSP_FFT_MAX_PLANS
+
+namespace ei {
+namespace fft {
+
+/**
+ * Precomputed real FFT: twiddle and bit reversal tables for power of two
+ * sizes (n_fft >= 8), a kissfft config for all other sizes.
+ */
+typedef struct rfft_plan rfft_plan_t;
+
+/**
+ * Create a plan for a real FFT of n_fft points
+ * @returns nullptr when out of memory or n_fft is odd
+ */
+rfft_plan_t *rfft_plan_create(size_t n_fft);
+
+void rfft_plan_free(rfft_plan_t *plan);
+
+/**
+ * Cached plan for n_fft points, created on first use. nullptr when out of memory,
+ * n_fft is odd or all EIDSP_FFT_MAX_PLANS slots are taken by other sizes.
+ * Plans are shared: the built-in ones are read only, but the kissfft ones (sizes
+ * that aren't a power of two) must not run from two threads at once, rfft()
+ * takes care of that.
+ */
+const rfft_plan_t *rfft_get_plan(size_t n_fft);
+
+/**
+ * Free all cached plans
+ */
+void rfft_clear_plans();
+
+/**
+ * Real FFT, same (unscaled) output as kiss_fftr
+ * @param plan Plan from rfft_plan_create() or rfft_get_plan()
+ * @param input n_fft points, used as scratch (contents are undefined afterwards)
+ * @param output n_fft / 2 + 1 points
+ */
+int rfft_execute(const rfft_plan_t *plan, float *input, fft_complex_t *output);
+
+/**
+ * Real FFT through the cached plan of n_fft (or a temporary plan if there's no free slot)
+ * @param input n_fft points, used as scratch (contents are undefined afterwards)
+ * @param output n_fft / 2 + 1 points
+ */
+int rfft(float *input, fft_complex_t *output, size_t n_fft);
+
+/**
+ * Whether n_fft is handled by the built-in transform, rather than by kissfft
+ */
+bool rfft_size_is_native(size_t n_fft);
+
+/**
+ * Name of the butterfly kernels ("sse2", "neon" or "scalar")
+ */
+const char *rfft_kernels_name();
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_FFT_RFFT_H_
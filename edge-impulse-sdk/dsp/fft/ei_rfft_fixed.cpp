@@ -0,0 +1,253 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/dsp/fft/ei_rfft_fixed.h"
+
+#include <math.h>
+#include <string.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/dsp/fft/ei_rfft.h"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace fft {
+
+/**
+ * Same structure as the float transform (ei_rfft.cpp): a complex FFT of
+ * n / 2 points over the even (real) and odd (imaginary) samples, then split
+ * into the spectrum of the real signal. Data is int32 with Q30 twiddles, the
+ * products are 64 bits wide. Nothing is scaled between the stages, the input
+ * bound of rfft_fixed_input_bits() leaves room for the growth of all of them.
+ */
+struct rfft_fixed_plan {
+    size_t n_fft;
+    size_t half;                // length of the complex transform, n_fft / 2
+    uint16_t *bitrev;           // half entries
+    int32_t *tw;                // e^(-2 pi i k / n_fft) in Q30, k = 0 .. half - 1, interleaved
+    size_t bytes;
+};
+
+#define RFFT_FIXED_Q30_ONE      (1 << 30)
+
+static inline int32_t mul_q30(int64_t acc)
+{
+    return (int32_t)((acc + (1 << 29)) >> 30);
+}
+
+static size_t log2_of(size_t n)
+{
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n) {
+        bits++;
+    }
+    return bits;
+}
+
+rfft_fixed_plan_t *rfft_fixed_plan_create(size_t n_fft)
+{
+    if (n_fft < 8 || n_fft > 65536 || (n_fft & (n_fft - 1)) != 0) {
+        return nullptr;
+    }
+
+    const size_t half = n_fft / 2;
+    // tables live in the same allocation as the plan, twiddles first (largest alignment)
+    const size_t bytes = sizeof(rfft_fixed_plan_t) + 2 * half * sizeof(int32_t) + half * sizeof(uint16_t);
+    uint8_t *buffer = (uint8_t *)ei_calloc(1, bytes);
+    if (!buffer) {
+        return nullptr;
+    }
+    ei_dsp_register_alloc(bytes, buffer);
+
+    rfft_fixed_plan_t *plan = (rfft_fixed_plan_t *)buffer;
+    plan->n_fft = n_fft;
+    plan->half = half;
+    plan->bytes = bytes;
+    plan->tw = (int32_t *)(buffer + sizeof(rfft_fixed_plan_t));
+    plan->bitrev = (uint16_t *)(plan->tw + 2 * half);
+
+    const size_t bits = log2_of(half);
+    for (size_t ix = 0; ix < half; ix++) {
+        uint32_t rev = 0;
+        for (size_t b = 0; b < bits; b++) {
+            rev |= ((ix >> b) & 1) << (bits - 1 - b);
+        }
+        plan->bitrev[ix] = (uint16_t)rev;
+    }
+
+    // only when the plan is created, so fine on soft float targets
+    for (size_t k = 0; k < half; k++) {
+        const double phase = -2.0 * M_PI * (double)k / (double)n_fft;
+        plan->tw[2 * k] = (int32_t)lround(cos(phase) * RFFT_FIXED_Q30_ONE);
+        plan->tw[2 * k + 1] = (int32_t)lround(sin(phase) * RFFT_FIXED_Q30_ONE);
+    }
+
+    return plan;
+}
+
+void rfft_fixed_plan_free(rfft_fixed_plan_t *plan)
+{
+    if (!plan) {
+        return;
+    }
+    ei_dsp_register_free(plan->bytes, plan);
+    ei_free(plan);
+}
+
+size_t rfft_fixed_plan_bytes(const rfft_fixed_plan_t *plan)
+{
+    return plan->bytes;
+}
+
+int rfft_fixed_input_bits(size_t n_fft)
+{
+    return 30 - (int)log2_of(n_fft);
+}
+
+int rfft_fixed_execute(const rfft_fixed_plan_t *plan, int32_t *data)
+{
+    if (!plan) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const size_t half = plan->half;
+    const int32_t *tw = plan->tw;
+
+    for (size_t ix = 0; ix < half; ix++) {
+        const size_t rev = plan->bitrev[ix];
+        if (ix < rev) {
+            const int32_t re = data[2 * ix];
+            const int32_t im = data[2 * ix + 1];
+            data[2 * ix] = data[2 * rev];
+            data[2 * ix + 1] = data[2 * rev + 1];
+            data[2 * rev] = re;
+            data[2 * rev + 1] = im;
+        }
+    }
+
+    // first stage has no twiddles
+    for (size_t ix = 0; ix < 2 * half; ix += 4) {
+        const int32_t ar = data[ix], ai = data[ix + 1];
+        const int32_t br = data[ix + 2], bi = data[ix + 3];
+        data[ix] = ar + br;
+        data[ix + 1] = ai + bi;
+        data[ix + 2] = ar - br;
+        data[ix + 3] = ai - bi;
+    }
+
+    for (size_t span = 2; span < half; span <<= 1) {
+        // W_(2 span)^k = W_n^(k * half / span)
+        const size_t stride = half / span;
+        for (size_t k = 0; k < span; k++) {
+            const int64_t wr = tw[2 * k * stride];
+            const int64_t wi = tw[2 * k * stride + 1];
+            for (size_t start = k; start < half; start += 2 * span) {
+                int32_t *a = data + 2 * start;
+                int32_t *b = a + 2 * span;
+                const int32_t tr = mul_q30(b[0] * wr - b[1] * wi);
+                const int32_t ti = mul_q30(b[0] * wi + b[1] * wr);
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+
+    // split, X[k] = (E2[k] + W^k O2[k]) / 2 and X[half - k] = conj(E2[k] - W^k O2[k]) / 2,
+    // with E2 = Z[k] + conj(Z[half - k]) and O2 = (Z[k] - conj(Z[half - k])) / i
+    const int32_t z0r = data[0];
+    const int32_t z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = 0;
+    data[2 * half] = z0r - z0i;
+    data[2 * half + 1] = 0;
+
+    for (size_t k = 1; k <= half / 2; k++) {
+        const size_t j = half - k;
+        const int64_t ar = data[2 * k], ai = data[2 * k + 1];
+        const int64_t cr = data[2 * j], ci = data[2 * j + 1];
+
+        const int64_t e2r = ar + cr;
+        const int64_t e2i = ai - ci;
+        const int64_t o2r = ai + ci;
+        const int64_t o2i = cr - ar;
+
+        const int64_t wr = tw[2 * k];
+        const int64_t wi = tw[2 * k + 1];
+        const int64_t wor = mul_q30(o2r * wr - o2i * wi);
+        const int64_t woi = mul_q30(o2r * wi + o2i * wr);
+
+        data[2 * k] = (int32_t)((e2r + wor + 1) >> 1);
+        data[2 * k + 1] = (int32_t)((e2i + woi + 1) >> 1);
+        data[2 * j] = (int32_t)((e2r - wor + 1) >> 1);
+        data[2 * j + 1] = (int32_t)((woi - e2i + 1) >> 1);
+    }
+
+    return EIDSP_OK;
+}
+
+static rfft_fixed_plan_t *fixed_plans[EIDSP_FFT_MAX_PLANS];
+
+const rfft_fixed_plan_t *rfft_fixed_get_plan(size_t n_fft)
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        if (fixed_plans[ix] && fixed_plans[ix]->n_fft == n_fft) {
+            return fixed_plans[ix];
+        }
+    }
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        if (!fixed_plans[ix]) {
+            fixed_plans[ix] = rfft_fixed_plan_create(n_fft);
+            return fixed_plans[ix];
+        }
+    }
+    return nullptr;
+}
+
+void rfft_fixed_clear_plans()
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FFT_MAX_PLANS; ix++) {
+        rfft_fixed_plan_free(fixed_plans[ix]);
+        fixed_plans[ix] = nullptr;
+    }
+}
+
+} // namespace fft
+} // namespace ei
@@ -0,0 +1,91 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _EIDSP_FFT_RFFT_FIXED_H_
+#define _EIDSP_FFT_RFFT_FIXED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ei {
+namespace fft {
+
+/**
+ * Precomputed fixed point real FFT for power of two sizes (8 <= n_fft <= 65536):
+ * Q30 twiddles and the bit reversal table. Uses the integer unit only, for
+ * targets without (or with a slow) FPU.
+ */
+typedef struct rfft_fixed_plan rfft_fixed_plan_t;
+
+/**
+ * Create a plan for a fixed point real FFT of n_fft points
+ * @returns nullptr when out of memory or n_fft is not a supported power of two
+ */
+rfft_fixed_plan_t *rfft_fixed_plan_create(size_t n_fft);
+
+void rfft_fixed_plan_free(rfft_fixed_plan_t *plan);
+
+/**
+ * Cached plan for n_fft points, created on first use. nullptr when out of memory,
+ * n_fft is not supported or all EIDSP_FFT_MAX_PLANS slots are taken by other sizes.
+ */
+const rfft_fixed_plan_t *rfft_fixed_get_plan(size_t n_fft);
+
+/**
+ * Free all cached fixed point plans
+ */
+void rfft_fixed_clear_plans();
+
+/**
+ * Heap used by the plan, in bytes
+ */
+size_t rfft_fixed_plan_bytes(const rfft_fixed_plan_t *plan);
+
+/**
+ * The input of rfft_fixed_execute() must satisfy |x| <= 2^rfft_fixed_input_bits(n_fft),
+ * which keeps every intermediate value (and the output) within 2^30
+ */
+int rfft_fixed_input_bits(size_t n_fft);
+
+/**
+ * Unscaled real FFT (same scale as rfft()) in place, with round to nearest after
+ * every twiddle multiply and in the final split
+ * @param data n_fft + 2 values, the input in the first n_fft. Holds the
+ *     n_fft / 2 + 1 complex output points (interleaved real / imaginary) afterwards.
+ */
+int rfft_fixed_execute(const rfft_fixed_plan_t *plan, int32_t *data);
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_FFT_RFFT_FIXED_H_
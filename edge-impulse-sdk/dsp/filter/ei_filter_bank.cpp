@@ -0,0 +1,456 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/dsp/filter/ei_filter_bank.h"
+
+#include <math.h>
+#include <string.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#if EIDSP_FILTER_ENABLE_HOST_SIMD == 1
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define EI_FILTER_SIMD_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define EI_FILTER_SIMD_NEON 1
+#endif
+#endif // EIDSP_FILTER_ENABLE_HOST_SIMD == 1
+
+// samples per channel that go through the sections in one go
+#define EI_FILTER_BLOCK         64
+
+namespace ei {
+namespace filter {
+
+/**
+ * EI_FILTER_LANES floats, one per channel.
+ * On targets without SIMD this is a plain array: the lanes are independent
+ * recurrences, so the FPU pipeline stays busy instead of waiting on the
+ * previous sample of a single channel.
+ */
+#if defined(EI_FILTER_SIMD_SSE)
+
+static const char *lane_kernels_name = "sse2";
+
+typedef __m128 lanes_t;
+
+static inline lanes_t lanes_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void lanes_store(float *p, lanes_t v) { _mm_storeu_ps(p, v); }
+static inline lanes_t lanes_set1(float v) { return _mm_set1_ps(v); }
+static inline lanes_t lanes_add(lanes_t a, lanes_t b) { return _mm_add_ps(a, b); }
+static inline lanes_t lanes_sub(lanes_t a, lanes_t b) { return _mm_sub_ps(a, b); }
+static inline lanes_t lanes_mul(lanes_t a, lanes_t b) { return _mm_mul_ps(a, b); }
+
+#elif defined(EI_FILTER_SIMD_NEON)
+
+static const char *lane_kernels_name = "neon";
+
+typedef float32x4_t lanes_t;
+
+static inline lanes_t lanes_load(const float *p) { return vld1q_f32(p); }
+static inline void lanes_store(float *p, lanes_t v) { vst1q_f32(p, v); }
+static inline lanes_t lanes_set1(float v) { return vdupq_n_f32(v); }
+static inline lanes_t lanes_add(lanes_t a, lanes_t b) { return vaddq_f32(a, b); }
+static inline lanes_t lanes_sub(lanes_t a, lanes_t b) { return vsubq_f32(a, b); }
+static inline lanes_t lanes_mul(lanes_t a, lanes_t b) { return vmulq_f32(a, b); }
+
+#else
+
+static const char *lane_kernels_name = "scalar";
+
+typedef struct {
+    float v[EI_FILTER_LANES];
+} lanes_t;
+
+static inline lanes_t lanes_load(const float *p)
+{
+    lanes_t r;
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        r.v[l] = p[l];
+    }
+    return r;
+}
+
+static inline void lanes_store(float *p, lanes_t a)
+{
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        p[l] = a.v[l];
+    }
+}
+
+static inline lanes_t lanes_set1(float v)
+{
+    lanes_t r;
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        r.v[l] = v;
+    }
+    return r;
+}
+
+static inline lanes_t lanes_add(lanes_t a, lanes_t b)
+{
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        a.v[l] += b.v[l];
+    }
+    return a;
+}
+
+static inline lanes_t lanes_sub(lanes_t a, lanes_t b)
+{
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        a.v[l] -= b.v[l];
+    }
+    return a;
+}
+
+static inline lanes_t lanes_mul(lanes_t a, lanes_t b)
+{
+    for (int l = 0; l < EI_FILTER_LANES; l++) {
+        a.v[l] *= b.v[l];
+    }
+    return a;
+}
+
+#endif
+
+const char *filter_kernels_name()
+{
+    return lane_kernels_name;
+}
+
+/**
+ * Coefficients are 6 floats per section: b0, b1, b2, 1 / a0, a1, a2 for
+ * IIR_SOS and A, d1, d2 for the Butterworth sections. The state of a group
+ * of EI_FILTER_LANES channels is 2 x EI_FILTER_LANES floats per section
+ * (d0 / d1 of sosfilt, or w1 / w2 of the Butterworth sections).
+ */
+struct iir_bank {
+    iir_type_t type;
+    size_t num_sections;
+    size_t channels;
+    size_t groups;
+    size_t phase;               // samples to skip before the next decimated output
+    float *coeff;
+    float *state;
+};
+
+static size_t header_bytes()
+{
+    return (sizeof(iir_bank_t) + 15) & ~(size_t)15;
+}
+
+static size_t group_count(size_t channels)
+{
+    return (channels + EI_FILTER_LANES - 1) / EI_FILTER_LANES;
+}
+
+size_t iir_bank_bytes(size_t num_sections, size_t channels)
+{
+    return header_bytes() + num_sections * 6 * sizeof(float) +
+        group_count(channels) * num_sections * 2 * EI_FILTER_LANES * sizeof(float);
+}
+
+static iir_bank_t *init_bank(void *buffer, iir_type_t type, size_t num_sections, size_t channels)
+{
+    if (!buffer || num_sections == 0) {
+        return nullptr;
+    }
+    iir_bank_t *bank = (iir_bank_t *)buffer;
+    bank->type = type;
+    bank->num_sections = num_sections;
+    bank->channels = channels;
+    bank->groups = group_count(channels);
+    bank->coeff = (float *)((uint8_t *)buffer + header_bytes());
+    bank->state = bank->coeff + num_sections * 6;
+    iir_reset(bank);
+    return bank;
+}
+
+iir_bank_t *iir_init_sos(void *buffer, const float *sos, size_t num_sections, size_t channels)
+{
+    for (size_t s = 0; s < num_sections; s++) {
+        if (sos[s * 6 + 3] == 0.0f) {
+            return nullptr;
+        }
+    }
+    iir_bank_t *bank = init_bank(buffer, IIR_SOS, num_sections, channels);
+    if (!bank) {
+        return nullptr;
+    }
+    for (size_t s = 0; s < num_sections; s++) {
+        const float *b = sos + s * 6;
+        const float *a = b + 3;
+        float *c = bank->coeff + s * 6;
+        c[0] = b[0];
+        c[1] = b[1];
+        c[2] = b[2];
+        c[3] = 1.0f / a[0];
+        c[4] = a[1];
+        c[5] = a[2];
+    }
+    return bank;
+}
+
+iir_bank_t *iir_init_butterworth(
+    void *buffer,
+    int filter_order,
+    float sampling_freq,
+    float cutoff_freq,
+    bool high_pass,
+    size_t channels)
+{
+    const int n_steps = filter_order / 2;
+    if (n_steps <= 0) {
+        return nullptr;
+    }
+    iir_bank_t *bank = init_bank(
+        buffer,
+        high_pass ? IIR_BUTTERWORTH_HIGHPASS : IIR_BUTTERWORTH_LOWPASS,
+        n_steps,
+        channels);
+    if (!bank) {
+        return nullptr;
+    }
+
+    // same design as spectral::filters::butterworth_lowpass() / butterworth_highpass()
+    float a = tan(M_PI * cutoff_freq / sampling_freq);
+    float a2 = pow(a, 2);
+    for (int ix = 0; ix < n_steps; ix++) {
+        float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+        float s = a2 + (2.0 * a * r) + 1.0;
+        float *c = bank->coeff + ix * 6;
+        c[0] = high_pass ? 1.0f / s : a2 / s;
+        c[1] = 2.0 * (1 - a2) / s;
+        c[2] = -(a2 - (2.0 * a * r) + 1.0) / s;
+        c[3] = c[4] = c[5] = 0.0f;
+    }
+    return bank;
+}
+
+iir_bank_t *iir_create_sos(const float *sos, size_t num_sections, size_t channels)
+{
+    void *buffer = ei_malloc(iir_bank_bytes(num_sections, channels));
+    iir_bank_t *bank = iir_init_sos(buffer, sos, num_sections, channels);
+    if (!bank) {
+        ei_free(buffer);
+    }
+    return bank;
+}
+
+iir_bank_t *iir_create_butterworth(
+    int filter_order,
+    float sampling_freq,
+    float cutoff_freq,
+    bool high_pass,
+    size_t channels)
+{
+    void *buffer = ei_malloc(iir_bank_bytes(filter_order / 2, channels));
+    iir_bank_t *bank =
+        iir_init_butterworth(buffer, filter_order, sampling_freq, cutoff_freq, high_pass, channels);
+    if (!bank) {
+        ei_free(buffer);
+    }
+    return bank;
+}
+
+void iir_free(iir_bank_t *bank)
+{
+    ei_free(bank);
+}
+
+void iir_reset(iir_bank_t *bank)
+{
+    memset(bank->state, 0, bank->groups * bank->num_sections * 2 * EI_FILTER_LANES * sizeof(float));
+    bank->phase = 0;
+}
+
+int iir_set_state(iir_bank_t *bank, size_t channel, const float *zi, float x0)
+{
+    if (channel >= bank->channels) {
+        EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+    }
+    const size_t group = channel / EI_FILTER_LANES;
+    const size_t lane = channel % EI_FILTER_LANES;
+    float *state = bank->state + group * bank->num_sections * 2 * EI_FILTER_LANES;
+    for (size_t s = 0; s < bank->num_sections; s++) {
+        state[(s * 2) * EI_FILTER_LANES + lane] = zi[s * 2] * x0;
+        state[(s * 2 + 1) * EI_FILTER_LANES + lane] = zi[s * 2 + 1] * x0;
+    }
+    return EIDSP_OK;
+}
+
+/**
+ * Run all sections over n samples of one group of channels, in place.
+ * block holds EI_FILTER_LANES floats per sample, one per channel. Each section
+ * goes over the whole block with its state and coefficients in registers.
+ */
+template<iir_type_t type>
+static void iir_block(const float *coeff, float *state, size_t num_sections, float *block, size_t n)
+{
+    for (size_t s = 0; s < num_sections; s++) {
+        const float *c = coeff + s * 6;
+        float *st = state + s * 2 * EI_FILTER_LANES;
+        lanes_t s0 = lanes_load(st);
+        lanes_t s1 = lanes_load(st + EI_FILTER_LANES);
+
+        if (type == IIR_SOS) {
+            // y = (b0 x + d0) / a0, d0 = b1 x - a1 y + d1, d1 = b2 x - a2 y, as signal::iir2
+            const lanes_t b0 = lanes_set1(c[0]);
+            const lanes_t b1 = lanes_set1(c[1]);
+            const lanes_t b2 = lanes_set1(c[2]);
+            const lanes_t inv_a0 = lanes_set1(c[3]);
+            const lanes_t a1 = lanes_set1(c[4]);
+            const lanes_t a2 = lanes_set1(c[5]);
+            for (size_t ix = 0; ix < n; ix++) {
+                float *p = block + ix * EI_FILTER_LANES;
+                const lanes_t x = lanes_load(p);
+                const lanes_t y = lanes_mul(lanes_add(lanes_mul(b0, x), s0), inv_a0);
+                s0 = lanes_add(lanes_sub(lanes_mul(b1, x), lanes_mul(a1, y)), s1);
+                s1 = lanes_sub(lanes_mul(b2, x), lanes_mul(a2, y));
+                lanes_store(p, y);
+            }
+        }
+        else {
+            // w0 = d1 w1 + d2 w2 + x, y = A (w0 +/- 2 w1 + w2). The sum is taken as
+            // (w0 +/- w1) +/- (w1 +/- w2), neighbouring states are close to each other
+            // so this keeps float precision without going through double.
+            const lanes_t A = lanes_set1(c[0]);
+            const lanes_t d1 = lanes_set1(c[1]);
+            const lanes_t d2 = lanes_set1(c[2]);
+            for (size_t ix = 0; ix < n; ix++) {
+                float *p = block + ix * EI_FILTER_LANES;
+                const lanes_t x = lanes_load(p);
+                const lanes_t w0 = lanes_add(lanes_add(lanes_mul(d1, s0), lanes_mul(d2, s1)), x);
+                lanes_t y;
+                if (type == IIR_BUTTERWORTH_HIGHPASS) {
+                    y = lanes_mul(A, lanes_sub(lanes_sub(w0, s0), lanes_sub(s0, s1)));
+                }
+                else {
+                    y = lanes_mul(A, lanes_add(lanes_add(w0, s0), lanes_add(s0, s1)));
+                }
+                s1 = s0;
+                s0 = w0;
+                lanes_store(p, y);
+            }
+        }
+
+        lanes_store(st, s0);
+        lanes_store(st + EI_FILTER_LANES, s1);
+    }
+}
+
+size_t iir_run(
+    iir_bank_t *bank,
+    const float *input,
+    size_t in_channel_stride,
+    size_t in_sample_stride,
+    float *output,
+    size_t out_channel_stride,
+    size_t out_sample_stride,
+    size_t samples,
+    size_t decimation)
+{
+    if (decimation == 0) {
+        decimation = 1;
+    }
+
+    float block[EI_FILTER_BLOCK * EI_FILTER_LANES];
+    size_t written = 0;
+    size_t phase = bank->phase;
+
+    for (size_t group = 0; group < bank->groups; group++) {
+        const size_t c0 = group * EI_FILTER_LANES;
+        const size_t lanes = bank->channels - c0 < EI_FILTER_LANES ?
+            bank->channels - c0 : EI_FILTER_LANES;
+        float *state = bank->state + group * bank->num_sections * 2 * EI_FILTER_LANES;
+        const float *in = input + c0 * in_channel_stride;
+        float *out = output + c0 * out_channel_stride;
+
+        // every group starts from the same decimation phase
+        phase = bank->phase;
+        written = 0;
+
+        for (size_t t0 = 0; t0 < samples; t0 += EI_FILTER_BLOCK) {
+            const size_t n = samples - t0 < EI_FILTER_BLOCK ? samples - t0 : EI_FILTER_BLOCK;
+
+            // gather the channels of the group into lanes (unused lanes run on zeros)
+            if (lanes < EI_FILTER_LANES) {
+                memset(block, 0, sizeof(block));
+            }
+            for (size_t ix = 0; ix < n; ix++) {
+                const float *x = in + (t0 + ix) * in_sample_stride;
+                for (size_t l = 0; l < lanes; l++) {
+                    block[ix * EI_FILTER_LANES + l] = x[l * in_channel_stride];
+                }
+            }
+
+            switch (bank->type) {
+                case IIR_SOS:
+                    iir_block<IIR_SOS>(bank->coeff, state, bank->num_sections, block, n);
+                    break;
+                case IIR_BUTTERWORTH_LOWPASS:
+                    iir_block<IIR_BUTTERWORTH_LOWPASS>(bank->coeff, state, bank->num_sections, block, n);
+                    break;
+                case IIR_BUTTERWORTH_HIGHPASS:
+                    iir_block<IIR_BUTTERWORTH_HIGHPASS>(bank->coeff, state, bank->num_sections, block, n);
+                    break;
+            }
+
+            // scatter every decimation-th sample, the block was read before
+            // so this also works in place
+            for (size_t ix = 0; ix < n; ix++) {
+                if (phase == 0) {
+                    float *y = out + written * out_sample_stride;
+                    for (size_t l = 0; l < lanes; l++) {
+                        y[l * out_channel_stride] = block[ix * EI_FILTER_LANES + l];
+                    }
+                    written++;
+                    phase = decimation - 1;
+                }
+                else {
+                    phase--;
+                }
+            }
+        }
+    }
+
+    bank->phase = phase;
+    return written;
+}
+
+} // namespace filter
+} // namespace ei
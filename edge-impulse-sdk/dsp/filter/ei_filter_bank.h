@@ -0,0 +1,147 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _EIDSP_FILTER_BANK_H_
+#define _EIDSP_FILTER_BANK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// channels that are filtered together, one per SIMD lane
+#define EI_FILTER_LANES         4
+
+namespace ei {
+namespace filter {
+
+typedef enum {
+    // scipy.signal.sosfilt sections (b0, b1, b2, a0, a1, a2), transposed direct form II
+    IIR_SOS = 0,
+    // Butterworth low pass sections, direct form II, y = A (w0 + 2 w1 + w2)
+    IIR_BUTTERWORTH_LOWPASS = 1,
+    // Butterworth high pass sections, direct form II, y = A (w0 - 2 w1 + w2)
+    IIR_BUTTERWORTH_HIGHPASS = 2,
+} iir_type_t;
+
+/**
+ * Cascade of second order sections that filters several channels (axes) at once,
+ * EI_FILTER_LANES channels per pass. Every channel has its own state, which
+ * carries over from one call of iir_run() to the next, so a signal can be
+ * streamed through the bank one window at a time.
+ */
+typedef struct iir_bank iir_bank_t;
+
+/**
+ * Bytes needed for a bank of num_sections sections over channels channels
+ */
+size_t iir_bank_bytes(size_t num_sections, size_t channels);
+
+/**
+ * Set up a bank of second order sections in caller provided memory, state is zero
+ * @param buffer iir_bank_bytes(num_sections, channels) bytes, aligned to sizeof(void *)
+ * @param sos 6 coefficients per section, as in scipy.signal.sosfilt
+ * @returns nullptr when buffer is nullptr or a0 of a section is zero
+ */
+iir_bank_t *iir_init_sos(void *buffer, const float *sos, size_t num_sections, size_t channels);
+
+/**
+ * Set up a Butterworth filter (same design as spectral::filters::butterworth_lowpass() /
+ * butterworth_highpass()) in caller provided memory, state is zero.
+ * Opt-in only: the bank sums the section output in float, spectral::filters in
+ * double, so the output differs from the DSP blocks by up to ~1e-4 of the input
+ * peak at low cutoffs. The DSP blocks keep using spectral::filters.
+ * @param buffer iir_bank_bytes(filter_order / 2, channels) bytes, aligned to sizeof(void *)
+ * @param filter_order Even filter order (between 2..8)
+ * @returns nullptr when buffer is nullptr or filter_order < 2
+ */
+iir_bank_t *iir_init_butterworth(
+    void *buffer,
+    int filter_order,
+    float sampling_freq,
+    float cutoff_freq,
+    bool high_pass,
+    size_t channels);
+
+/**
+ * Same as iir_init_sos() / iir_init_butterworth(), with memory from ei_malloc.
+ * Free with iir_free().
+ */
+iir_bank_t *iir_create_sos(const float *sos, size_t num_sections, size_t channels);
+iir_bank_t *iir_create_butterworth(
+    int filter_order,
+    float sampling_freq,
+    float cutoff_freq,
+    bool high_pass,
+    size_t channels);
+
+void iir_free(iir_bank_t *bank);
+
+/**
+ * Zero the state of every channel and restart the decimation phase
+ */
+void iir_reset(iir_bank_t *bank);
+
+/**
+ * Set the state of one channel to zi * x0, as sosfilt with zi = sosfilt_zi(sos) * x0
+ * @param zi 2 values per section
+ */
+int iir_set_state(iir_bank_t *bank, size_t channel, const float *zi, float x0);
+
+/**
+ * Filter samples of every channel. Sample t of channel c is read from
+ * input[c * in_channel_stride + t * in_sample_stride], so this works on row
+ * major matrices (one row per channel) as well as on interleaved frames.
+ * Every decimation-th filtered sample is written to output (in the same way,
+ * with the output strides), counting on from the previous call. Output may
+ * be the same buffer as input.
+ * @returns number of samples written per channel
+ */
+size_t iir_run(
+    iir_bank_t *bank,
+    const float *input,
+    size_t in_channel_stride,
+    size_t in_sample_stride,
+    float *output,
+    size_t out_channel_stride,
+    size_t out_sample_stride,
+    size_t samples,
+    size_t decimation = 1);
+
+/**
+ * Name of the lane kernels ("sse2", "neon" or "scalar")
+ */
+const char *filter_kernels_name();
+
+} // namespace filter
+} // namespace ei
+
+#endif // _EIDSP_FILTER_BANK_H_
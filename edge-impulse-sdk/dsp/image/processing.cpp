@@ -34,22 +34,364 @@
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 #include "edge-impulse-sdk/classifier/ei_constants.h"
+#include "edge-impulse-sdk/dsp/config.hpp"
 #include <string.h>
 #include <stddef.h>
 
+#if EIDSP_IMAGE_ENABLE_HOST_SIMD == 1
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EIDSP_IMAGE_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define EIDSP_IMAGE_SIMD_NEON 1
+#endif
+#endif // EIDSP_IMAGE_ENABLE_HOST_SIMD == 1
+
 namespace ei {
 namespace image {
 namespace processing {
 
+namespace {
+
+// Fixed point fractions of resize_image()
+constexpr int RESIZE_FRAC_BITS = 14;
+constexpr int RESIZE_FRAC_VAL = (1 << RESIZE_FRAC_BITS);
+constexpr int RESIZE_FRAC_MASK = (RESIZE_FRAC_VAL - 1);
+
 /**
- * @brief Convert YUV to RGB
+ * Vector versions of the inner loops. The conversions run back to front (so they
+ * work in place, like the reference) and return how many pixels (pairs) at the
+ * start of the buffer they left for the scalar code.
+ */
+struct ImageKernels {
+    const char *name;
+    // out[i] = top[i] + (((bottom[i] - top[i]) * weight + 8192) >> 14), 0 <= weight < 16384
+    void (*blend_rows)(const int16_t *top, const int16_t *bottom, int weight, int count, uint8_t *out);
+    unsigned int (*yuv422_to_rgb888)(uint8_t *rgb_out, const uint8_t *yuv_in, unsigned int pairs);
+    unsigned int (*rgb565_to_rgb888)(uint8_t *rgb_out, const uint8_t *rgb565_in, unsigned int pixels, bool big_endian);
+};
+
+inline uint8_t clamp_u8(int v)
+{
+    return (uint8_t)(v > 255 ? 255 : (v < 0 ? 0 : v));
+}
+
+// One UYVY pixel pair, same math as yuv422_to_rgb888_reference(). Reads before writing.
+inline void yuv422_pair_to_rgb888(const uint8_t *in, uint8_t *out)
+{
+    int u = in[0] - 128;
+    int y0 = in[1] - 16;
+    int v = in[2] - 128;
+    int y1 = in[3] - 16;
+
+    out[0] = clamp_u8((298 * y0 + 409 * v + 128) >> 8);
+    out[1] = clamp_u8((298 * y0 - 100 * u - 208 * v + 128) >> 8);
+    out[2] = clamp_u8((298 * y0 + 516 * u + 128) >> 8);
+    out[3] = clamp_u8((298 * y1 + 409 * v + 128) >> 8);
+    out[4] = clamp_u8((298 * y1 - 100 * u - 208 * v + 128) >> 8);
+    out[5] = clamp_u8((298 * y1 + 516 * u + 128) >> 8);
+}
+
+// Expands 5/6 bit channels by replicating the top bits, so 0x1f becomes 0xff
+inline void rgb565_pixel_to_rgb888(const uint8_t *in, uint8_t *out, bool big_endian)
+{
+    uint16_t v = big_endian ? (uint16_t)((in[0] << 8) | in[1]) : (uint16_t)((in[1] << 8) | in[0]);
+
+    out[0] = (uint8_t)(((v >> 8) & 0xf8) | (v >> 13));
+    out[1] = (uint8_t)(((v >> 3) & 0xfc) | ((v >> 9) & 0x03));
+    out[2] = (uint8_t)(((v << 3) & 0xf8) | ((v >> 2) & 0x07));
+}
+
+void blend_rows_scalar(const int16_t *top, const int16_t *bottom, int weight, int count, uint8_t *out)
+{
+    for (int ix = 0; ix < count; ix++) {
+        out[ix] = (uint8_t)(top[ix] +
+            (((bottom[ix] - top[ix]) * weight + RESIZE_FRAC_VAL / 2) >> RESIZE_FRAC_BITS));
+    }
+}
+
+unsigned int yuv422_to_rgb888_none(uint8_t *rgb_out, const uint8_t *yuv_in, unsigned int pairs)
+{
+    (void)rgb_out;
+    (void)yuv_in;
+    return pairs;
+}
+
+unsigned int rgb565_to_rgb888_none(uint8_t *rgb_out, const uint8_t *rgb565_in, unsigned int pixels, bool big_endian)
+{
+    (void)rgb_out;
+    (void)rgb565_in;
+    (void)big_endian;
+    return pixels;
+}
+
+const ImageKernels scalar_kernels = {
+    "scalar", blend_rows_scalar, yuv422_to_rgb888_none, rgb565_to_rgb888_none
+};
+
+#if defined(EIDSP_IMAGE_SIMD_X86)
+
+// (a * b + 0x4000) >> 15 with b = 2 * weight is exactly (a * weight + 8192) >> 14
+__attribute__((target("sse4.1"))) void blend_rows_sse41(
+    const int16_t *top, const int16_t *bottom, int weight, int count, uint8_t *out)
+{
+    const __m128i w = _mm_set1_epi16((int16_t)(weight * 2));
+    int ix = 0;
+    for (; ix + 8 <= count; ix += 8) {
+        __m128i t = _mm_loadu_si128((const __m128i *)(top + ix));
+        __m128i b = _mm_loadu_si128((const __m128i *)(bottom + ix));
+        __m128i r = _mm_add_epi16(t, _mm_mulhrs_epi16(_mm_sub_epi16(b, t), w));
+        _mm_storel_epi64((__m128i *)(out + ix), _mm_packus_epi16(r, r));
+    }
+    blend_rows_scalar(top + ix, bottom + ix, weight, count - ix, out + ix);
+}
+
+__attribute__((target("avx2"))) void blend_rows_avx2(
+    const int16_t *top, const int16_t *bottom, int weight, int count, uint8_t *out)
+{
+    const __m256i w = _mm256_set1_epi16((int16_t)(weight * 2));
+    int ix = 0;
+    for (; ix + 16 <= count; ix += 16) {
+        __m256i t = _mm256_loadu_si256((const __m256i *)(top + ix));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(bottom + ix));
+        __m256i r = _mm256_add_epi16(t, _mm256_mulhrs_epi16(_mm256_sub_epi16(b, t), w));
+        __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(r, r), 0x08);
+        _mm_storeu_si128((__m128i *)(out + ix), _mm256_castsi256_si128(p));
+    }
+    blend_rows_sse41(top + ix, bottom + ix, weight, count - ix, out + ix);
+}
+
+// Store 8 pixels (16 bit lanes, in pixel order) as 24 bytes of packed RGB888
+__attribute__((target("sse4.1"))) inline void store_rgb888_sse41(
+    uint8_t *out, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i lo_rg = _mm_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+    const __m128i lo_b = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i hi_rg = _mm_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i hi_b = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    __m128i rg = _mm_packus_epi16(r, g);
+    __m128i bb = _mm_packus_epi16(b, b);
+    _mm_storeu_si128((__m128i *)out,
+        _mm_or_si128(_mm_shuffle_epi8(rg, lo_rg), _mm_shuffle_epi8(bb, lo_b)));
+    _mm_storel_epi64((__m128i *)(out + 16),
+        _mm_or_si128(_mm_shuffle_epi8(rg, hi_rg), _mm_shuffle_epi8(bb, hi_b)));
+}
+
+// 4 pixel pairs per iteration, in 32 bit lanes
+__attribute__((target("sse4.1"))) unsigned int yuv422_to_rgb888_sse41(
+    uint8_t *rgb_out, const uint8_t *yuv_in, unsigned int pairs)
+{
+    const __m128i shuf_u = _mm_setr_epi8(0, -1, -1, -1, 4, -1, -1, -1, 8, -1, -1, -1, 12, -1, -1, -1);
+    const __m128i shuf_y0 = _mm_setr_epi8(1, -1, -1, -1, 5, -1, -1, -1, 9, -1, -1, -1, 13, -1, -1, -1);
+    const __m128i shuf_v = _mm_setr_epi8(2, -1, -1, -1, 6, -1, -1, -1, 10, -1, -1, -1, 14, -1, -1, -1);
+    const __m128i shuf_y1 = _mm_setr_epi8(3, -1, -1, -1, 7, -1, -1, -1, 11, -1, -1, -1, 15, -1, -1, -1);
+    const __m128i c16 = _mm_set1_epi32(16);
+    const __m128i c128 = _mm_set1_epi32(128);
+    const __m128i c298 = _mm_set1_epi32(298);
+
+    unsigned int ix = pairs;
+    while (ix >= 4) {
+        ix -= 4;
+        __m128i in = _mm_loadu_si128((const __m128i *)(yuv_in + ix * 4));
+        __m128i u = _mm_sub_epi32(_mm_shuffle_epi8(in, shuf_u), c128);
+        __m128i v = _mm_sub_epi32(_mm_shuffle_epi8(in, shuf_v), c128);
+        __m128i y0 = _mm_mullo_epi32(_mm_sub_epi32(_mm_shuffle_epi8(in, shuf_y0), c16), c298);
+        __m128i y1 = _mm_mullo_epi32(_mm_sub_epi32(_mm_shuffle_epi8(in, shuf_y1), c16), c298);
+
+        __m128i r_uv = _mm_add_epi32(_mm_mullo_epi32(v, _mm_set1_epi32(409)), c128);
+        __m128i g_uv = _mm_sub_epi32(c128, _mm_add_epi32(
+            _mm_mullo_epi32(u, _mm_set1_epi32(100)), _mm_mullo_epi32(v, _mm_set1_epi32(208))));
+        __m128i b_uv = _mm_add_epi32(_mm_mullo_epi32(u, _mm_set1_epi32(516)), c128);
+
+        // put the two pixels of every pair next to each other
+        __m128i y_lo = _mm_unpacklo_epi32(y0, y1);
+        __m128i y_hi = _mm_unpackhi_epi32(y0, y1);
+        __m128i r_lo = _mm_unpacklo_epi32(r_uv, r_uv), r_hi = _mm_unpackhi_epi32(r_uv, r_uv);
+        __m128i g_lo = _mm_unpacklo_epi32(g_uv, g_uv), g_hi = _mm_unpackhi_epi32(g_uv, g_uv);
+        __m128i b_lo = _mm_unpacklo_epi32(b_uv, b_uv), b_hi = _mm_unpackhi_epi32(b_uv, b_uv);
+
+        __m128i r = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y_lo, r_lo), 8),
+            _mm_srai_epi32(_mm_add_epi32(y_hi, r_hi), 8));
+        __m128i g = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y_lo, g_lo), 8),
+            _mm_srai_epi32(_mm_add_epi32(y_hi, g_hi), 8));
+        __m128i b = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y_lo, b_lo), 8),
+            _mm_srai_epi32(_mm_add_epi32(y_hi, b_hi), 8));
+
+        store_rgb888_sse41(rgb_out + ix * 6, r, g, b);
+    }
+    return ix;
+}
+
+// 8 pixels per iteration, in 16 bit lanes
+__attribute__((target("sse4.1"))) unsigned int rgb565_to_rgb888_sse41(
+    uint8_t *rgb_out, const uint8_t *rgb565_in, unsigned int pixels, bool big_endian)
+{
+    const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+    unsigned int ix = pixels;
+    while (ix >= 8) {
+        ix -= 8;
+        __m128i v = _mm_loadu_si128((const __m128i *)(rgb565_in + ix * 2));
+        if (big_endian) {
+            v = _mm_shuffle_epi8(v, swap);
+        }
+        __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 8), _mm_set1_epi16(0xf8)),
+            _mm_srli_epi16(v, 13));
+        __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 3), _mm_set1_epi16(0xfc)),
+            _mm_and_si128(_mm_srli_epi16(v, 9), _mm_set1_epi16(0x03)));
+        __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 3), _mm_set1_epi16(0xf8)),
+            _mm_and_si128(_mm_srli_epi16(v, 2), _mm_set1_epi16(0x07)));
+
+        store_rgb888_sse41(rgb_out + ix * 3, r, g, b);
+    }
+    return ix;
+}
+
+const ImageKernels sse41_kernels = {
+    "sse4.1", blend_rows_sse41, yuv422_to_rgb888_sse41, rgb565_to_rgb888_sse41
+};
+const ImageKernels avx2_kernels = {
+    "avx2", blend_rows_avx2, yuv422_to_rgb888_sse41, rgb565_to_rgb888_sse41
+};
+
+const ImageKernels *detect_kernels()
+{
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2_kernels;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return &sse41_kernels;
+    }
+    return &scalar_kernels;
+}
+
+#elif defined(EIDSP_IMAGE_SIMD_NEON)
+
+// vqrdmulhq_s16(a, 2 * weight) is exactly (a * weight + 8192) >> 14
+void blend_rows_neon(const int16_t *top, const int16_t *bottom, int weight, int count, uint8_t *out)
+{
+    const int16x8_t w = vdupq_n_s16((int16_t)(weight * 2));
+    int ix = 0;
+    for (; ix + 8 <= count; ix += 8) {
+        int16x8_t t = vld1q_s16(top + ix);
+        int16x8_t b = vld1q_s16(bottom + ix);
+        int16x8_t r = vaddq_s16(t, vqrdmulhq_s16(vsubq_s16(b, t), w));
+        vst1_u8(out + ix, vqmovun_s16(r));
+    }
+    blend_rows_scalar(top + ix, bottom + ix, weight, count - ix, out + ix);
+}
+
+inline uint8x8_t yuv_channel_neon(int32x4_t lo, int32x4_t hi)
+{
+    return vqmovun_s16(vcombine_s16(
+        vqmovn_s32(vshrq_n_s32(lo, 8)), vqmovn_s32(vshrq_n_s32(hi, 8))));
+}
+
+// R, G and B of the 8 pixels with luma y, in 32 bit lanes
+inline void yuv_pixels_neon(int16x8_t y, int16x8_t u, int16x8_t v,
+    uint8x8_t *r, uint8x8_t *g, uint8x8_t *b)
+{
+    const int32x4_t c128 = vdupq_n_s32(128);
+    int32x4_t y_lo = vmlaq_n_s32(c128, vmovl_s16(vget_low_s16(y)), 298);
+    int32x4_t y_hi = vmlaq_n_s32(c128, vmovl_s16(vget_high_s16(y)), 298);
+
+    *r = yuv_channel_neon(vmlal_n_s16(y_lo, vget_low_s16(v), 409),
+        vmlal_n_s16(y_hi, vget_high_s16(v), 409));
+    *g = yuv_channel_neon(vmlsl_n_s16(vmlsl_n_s16(y_lo, vget_low_s16(u), 100), vget_low_s16(v), 208),
+        vmlsl_n_s16(vmlsl_n_s16(y_hi, vget_high_s16(u), 100), vget_high_s16(v), 208));
+    *b = yuv_channel_neon(vmlal_n_s16(y_lo, vget_low_s16(u), 516),
+        vmlal_n_s16(y_hi, vget_high_s16(u), 516));
+}
+
+// 8 pixel pairs per iteration
+unsigned int yuv422_to_rgb888_neon(uint8_t *rgb_out, const uint8_t *yuv_in, unsigned int pairs)
+{
+    unsigned int ix = pairs;
+    while (ix >= 8) {
+        ix -= 8;
+        uint8x8x4_t in = vld4_u8(yuv_in + ix * 4);
+        int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(in.val[0], vdup_n_u8(128)));
+        int16x8_t y0 = vreinterpretq_s16_u16(vsubl_u8(in.val[1], vdup_n_u8(16)));
+        int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(in.val[2], vdup_n_u8(128)));
+        int16x8_t y1 = vreinterpretq_s16_u16(vsubl_u8(in.val[3], vdup_n_u8(16)));
+
+        uint8x8_t r0, g0, b0, r1, g1, b1;
+        yuv_pixels_neon(y0, u, v, &r0, &g0, &b0);
+        yuv_pixels_neon(y1, u, v, &r1, &g1, &b1);
+
+        uint8x8x2_t r = vzip_u8(r0, r1);
+        uint8x8x2_t g = vzip_u8(g0, g1);
+        uint8x8x2_t b = vzip_u8(b0, b1);
+        uint8x16x3_t out;
+        out.val[0] = vcombine_u8(r.val[0], r.val[1]);
+        out.val[1] = vcombine_u8(g.val[0], g.val[1]);
+        out.val[2] = vcombine_u8(b.val[0], b.val[1]);
+        vst3q_u8(rgb_out + ix * 6, out);
+    }
+    return ix;
+}
+
+// 8 pixels per iteration
+unsigned int rgb565_to_rgb888_neon(uint8_t *rgb_out, const uint8_t *rgb565_in, unsigned int pixels, bool big_endian)
+{
+    unsigned int ix = pixels;
+    while (ix >= 8) {
+        ix -= 8;
+        uint8x16_t bytes = vld1q_u8(rgb565_in + ix * 2);
+        if (big_endian) {
+            bytes = vrev16q_u8(bytes);
+        }
+        uint16x8_t v = vreinterpretq_u16_u8(bytes);
+
+        uint8x8x3_t out;
+        out.val[0] = vmovn_u16(vorrq_u16(vandq_u16(vshrq_n_u16(v, 8), vdupq_n_u16(0xf8)),
+            vshrq_n_u16(v, 13)));
+        out.val[1] = vmovn_u16(vorrq_u16(vandq_u16(vshrq_n_u16(v, 3), vdupq_n_u16(0xfc)),
+            vandq_u16(vshrq_n_u16(v, 9), vdupq_n_u16(0x03))));
+        out.val[2] = vmovn_u16(vorrq_u16(vandq_u16(vshlq_n_u16(v, 3), vdupq_n_u16(0xf8)),
+            vandq_u16(vshrq_n_u16(v, 2), vdupq_n_u16(0x07))));
+        vst3_u8(rgb_out + ix * 3, out);
+    }
+    return ix;
+}
+
+const ImageKernels neon_kernels = {
+    "neon", blend_rows_neon, yuv422_to_rgb888_neon, rgb565_to_rgb888_neon
+};
+
+const ImageKernels *detect_kernels()
+{
+    return &neon_kernels;
+}
+
+#else
+
+const ImageKernels *detect_kernels()
+{
+    return &scalar_kernels;
+}
+
+#endif // EIDSP_IMAGE_SIMD_X86 / EIDSP_IMAGE_SIMD_NEON
+
+const ImageKernels *get_kernels()
+{
+    static const ImageKernels *kernels = detect_kernels();
+    return kernels;
+}
+
+} // namespace
+
+/**
+ * @brief Convert YUV to RGB, scalar reference implementation
  *
  * @param rgb_out Output buffer (can be the same as yuv_in if big enough)
  * @param yuv_in Input buffer
  * @param in_size_B Size of input image in B
  * @param opts Note, only BIG_ENDIAN_ORDER supported presently
  */
-int yuv422_to_rgb888(
+int yuv422_to_rgb888_reference(
     unsigned char *rgb_out,
     unsigned const char *yuv_in,
     unsigned int in_size_B,
@@ -105,8 +447,87 @@ int yuv422_to_rgb888(
 }
 
 /**
- * @brief Crops an image. Can be in-place. 4B alignment for best performance
- * (Alignment is tested, will fall back to B by B movement)
+ * @brief Convert YUV to RGB
+ * Same results as yuv422_to_rgb888_reference(), vectorized on hosts with
+ * SSE4.1 or NEON
+ *
+ * @param rgb_out Output buffer (can be the same as yuv_in if big enough)
+ * @param yuv_in Input buffer
+ * @param in_size_B Size of input image in B
+ * @param opts Note, only BIG_ENDIAN_ORDER supported presently
+ */
+int yuv422_to_rgb888(
+    unsigned char *rgb_out,
+    unsigned const char *yuv_in,
+    unsigned int in_size_B,
+    YUV_OPTIONS opts)
+{
+    if (!TEST_BIT_MASK(opts, BIG_ENDIAN_ORDER) || TEST_BIT_MASK(opts, PAD_4B) || (in_size_B % 4) != 0) {
+        return yuv422_to_rgb888_reference(rgb_out, yuv_in, in_size_B, opts);
+    }
+
+    const ImageKernels *kernels = get_kernels();
+    if (kernels->yuv422_to_rgb888 == yuv422_to_rgb888_none) {
+        return yuv422_to_rgb888_reference(rgb_out, yuv_in, in_size_B, opts);
+    }
+
+    unsigned int pairs = kernels->yuv422_to_rgb888(rgb_out, yuv_in, in_size_B / 4);
+
+    // back to front, so this works in place too
+    while (pairs > 0) {
+        pairs--;
+        yuv422_pair_to_rgb888(&yuv_in[pairs * 4], &rgb_out[pairs * 6]);
+    }
+    return EIDSP_OK;
+}
+
+/**
+ * @brief Convert RGB565 to RGB, scalar reference implementation
+ *
+ * @param rgb_out Output buffer (can be the same as rgb565_in if big enough)
+ * @param rgb565_in Input buffer
+ * @param in_size_B Size of input image in B
+ * @param big_endian High byte of every pixel first (as delivered by most camera drivers)
+ */
+int rgb565_to_rgb888_reference(
+    unsigned char *rgb_out,
+    unsigned const char *rgb565_in,
+    unsigned int in_size_B,
+    bool big_endian)
+{
+    for (unsigned int pixel = in_size_B / 2; pixel > 0; pixel--) {
+        rgb565_pixel_to_rgb888(&rgb565_in[(pixel - 1) * 2], &rgb_out[(pixel - 1) * 3], big_endian);
+    }
+    return EIDSP_OK;
+}
+
+/**
+ * @brief Convert RGB565 to RGB, 5 and 6 bit channels are expanded by repeating
+ * their top bits. Vectorized on hosts with SSE4.1 or NEON.
+ *
+ * @param rgb_out Output buffer (can be the same as rgb565_in if big enough)
+ * @param rgb565_in Input buffer
+ * @param in_size_B Size of input image in B
+ * @param big_endian High byte of every pixel first (as delivered by most camera drivers)
+ */
+int rgb565_to_rgb888(
+    unsigned char *rgb_out,
+    unsigned const char *rgb565_in,
+    unsigned int in_size_B,
+    bool big_endian)
+{
+    unsigned int pixels = get_kernels()->rgb565_to_rgb888(rgb_out, rgb565_in, in_size_B / 2, big_endian);
+
+    // back to front, so this works in place too
+    while (pixels > 0) {
+        pixels--;
+        rgb565_pixel_to_rgb888(&rgb565_in[pixels * 2], &rgb_out[pixels * 3], big_endian);
+    }
+    return EIDSP_OK;
+}
+
+/**
+ * @brief Crops an image. Can be in-place.
  *
  * @param srcWidth X dimension in pixels
  * @param srcHeight Y dimension in pixels
@@ -129,8 +550,7 @@ int cropImage(
     int dstHeight,
     int iBpp)
 {
-    uint32_t *s32, *d32;
-    int x, y;
+    int y;
 
     if (startX < 0 || startX >= srcWidth || startY < 0 || startY >= srcHeight ||
         (startX + dstWidth) > srcWidth || (startY + dstHeight) > srcHeight) {
@@ -140,61 +560,16 @@ int cropImage(
         return EIDSP_PARAMETER_INVALID;
     }
 
-    if (iBpp == 8) {
-        const uint8_t *s;
-        uint8_t *d;
-        for (y = 0; y < dstHeight; y++) {
-            s = &srcImage[srcWidth * (y + startY) + startX];
-            d = &dstImage[(dstWidth * y)];
-            x = 0;
-            if ((intptr_t)s & 3 || (intptr_t)d & 3) { // either src or dst pointer is not aligned
-                for (; x < dstWidth; x++) {
-                    *d++ = *s++; // have to do it byte-by-byte
-                }
-            }
-            else {
-                // move 4 bytes at a time if aligned or alignment not enforced
-                s32 = (uint32_t *)s;
-                d32 = (uint32_t *)d;
-                for (; x < dstWidth - 3; x += 4) {
-                    *d32++ = *s32++;
-                }
-                // any remaining stragglers?
-                s = (uint8_t *)s32;
-                d = (uint8_t *)d32;
-                for (; x < dstWidth; x++) {
-                    *d++ = *s++;
-                }
-            }
-        } // for y
-    } // 8-bpp
-    else {
-        uint16_t *s, *d;
-        for (y = 0; y < dstHeight; y++) {
-            s = (uint16_t *)&srcImage[2 * srcWidth * (y + startY) + startX * 2];
-            d = (uint16_t *)&dstImage[(dstWidth * y * 2)];
-            x = 0;
-            if ((intptr_t)s & 2 || (intptr_t)d & 2) { // either src or dst pointer is not aligned
-                for (; x < dstWidth; x++) {
-                    *d++ = *s++; // have to do it 16-bits at a time
-                }
-            }
-            else {
-                // move 4 bytes at a time if aligned or alignment no enforced
-                s32 = (uint32_t *)s;
-                d32 = (uint32_t *)d;
-                for (; x < dstWidth - 1; x += 2) { // we can move 2 pixels at a time
-                    *d32++ = *s32++;
-                }
-                // any remaining stragglers?
-                s = (uint16_t *)s32;
-                d = (uint16_t *)d32;
-                for (; x < dstWidth; x++) {
-                    *d++ = *s++;
-                }
-            }
-        } // for y
-    } // 16-bpp case
+    // rows move to lower (or the same) addresses, so front to back works in place;
+    // memmove uses the widest copies the platform has
+    const int bytes_pp = iBpp / 8;
+    for (y = 0; y < dstHeight; y++) {
+        const uint8_t *s = &srcImage[bytes_pp * (srcWidth * (y + startY) + startX)];
+        uint8_t *d = &dstImage[bytes_pp * dstWidth * y];
+        if (s != d) {
+            memmove(d, s, bytes_pp * dstWidth);
+        }
+    }
 
     return EIDSP_OK;
 } /* cropImage() */
@@ -235,7 +610,7 @@ int crop_image_rgb888_packed(
 }
 
 /**
- * @brief Resize an image using interpolation
+ * @brief Resize an image using interpolation, scalar reference implementation
  * Can be used to resize the image smaller or larger
  * If resizing much smaller than 1/3 size, then a more rubust algorithm should average all of the pixels
  * This algorithm uses bilinear interpolation - averages a 2x2 region to generate each new pixel
@@ -248,7 +623,7 @@ int crop_image_rgb888_packed(
  * @param dstImage Output buffer, can be same as input buffer
  * @param pixel_size_B Size of pixels in Bytes.  3 for RGB, 1 for mono
  */
-int resize_image(
+int resize_image_reference(
     const uint8_t *srcImage,
     int srcWidth,
     int srcHeight,
@@ -323,6 +698,225 @@ int resize_image(
     return EIDSP_OK;
 } // resizeImage()
 
+namespace {
+
+// Source rows interpolated horizontally to the output width, two are cached
+// so rows shared by consecutive output rows are only computed once
+typedef struct {
+    const uint8_t *src;
+    int src_stride;
+    const int32_t *x_offset;    // per output column, first source byte
+    const int16_t *x_frac;      // per output column, weight of the right neighbour
+    int width;
+    int interp_width;           // leading columns that have a right neighbour
+    int pixel_size;
+    int16_t *rows[2];
+    int row_ix[2];
+} resize_rows_t;
+
+// Interpolate source row `s` horizontally
+void resize_row(const resize_rows_t *ctx, const uint8_t *s, int16_t *out)
+{
+    const int c = ctx->pixel_size;
+    int x = 0;
+
+    // a zero weight gives the left pixel, so only the columns past the last source
+    // pixel (upscaling) need to skip reading the right neighbour
+    if (c == RGB888_B_SIZE) {
+        for (; x < ctx->interp_width; x++) {
+            const uint8_t *p = s + ctx->x_offset[x];
+            const int frac = ctx->x_frac[x];
+            out[0] = (int16_t)(p[0] + (((p[3] - p[0]) * frac + RESIZE_FRAC_VAL / 2) >> RESIZE_FRAC_BITS));
+            out[1] = (int16_t)(p[1] + (((p[4] - p[1]) * frac + RESIZE_FRAC_VAL / 2) >> RESIZE_FRAC_BITS));
+            out[2] = (int16_t)(p[2] + (((p[5] - p[2]) * frac + RESIZE_FRAC_VAL / 2) >> RESIZE_FRAC_BITS));
+            out += 3;
+        }
+    }
+    else {
+        for (; x < ctx->interp_width; x++) {
+            const uint8_t *p = s + ctx->x_offset[x];
+            const int frac = ctx->x_frac[x];
+            for (int color = 0; color < c; color++) {
+                *out++ = (int16_t)(p[color] +
+                    (((p[color + c] - p[color]) * frac + RESIZE_FRAC_VAL / 2) >> RESIZE_FRAC_BITS));
+            }
+        }
+    }
+    for (; x < ctx->width; x++) {
+        const uint8_t *p = s + ctx->x_offset[x];
+        for (int color = 0; color < c; color++) {
+            *out++ = p[color];
+        }
+    }
+}
+
+// Column offsets and weights, same steps as resize_image_reference()
+void resize_columns(int32_t *x_offset, int16_t *x_frac, int srcWidth, int dstWidth, int pixel_size,
+    int *interp_width)
+{
+    const uint32_t src_x_frac = (srcWidth * RESIZE_FRAC_VAL) / dstWidth;
+
+    *interp_width = 0;
+    uint32_t src_x_accum = 0;
+    for (int x = 0; x < dstWidth; x++) {
+        int tx = src_x_accum >> RESIZE_FRAC_BITS;
+        x_offset[x] = tx * pixel_size;
+        x_frac[x] = (int16_t)(src_x_accum & RESIZE_FRAC_MASK);
+        if (tx + 1 < srcWidth) {
+            *interp_width = x + 1;
+        }
+        src_x_accum += src_x_frac;
+    }
+}
+
+// Get a (cached) row, without evicting row `keep`
+int16_t *resize_cached_row(resize_rows_t *ctx, int row, int keep)
+{
+    if (ctx->row_ix[0] == row) {
+        return ctx->rows[0];
+    }
+    if (ctx->row_ix[1] == row) {
+        return ctx->rows[1];
+    }
+    int slot = ctx->row_ix[0] == keep ? 1 : 0;
+    resize_row(ctx, ctx->src + row * ctx->src_stride, ctx->rows[slot]);
+    ctx->row_ix[slot] = row;
+    return ctx->rows[slot];
+}
+
+} // namespace
+
+/**
+ * @brief Resize an image using interpolation
+ * Can be used to resize the image smaller or larger
+ * If resizing much smaller than 1/3 size, then a more rubust algorithm should average all of the pixels
+ * This algorithm uses bilinear interpolation - averages a 2x2 region to generate each new pixel
+ *
+ * Same results as resize_image_reference(), but every source row is interpolated
+ * horizontally only once (from precomputed column offsets and weights), and the
+ * vertical blend is vectorized on hosts with SSE4.1, AVX2 or NEON. At the right
+ * and bottom edge of an upscaled image the last pixel is repeated, where the
+ * reference reads past the row.
+ *
+ * @param srcWidth Input image width in pixels
+ * @param srcHeight Input image height in pixels
+ * @param srcImage Input buffer
+ * @param dstWidth Output image width in pixels
+ * @param dstHeight Output image height in pixels
+ * @param dstImage Output buffer, can be same as input buffer (when downscaling)
+ * @param pixel_size_B Size of pixels in Bytes.  3 for RGB, 1 for mono
+ */
+int resize_image(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    uint8_t *dstImage,
+    int dstWidth,
+    int dstHeight,
+    int pixel_size_B)
+{
+    if (srcHeight < 2) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+
+    uint8_t *scratch = (uint8_t *)ei_malloc(resize_image_scratch_size(dstWidth, pixel_size_B));
+    if (!scratch) {
+        return resize_image_reference(
+            srcImage, srcWidth, srcHeight, dstImage, dstWidth, dstHeight, pixel_size_B);
+    }
+
+    int ret = resize_image_with_scratch(
+        srcImage, srcWidth, srcHeight, dstImage, dstWidth, dstHeight, pixel_size_B, scratch);
+    ei_free(scratch);
+    return ret;
+}
+
+/**
+ * @brief Bytes of scratch memory resize_image_with_scratch() needs for an output row
+ *
+ * @param dstWidth Output image width in pixels
+ * @param pixel_size_B Size of pixels in Bytes.  3 for RGB, 1 for mono
+ */
+size_t resize_image_scratch_size(int dstWidth, int pixel_size_B)
+{
+    // two interpolated source rows, then the column offsets and weights
+    return 2 * (size_t)dstWidth * pixel_size_B * sizeof(int16_t) +
+        (size_t)dstWidth * (sizeof(int32_t) + sizeof(int16_t));
+}
+
+/**
+ * @brief resize_image() with caller owned scratch memory, for callers that resize
+ * every frame and keep the buffer around
+ *
+ * @param scratch At least resize_image_scratch_size(dstWidth, pixel_size_B) bytes,
+ *                aligned for int32_t
+ */
+int resize_image_with_scratch(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    uint8_t *dstImage,
+    int dstWidth,
+    int dstHeight,
+    int pixel_size_B,
+    uint8_t *scratch)
+{
+    if (srcHeight < 2 || !scratch) {
+        return EIDSP_PARAMETER_INVALID;
+    }
+
+    const int row_size = dstWidth * pixel_size_B;
+
+    resize_rows_t ctx;
+    ctx.src = srcImage;
+    ctx.src_stride = srcWidth * pixel_size_B;
+    ctx.width = dstWidth;
+    ctx.pixel_size = pixel_size_B;
+    ctx.rows[0] = (int16_t *)scratch;
+    ctx.rows[1] = ctx.rows[0] + row_size;
+    ctx.row_ix[0] = -1;
+    ctx.row_ix[1] = -1;
+
+    int32_t *x_offset = (int32_t *)(ctx.rows[1] + row_size);
+    int16_t *x_frac = (int16_t *)(x_offset + dstWidth);
+    ctx.x_offset = x_offset;
+    ctx.x_frac = x_frac;
+
+    resize_columns(x_offset, x_frac, srcWidth, dstWidth, pixel_size_B, &ctx.interp_width);
+
+    const uint32_t src_y_frac = (srcHeight * RESIZE_FRAC_VAL) / dstHeight;
+
+    const ImageKernels *kernels = get_kernels();
+
+    uint32_t src_y_accum = 0;
+    for (int y = 0; y < dstHeight; y++) {
+        int ty = src_y_accum >> RESIZE_FRAC_BITS;
+        int y_frac = (ty + 1 < srcHeight) ? (int)(src_y_accum & RESIZE_FRAC_MASK) : 0;
+        src_y_accum += src_y_frac;
+
+        uint8_t *d = &dstImage[y * row_size];
+        int16_t *top = resize_cached_row(&ctx, ty, ty + 1);
+        if (y_frac == 0) {
+            kernels->blend_rows(top, top, 0, row_size, d);
+        }
+        else {
+            int16_t *bottom = resize_cached_row(&ctx, ty + 1, ty);
+            kernels->blend_rows(top, bottom, y_frac, row_size, d);
+        }
+    }
+
+    return EIDSP_OK;
+}
+
+/**
+ * @brief Name of the vector instruction set used by the image functions
+ * ("avx2", "sse4.1", "neon" or "scalar")
+ */
+const char *get_image_kernels_name()
+{
+    return get_kernels()->name;
+}
+
 /**
  * @brief Calculate new dims that match the aspect ratio of destination
  * This prevents a squashed look
@@ -544,6 +1138,285 @@ int resize_image_using_mode(
     // shouldn't get here
     return -2;
 }
+
+struct resize_stream {
+    resize_rows_t cols;         // column tables and the two cached rows (src unused)
+    IMAGE_FORMAT format;
+    int src_bpp;                // bytes per source pixel
+    int src_stride;             // bytes per source row
+    int src_height;
+    int crop_x, crop_y;         // part of the source that is resized
+    int crop_width, crop_height;
+    int resize_height;          // rows of the resized image ...
+    int offset_x, offset_y;     // ... and its place in the output (fit-longest pads around it)
+    int dst_width, dst_height;
+    uint32_t src_y_frac;
+    uint32_t src_y_accum;       // position of the next resized row
+    int src_row;                // next source row to be pushed
+    int resized_row;            // next resized row
+    int out_row;                // next output row
+    uint8_t *out;               // one output row
+    uint8_t *line;              // one converted source row (RGB565 and YUV422 sources)
+    resize_stream_row_fn row_fn;
+    void *user_data;
+    uint8_t *scratch;
+};
+
+namespace {
+
+// Hand out the rows of padding (fit-longest) up to output row `end`
+void resize_stream_pad_rows(resize_stream_t *stream, int end)
+{
+    if (stream->out_row >= end) {
+        return;
+    }
+    memset(stream->out, 0, stream->dst_width * stream->cols.pixel_size);
+    for (; stream->out_row < end; stream->out_row++) {
+        stream->row_fn(stream->out, stream->out_row, stream->user_data);
+    }
+}
+
+// Source rows of the next resized row
+inline void resize_stream_next_rows(const resize_stream_t *stream, int *ty, int *y_frac)
+{
+    *ty = stream->src_y_accum >> RESIZE_FRAC_BITS;
+    *y_frac = (*ty + 1 < stream->crop_height) ? (int)(stream->src_y_accum & RESIZE_FRAC_MASK) : 0;
+}
+
+inline int16_t *resize_stream_row(resize_stream_t *stream, int row)
+{
+    if (stream->cols.row_ix[0] == row) {
+        return stream->cols.rows[0];
+    }
+    if (stream->cols.row_ix[1] == row) {
+        return stream->cols.rows[1];
+    }
+    return nullptr;
+}
+
+// Blend and hand out every resized row whose source rows are cached
+void resize_stream_emit(resize_stream_t *stream)
+{
+    const ImageKernels *kernels = get_kernels();
+    const int c = stream->cols.pixel_size;
+    const int count = stream->cols.width * c;
+    uint8_t *d = stream->out + stream->offset_x * c;
+
+    while (stream->resized_row < stream->resize_height) {
+        int ty, y_frac;
+        resize_stream_next_rows(stream, &ty, &y_frac);
+
+        int16_t *top = resize_stream_row(stream, ty);
+        if (!top) {
+            break;
+        }
+        if (y_frac == 0) {
+            kernels->blend_rows(top, top, 0, count, d);
+        }
+        else {
+            int16_t *bottom = resize_stream_row(stream, ty + 1);
+            if (!bottom) {
+                break;
+            }
+            kernels->blend_rows(top, bottom, y_frac, count, d);
+        }
+
+        stream->row_fn(stream->out, stream->out_row++, stream->user_data);
+        stream->resized_row++;
+        stream->src_y_accum += stream->src_y_frac;
+    }
+
+    if (stream->resized_row == stream->resize_height) {
+        resize_stream_pad_rows(stream, stream->dst_height);
+    }
+}
+
+// Crop and convert a needed source row to RGB888 (or gray), then interpolate it
+void resize_stream_add_row(resize_stream_t *stream, const uint8_t *src, int row, int keep)
+{
+    const uint8_t *s;
+    switch (stream->format) {
+        case IMAGE_FORMAT_RGB565:
+            rgb565_to_rgb888(stream->line, src + stream->crop_x * 2, stream->crop_width * 2, true);
+            s = stream->line;
+            break;
+        case IMAGE_FORMAT_YUV422: {
+            // convert whole pixel pairs
+            const int x0 = stream->crop_x & ~1;
+            const int pairs = (stream->crop_x + stream->crop_width - x0 + 1) / 2;
+            yuv422_to_rgb888(stream->line, src + x0 * 2, pairs * 4, BIG_ENDIAN_ORDER);
+            s = stream->line + (stream->crop_x - x0) * 3;
+            break;
+        }
+        default:
+            s = src + stream->crop_x * stream->src_bpp;
+            break;
+    }
+
+    int slot = stream->cols.row_ix[0] == keep ? 1 : 0;
+    resize_row(&stream->cols, s, stream->cols.rows[slot]);
+    stream->cols.row_ix[slot] = row;
+}
+
+} // namespace
+
+resize_stream_t *resize_stream_create(
+    int srcWidth,
+    int srcHeight,
+    IMAGE_FORMAT format,
+    int dstWidth,
+    int dstHeight,
+    int mode,
+    resize_stream_row_fn row_fn,
+    void *user_data)
+{
+    if (srcWidth < 1 || srcHeight < 1 || dstWidth < 1 || dstHeight < 1 || !row_fn) {
+        EI_LOGE("resize_stream_create: invalid parameters\n");
+        return nullptr;
+    }
+    if (format == IMAGE_FORMAT_YUV422 && (srcWidth & 1)) {
+        EI_LOGE("resize_stream_create: YUV422 width must be even\n");
+        return nullptr;
+    }
+
+    // same geometry as resize_image_using_mode()
+    int crop_x = 0, crop_y = 0, crop_width = srcWidth, crop_height = srcHeight;
+    int resize_width = dstWidth, resize_height = dstHeight;
+    int offset_x = 0, offset_y = 0;
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        // plain copy
+    }
+    else if (mode == EI_CLASSIFIER_RESIZE_FIT_SHORTEST) {
+        calculate_crop_dims(srcWidth, srcHeight, dstWidth, dstHeight, crop_width, crop_height);
+        crop_x = (srcWidth - crop_width) / 2;
+        crop_y = (srcHeight - crop_height) / 2;
+    }
+    else if (mode == EI_CLASSIFIER_RESIZE_FIT_LONGEST) {
+        float srcAspect = static_cast<float>(srcWidth) / srcHeight;
+        float dstAspect = static_cast<float>(dstWidth) / dstHeight;
+        if (srcAspect > dstAspect) {
+            resize_height = static_cast<int>(dstWidth / srcAspect);
+        }
+        else {
+            resize_width = static_cast<int>(dstHeight * srcAspect);
+        }
+        offset_x = (dstWidth - resize_width) / 2;
+        offset_y = (dstHeight - resize_height) / 2;
+    }
+    else if (mode != EI_CLASSIFIER_RESIZE_SQUASH) {
+        EI_LOGE("resize_stream_create: unsupported resize mode %d\n", mode);
+        return nullptr;
+    }
+
+    if (crop_width < 1 || crop_width > srcWidth || crop_height < 2 || crop_height > srcHeight ||
+        resize_width < 1 || resize_height < 1) {
+        EI_LOGE("resize_stream_create: can't resize %dx%d to %dx%d\n", srcWidth, srcHeight, dstWidth, dstHeight);
+        return nullptr;
+    }
+
+    const int pixel_size = format == IMAGE_FORMAT_GRAYSCALE ? MONO_B_SIZE : RGB888_B_SIZE;
+    const bool convert = format == IMAGE_FORMAT_RGB565 || format == IMAGE_FORMAT_YUV422;
+    const size_t row_size = resize_width * pixel_size;
+    const size_t scratch_size = resize_width * sizeof(int32_t) + 2 * row_size * sizeof(int16_t) +
+        resize_width * sizeof(int16_t) + dstWidth * pixel_size + (convert ? (crop_width + 2) * 3 : 0);
+
+    resize_stream_t *stream = (resize_stream_t *)ei_calloc(1, sizeof(resize_stream_t));
+    uint8_t *scratch = (uint8_t *)ei_calloc(1, scratch_size);
+    if (!stream || !scratch) {
+        EI_LOGE("resize_stream_create: out of memory\n");
+        ei_free(stream);
+        ei_free(scratch);
+        return nullptr;
+    }
+
+    int32_t *x_offset = (int32_t *)scratch;
+    stream->cols.rows[0] = (int16_t *)(x_offset + resize_width);
+    stream->cols.rows[1] = stream->cols.rows[0] + row_size;
+    int16_t *x_frac = stream->cols.rows[1] + row_size;
+    stream->out = (uint8_t *)(x_frac + resize_width);
+    stream->line = convert ? stream->out + dstWidth * pixel_size : nullptr;
+    stream->scratch = scratch;
+
+    resize_columns(x_offset, x_frac, crop_width, resize_width, pixel_size, &stream->cols.interp_width);
+    stream->cols.src = nullptr;
+    stream->cols.src_stride = 0;
+    stream->cols.x_offset = x_offset;
+    stream->cols.x_frac = x_frac;
+    stream->cols.width = resize_width;
+    stream->cols.pixel_size = pixel_size;
+    stream->cols.row_ix[0] = -1;
+    stream->cols.row_ix[1] = -1;
+
+    stream->format = format;
+    stream->src_bpp = format == IMAGE_FORMAT_RGB888 ? 3 : (format == IMAGE_FORMAT_GRAYSCALE ? 1 : 2);
+    stream->src_stride = srcWidth * stream->src_bpp;
+    stream->src_height = srcHeight;
+    stream->crop_x = crop_x;
+    stream->crop_y = crop_y;
+    stream->crop_width = crop_width;
+    stream->crop_height = crop_height;
+    stream->resize_height = resize_height;
+    stream->offset_x = offset_x;
+    stream->offset_y = offset_y;
+    stream->dst_width = dstWidth;
+    stream->dst_height = dstHeight;
+    stream->src_y_frac = (crop_height * RESIZE_FRAC_VAL) / resize_height;
+    stream->row_fn = row_fn;
+    stream->user_data = user_data;
+
+    return stream;
+}
+
+int resize_stream_push_rows(resize_stream_t *stream, const uint8_t *rows, int row_count)
+{
+    if (row_count < 0 || stream->src_row + row_count > stream->src_height) {
+        return EIDSP_OUT_OF_BOUNDS;
+    }
+
+    if (stream->src_row == 0) {
+        resize_stream_pad_rows(stream, stream->offset_y);
+    }
+
+    for (int ix = 0; ix < row_count; ix++, stream->src_row++) {
+        const int row = stream->src_row - stream->crop_y;
+        if (row < 0 || row >= stream->crop_height || stream->resized_row >= stream->resize_height) {
+            continue;
+        }
+
+        // rows arrive in order, so only the rows of the next resized row are still needed
+        int ty, y_frac;
+        resize_stream_next_rows(stream, &ty, &y_frac);
+        if (row != ty && !(row == ty + 1 && y_frac != 0)) {
+            continue;
+        }
+
+        resize_stream_add_row(stream, rows + ix * stream->src_stride, row, ty);
+        resize_stream_emit(stream);
+    }
+
+    return EIDSP_OK;
+}
+
+bool resize_stream_done(const resize_stream_t *stream)
+{
+    return stream->out_row == stream->dst_height;
+}
+
+int resize_stream_pixel_size(const resize_stream_t *stream)
+{
+    return stream->cols.pixel_size;
+}
+
+void resize_stream_free(resize_stream_t *stream)
+{
+    if (!stream) {
+        return;
+    }
+    ei_free(stream->scratch);
+    ei_free(stream);
+}
+
 } //namespaces
 }
 }
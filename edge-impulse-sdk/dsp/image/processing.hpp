@@ -57,6 +57,41 @@ int yuv422_to_rgb888(
     unsigned int in_size_B,
     YUV_OPTIONS opts);
 
+/**
+ * @copydoc yuv422_to_rgb888()
+ * Scalar reference implementation.
+ */
+int yuv422_to_rgb888_reference(
+    unsigned char *rgb_out,
+    unsigned const char *yuv_in,
+    unsigned int in_size_B,
+    YUV_OPTIONS opts);
+
+/**
+ * @brief Convert RGB565 to RGB, 5 and 6 bit channels are expanded by repeating
+ * their top bits
+ *
+ * @param rgb_out Output buffer (can be the same as rgb565_in if big enough)
+ * @param rgb565_in Input buffer
+ * @param in_size_B Size of input image in B
+ * @param big_endian High byte of every pixel first (as delivered by most camera drivers)
+ */
+int rgb565_to_rgb888(
+    unsigned char *rgb_out,
+    unsigned const char *rgb565_in,
+    unsigned int in_size_B,
+    bool big_endian = true);
+
+/**
+ * @copydoc rgb565_to_rgb888()
+ * Scalar reference implementation.
+ */
+int rgb565_to_rgb888_reference(
+    unsigned char *rgb_out,
+    unsigned const char *rgb565_in,
+    unsigned int in_size_B,
+    bool big_endian = true);
+
 /**
  * @brief Crops an image. Can be in-place. 4B alignment for best performance
  * (Alignment is tested, will fall back to B by B movement)
@@ -130,6 +165,52 @@ int resize_image(
     int dstHeight,
     int pixel_size_B);
 
+/**
+ * @brief Bytes of scratch memory resize_image_with_scratch() needs for an output row
+ *
+ * @param dstWidth Output image width in pixels
+ * @param pixel_size_B Size of pixels in Bytes.  3 for RGB, 1 for mono
+ */
+size_t resize_image_scratch_size(int dstWidth, int pixel_size_B);
+
+/**
+ * @copydoc resize_image()
+ * Uses caller owned scratch memory instead of allocating it on every call, for
+ * callers that resize every frame and keep the buffer around.
+ *
+ * @param scratch At least resize_image_scratch_size(dstWidth, pixel_size_B) bytes,
+ *                aligned for int32_t
+ */
+int resize_image_with_scratch(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    uint8_t *dstImage,
+    int dstWidth,
+    int dstHeight,
+    int pixel_size_B,
+    uint8_t *scratch);
+
+/**
+ * @copydoc resize_image()
+ * Scalar reference implementation, resize_image() returns the same results
+ * (except past the edge of an upscaled image, where this reads past the row).
+ */
+int resize_image_reference(
+    const uint8_t *srcImage,
+    int srcWidth,
+    int srcHeight,
+    uint8_t *dstImage,
+    int dstWidth,
+    int dstHeight,
+    int pixel_size_B);
+
+/**
+ * @brief Name of the vector instruction set used by the image functions
+ * ("avx2", "sse4.1", "neon" or "scalar")
+ */
+const char *get_image_kernels_name();
+
 /**
  * @brief Calculate new dims that match the aspect ratio of destination
  * This prevents a squashed look
@@ -216,5 +297,79 @@ int resize_image_using_mode(
     int dstHeight,
     int pixel_size_B,
     int mode);
+
+/**
+ * Pixel formats of the source rows of a resize stream
+ */
+enum IMAGE_FORMAT
+{
+    IMAGE_FORMAT_RGB888 = 0,
+    IMAGE_FORMAT_RGB565 = 1, // 2 bytes per pixel, high byte first
+    IMAGE_FORMAT_YUV422 = 2, // UYVY pixel pairs, width must be even
+    IMAGE_FORMAT_GRAYSCALE = 3,
+};
+
+/**
+ * @brief Called for every output row of a resize stream, in order
+ *
+ * @param row Output row, dstWidth pixels of RGB888 (or 1 byte for grayscale sources)
+ * @param y Index of the row in the output image
+ * @param user_data As passed to resize_stream_create()
+ */
+typedef void (*resize_stream_row_fn)(const uint8_t *row, int y, void *user_data);
+
+typedef struct resize_stream resize_stream_t;
+
+/**
+ * @brief Crop, colour convert and resize an image that arrives a few rows at a
+ * time (e.g. from camera DMA buffers). Every output row is handed to row_fn as
+ * soon as the source rows it's interpolated from were pushed, so the full frame
+ * (converted or resized) is never held in memory. Source rows that no output
+ * row is interpolated from are skipped without converting them.
+ * The output is the same as colour converting the frame and calling
+ * resize_image_using_mode().
+ *
+ * @param srcWidth Source width in pixels
+ * @param srcHeight Source height in pixels
+ * @param format Pixel format of the source rows
+ * @param dstWidth Output width in pixels
+ * @param dstHeight Output height in pixels
+ * @param mode Resizing mode (FIT_SHORTEST=1, FIT_LONGEST=2, SQUASH=3)
+ * @param row_fn Called with every output row
+ * @param user_data Passed to row_fn
+ * @return New stream (free with resize_stream_free()), nullptr if out of memory
+ * or the parameters are invalid
+ */
+resize_stream_t *resize_stream_create(
+    int srcWidth,
+    int srcHeight,
+    IMAGE_FORMAT format,
+    int dstWidth,
+    int dstHeight,
+    int mode,
+    resize_stream_row_fn row_fn,
+    void *user_data);
+
+/**
+ * @brief Push the next source rows of the image
+ *
+ * @param stream Stream from resize_stream_create()
+ * @param rows Whole rows in the source format, without padding between them
+ * @param row_count Number of rows
+ * @return int EIDSP_OK, or EIDSP_OUT_OF_BOUNDS when pushing past the last row
+ */
+int resize_stream_push_rows(resize_stream_t *stream, const uint8_t *rows, int row_count);
+
+/**
+ * @brief Whether all output rows were handed out
+ */
+bool resize_stream_done(const resize_stream_t *stream);
+
+/**
+ * @brief Bytes per pixel of the output rows (3, or 1 for grayscale sources)
+ */
+int resize_stream_pixel_size(const resize_stream_t *stream);
+
+void resize_stream_free(resize_stream_t *stream);
 }}} //namespaces
 #endif //!__EI_IMAGE_PROCESSING__H__
\ No newline at end of file
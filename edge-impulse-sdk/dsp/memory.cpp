@@ -32,3 +32,177 @@
 
 size_t ei_memory_in_use = 0;
 size_t ei_memory_peak_use = 0;
+
+#include "ei_dsp_scratch.h"
+
+// the open scope is per thread where threads exist
+#ifndef EIDSP_SCRATCH_THREAD_LOCAL
+#if defined(__unix__) || defined(__APPLE__) || defined(_WIN32) || defined(ESP_PLATFORM)
+#define EIDSP_SCRATCH_THREAD_LOCAL   thread_local
+#else
+#define EIDSP_SCRATCH_THREAD_LOCAL
+#endif
+#endif // EIDSP_SCRATCH_THREAD_LOCAL
+
+namespace ei {
+
+#define EI_DSP_SCRATCH_ALIGN        16
+#define EI_DSP_SCRATCH_FLAG_FREED   1
+#define EI_DSP_SCRATCH_FLAG_HEAP    2
+
+// precedes every scratch block, in the arena or on the heap
+typedef struct {
+    ei_dsp_scratch_arena_t *arena;  // nullptr for heap blocks allocated outside of a scope
+    uint32_t prev;                  // offset of the previous arena block
+    uint32_t size;                  // block size including this header
+    uint32_t flags;
+} ei_dsp_scratch_header_t;
+
+#define EI_DSP_SCRATCH_HEADER_SIZE \
+    ((sizeof(ei_dsp_scratch_header_t) + EI_DSP_SCRATCH_ALIGN - 1) & ~(size_t)(EI_DSP_SCRATCH_ALIGN - 1))
+
+static EIDSP_SCRATCH_THREAD_LOCAL ei_dsp_scratch_arena_t *scratch_current = nullptr;
+
+static inline ei_dsp_scratch_header_t *scratch_header(void *ptr) {
+    return (ei_dsp_scratch_header_t *)((uint8_t *)ptr - EI_DSP_SCRATCH_HEADER_SIZE);
+}
+
+void ei_dsp_scratch_init(ei_dsp_scratch_arena_t *arena) {
+    memset(arena, 0, sizeof(ei_dsp_scratch_arena_t));
+    arena->last = EI_DSP_SCRATCH_NONE;
+}
+
+void ei_dsp_scratch_release(ei_dsp_scratch_arena_t *arena) {
+    if (arena->buffer) {
+        ei_aligned_free(arena->buffer);
+    }
+    arena->buffer = nullptr;
+    arena->size = 0;
+    arena->top = 0;
+    arena->last = EI_DSP_SCRATCH_NONE;
+}
+
+bool ei_dsp_scratch_reserve(ei_dsp_scratch_arena_t *arena, size_t bytes) {
+    if (bytes <= arena->size) {
+        return true;
+    }
+    // only move an empty arena, live blocks point into the old one
+    if (arena->top != 0) {
+        return false;
+    }
+    ei_dsp_scratch_release(arena);
+    arena->buffer = (uint8_t *)ei_aligned_calloc(EI_DSP_SCRATCH_ALIGN, bytes);
+    if (!arena->buffer) {
+        return false;
+    }
+    arena->size = bytes;
+    if (bytes > arena->required) {
+        arena->required = bytes;
+    }
+    return true;
+}
+
+bool ei_dsp_scratch_begin(ei_dsp_scratch_arena_t *arena) {
+    if (scratch_current != nullptr) {
+        return false;
+    }
+    if (arena->required > arena->size) {
+        // if this fails we just keep using the heap for what doesn't fit
+        ei_dsp_scratch_reserve(arena, arena->required);
+    }
+    arena->in_use = 0;
+    arena->peak = 0;
+    arena->heap_allocs = 0;
+    scratch_current = arena;
+    return true;
+}
+
+size_t ei_dsp_scratch_end(ei_dsp_scratch_arena_t *arena) {
+    if (scratch_current == arena) {
+        scratch_current = nullptr;
+    }
+    if (arena->peak > arena->required) {
+        arena->required = arena->peak;
+    }
+    return arena->peak;
+}
+
+void *ei_dsp_scratch_calloc(size_t bytes) {
+    // block sizes are 32 bits in the header
+    if (bytes > (size_t)UINT32_MAX - EI_DSP_SCRATCH_HEADER_SIZE - EI_DSP_SCRATCH_ALIGN) {
+        return nullptr;
+    }
+
+    ei_dsp_scratch_arena_t *arena = scratch_current;
+    const size_t block_size = EI_DSP_SCRATCH_HEADER_SIZE +
+        ((bytes + EI_DSP_SCRATCH_ALIGN - 1) & ~(size_t)(EI_DSP_SCRATCH_ALIGN - 1));
+
+    ei_dsp_scratch_header_t *header;
+    if (arena && arena->top + block_size <= arena->size) {
+        header = (ei_dsp_scratch_header_t *)(arena->buffer + arena->top);
+        header->prev = (uint32_t)arena->last;
+        header->flags = 0;
+        arena->last = arena->top;
+        arena->top += block_size;
+        memset((uint8_t *)header + EI_DSP_SCRATCH_HEADER_SIZE, 0, block_size - EI_DSP_SCRATCH_HEADER_SIZE);
+    }
+    else {
+        header = (ei_dsp_scratch_header_t *)ei_calloc(block_size, 1);
+        if (!header) {
+            return nullptr;
+        }
+        header->prev = (uint32_t)EI_DSP_SCRATCH_NONE;
+        header->flags = EI_DSP_SCRATCH_FLAG_HEAP;
+        if (arena) {
+            arena->heap_allocs++;
+        }
+    }
+    header->arena = arena;
+    header->size = (uint32_t)block_size;
+
+    if (arena) {
+        arena->in_use += block_size;
+        // blocks freed out of order still take arena space until the ones above them
+        // are freed, so size the arena for the top as well
+        size_t footprint = (header->flags & EI_DSP_SCRATCH_FLAG_HEAP) ? arena->top + block_size : arena->top;
+        if (arena->in_use > footprint) {
+            footprint = arena->in_use;
+        }
+        if (footprint > arena->peak) {
+            arena->peak = footprint;
+        }
+    }
+
+    return (uint8_t *)header + EI_DSP_SCRATCH_HEADER_SIZE;
+}
+
+void ei_dsp_scratch_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    ei_dsp_scratch_header_t *header = scratch_header(ptr);
+    ei_dsp_scratch_arena_t *arena = header->arena;
+
+    if (arena) {
+        arena->in_use = arena->in_use > header->size ? arena->in_use - header->size : 0;
+    }
+
+    if (header->flags & EI_DSP_SCRATCH_FLAG_HEAP) {
+        ei_free(header);
+        return;
+    }
+
+    // pop the last block, and every block below it that was freed out of order
+    header->flags |= EI_DSP_SCRATCH_FLAG_FREED;
+    while (arena->last != EI_DSP_SCRATCH_NONE) {
+        ei_dsp_scratch_header_t *last = (ei_dsp_scratch_header_t *)(arena->buffer + arena->last);
+        if (!(last->flags & EI_DSP_SCRATCH_FLAG_FREED)) {
+            break;
+        }
+        arena->top = arena->last;
+        arena->last = last->prev == (uint32_t)EI_DSP_SCRATCH_NONE ? EI_DSP_SCRATCH_NONE : last->prev;
+    }
+}
+
+} // namespace ei
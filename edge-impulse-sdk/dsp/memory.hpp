@@ -34,10 +34,26 @@
 // clang-format off
 #include <functional>
 #include <stdio.h>
+#include <string.h>
 #include <memory>
 #include "../porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "config.hpp"
+#include "ei_dsp_scratch.h"
+
+// Lock the caches that are built on first use (FFT plans, filterbanks, K-means plans),
+// on ports where the classifier may run on more than one thread
+#ifndef EIDSP_CACHE_LOCK
+#if EI_PORTING_ESPRESSIF == 1 || EI_PORTING_POSIX == 1
+#define EIDSP_CACHE_LOCK                1
+#else
+#define EIDSP_CACHE_LOCK                0
+#endif
+#endif // EIDSP_CACHE_LOCK
+
+#if EIDSP_CACHE_LOCK == 1
+#include <mutex>
+#endif
 
 extern size_t ei_memory_in_use;
 extern size_t ei_memory_peak_use;
@@ -129,7 +145,11 @@ namespace ei {
     #define ei_dsp_calloc(...) memory::ei_wrapped_calloc(__func__, __FILE__, __LINE__, __VA_ARGS__)
     #define ei_dsp_free(...) memory::ei_wrapped_free(__func__, __FILE__, __LINE__, __VA_ARGS__)
 
+#if EIDSP_SCRATCH_ARENA
+    #define EI_DSP_MATRIX(name, n_rows, n_cols) ei::EiDspScratchBuffer name##_scratch((n_rows) * (n_cols) * sizeof(float), __func__, __FILE__, __LINE__); if (!name##_scratch.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); } matrix_t name(n_rows, n_cols, (float *)name##_scratch.buffer);
+#else
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
+#endif
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
@@ -141,7 +161,11 @@ namespace ei {
     #define ei_dsp_malloc ei_malloc
     #define ei_dsp_calloc ei_calloc
     #define ei_dsp_free(ptr, size) ei_free(ptr)
+#if EIDSP_SCRATCH_ARENA
+    #define EI_DSP_MATRIX(name, n_rows, n_cols) ei::EiDspScratchBuffer name##_scratch((n_rows) * (n_cols) * sizeof(float)); if (!name##_scratch.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); } matrix_t name(n_rows, n_cols, (float *)name##_scratch.buffer);
+#else
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
+#endif
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
@@ -236,6 +260,76 @@ static ei_unique_ptr_t make_tracked_unique_ptr(void* ptr_in, size_t size)
 }
 #endif
 
+/**
+ * Scoped lock of the shared DSP / learn block caches. One (recursive) mutex for
+ * all of them, cache lookups are rare and short next to the work they save.
+ */
+class EiDspCacheLock {
+public:
+#if EIDSP_CACHE_LOCK == 1
+    EiDspCacheLock() { mutex().lock(); }
+    ~EiDspCacheLock() { mutex().unlock(); }
+#else
+    EiDspCacheLock() { }
+#endif
+
+    EiDspCacheLock(const EiDspCacheLock&) = delete;
+    EiDspCacheLock& operator=(const EiDspCacheLock&) = delete;
+
+#if EIDSP_CACHE_LOCK == 1
+private:
+    static std::recursive_mutex& mutex() {
+        static std::recursive_mutex m;
+        return m;
+    }
+#endif
+};
+
+/**
+ * Zeroed DSP scratch memory (see ei_dsp_scratch.h) for the lifetime of the object,
+ * the storage behind EI_DSP_MATRIX and the per-run temporaries of the DSP blocks
+ */
+class EiDspScratchBuffer {
+public:
+    EiDspScratchBuffer(size_t bytes
+#if EIDSP_TRACK_ALLOCATIONS
+        , const char *fn = "scratch", const char *file = "", int line = 0
+#endif
+        ) : buffer(ei_dsp_scratch_calloc(bytes))
+#if EIDSP_TRACK_ALLOCATIONS
+        , _bytes(bytes), _fn(fn), _file(file), _line(line)
+#endif
+    {
+#if EIDSP_TRACK_ALLOCATIONS
+        if (buffer) {
+            ei_dsp_register_alloc_internal(_fn, _file, _line, _bytes, buffer);
+        }
+#endif
+    }
+
+    ~EiDspScratchBuffer() {
+#if EIDSP_TRACK_ALLOCATIONS
+        if (buffer) {
+            ei_dsp_register_free_internal(_fn, _file, _line, _bytes, buffer);
+        }
+#endif
+        ei_dsp_scratch_free(buffer);
+    }
+
+    EiDspScratchBuffer(const EiDspScratchBuffer&) = delete;
+    EiDspScratchBuffer& operator=(const EiDspScratchBuffer&) = delete;
+
+    void *buffer;
+
+#if EIDSP_TRACK_ALLOCATIONS
+private:
+    size_t _bytes;
+    const char *_fn;
+    const char *_file;
+    int _line;
+#endif
+};
+
 /*
  * @brief Make a unique ptr that supports memory tracking
  * @param ptr A pointer that will be written with the malloc'd address
@@ -61,6 +61,7 @@
 #include "ei_utils.h"
 #include "dct/fast-dct-fft.h"
 #include "kissfft/kiss_fftr.h"
+#include "fft/ei_rfft.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 
 #if __has_include("model-parameters/model_metadata.h")
@@ -391,7 +392,7 @@ public:
             size_t cycleBegin; // index of start of cycle
             size_t i; // location in matrix
             size_t all_done_mark = 1;
-            ei_vector<bool> done(size+1,false);
+            ei_scratch_vector<bool> done(size+1,false);
 
             i = 1; // Note that matrix[0] and last element of matrix won't move
             while (1)
@@ -544,21 +545,18 @@ public:
 
     static int dct_transform(float vector[], size_t len)
     {
-        const size_t fft_data_out_size = (len / 2 + 1) * sizeof(ei::fft_complex_t);
-        const size_t fft_data_in_size = len * sizeof(float);
-
-        // Allocate KissFFT input / output buffer
-        fft_complex_t *fft_data_out =
-            (ei::fft_complex_t*)ei_dsp_calloc(fft_data_out_size, 1);
-        if (!fft_data_out) {
+        // Allocate KissFFT input / output buffer (complex output as interleaved floats)
+        EI_DSP_MATRIX(fft_data_out_matrix, 1, (len / 2 + 1) * 2);
+        if (!fft_data_out_matrix.buffer) {
             return ei::EIDSP_OUT_OF_MEM;
         }
+        fft_complex_t *fft_data_out = reinterpret_cast<fft_complex_t *>(fft_data_out_matrix.buffer);
 
-        float *fft_data_in = (float*)ei_dsp_calloc(fft_data_in_size, 1);
-        if (!fft_data_in) {
-            ei_dsp_free(fft_data_out, fft_data_out_size);
+        EI_DSP_MATRIX(fft_data_in_matrix, 1, len);
+        if (!fft_data_in_matrix.buffer) {
             return ei::EIDSP_OUT_OF_MEM;
         }
+        float *fft_data_in = fft_data_in_matrix.buffer;
 
         // Preprocess the input buffer with the data from the vector
         size_t halfLen = len / 2;
@@ -572,8 +570,6 @@ public:
 
         int r = ei::numpy::rfft(fft_data_in, len, fft_data_out, (len / 2 + 1), len);
         if (r != 0) {
-            ei_dsp_free(fft_data_in, fft_data_in_size);
-            ei_dsp_free(fft_data_out, fft_data_out_size);
             return r;
         }
 
@@ -589,9 +585,6 @@ public:
             // second half bins not calculated would have just been the conjugate of the first half (note minus of imag)
             vector[i] = fft_data_out[conj_idx].r * cos(temp) - fft_data_out[conj_idx].i * sin(temp);
         }
-        ei_dsp_free(fft_data_in, fft_data_in_size);
-        ei_dsp_free(fft_data_out, fft_data_out_size);
-
         return 0;
     }
 
@@ -1316,9 +1309,12 @@ public:
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
         }
 
-        fft_complex_t *fft_output = NULL;
-        auto ptr = EI_MAKE_TRACKED_POINTER(fft_output, n_fft_out_features);
-        EI_ERR_AND_RETURN_ON_NULL(fft_output, EIDSP_OUT_OF_MEM);
+        // complex output as interleaved floats, so it comes from the DSP scratch arena
+        EI_DSP_MATRIX(fft_output_matrix, 1, n_fft_out_features * 2);
+        if (!fft_output_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        fft_complex_t *fft_output = reinterpret_cast<fft_complex_t *>(fft_output_matrix.buffer);
 
         int ret = rfft(src, src_size, fft_output, n_fft_out_features, n_fft);
         if (ret != EIDSP_OK) {
@@ -1361,16 +1357,37 @@ public:
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        // If the buffer wasn't assigned to source above, let's copy and pad
+        return rfft(src, src_size, output, output_size, n_fft, fft_input.buffer);
+    }
+
+    /**
+     * rfft() with a caller provided input buffer, for callers that run many frames
+     * of the same size (the buffer is overwritten).
+     * @param fft_input Scratch buffer of n_fft floats
+     * @returns 0 if OK
+     */
+    static int rfft(const float *src, size_t src_size, fft_complex_t *output, size_t output_size, size_t n_fft,
+        float *fft_input)
+    {
+        size_t n_fft_out_features = (n_fft / 2) + 1;
+        if (output_size != n_fft_out_features) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+        // truncate if needed
+        if (src_size > n_fft) {
+            src_size = n_fft;
+        }
+
         // copy from src to fft_input
-        memcpy(fft_input.buffer, src, src_size * sizeof(float));
+        memcpy(fft_input, src, src_size * sizeof(float));
         // pad to the rigth with zeros
-        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
+        memset(fft_input + src_size, 0, (n_fft - src_size) * sizeof(float));
 
-        auto res = ei::fft::hw_r2c_fft(fft_input.buffer, output, n_fft);
+        auto res = ei::fft::hw_r2c_fft(fft_input, output, n_fft);
         if (handle_fft_hw_failure(res, n_fft)) {
             // fallback to software
-            return software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
+            return software_rfft(fft_input, output, n_fft, n_fft_out_features);
         }
 
         return EIDSP_OK;
@@ -1665,19 +1682,15 @@ public:
 
         matrix_t temp_matrix(1, matrix->rows * matrix->cols, matrix->buffer);
 
-        matrix_t min_matrix(1, 1);
-        if (!min_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
+        float min_value;
+        matrix_t min_matrix(1, 1, &min_value);
         r = min(&temp_matrix, &min_matrix);
         if (r != EIDSP_OK) {
             EIDSP_ERR(r);
         }
 
-        matrix_t max_matrix(1, 1);
-        if (!max_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
+        float max_value;
+        matrix_t max_matrix(1, 1, &max_value);
         r = max(&temp_matrix, &max_matrix);
         if (r != EIDSP_OK) {
             EIDSP_ERR(r);
@@ -1742,24 +1755,14 @@ public:
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
     #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
-        // create fftr context
-        size_t kiss_fftr_mem_length;
-
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
-        // execute the rfft operation
-        kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
-
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
-
-        return EIDSP_OK;
+        // cached plan per size, kissfft for the sizes that aren't a power of two
+        // (plans register their allocations with ei_dsp_register_alloc)
+        return ei::fft::rfft(fft_input, output, n_fft);
     #else
-        return EIDSP_NOT_SUPPORTED;
+        if (!ei::fft::rfft_size_is_native(n_fft)) {
+            return EIDSP_NOT_SUPPORTED;
+        }
+        return ei::fft::rfft(fft_input, output, n_fft);
     #endif
     }
 
@@ -2064,6 +2067,39 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * power_spectrum() with caller provided FFT buffers, see rfft()
+     * @param fft_input Scratch buffer of fft_points floats
+     * @param fft_output Scratch buffer of fft_points / 2 + 1 complex values
+     */
+    static int power_spectrum(
+        const float *frame,
+        size_t frame_size,
+        float *out_buffer,
+        size_t out_buffer_size,
+        uint16_t fft_points,
+        float *fft_input,
+        fft_complex_t *fft_output)
+    {
+        if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        int r = numpy::rfft(frame, frame_size, fft_output, out_buffer_size, fft_points, fft_input);
+        if (r != EIDSP_OK) {
+            return r;
+        }
+
+        // same steps as rfft() (magnitude) + power_spectrum(), so the results are identical
+        for (size_t ix = 0; ix < out_buffer_size; ix++) {
+            float magnitude = sqrt(fft_output[ix].r * fft_output[ix].r + fft_output[ix].i * fft_output[ix].i);
+            out_buffer[ix] = (1.0 / static_cast<float>(fft_points)) *
+                (magnitude * magnitude);
+        }
+
+        return EIDSP_OK;
+    }
+
     static int welch_max_hold(
         float *input,
         size_t input_size,
@@ -2078,10 +2114,12 @@ public:
         bool do_saved_point = false;
         size_t fft_out_size = fft_points / 2 + 1;
         float *fft_out;
-        const size_t size = fft_out_size * sizeof(float);
-        ei_unique_ptr_t p_fft_out(nullptr, [size](void* ptr){ei::ei_dsp_free_func(ptr, size);});
+        ei_unique_ptr_t p_fft_out(nullptr, ei_dsp_scratch_free);
         if (input_size < fft_points) {
-            fft_out = (float *)ei_dsp_calloc(fft_out_size, sizeof(float));
+            fft_out = (float *)ei_dsp_scratch_calloc(fft_out_size * sizeof(float));
+            if (!fft_out) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
             p_fft_out.reset(fft_out);
         }
         else {
@@ -38,6 +38,7 @@
 #ifdef __cplusplus
 #include <functional>
 #include "edge-impulse-sdk/dsp/ei_vector.h"
+#include "edge-impulse-sdk/dsp/ei_dsp_scratch.h"
 #ifdef __MBED__
 #include "mbed.h"
 #endif // __MBED__
@@ -645,6 +646,36 @@ typedef enum {
     DCT_NORMALIZATION_ORTHO
 } DCT_NORMALIZATION_MODE;
 
+/**
+ * Layout of the buffer behind a typed signal (see signal_view_t)
+ */
+typedef enum {
+    SIGNAL_VIEW_NONE = 0,           // only get_data()
+    SIGNAL_VIEW_RGB888 = 1,         // 3 bytes per pixel, R G B
+    SIGNAL_VIEW_RGB565 = 2,         // 2 bytes per pixel
+    SIGNAL_VIEW_GRAYSCALE = 3,      // 1 byte per pixel
+    SIGNAL_VIEW_INT16 = 4,          // int16 samples, mono or interleaved axes
+} signal_view_format_t;
+
+/**
+ * Typed, zero-copy view of the samples behind a signal_t. Sample `ix` of the
+ * signal is element `ix` of `data` and, past `length`, element `ix - length`
+ * of `wrap`, so the two halves of a ring buffer are viewed without copying.
+ * Images are one element per pixel. Blocks that read the raw layout (the image
+ * blocks, the fixed point audio features) use the view when it covers the
+ * whole signal, everything else reads get_data(), see ei_signal_view.h.
+ */
+typedef struct ei_signal_view_t {
+    signal_view_format_t format = SIGNAL_VIEW_NONE;
+    const void *data = nullptr;
+    size_t length = 0;
+    const void *wrap = nullptr;
+    size_t wrap_length = 0;
+    uint16_t axes = 1;                  // INT16: interleaved axes per frame
+    const float *axis_scale = nullptr;  // INT16: get_data() returns sample * axis_scale[axis], raw values if null
+    bool big_endian = true;             // RGB565: high byte of every pixel first
+} signal_view_t;
+
 /**
  * @addtogroup ei_structs
  * @{
@@ -699,6 +730,13 @@ typedef struct ei_signal_t {
      *  preprocessing and inference.
     */
     size_t total_length;
+
+    /**
+     * Optional typed view of the same samples, set by the signal_from_*() adapters
+     * in ei_signal_view.h. `get_data` stays the reference, the view only lets
+     * blocks skip the float conversion.
+     */
+    signal_view_t view;
 } signal_t;
 
 /** @} */
@@ -715,6 +753,7 @@ typedef struct ei_feature_t {
         ei::matrix_u8_t* matrix_u8;
     };
     uint32_t blockId;
+    bool scratch;       // matrix and its buffer are one ei_dsp_scratch_calloc() block
 
     void* operator new(size_t size) {
         return ei_malloc(size);
@@ -732,6 +771,42 @@ typedef struct ei_feature_t {
         ei_free(ptr);
     }
 } feature_t;
+
+/**
+ * Raw output matrix in a single DSP scratch block (the matrix and its buffer),
+ * from the arena while a scratch scope is open. Free with ei_feature_free_matrix().
+ */
+template <typename M, typename T>
+M *ei_feature_scratch_matrix(ei_feature_t *feature, uint32_t rows, uint32_t cols)
+{
+    uint8_t *block = (uint8_t *)ei::ei_dsp_scratch_calloc(sizeof(M) + rows * cols * sizeof(T));
+    if (!block) {
+        return nullptr;
+    }
+    M *matrix = ::new (block) M(rows, cols, (T *)(block + sizeof(M)));
+    feature->matrix = (ei::matrix_t *)matrix;
+    feature->scratch = true;
+    return matrix;
+}
+
+/**
+ * Free a raw output matrix, from ei_feature_scratch_matrix() or new
+ */
+static inline void ei_feature_free_matrix(ei_feature_t *feature)
+{
+    if (!feature->matrix) {
+        return;
+    }
+    if (feature->scratch) {
+        // the buffer is part of the block, so there's nothing else to release
+        ei::ei_dsp_scratch_free(feature->matrix);
+    }
+    else {
+        delete feature->matrix;
+    }
+    feature->matrix = nullptr;
+    feature->scratch = false;
+}
 #endif // __cplusplus
 
 // required on Adafruit nRF52
@@ -75,6 +75,8 @@ typedef enum {
     EI_IMPULSE_LAST_LAYER_NOT_SUPPORTED = -28, /**< The last layer is not supported by inferencing engine. */
     EI_IMPULSE_POSTPROCESSING_ERROR = -29, /**< Error in post-processing portion of impulse */
     EI_IMPULSE_DATA_NORMALIZATION_ERROR = -30, /**< Error in data normalization portion of impulse */
+    EI_IMPULSE_QUEUE_FULL = -31, /**< The asynchronous classifier's queue is full and overwriting is disabled */
+    EI_IMPULSE_NO_DATA = -32, /**< No complete slice is waiting in the sample ring buffer yet */
 } EI_IMPULSE_ERROR;
 
 #endif // _EIDSP_RETURN_TYPES_H_
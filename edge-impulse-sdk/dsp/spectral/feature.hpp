@@ -36,8 +36,19 @@
 #include "wavelet.hpp"
 #include "signal.hpp"
 #include "edge-impulse-sdk/dsp/ei_utils.h"
+#include "edge-impulse-sdk/dsp/fft/ei_rfft.h"
+#include "edge-impulse-sdk/dsp/filter/ei_filter_bank.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 #include "model-parameters/model_metadata.h"
 
+// the axes are spread over both cores by the ESP-NN worker task
+#if EIDSP_SPECTRAL_MULTICORE == 1 && EI_PORTING_ESPRESSIF == 1 && EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+#include "edge-impulse-sdk/porting/espressif/ei_esp_nn_parallel.h"
+#define EIDSP_SPECTRAL_RUN_PARALLEL     1
+#else
+#define EIDSP_SPECTRAL_RUN_PARALLEL     0
+#endif
+
 namespace ei {
 namespace spectral {
 
@@ -50,8 +61,225 @@ typedef enum {
 class feature {
 public:
 
+    /**
+     * Per axis work of the spectral analysis, runs on either core
+     * @param ctx Context of the block
+     * @param work Scratch buffer of the calling core
+     * @param row Axis
+     * @returns 0 if OK
+     */
+    typedef int (*axis_fn_t)(const void *ctx, float *work, size_t row);
+
+    typedef struct {
+        axis_fn_t fn;
+        const void *ctx;
+        float *work;
+        size_t row_begin;
+        size_t row_end;
+        int ret;
+        ei_dsp_scratch_arena_t *arena;  // scratch of the other core, nullptr on the calling one
+    } axes_job_t;
+
+    static void run_axes_job(void *arg)
+    {
+        axes_job_t *job = (axes_job_t *)arg;
+        job->ret = EIDSP_OK;
+
+        // scratch scopes are per task, the worker keeps its own arena
+        bool scratch_open = job->arena && ei_dsp_scratch_begin(job->arena);
+
+        for (size_t row = job->row_begin; row < job->row_end; row++) {
+            job->ret = job->fn(job->ctx, job->work, row);
+            if (job->ret != EIDSP_OK) {
+                break;
+            }
+        }
+
+        if (scratch_open) {
+            ei_dsp_scratch_end(job->arena);
+        }
+    }
+
+#if EIDSP_SPECTRAL_RUN_PARALLEL == 1
+    // only the ESP-NN worker task uses it, one job at a time
+    static ei_dsp_scratch_arena_t *worker_scratch_arena()
+    {
+        static ei_dsp_scratch_arena_t arena = { nullptr, 0, 0, EI_DSP_SCRATCH_NONE, 0, 0, 0, 0 };
+        return &arena;
+    }
+#endif
+
+    /**
+     * Run fn over all axes. With EIDSP_SPECTRAL_MULTICORE the second half of the
+     * axes runs on the other core, with its own work buffer.
+     * @param work_size Floats of scratch per core
+     * @param fft_length FFT size fn runs, the other core only gets axes if the
+     *  transform of this size is reentrant
+     */
+    static int run_axes(axis_fn_t fn, const void *ctx, size_t rows, size_t work_size, size_t fft_length)
+    {
+        EI_DSP_MATRIX(work, 1, work_size > 0 ? work_size : 1);
+        if (!work.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+#if EIDSP_SPECTRAL_RUN_PARALLEL == 1
+        // kissfft plans keep a scratch buffer, the built-in ones are read only
+        if (rows >= 2 && fft::rfft_size_is_native(fft_length)) {
+            // create the cached plan before both cores look it up
+            fft::rfft_get_plan(fft_length);
+
+            EI_DSP_MATRIX(worker_work, 1, work_size > 0 ? work_size : 1);
+            if (worker_work.buffer) {
+                const size_t split = (rows + 1) / 2;
+                axes_job_t local = { fn, ctx, work.buffer, 0, split, EIDSP_OK, nullptr };
+                axes_job_t worker = { fn, ctx, worker_work.buffer, split, rows, EIDSP_OK, worker_scratch_arena() };
+                if (ei_esp_nn_parallel_run(run_axes_job, &worker, run_axes_job, &local)) {
+                    return local.ret != EIDSP_OK ? local.ret : worker.ret;
+                }
+            }
+        }
+#else
+        (void)fft_length;
+#endif
+
+        axes_job_t all = { fn, ctx, work.buffer, 0, rows, EIDSP_OK, nullptr };
+        run_axes_job(&all);
+        return all.ret;
+    }
+
+    typedef struct {
+        matrix_t *out_features;
+        matrix_t *input_matrix;
+        const float *rms;
+        float sampling_freq;
+        uint16_t fft_length;
+        uint8_t fft_peaks;
+        float fft_peaks_threshold;
+        matrix_t *edges_matrix_in;
+        matrix_t *freq_matrix;          // frequency of every periodogram bin
+        const fft_complex_t *boxcar;    // spectrum of the detrended segment, nullptr if it's all of fft_length
+    } spectral_analysis_ctx_t;
+
+    static size_t align_floats(size_t n)
+    {
+        return (n + 3) & ~((size_t)3);
+    }
+
+    /**
+     * Scratch floats per core of spectral_analysis_axis(): FFT input, complex
+     * spectrum, magnitude and power
+     */
+    static size_t spectral_analysis_work_size(uint16_t fft_length)
+    {
+        const size_t n_bins = fft_length / 2 + 1;
+        return align_floats(fft_length) + align_floats(n_bins * 2) + 2 * align_floats(n_bins);
+    }
+
+    /**
+     * One axis of spectral_analysis(): a single FFT that both the peaks and the
+     * spectral power edges are derived from.
+     */
+    static int spectral_analysis_axis(const void *ctx_ptr, float *work, size_t row)
+    {
+        const spectral_analysis_ctx_t *ctx = (const spectral_analysis_ctx_t *)ctx_ptr;
+        matrix_t *input_matrix = ctx->input_matrix;
+        const uint16_t fft_length = ctx->fft_length;
+        const size_t n_bins = fft_length / 2 + 1;
+        int ret;
+
+        float *axis = input_matrix->buffer + (row * input_matrix->cols);
+
+        float *fft_input = work;
+        fft_complex_t *spectrum = reinterpret_cast<fft_complex_t *>(fft_input + align_floats(fft_length));
+        EI_DSP_MATRIX_B(fft_matrix, 1, n_bins, fft_input + align_floats(fft_length) + align_floats(n_bins * 2));
+        EI_DSP_MATRIX_B(power_matrix, 1, n_bins, fft_matrix.buffer + align_floats(n_bins));
+
+        // calculate FFT
+        ret = numpy::rfft(axis, input_matrix->cols, spectrum, n_bins, fft_length, fft_input);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // magnitude, multiplied by 2/N
+        for (size_t ix = 0; ix < n_bins; ix++) {
+            fft_matrix.buffer[ix] = sqrt(spectrum[ix].r * spectrum[ix].r + spectrum[ix].i * spectrum[ix].i);
+        }
+        numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
+
+        // we're now using the FFT matrix to calculate peaks etc.
+        EI_DSP_MATRIX(peaks_matrix, ctx->fft_peaks, 2);
+        ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
+            ctx->sampling_freq, ctx->fft_peaks_threshold, fft_length);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // periodogram for spectral power buckets, from the same FFT. The periodogram
+        // detrends the first nperseg samples before its transform, which is the
+        // spectrum minus mean * (spectrum of nperseg ones).
+        const size_t nperseg = input_matrix->cols < fft_length ? input_matrix->cols : fft_length;
+        EI_DSP_MATRIX_B(segment_matrix, 1, nperseg, axis);
+        EI_DSP_MATRIX(mean_matrix, 1, 1);
+        ret = numpy::mean(&segment_matrix, &mean_matrix);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        const float mean = mean_matrix.buffer[0];
+        const float scale = 1.0f / (ctx->sampling_freq * nperseg);
+
+        for (size_t ix = 0; ix < n_bins; ix++) {
+            float r = spectrum[ix].r;
+            float i = spectrum[ix].i;
+            if (ctx->boxcar) {
+                r -= mean * ctx->boxcar[ix].r;
+                i -= mean * ctx->boxcar[ix].i;
+            }
+            else if (ix == 0) {
+                // the segment is all of fft_length, ones only have a DC component
+                r -= mean * static_cast<float>(nperseg);
+            }
+
+            // conjugate and then multiply with itself and scale
+            float p = (r * r) + (i * i);
+            p *= scale;
+            if (ix != static_cast<size_t>(fft_length / 2)) {
+                p *= 2;
+            }
+            power_matrix.buffer[ix] = p;
+        }
+
+        EI_DSP_MATRIX(edges_matrix_out, ctx->edges_matrix_in->rows - 1, 1);
+        ret = spectral::processing::spectral_power_edges(
+            &power_matrix,
+            ctx->freq_matrix,
+            ctx->edges_matrix_in,
+            &edges_matrix_out,
+            ctx->sampling_freq);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        float *features_row = ctx->out_features->buffer + (row * ctx->out_features->cols);
+
+        size_t fx = 0;
+
+        features_row[fx++] = ctx->rms[row];
+        for (size_t peak_row = 0; peak_row < peaks_matrix.rows; peak_row++) {
+            features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0];
+            features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1];
+        }
+        for (size_t edge_row = 0; edge_row < edges_matrix_out.rows; edge_row++) {
+            features_row[fx++] = edges_matrix_out.buffer[edge_row * edges_matrix_out.cols] / 10.0f;
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Calculate the spectral features over a signal.
+     * Every axis takes one FFT, the peaks and the spectral power edges (the
+     * periodogram) are both derived from it.
      * @param out_features Output matrix. Use `calculate_spectral_buffer_size` to calculate
      *  the size required. Needs as many rows as `raw_data`.
      * @param input_matrix Signal, with one row per axis
@@ -95,7 +323,7 @@ public:
 
         EI_TRY(processing::subtract_mean(input_matrix) );
 
-        // apply filter
+        // apply filter, all axes in one pass
         if (filter_type == filter_lowpass) {
             ret = spectral::processing::butterworth_lowpass_filter(
                 input_matrix, sampling_freq, filter_cutoff, filter_order);
@@ -118,71 +346,53 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // find peaks in FFT
-        EI_DSP_MATRIX(peaks_matrix, axes, fft_peaks * 2);
-
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            // per axis code
-
-            // get a slice of the current axis
-            EI_DSP_MATRIX_B(axis_matrix, 1, input_matrix->cols, input_matrix->buffer + (row * input_matrix->cols));
-
-            // calculate FFT
-            EI_DSP_MATRIX(fft_matrix, 1, fft_length / 2 + 1);
-            ret = numpy::rfft(axis_matrix.buffer, axis_matrix.cols, fft_matrix.buffer, fft_matrix.cols, fft_length);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
-
-            // multiply by 2/N
-            numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
-
-            // we're now using the FFT matrix to calculate peaks etc.
-            EI_DSP_MATRIX(peaks_matrix, fft_peaks, 2);
-            ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
-                sampling_freq, fft_peaks_threshold, fft_length);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
-
-            // calculate periodogram for spectral power buckets
-            EI_DSP_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
-            EI_DSP_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
-            ret = spectral::processing::periodogram(&axis_matrix,
-                &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
-            }
-
-            EI_DSP_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
-            ret = spectral::processing::spectral_power_edges(
-                &period_fft_matrix,
-                &period_freq_matrix,
-                edges_matrix_in,
-                &edges_matrix_out,
-                sampling_freq);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
-            }
-
-            float *features_row = out_features->buffer + (row * out_features->cols);
+        // periodogram bin frequencies, the same for every axis
+        const size_t n_bins = fft_length / 2 + 1;
+        EI_DSP_MATRIX(freq_matrix, 1, n_bins);
+        if (!freq_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        for (size_t ix = 0; ix < n_bins; ix++) {
+            freq_matrix.buffer[ix] = static_cast<float>(ix) * (1.0f / (fft_length * (1.0f / sampling_freq)));
+        }
 
-            size_t fx = 0;
+        // the detrended segment is shorter than the FFT (zero padded), its mean
+        // leaks into every bin: keep the spectrum of a segment of ones around
+        EI_DSP_MATRIX(boxcar_matrix, 1, input_matrix->cols < fft_length ? n_bins * 2 : 1);
+        if (!boxcar_matrix.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        fft_complex_t *boxcar = nullptr;
+        if (input_matrix->cols < fft_length) {
+            boxcar = reinterpret_cast<fft_complex_t *>(boxcar_matrix.buffer);
 
-            features_row[fx++] = rms_matrix.buffer[row];
-            for (size_t peak_row = 0; peak_row < peaks_matrix.rows; peak_row++) {
-                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 0];
-                features_row[fx++] = peaks_matrix.buffer[peak_row * peaks_matrix.cols + 1];
+            EI_DSP_MATRIX(ones_matrix, 1, input_matrix->cols);
+            if (!ones_matrix.buffer) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
-            for (size_t edge_row = 0; edge_row < edges_matrix_out.rows; edge_row++) {
-                features_row[fx++] = edges_matrix_out.buffer[edge_row * edges_matrix_out.cols] / 10.0f;
+            for (size_t ix = 0; ix < input_matrix->cols; ix++) {
+                ones_matrix.buffer[ix] = 1.0f;
             }
+            EI_TRY(numpy::rfft(ones_matrix.buffer, ones_matrix.cols, boxcar, n_bins, fft_length));
         }
 
-        return EIDSP_OK;
+        spectral_analysis_ctx_t ctx = {
+            out_features,
+            input_matrix,
+            rms_matrix.buffer,
+            sampling_freq,
+            fft_length,
+            fft_peaks,
+            fft_peaks_threshold,
+            edges_matrix_in,
+            &freq_matrix,
+            boxcar
+        };
+
+        return run_axes(spectral_analysis_axis, &ctx, axes,
+            spectral_analysis_work_size(fft_length), fft_length);
     }
 
-
     /**
      * Calculate the buffer size for Spectral Analysis
      * @param rms: Whether to calculate the RMS as part of the features
@@ -222,7 +432,7 @@ public:
         }
 
         // the spectral edges that we want to calculate
-        matrix_t edges_matrix_in(64, 1);
+        EI_DSP_MATRIX(edges_matrix_in, 64, 1);
         size_t edge_matrix_ix = 0;
 
         char spectral_str[128] = { 0 };
@@ -333,6 +543,111 @@ public:
         }
     }
 
+    typedef struct {
+        matrix_t *input_matrix;
+        float *output;
+        ei_dsp_config_spectral_analysis_t *config;
+        size_t start_bin;
+        size_t stop_bin;
+        size_t features_per_axis;
+    } spec_features_ctx_t;
+
+    static size_t spec_features_per_axis(ei_dsp_config_spectral_analysis_t *config, size_t num_bins)
+    {
+        // RMS, skewness, kurtosis (and the skewness and kurtosis of the spectrum in v4), the bins
+        return 3 + (config->implementation_version == 4 ? 2 : 0) + num_bins;
+    }
+
+    /**
+     * One axis of extract_spec_features(), work is fft_length / 2 + 1 floats in v4
+     */
+    static int spec_features_axis(const void *ctx_ptr, float *work, size_t row)
+    {
+        const spec_features_ctx_t *ctx = (const spec_features_ctx_t *)ctx_ptr;
+        ei_dsp_config_spectral_analysis_t *config = ctx->config;
+        const size_t start_bin = ctx->start_bin;
+        const size_t stop_bin = ctx->stop_bin;
+        const size_t num_bins = stop_bin - start_bin;
+
+        float *data_window = ctx->input_matrix->get_row_ptr(row);
+        size_t data_size = ctx->input_matrix->cols;
+        float *feature_out = ctx->output + row * ctx->features_per_axis;
+
+        matrix_t rms_in_matrix(1, data_size, data_window);
+        matrix_t rms_out_matrix(1, 1, feature_out);
+        EI_TRY(numpy::rms(&rms_in_matrix, &rms_out_matrix));
+
+        feature_out++;
+
+        // Standard Deviation
+        float stddev = *(feature_out-1); //= sqrt(numpy::variance(data_window, data_size));
+        if (stddev == 0.0f) {
+            stddev = 1e-10f;
+        }
+        // Don't add std dev as a feature b/c it's the same as RMS
+        // Skew and Kurtosis w/ shortcut:
+        // See definition at https://en.wikipedia.org/wiki/Skewness
+        // See definition at https://en.wikipedia.org/wiki/Kurtosis
+        // Substitute 0 for mean (b/c it is subtracted out above)
+        // Skew becomes: mean(X^3) / stddev^3
+        // Kurtosis becomes: mean(X^4) / stddev^4
+        // Note, this is the Fisher definition of Kurtosis, so subtract 3
+        // (see https://docs.scipy.org/doc/scipy/reference/generated/scipy.stats.kurtosis.html)
+        float s_sum = 0;
+        float k_sum = 0;
+        float temp;
+        for (size_t i = 0; i < data_size; i++) {
+            temp = data_window[i] * data_window[i] * data_window[i];
+            s_sum += temp;
+            k_sum += temp * data_window[i];
+        }
+        // Skewness out
+        temp = stddev * stddev * stddev;
+        *feature_out++ = (s_sum / data_size) / temp;
+        // Kurtosis out
+        *feature_out++ = ((k_sum / data_size) / (temp * stddev)) - 3;
+
+        if (config->implementation_version == 4) {
+
+            size_t fft_out_size = config->fft_length / 2 + 1;
+            float *fft_out = work;
+            EI_TRY(numpy::welch_max_hold(
+                data_window,
+                data_size,
+                fft_out,
+                0,
+                fft_out_size,
+                config->fft_length,
+                config->do_fft_overlap));
+
+            matrix_t x(1, fft_out_size, fft_out);
+            EI_DSP_MATRIX(out, 1, 1);
+
+            *feature_out++ = (numpy::skew(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+            *feature_out++ = (numpy::kurtosis(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+
+            for (size_t i = start_bin; i < stop_bin; i++) {
+                feature_out[i - start_bin] = fft_out[i];
+            }
+        } else {
+            EI_TRY(numpy::welch_max_hold(
+                data_window,
+                data_size,
+                feature_out,
+                start_bin,
+                stop_bin,
+                config->fft_length,
+                config->do_fft_overlap));
+        }
+        if (config->do_log) {
+            numpy::zero_handling(feature_out, num_bins);
+            ei_matrix temp(num_bins, 1, feature_out);
+            numpy::log10(&temp);
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * @brief Calculates the spectral analysis features.
      *
@@ -403,87 +718,20 @@ public:
         }
         size_t num_bins = stop_bin - start_bin;
 
-        float *feature_out = output_matrix->buffer;
-        const float *feature_out_ori = feature_out;
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            float *data_window = input_matrix->get_row_ptr(row);
-            size_t data_size = input_matrix->cols;
-
-            matrix_t rms_in_matrix(1, data_size, data_window);
-            matrix_t rms_out_matrix(1, 1, feature_out);
-            EI_TRY(numpy::rms(&rms_in_matrix, &rms_out_matrix));
-
-            feature_out++;
-
-            // Standard Deviation
-            float stddev = *(feature_out-1); //= sqrt(numpy::variance(data_window, data_size));
-            if (stddev == 0.0f) {
-                stddev = 1e-10f;
-            }
-            // Don't add std dev as a feature b/c it's the same as RMS
-            // Skew and Kurtosis w/ shortcut:
-            // See definition at https://en.wikipedia.org/wiki/Skewness
-            // See definition at https://en.wikipedia.org/wiki/Kurtosis
-            // Substitute 0 for mean (b/c it is subtracted out above)
-            // Skew becomes: mean(X^3) / stddev^3
-            // Kurtosis becomes: mean(X^4) / stddev^4
-            // Note, this is the Fisher definition of Kurtosis, so subtract 3
-            // (see https://docs.scipy.org/doc/scipy/reference/generated/scipy.stats.kurtosis.html)
-            float s_sum = 0;
-            float k_sum = 0;
-            float temp;
-            for (size_t i = 0; i < data_size; i++) {
-                temp = data_window[i] * data_window[i] * data_window[i];
-                s_sum += temp;
-                k_sum += temp * data_window[i];
-            }
-            // Skewness out
-            temp = stddev * stddev * stddev;
-            *feature_out++ = (s_sum / data_size) / temp;
-            // Kurtosis out
-            *feature_out++ = ((k_sum / data_size) / (temp * stddev)) - 3;
-
-            if (config->implementation_version == 4) {
-
-                size_t fft_out_size = config->fft_length / 2 + 1;
-                ei_vector<float> fft_out(fft_out_size);
-                EI_TRY(numpy::welch_max_hold(
-                    data_window,
-                    data_size,
-                    fft_out.data(),
-                    0,
-                    fft_out_size,
-                    config->fft_length,
-                    config->do_fft_overlap));
-
-                matrix_t x(1, fft_out.size(), const_cast<float *>(fft_out.data()));
-                matrix_t out(1, 1);
-
-                *feature_out++ = (numpy::skew(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
-                *feature_out++ = (numpy::kurtosis(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
-
-                for (size_t i = start_bin; i < stop_bin; i++) {
-                    feature_out[i - start_bin] = fft_out[i];
-                }
-            } else {
-                EI_TRY(numpy::welch_max_hold(
-                    data_window,
-                    data_size,
-                    feature_out,
-                    start_bin,
-                    stop_bin,
-                    config->fft_length,
-                    config->do_fft_overlap));
-            }
-            if (config->do_log) {
-                numpy::zero_handling(feature_out, num_bins);
-                ei_matrix temp(num_bins, 1, feature_out);
-                numpy::log10(&temp);
-            }
-            feature_out += num_bins;
-        }
-        size_t num_features = feature_out - feature_out_ori;
-        return num_features;
+        spec_features_ctx_t ctx = {
+            input_matrix,
+            output_matrix->buffer,
+            config,
+            start_bin,
+            stop_bin,
+            spec_features_per_axis(config, num_bins)
+        };
+
+        const size_t fft_out_size = config->fft_length / 2 + 1;
+        EI_TRY(run_axes(spec_features_axis, &ctx, input_matrix->rows,
+            config->implementation_version == 4 ? fft_out_size : 0, config->fft_length));
+
+        return ctx.features_per_axis * input_matrix->rows;
     }
 
     static int extract_spectral_analysis_features_v2(
@@ -510,7 +758,7 @@ public:
         }
     }
 
-    static ei_vector<int> get_ratio_combo(int r)
+    static ei_scratch_vector<int> get_ratio_combo(int r)
     {
         if (r == 1 || r == 3 || r == 10) {
             return {r};
@@ -527,7 +775,7 @@ public:
     }
 
     // can do in-place or out-of-place
-    static size_t _decimate(matrix_t *input_matrix, matrix_t *output_matrix, size_t ratio)
+    static int _decimate(matrix_t *input_matrix, matrix_t *output_matrix, size_t ratio, size_t *out_size)
     {
         // generated by build_sav4_header in prepare.py
         static float sos_deci_3[] = {
@@ -570,22 +818,36 @@ public:
         float* sos = ratio == 3 ? sos_deci_3 : sos_deci_10;
         float* sos_zi = ratio == 3 ? sos_zi_deci_3 : sos_zi_deci_10;
 
-        const size_t out_size = signal::get_decimated_size(input_matrix->cols, ratio);
+        *out_size = signal::get_decimated_size(input_matrix->cols, ratio);
+        const size_t rows = input_matrix->rows;
+        if (rows == 0) {
+            return EIDSP_OK;
+        }
 
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            const float *x = input_matrix->get_row_ptr(row);
-            float *y = output_matrix->get_row_ptr(row);
-            signal::sosfilt sosfilt(sos, sos_zi, 4);
-            signal::decimate_simple(
-                x,
-                input_matrix->cols,
-                y,
-                output_matrix->cols,
-                ratio,
-                sosfilt);
+        // all rows through the filter bank at once, keeping every ratio-th sample
+        // (same as signal::decimate_simple() per row)
+        const size_t bank_bytes = filter::iir_bank_bytes(4, rows);
+        EI_DSP_MATRIX(bank_buffer, 1, (bank_bytes + sizeof(float) - 1) / sizeof(float));
+        filter::iir_bank_t *bank = filter::iir_init_sos(bank_buffer.buffer, sos, 4, rows);
+        if (!bank) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        for (size_t row = 0; row < rows; row++) {
+            filter::iir_set_state(bank, row, sos_zi, input_matrix->get_row_ptr(row)[0]);
         }
 
-        return out_size;
+        filter::iir_run(
+            bank,
+            input_matrix->buffer,
+            input_matrix->cols,
+            1,
+            output_matrix->buffer,
+            output_matrix->cols,
+            1,
+            input_matrix->cols,
+            ratio);
+
+        return EIDSP_OK;
     }
 
     static int extract_spectral_analysis_features_v4(
@@ -609,10 +871,10 @@ public:
             EI_TRY(numpy::scale(input_matrix, config->scale_axes));
 
             if (config->input_decimation_ratio > 1) {
-                ei_vector<int> ratio_combo = get_ratio_combo(config->input_decimation_ratio);
+                ei_scratch_vector<int> ratio_combo = get_ratio_combo(config->input_decimation_ratio);
                 size_t out_size = input_matrix->cols;
                 for (int r : ratio_combo) {
-                    out_size = _decimate(input_matrix, input_matrix, r);
+                    EI_TRY(_decimate(input_matrix, input_matrix, r, &out_size));
                 }
 
                 // rearrange input matrix to be in the right shape after decimation
@@ -655,8 +917,9 @@ public:
             constexpr size_t decimation = 10;
             const size_t decimated_size =
                 signal::get_decimated_size(input_matrix->cols, decimation);
-            matrix_t lf_signal(input_matrix->rows, decimated_size);
-            _decimate(input_matrix, &lf_signal, decimation);
+            EI_DSP_MATRIX(lf_signal, input_matrix->rows, decimated_size);
+            size_t lf_size;
+            EI_TRY(_decimate(input_matrix, &lf_signal, decimation, &lf_size));
 
             size_t n_features = extract_spec_features(
                 input_matrix,
@@ -50,7 +50,7 @@ namespace filters {
      * @param dest Destination array
      * @param size Size of both source and destination arrays
      */
-    static void butterworth_lowpass(
+    __attribute__((unused)) static void butterworth_lowpass(
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
@@ -106,7 +106,7 @@ namespace filters {
      * @param dest Destination array
      * @param size Size of both source and destination arrays
      */
-    static void butterworth_highpass(
+    __attribute__((unused)) static void butterworth_highpass(
         int filter_order,
         float sampling_freq,
         float cutoff_freq,
@@ -153,6 +153,80 @@ namespace filters {
         ei_dsp_free(w2, n_steps*sizeof(float));
     }
 
+    /**
+     * Butterworth filter over every row of a matrix (one row per axis), in place.
+     * The coefficients are designed once and all rows advance together, one sample
+     * at a time, with their own filter state. Same output as butterworth_lowpass() /
+     * butterworth_highpass() on each row.
+     * @param filter_order Even filter order (between 2..8)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @param high_pass High pass instead of low pass
+     * @param matrix Signal, one row per axis
+     * @returns 0 if OK
+     */
+    static int butterworth_rows(
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq,
+        bool high_pass,
+        matrix_t *matrix)
+    {
+        const int n_steps = filter_order / 2;
+        const size_t rows = matrix->rows;
+        const size_t cols = matrix->cols;
+        if (n_steps <= 0 || rows == 0) {
+            return EIDSP_OK;
+        }
+
+        float a = tan(M_PI * cutoff_freq / sampling_freq);
+        float a2 = pow(a, 2);
+
+        // A, d1 and d2 per step, then w1 and w2 per step of every row
+        EI_DSP_MATRIX(coefficients, 3, n_steps);
+        EI_DSP_MATRIX(state, rows, 2 * n_steps);
+        if (!coefficients.buffer || !state.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        float *A = coefficients.get_row_ptr(0);
+        float *d1 = coefficients.get_row_ptr(1);
+        float *d2 = coefficients.get_row_ptr(2);
+
+        // Calculate the filter parameters
+        for (int ix = 0; ix < n_steps; ix++) {
+            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+            float s = a2 + (2.0 * a * r) + 1.0;
+            A[ix] = high_pass ? 1.0f / s : a2 / s;
+            d1[ix] = 2.0 * (1 - a2) / s;
+            d2[ix] = -(a2 - (2.0 * a * r) + 1.0) / s;
+        }
+
+        // Apply the filter, sample major so the coefficients stay in registers
+        for (size_t sx = 0; sx < cols; sx++) {
+            for (size_t row = 0; row < rows; row++) {
+                float *w1 = state.get_row_ptr(row);
+                float *w2 = w1 + n_steps;
+                float *x = matrix->buffer + (row * cols) + sx;
+                float v = *x;
+
+                for (int i = 0; i < n_steps; i++) {
+                    float w0 = d1[i] * w1[i] + d2[i] * w2[i] + v;
+                    if (high_pass) {
+                        v = A[i] * (w0 - (2.0 * w1[i]) + w2[i]);
+                    }
+                    else {
+                        v = A[i] * (w0 + (2.0 * w1[i]) + w2[i]);
+                    }
+                    w2[i] = w1[i];
+                    w1[i] = w0;
+                }
+                *x = v;
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
 } // namespace filters
 } // namespace spectral
 } // namespace ei
@@ -120,17 +120,8 @@ namespace processing {
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_lowpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
-        }
-
-        return EIDSP_OK;
+        // all rows (axes) in one pass
+        return filters::butterworth_rows(filter_order, sampling_frequency, filter_cutoff, false, matrix);
     }
 
     /**
@@ -149,17 +140,8 @@ namespace processing {
         float filter_cutoff,
         uint8_t filter_order)
     {
-        for (size_t row = 0; row < matrix->rows; row++) {
-            filters::butterworth_highpass(
-                filter_order,
-                sampling_frequency,
-                filter_cutoff,
-                matrix->buffer + (row * matrix->cols),
-                matrix->buffer + (row * matrix->cols),
-                matrix->cols);
-        }
-
-        return EIDSP_OK;
+        // all rows (axes) in one pass
+        return filters::butterworth_rows(filter_order, sampling_frequency, filter_cutoff, true, matrix);
     }
 
     /**
@@ -275,7 +257,8 @@ namespace processing {
         }
 
         // turn this into C++ vector and sort it based on amplitude
-        ei_vector<freq_peak_t> peaks;
+        ei_scratch_vector<freq_peak_t> peaks;
+        peaks.reserve(peak_count > output_matrix->rows ? peak_count : output_matrix->rows);
         for (uint8_t ix = 0; ix < peak_count; ix++) {
             freq_peak_t d;
 
@@ -449,10 +432,13 @@ namespace processing {
             EIDSP_ERR(ret);
         }
 
-        fft_complex_t *fft_output = (fft_complex_t*)ei_dsp_calloc((n_fft / 2 + 1) * sizeof(fft_complex_t), 1);
+        ei::EiDspScratchBuffer fft_output_scratch((n_fft / 2 + 1) * sizeof(fft_complex_t));
+        fft_complex_t *fft_output = (fft_complex_t*)fft_output_scratch.buffer;
+        if (!fft_output) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
         ret = numpy::rfft(welch_matrix.buffer, welch_matrix.cols, fft_output, n_fft / 2 + 1, n_fft);
         if (ret != EIDSP_OK) {
-            ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
             EIDSP_ERR(ret);
         }
 
@@ -472,8 +458,6 @@ namespace processing {
             out_fft_matrix->buffer[ix] = fft_output[ix].r;
         }
 
-        ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
-
         return EIDSP_OK;
     }
 
@@ -40,177 +40,137 @@ namespace spectral {
 
 using fvec = ei_vector<float>;
 
-inline float dot(const float *x, const float *y, size_t sz)
-{
-    float sum = 0.0f;
-    for (size_t i = 0; i < sz; i++) {
-        sum += x[i] * y[i];
-    }
-    return sum;
-}
-
-inline void histo(const fvec &x, size_t nbins, fvec &h, bool normalize = false)
-{
-    float min = *std::min_element(x.begin(), x.end());
-    float max = *std::max_element(x.begin(), x.end());
-    float step = (max - min) / nbins;
-    h.resize(nbins);
-    for (size_t i = 0; i < x.size(); i++) {
-        size_t bin = (x[i] - min) / step;
-        if (bin >= nbins)
-            bin = nbins - 1;
-        h[bin]++;
-    }
-    if (normalize) {
-        float s = numpy::sum(h.data(), h.size());
-        for (size_t i = 0; i < nbins; i++) {
-            h[i] /= s;
-        }
-    }
-}
-
 class wavelet {
 
     static constexpr size_t NUM_FEATHERS_PER_COMP = 14;
+    static constexpr size_t MAX_FILTER_LENGTH = 20;
+    static constexpr size_t ENTROPY_BINS = 100;
+
+    /**
+     * Buffers of all decomposition levels of one axis. Every level is at most
+     * the size of the first one, so they're carved out of a single scratch
+     * matrix once per block (see work_size()) and reused for every level and axis.
+     */
+    typedef struct {
+        float h[MAX_FILTER_LENGTH];     // low pass decomposition filter, reversed
+        float g[MAX_FILTER_LENGTH];     // high pass decomposition filter, reversed
+        size_t nh;
+        float *padded;                  // input of the current level, symmetric padded
+        float *approx;                  // approximation coefficients, input of the next level
+        float *detail;                  // detail coefficients of the current level
+        float *select;                  // copy of the coefficients the percentiles reorder
+        float hist[ENTROPY_BINS];
+    } workspace_t;
 
     template <size_t wave_size>
-    static void get_filter(const std::array<std::array<float, wave_size>, 2> wav, fvec &h, fvec &g)
+    static size_t get_filter(const std::array<std::array<float, wave_size>, 2> &wav, float *h, float *g)
     {
-        size_t n = wav[0].size();
-        h.resize(n);
-        g.resize(n);
-        for (size_t i = 0; i < n; i++) {
-            h[i] = wav[0][n - i - 1];
-            g[i] = wav[1][n - i - 1];
+        static_assert(wave_size <= MAX_FILTER_LENGTH, "wavelet filter too long");
+        for (size_t i = 0; i < wave_size; i++) {
+            h[i] = wav[0][wave_size - i - 1];
+            g[i] = wav[1][wave_size - i - 1];
         }
+        return wave_size;
     }
 
-    static void find_filter(const char *wav, fvec &h, fvec &g)
+    static size_t find_filter(const char *wav, float *h, float *g)
     {
-        if (strcmp(wav, "bior1.3") == 0) get_filter<6>(bior1p3, h, g);
-        else if (strcmp(wav, "bior1.5") == 0) get_filter<10>(bior1p5, h, g);
-        else if (strcmp(wav, "bior2.2") == 0) get_filter<6>(bior2p2, h, g);
-        else if (strcmp(wav, "bior2.4") == 0) get_filter<10>(bior2p4, h, g);
-        else if (strcmp(wav, "bior2.6") == 0) get_filter<14>(bior2p6, h, g);
-        else if (strcmp(wav, "bior2.8") == 0) get_filter<18>(bior2p8, h, g);
-        else if (strcmp(wav, "bior3.1") == 0) get_filter<4>(bior3p1, h, g);
-        else if (strcmp(wav, "bior3.3") == 0) get_filter<8>(bior3p3, h, g);
-        else if (strcmp(wav, "bior3.5") == 0) get_filter<12>(bior3p5, h, g);
-        else if (strcmp(wav, "bior3.7") == 0) get_filter<16>(bior3p7, h, g);
-        else if (strcmp(wav, "bior3.9") == 0) get_filter<20>(bior3p9, h, g);
-        else if (strcmp(wav, "bior4.4") == 0) get_filter<10>(bior4p4, h, g);
-        else if (strcmp(wav, "bior5.5") == 0) get_filter<12>(bior5p5, h, g);
-        else if (strcmp(wav, "bior6.8") == 0) get_filter<18>(bior6p8, h, g);
-        else if (strcmp(wav, "coif1") == 0) get_filter<6>(coif1, h, g);
-        else if (strcmp(wav, "coif2") == 0) get_filter<12>(coif2, h, g);
-        else if (strcmp(wav, "coif3") == 0) get_filter<18>(coif3, h, g);
-        else if (strcmp(wav, "db2") == 0) get_filter<4>(db2, h, g);
-        else if (strcmp(wav, "db3") == 0) get_filter<6>(db3, h, g);
-        else if (strcmp(wav, "db4") == 0) get_filter<8>(db4, h, g);
-        else if (strcmp(wav, "db5") == 0) get_filter<10>(db5, h, g);
-        else if (strcmp(wav, "db6") == 0) get_filter<12>(db6, h, g);
-        else if (strcmp(wav, "db7") == 0) get_filter<14>(db7, h, g);
-        else if (strcmp(wav, "db8") == 0) get_filter<16>(db8, h, g);
-        else if (strcmp(wav, "db9") == 0) get_filter<18>(db9, h, g);
-        else if (strcmp(wav, "db10") == 0) get_filter<20>(db10, h, g);
-        else if (strcmp(wav, "haar") == 0) get_filter<2>(haar, h, g);
-        else if (strcmp(wav, "rbio1.3") == 0) get_filter<6>(rbio1p3, h, g);
-        else if (strcmp(wav, "rbio1.5") == 0) get_filter<10>(rbio1p5, h, g);
-        else if (strcmp(wav, "rbio2.2") == 0) get_filter<6>(rbio2p2, h, g);
-        else if (strcmp(wav, "rbio2.4") == 0) get_filter<10>(rbio2p4, h, g);
-        else if (strcmp(wav, "rbio2.6") == 0) get_filter<14>(rbio2p6, h, g);
-        else if (strcmp(wav, "rbio2.8") == 0) get_filter<18>(rbio2p8, h, g);
-        else if (strcmp(wav, "rbio3.1") == 0) get_filter<4>(rbio3p1, h, g);
-        else if (strcmp(wav, "rbio3.3") == 0) get_filter<8>(rbio3p3, h, g);
-        else if (strcmp(wav, "rbio3.5") == 0) get_filter<12>(rbio3p5, h, g);
-        else if (strcmp(wav, "rbio3.7") == 0) get_filter<16>(rbio3p7, h, g);
-        else if (strcmp(wav, "rbio3.9") == 0) get_filter<20>(rbio3p9, h, g);
-        else if (strcmp(wav, "rbio4.4") == 0) get_filter<10>(rbio4p4, h, g);
-        else if (strcmp(wav, "rbio5.5") == 0) get_filter<12>(rbio5p5, h, g);
-        else if (strcmp(wav, "rbio6.8") == 0) get_filter<18>(rbio6p8, h, g);
-        else if (strcmp(wav, "sym2") == 0) get_filter<4>(sym2, h, g);
-        else if (strcmp(wav, "sym3") == 0) get_filter<6>(sym3, h, g);
-        else if (strcmp(wav, "sym4") == 0) get_filter<8>(sym4, h, g);
-        else if (strcmp(wav, "sym5") == 0) get_filter<10>(sym5, h, g);
-        else if (strcmp(wav, "sym6") == 0) get_filter<12>(sym6, h, g);
-        else if (strcmp(wav, "sym7") == 0) get_filter<14>(sym7, h, g);
-        else if (strcmp(wav, "sym8") == 0) get_filter<16>(sym8, h, g);
-        else if (strcmp(wav, "sym9") == 0) get_filter<18>(sym9, h, g);
-        else if (strcmp(wav, "sym10") == 0) get_filter<20>(sym10, h, g);
-        else assert(0); // wavelet not in the list
+        if (strcmp(wav, "bior1.3") == 0) return get_filter<6>(bior1p3, h, g);
+        if (strcmp(wav, "bior1.5") == 0) return get_filter<10>(bior1p5, h, g);
+        if (strcmp(wav, "bior2.2") == 0) return get_filter<6>(bior2p2, h, g);
+        if (strcmp(wav, "bior2.4") == 0) return get_filter<10>(bior2p4, h, g);
+        if (strcmp(wav, "bior2.6") == 0) return get_filter<14>(bior2p6, h, g);
+        if (strcmp(wav, "bior2.8") == 0) return get_filter<18>(bior2p8, h, g);
+        if (strcmp(wav, "bior3.1") == 0) return get_filter<4>(bior3p1, h, g);
+        if (strcmp(wav, "bior3.3") == 0) return get_filter<8>(bior3p3, h, g);
+        if (strcmp(wav, "bior3.5") == 0) return get_filter<12>(bior3p5, h, g);
+        if (strcmp(wav, "bior3.7") == 0) return get_filter<16>(bior3p7, h, g);
+        if (strcmp(wav, "bior3.9") == 0) return get_filter<20>(bior3p9, h, g);
+        if (strcmp(wav, "bior4.4") == 0) return get_filter<10>(bior4p4, h, g);
+        if (strcmp(wav, "bior5.5") == 0) return get_filter<12>(bior5p5, h, g);
+        if (strcmp(wav, "bior6.8") == 0) return get_filter<18>(bior6p8, h, g);
+        if (strcmp(wav, "coif1") == 0) return get_filter<6>(coif1, h, g);
+        if (strcmp(wav, "coif2") == 0) return get_filter<12>(coif2, h, g);
+        if (strcmp(wav, "coif3") == 0) return get_filter<18>(coif3, h, g);
+        if (strcmp(wav, "db2") == 0) return get_filter<4>(db2, h, g);
+        if (strcmp(wav, "db3") == 0) return get_filter<6>(db3, h, g);
+        if (strcmp(wav, "db4") == 0) return get_filter<8>(db4, h, g);
+        if (strcmp(wav, "db5") == 0) return get_filter<10>(db5, h, g);
+        if (strcmp(wav, "db6") == 0) return get_filter<12>(db6, h, g);
+        if (strcmp(wav, "db7") == 0) return get_filter<14>(db7, h, g);
+        if (strcmp(wav, "db8") == 0) return get_filter<16>(db8, h, g);
+        if (strcmp(wav, "db9") == 0) return get_filter<18>(db9, h, g);
+        if (strcmp(wav, "db10") == 0) return get_filter<20>(db10, h, g);
+        if (strcmp(wav, "haar") == 0) return get_filter<2>(haar, h, g);
+        if (strcmp(wav, "rbio1.3") == 0) return get_filter<6>(rbio1p3, h, g);
+        if (strcmp(wav, "rbio1.5") == 0) return get_filter<10>(rbio1p5, h, g);
+        if (strcmp(wav, "rbio2.2") == 0) return get_filter<6>(rbio2p2, h, g);
+        if (strcmp(wav, "rbio2.4") == 0) return get_filter<10>(rbio2p4, h, g);
+        if (strcmp(wav, "rbio2.6") == 0) return get_filter<14>(rbio2p6, h, g);
+        if (strcmp(wav, "rbio2.8") == 0) return get_filter<18>(rbio2p8, h, g);
+        if (strcmp(wav, "rbio3.1") == 0) return get_filter<4>(rbio3p1, h, g);
+        if (strcmp(wav, "rbio3.3") == 0) return get_filter<8>(rbio3p3, h, g);
+        if (strcmp(wav, "rbio3.5") == 0) return get_filter<12>(rbio3p5, h, g);
+        if (strcmp(wav, "rbio3.7") == 0) return get_filter<16>(rbio3p7, h, g);
+        if (strcmp(wav, "rbio3.9") == 0) return get_filter<20>(rbio3p9, h, g);
+        if (strcmp(wav, "rbio4.4") == 0) return get_filter<10>(rbio4p4, h, g);
+        if (strcmp(wav, "rbio5.5") == 0) return get_filter<12>(rbio5p5, h, g);
+        if (strcmp(wav, "rbio6.8") == 0) return get_filter<18>(rbio6p8, h, g);
+        if (strcmp(wav, "sym2") == 0) return get_filter<4>(sym2, h, g);
+        if (strcmp(wav, "sym3") == 0) return get_filter<6>(sym3, h, g);
+        if (strcmp(wav, "sym4") == 0) return get_filter<8>(sym4, h, g);
+        if (strcmp(wav, "sym5") == 0) return get_filter<10>(sym5, h, g);
+        if (strcmp(wav, "sym6") == 0) return get_filter<12>(sym6, h, g);
+        if (strcmp(wav, "sym7") == 0) return get_filter<14>(sym7, h, g);
+        if (strcmp(wav, "sym8") == 0) return get_filter<16>(sym8, h, g);
+        if (strcmp(wav, "sym9") == 0) return get_filter<18>(sym9, h, g);
+        if (strcmp(wav, "sym10") == 0) return get_filter<20>(sym10, h, g);
+        return 0; // wavelet not in the list
     }
 
-    static void calculate_entropy(const fvec &y, fvec &features)
+    static size_t align_floats(size_t n)
     {
-        fvec h;
-        histo(y, 100, h, true);
-        // entropy = -sum(prob * log(prob)
-        float entropy = 0.0f;
-        for (size_t i = 0; i < h.size(); i++) {
-            if (h[i] > 0.0f) {
-                entropy -= h[i] * log(h[i]);
-            }
-        }
-        features.push_back(entropy);
+        return (n + 3) & ~((size_t)3);
     }
 
-    static float get_percentile_from_sorted(const fvec &sorted, float percentile)
+    static size_t coeff_count(size_t nx, size_t nh)
     {
-        // adding 0.5 is a trick to get rounding out of C flooring behavior during cast
-        size_t index = (size_t) ((percentile * (sorted.size()-1)) + 0.5);
-        return sorted[index];
+        return (nx + nh - 1) / 2;
     }
 
-    static void calculate_statistics(const fvec &y, fvec &features, float mean)
+    /**
+     * Floats of scratch for a decomposition of len samples with a filter of nh taps
+     */
+    static size_t work_size(size_t len, size_t nh)
     {
-        fvec sorted = y;
-        std::sort(sorted.begin(), sorted.end());
-        features.push_back(get_percentile_from_sorted(sorted,0.05));
-        features.push_back(get_percentile_from_sorted(sorted,0.25));
-        features.push_back(get_percentile_from_sorted(sorted,0.75));
-        features.push_back(get_percentile_from_sorted(sorted,0.95));
-        features.push_back(get_percentile_from_sorted(sorted,0.5));
-
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
-
-        features.push_back(mean);
-        if (numpy::stdev(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        features.push_back(numpy::variance(const_cast<float *>(y.data()), y.size()));
-        if (numpy::rms(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        if (numpy::skew(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
-        if (numpy::kurtosis(&x, &out) == EIDSP_OK)
-            features.push_back(out.get_row_ptr(0)[0]);
+        return align_floats(len + nh * 2 - 2) + 3 * align_floats(coeff_count(len, nh));
     }
 
-    static void calculate_crossings(const fvec &y, fvec &features, float mean)
+    static size_t get_percentile_index(size_t size, float percentile)
     {
-        size_t zc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
-            if (y[i] * y[i - 1] < 0) {
-                zc++;
-            }
-        }
-        features.push_back(zc / (float)y.size());
+        // adding 0.5 is a trick to get rounding out of C flooring behavior during cast
+        return (size_t) ((percentile * (size-1)) + 0.5);
+    }
 
-        size_t mc = 0;
-        for (size_t i = 1; i < y.size(); i++) {
-            if ((y[i] - mean) * (y[i - 1] - mean) < 0) {
-                mc++;
-            }
+    /**
+     * Put the k-th smallest value of buf in place, k outside [first, last) means
+     * it already is (an earlier selection put it there)
+     */
+    static void select_kth(float *buf, size_t first, size_t k, size_t last)
+    {
+        if (k >= first && k < last) {
+            std::nth_element(buf + first, buf + k, buf + last);
         }
-        features.push_back(mc / (float)y.size());
     }
 
-    static void
-    dwt(const float *x, size_t nx, const float *h, const float *g, size_t nh, fvec &a, fvec &d)
+    /**
+     * Single level DWT of x into ws->approx and ws->detail, x may be ws->approx
+     * @returns Number of coefficients
+     */
+    static size_t dwt(const float *x, size_t nx, workspace_t *ws)
     {
-        assert(nh <= 20 && nh > 0 && nx > 0);
-        size_t nx_padded = nx + nh * 2 - 2;
-        fvec x_padded(nx_padded);
+        const size_t nh = ws->nh;
+        float *x_padded = ws->padded;
 
         // symmetric padding (default in PyWavelet)
         for (size_t i = 0; i < nh - 2; i++)
@@ -220,75 +180,137 @@ class wavelet {
         for (size_t i = 0; i < nh; i++)
             x_padded[i + nx + nh - 2] = x[nx - 1 - i];
 
-        size_t ny = (nx + nh - 1) / 2;
-        a.resize(ny);
-        d.resize(ny);
+        const size_t ny = coeff_count(nx, nh);
 
-        // decimate and filter
-        const float *xx = x_padded.data();
+        // decimate and filter, both filters in one pass over the input
         for (size_t i = 0; i < ny; i++) {
-            a[i] = dot(xx + 2 * i, h, nh);
-            d[i] = dot(xx + 2 * i, g, nh);
+            const float *xx = x_padded + 2 * i;
+            float a = 0.0f;
+            float d = 0.0f;
+            for (size_t k = 0; k < nh; k++) {
+                a += xx[k] * ws->h[k];
+                d += xx[k] * ws->g[k];
+            }
+            ws->approx[i] = a;
+            ws->detail[i] = d;
         }
 
-        numpy::underflow_handling(d.data(), d.size());
-        numpy::underflow_handling(a.data(), a.size());
+        numpy::underflow_handling(ws->detail, ny);
+        numpy::underflow_handling(ws->approx, ny);
+        return ny;
     }
 
-    static void extract_features(fvec& y, fvec &features)
+    /**
+     * The NUM_FEATHERS_PER_COMP features of one set of coefficients: entropy,
+     * zero and mean crossings, percentiles (5, 25, 75, 95, 50), mean, stdev,
+     * variance, rms, skewness and kurtosis. Two passes over y instead of one
+     * per statistic, the percentiles are selected rather than sorted. Every sum
+     * accumulates in the same order as numpy::mean/stdev/variance/rms/skew/kurtosis.
+     */
+    static void extract_features(const float *y, size_t n, workspace_t *ws, float *features)
     {
-        matrix_t x(1, y.size(), const_cast<float *>(y.data()));
-        matrix_t out(1, 1);
-        if (numpy::mean(&x, &out) != EIDSP_OK)
-            assert(0);
-        float mean = out.get_row_ptr(0)[0];
-
-        calculate_entropy(y, features);
-        calculate_crossings(y, features, mean);
-        calculate_statistics(y, features, mean);
-    }
-
-    static void
-    wavedec_features(const float *x, int len, const char *wav, int level, fvec &features)
-    {
-        assert(level > 0 && level < 8);
-
-        fvec h;
-        fvec g;
-        find_filter(wav, h, g);
-
-        features.clear();
-        fvec a;
-        fvec d;
-        dwt(x, len, h.data(), g.data(), h.size(), a, d);
-        extract_features(d, features);
-
-        for (int l = 1; l < level; l++) {
-            dwt(a.data(), a.size(), h.data(), g.data(), h.size(), a, d);
-            extract_features(d, features);
+        // pass 1: mean, rms, range, zero crossings, copy for the percentiles
+        float sum = 0.0f;
+        float sum_sq = 0.0f;
+        float min = y[0];
+        float max = y[0];
+        size_t zc = 0;
+        for (size_t i = 0; i < n; i++) {
+            const float v = y[i];
+            sum += v;
+            sum_sq += v * v;
+            min = v < min ? v : min;
+            max = v > max ? v : max;
+            if (i > 0 && v * y[i - 1] < 0) {
+                zc++;
+            }
+            ws->select[i] = v;
         }
+        const float mean = sum / n;
+
+        // pass 2: central moments, mean crossings, histogram
+        const float step = (max - min) / ENTROPY_BINS;
+        memset(ws->hist, 0, sizeof(ws->hist));
+        float m_2 = 0.0f;
+        float m_3 = 0.0f;
+        float m_4 = 0.0f;
+        size_t mc = 0;
+        float prev_diff = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            const float diff = y[i] - mean;
+            const float square_diff = diff * diff;
+            m_2 += square_diff;
+            m_3 += square_diff * diff;
+            m_4 += square_diff * square_diff;
+            if (i > 0 && diff * prev_diff < 0) {
+                mc++;
+            }
+            prev_diff = diff;
 
-        extract_features(a, features);
+            size_t bin = step > 0.0f ? (size_t)((y[i] - min) / step) : 0;
+            if (bin >= ENTROPY_BINS)
+                bin = ENTROPY_BINS - 1;
+            ws->hist[bin]++;
+        }
 
-        for (int l = 0; l <= level / 2; l++) { // reverse order to match python results.
-            for (int i = 0; i < (int)NUM_FEATHERS_PER_COMP; i++) {
-                std::swap(
-                    features[l * NUM_FEATHERS_PER_COMP + i],
-                    features[(level - l) * NUM_FEATHERS_PER_COMP + i]);
+        // entropy = -sum(prob * log(prob)
+        float entropy = 0.0f;
+        for (size_t i = 0; i < ENTROPY_BINS; i++) {
+            const float prob = ws->hist[i] / n;
+            if (prob > 0.0f) {
+                entropy -= prob * log(prob);
             }
         }
+
+        // order statistics: the median first, the others within its halves
+        float *sel = ws->select;
+        const size_t ix_05 = get_percentile_index(n, 0.05);
+        const size_t ix_25 = get_percentile_index(n, 0.25);
+        const size_t ix_50 = get_percentile_index(n, 0.5);
+        const size_t ix_75 = get_percentile_index(n, 0.75);
+        const size_t ix_95 = get_percentile_index(n, 0.95);
+        select_kth(sel, 0, ix_50, n);
+        select_kth(sel, 0, ix_25, ix_50);
+        select_kth(sel, 0, ix_05, ix_25);
+        select_kth(sel, ix_50 + 1, ix_75, n);
+        select_kth(sel, ix_75 + 1, ix_95, n);
+
+        const float var_pop = m_2 / n;
+        const float skew_den = sqrt(var_pop * var_pop * var_pop);
+        const float kurt_den = var_pop * var_pop;
+
+        features[0] = entropy;
+        features[1] = zc / (float)n;
+        features[2] = mc / (float)n;
+        features[3] = sel[ix_05];
+        features[4] = sel[ix_25];
+        features[5] = sel[ix_75];
+        features[6] = sel[ix_95];
+        features[7] = sel[ix_50];
+        features[8] = mean;
+        features[9] = sqrt(var_pop);
+        features[10] = m_2 / (n - 1);
+        features[11] = sqrt(sum_sq / static_cast<float>(n));
+        features[12] = skew_den == 0.0f ? 0.0f : (m_3 / n) / skew_den;
+        features[13] = kurt_den == 0.0f ? -3.0f : ((m_4 / n) / kurt_den) - 3.0f;
     }
 
-    static int dwt_features(const float *x, int len, const char *wav, int level, fvec &features)
+    /**
+     * Multi level decomposition of x, features of every level written straight
+     * to their place in the output: approximation of the last level first, then
+     * the details from the last level to the first (the order of the python block)
+     */
+    static void wavedec_features(const float *x, size_t len, int level, workspace_t *ws, float *features)
     {
-        assert(level <= 7);
+        size_t n = dwt(x, len, ws);
+        extract_features(ws->detail, n, ws, features + level * NUM_FEATHERS_PER_COMP);
 
-        assert(features.size() == 0); // make sure features is empty
-        features.reserve((level + 1) * NUM_FEATHERS_PER_COMP);
-
-        wavedec_features(x, len, wav, level, features);
+        for (int l = 1; l < level; l++) {
+            n = dwt(ws->approx, n, ws);
+            extract_features(ws->detail, n, ws, features + (level - l) * NUM_FEATHERS_PER_COMP);
+        }
 
-        return features.size();
+        extract_features(ws->approx, n, ws, features);
     }
 
     static bool check_min_size(int len, int level)
@@ -333,26 +355,35 @@ public:
 
         EI_TRY(processing::subtract_mean(input_matrix));
 
-        int out_idx = 0;
-        for (size_t row = 0; row < input_matrix->rows; row++) {
-            float *data_window = input_matrix->get_row_ptr(row);
-            size_t data_size = input_matrix->cols;
+        const int level = config->wavelet_level;
+        const size_t data_size = input_matrix->cols;
+        const size_t num_features = (level + 1) * NUM_FEATHERS_PER_COMP;
 
-            if (!check_min_size(data_size, config->wavelet_level))
-                EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        if (level <= 0 || level > 7 || !check_min_size(data_size, level))
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        if (output_matrix->rows * output_matrix->cols != num_features * input_matrix->rows)
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
 
-            fvec features;
-            size_t num_features = dwt_features(
-                data_window,
-                data_size,
-                config->wavelet,
-                config->wavelet_level,
-                features);
+        workspace_t ws;
+        ws.nh = find_filter(config->wavelet, ws.h, ws.g);
+        if (ws.nh == 0)
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
 
-            assert(num_features == output_matrix->cols / input_matrix->rows);
-            for (size_t i = 0; i < num_features; i++) {
-                output_matrix->buffer[out_idx++] = features[i];
-            }
+        // one scratch buffer for all levels and axes
+        const size_t coeff_size = align_floats(coeff_count(data_size, ws.nh));
+        EI_DSP_MATRIX(work, 1, work_size(data_size, ws.nh));
+        ws.padded = work.buffer;
+        ws.approx = ws.padded + align_floats(data_size + ws.nh * 2 - 2);
+        ws.detail = ws.approx + coeff_size;
+        ws.select = ws.detail + coeff_size;
+
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            wavedec_features(
+                input_matrix->get_row_ptr(row),
+                data_size,
+                level,
+                &ws,
+                output_matrix->buffer + row * num_features);
         }
         return EIDSP_OK;
     }
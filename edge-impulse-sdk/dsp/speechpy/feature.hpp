@@ -36,6 +36,7 @@
 #include "../ei_utils.h"
 #include "functions.hpp"
 #include "processing.hpp"
+#include "sparse_filterbank.h"
 #include "../memory.hpp"
 #include "../returntypes.hpp"
 #include "../ei_vector.h"
@@ -76,15 +77,16 @@ public:
         const size_t hertz_mem_size = (num_filter + 2) * sizeof(float);
         const size_t freq_index_mem_size = (num_filter + 2) * sizeof(int);
 
-        float *mels = (float*)ei_dsp_malloc(mels_mem_size);
-        if (!mels) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
         if (filterbanks->rows != num_filter || filterbanks->cols != static_cast<uint32_t>(coefficients)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+        // the mel points only live while the filterbank is built
+        float *mels = (float*)ei_dsp_scratch_calloc(mels_mem_size);
+        if (!mels) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
 #if EIDSP_QUANTIZE_FILTERBANK
         memset(filterbanks->buffer, 0, filterbanks->rows * filterbanks->cols * sizeof(uint8_t));
 #else
@@ -103,9 +105,9 @@ public:
 
         // we should convert Mels back to Hertz because the start and end-points
         // should be at the desired frequencies.
-        float *hertz = (float*)ei_dsp_malloc(hertz_mem_size);
+        float *hertz = (float*)ei_dsp_scratch_calloc(hertz_mem_size);
         if (!hertz) {
-            ei_dsp_free(mels, mels_mem_size);
+            ei_dsp_scratch_free(mels);
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
         for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
@@ -125,20 +127,20 @@ public:
                 hertz[ix] -= 0.001;
             }
         }
-        ei_dsp_free(mels, mels_mem_size);
+        ei_dsp_scratch_free(mels);
 
         // The frequency resolution required to put filters at the
         // exact points calculated above should be extracted.
         //  So we should round those frequencies to the closest FFT bin.
-        int *freq_index = (int*)ei_dsp_malloc(freq_index_mem_size);
+        int *freq_index = (int*)ei_dsp_scratch_calloc(freq_index_mem_size);
         if (!freq_index) {
-            ei_dsp_free(hertz, hertz_mem_size);
+            ei_dsp_scratch_free(hertz);
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
         for (uint16_t ix = 0; ix < num_filter + 2; ix++) {
             freq_index[ix] = static_cast<int>(floor((coefficients + 1) * hertz[ix] / sampling_freq));
         }
-        ei_dsp_free(hertz, hertz_mem_size);
+        ei_dsp_scratch_free(hertz);
 
         for (size_t i = 0; i < num_filter; i++) {
             int left = freq_index[i];
@@ -147,7 +149,7 @@ public:
 
             EI_DSP_MATRIX(z, 1, (right - left + 1));
             if (!z.buffer) {
-                ei_dsp_free(freq_index, freq_index_mem_size);
+                ei_dsp_scratch_free(freq_index);
                 EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
             numpy::linspace(left, right, (right - left + 1), z.buffer);
@@ -175,7 +177,7 @@ public:
             filterbanks->cols = r;
         }
 
-        ei_dsp_free(freq_index, freq_index_mem_size);
+        ei_dsp_scratch_free(freq_index);
 
         return EIDSP_OK;
     }
@@ -193,6 +195,72 @@ public:
         return static_cast<int>(floor((fft_size + 1) * hertz / sampling_freq));
     }
 
+    /**
+     * Mel filter edges as FFT bins, as used by mfe(): filter i rises from bins[i] to
+     * bins[i + 1] and falls back to zero at bins[i + 2].
+     * A high_frequency of 0 means sampling_frequency / 2, and before version 4 a
+     * low_frequency of 0 means 300 Hz.
+     * @param bins Out buffer, num_filters + 2 entries
+     * @returns EIDSP_OK if OK
+     */
+    static int calculate_mel_bins(uint16_t *bins, uint16_t num_filters, uint16_t fft_length,
+        uint32_t sampling_frequency, uint32_t low_frequency, uint32_t high_frequency, uint16_t version)
+    {
+        if (high_frequency == 0) {
+            high_frequency = sampling_frequency / 2;
+        }
+
+        if (version<4) {
+            if (low_frequency == 0) {
+                low_frequency = 300;
+            }
+        }
+
+        const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        // Computing the Mel filterbank
+        // converting the upper and lower frequencies to Mels.
+        // num_filter + 2 is because for num_filter filterbanks we need
+        // num_filter+2 point.
+        float *mels;
+        const int MELS_SIZE = num_filters + 2;
+        const size_t mem_size = MELS_SIZE * sizeof(float);
+        mels = (float*)ei_dsp_scratch_calloc(mem_size);
+        EI_ERR_AND_RETURN_ON_NULL(mels, EIDSP_OUT_OF_MEM);
+        ei_unique_ptr_t __ptr__(mels, ei_dsp_scratch_free);
+
+        numpy::linspace(
+            functions::frequency_to_mel(static_cast<float>(low_frequency)),
+            functions::frequency_to_mel(static_cast<float>(high_frequency)),
+            num_filters + 2,
+            mels);
+
+        uint16_t max_bin = version >= 4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
+        // go to -1 size b/c special handling, see after
+        for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
+            mels[ix] = functions::mel_to_frequency(mels[ix]);
+            if (mels[ix] < low_frequency) {
+                mels[ix] = low_frequency;
+            }
+            if (mels[ix] > high_frequency) {
+                mels[ix] = high_frequency;
+            }
+            bins[ix] = get_fft_bin_from_hertz(max_bin, mels[ix], sampling_frequency);
+        }
+
+        // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
+        // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
+        // thus calculating the bucket to 64, not 65.
+        // we're adjusting this here a tiny bit to ensure we have the same result
+        mels[MELS_SIZE-1] = functions::mel_to_frequency(mels[MELS_SIZE-1]);
+        if (mels[MELS_SIZE-1] > high_frequency) {
+            mels[MELS_SIZE-1] = high_frequency;
+        }
+        mels[MELS_SIZE-1] -= 0.001;
+        bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
+
+        return EIDSP_OK;
+    }
+
     /**
      * Compute Mel-filterbank energy features from an audio signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -223,16 +291,6 @@ public:
     {
         int ret = 0;
 
-        if (high_frequency == 0) {
-            high_frequency = sampling_frequency / 2;
-        }
-
-        if (version<4) {
-            if (low_frequency == 0) {
-                low_frequency = 300;
-            }
-        }
-
         stack_frames_info_t stack_frame_info = { 0 };
         stack_frame_info.signal = signal;
 
@@ -267,47 +325,18 @@ public:
         }
 
         const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
-        // Computing the Mel filterbank
-        // converting the upper and lower frequencies to Mels.
-        // num_filter + 2 is because for num_filter filterbanks we need
-        // num_filter+2 point.
-        float *mels;
-        const int MELS_SIZE = num_filters + 2;
-        const size_t mem_size = MELS_SIZE * sizeof(float);
-        mels = (float*)ei_dsp_calloc(MELS_SIZE, sizeof(float));
-        EI_ERR_AND_RETURN_ON_NULL(mels, EIDSP_OUT_OF_MEM);
-        ei_unique_ptr_t __ptr__(mels,[mem_size](void* ptr){ei::ei_dsp_free_func(ptr, mem_size);});
-        uint16_t* bins = reinterpret_cast<uint16_t*>(mels); // alias the mels array so we can reuse the space
-
-        numpy::linspace(
-            functions::frequency_to_mel(static_cast<float>(low_frequency)),
-            functions::frequency_to_mel(static_cast<float>(high_frequency)),
-            num_filters + 2,
-            mels);
-
-        uint16_t max_bin = version >= 4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
-        // go to -1 size b/c special handling, see after
-        for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
-            mels[ix] = functions::mel_to_frequency(mels[ix]);
-            if (mels[ix] < low_frequency) {
-                mels[ix] = low_frequency;
-            }
-            if (mels[ix] > high_frequency) {
-                mels[ix] = high_frequency;
-            }
-            bins[ix] = get_fft_bin_from_hertz(max_bin, mels[ix], sampling_frequency);
-        }
 
-        // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
-        // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
-        // thus calculating the bucket to 64, not 65.
-        // we're adjusting this here a tiny bit to ensure we have the same result
-        mels[MELS_SIZE-1] = functions::mel_to_frequency(mels[MELS_SIZE-1]);
-        if (mels[MELS_SIZE-1] > high_frequency) {
-            mels[MELS_SIZE-1] = high_frequency;
+        // filterbank is cached per config, a temporary one on the scratch arena if all slots are taken
+        sparse_filterbank_t *temp_filterbank = nullptr;
+        const sparse_filterbank_t *filterbank = sparse_filterbank_get(SPARSE_FILTERBANK_MEL_BINS,
+            num_filters, fft_length, sampling_frequency, low_frequency, high_frequency, version);
+        if (!filterbank) {
+            temp_filterbank = sparse_filterbank_create(SPARSE_FILTERBANK_MEL_BINS,
+                num_filters, fft_length, sampling_frequency, low_frequency, high_frequency, version, true);
+            EI_ERR_AND_RETURN_ON_NULL(temp_filterbank, EIDSP_OUT_OF_MEM);
+            filterbank = temp_filterbank;
         }
-        mels[MELS_SIZE-1] -= 0.001;
-        bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
+        ei_unique_ptr_t __ptr__(temp_filterbank, [](void* ptr){ sparse_filterbank_free((sparse_filterbank_t*)ptr); });
 
         EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
         if (!power_spectrum_frame.buffer) {
@@ -356,38 +385,7 @@ public:
                 out_energies->buffer[ix] = energy;
             }
 
-            auto row_ptr = out_features->get_row_ptr(ix);
-            for (size_t i = 0; i < num_filters; i++) {
-                size_t left = bins[i];
-                size_t middle = bins[i+1];
-                size_t right = bins[i+2];
-
-                assert(right < power_spectrum_frame_size);
-                // now we have weights and locations to move from fft to mel sgram
-                // both left and right become zero weights, so skip them
-
-                // middle always has weight of 1.0
-                // since we skip left and right, if left = middle we need to handle that
-                row_ptr[i] = power_spectrum_frame.buffer[middle];
-
-                for (size_t bin = left+1; bin < right; bin++) {
-                    if (bin < middle) {
-                        row_ptr[i] +=
-                            ((static_cast<float>(bin) - left) / (middle - left)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                    // intentionally skip middle, handled above
-                    if (bin > middle) {
-                        row_ptr[i] +=
-                            ((right - static_cast<float>(bin)) / (right - middle)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                }
-            }
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+            sparse_filterbank_apply(filterbank, power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
         }
 
         numpy::zero_handling(out_features);
@@ -466,24 +464,18 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
-        uint16_t coefficients = fft_length / 2 + 1;
-
-        // calculate the filterbanks first... preferably I would want to do the matrix multiplications
-        // whenever they happen, but OK...
-#if EIDSP_QUANTIZE_FILTERBANK
-        EI_DSP_QUANTIZED_MATRIX(filterbanks, num_filters, coefficients, &numpy::dequantize_zero_one);
-#else
-        EI_DSP_MATRIX(filterbanks, num_filters, coefficients);
-#endif
-        if (!filterbanks.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        ret = feature::filterbanks(
-            &filterbanks, num_filters, coefficients, sampling_frequency, low_frequency, high_frequency, true);
-        if (ret != 0) {
-            EIDSP_ERR(ret);
+        // same weights as feature::filterbanks(), without the zeros, cached per config
+        // (a temporary one on the scratch arena if all slots are taken)
+        sparse_filterbank_t *temp_filterbank = nullptr;
+        const sparse_filterbank_t *filterbank = sparse_filterbank_get(SPARSE_FILTERBANK_SPEECHPY,
+            num_filters, fft_length, sampling_frequency, low_frequency, high_frequency, version);
+        if (!filterbank) {
+            temp_filterbank = sparse_filterbank_create(SPARSE_FILTERBANK_SPEECHPY,
+                num_filters, fft_length, sampling_frequency, low_frequency, high_frequency, version, true);
+            EI_ERR_AND_RETURN_ON_NULL(temp_filterbank, EIDSP_OUT_OF_MEM);
+            filterbank = temp_filterbank;
         }
+        ei_unique_ptr_t __ptr__(temp_filterbank, [](void* ptr){ sparse_filterbank_free((sparse_filterbank_t*)ptr); });
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
             size_t power_spectrum_frame_size = (fft_length / 2 + 1);
 
@@ -534,17 +526,7 @@ public:
             }
 
             // calculate the out_features directly here
-            ret = numpy::dot_by_row(
-                ix,
-                power_spectrum_frame.buffer,
-                power_spectrum_frame_size,
-                &filterbanks,
-                out_features
-            );
-
-            if (ret != 0) {
-                EIDSP_ERR(ret);
-            }
+            sparse_filterbank_apply(filterbank, power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
         }
 
         numpy::zero_handling(out_features);
@@ -0,0 +1,578 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#include "edge-impulse-sdk/dsp/speechpy/feature_fixed.h"
+
+#include <math.h>
+#include <string.h>
+#include "edge-impulse-sdk/dsp/ei_signal_view.h"
+#include "edge-impulse-sdk/dsp/fft/ei_rfft_fixed.h"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include "edge-impulse-sdk/dsp/speechpy/feature.hpp"
+#include "edge-impulse-sdk/dsp/speechpy/processing.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace speechpy {
+
+// 1.0 of the mel weights
+#define FIXED_POINT_WEIGHT_ONE      32768
+// 0.98 (preemphasis of the MFE blocks) in Q15
+#define FIXED_POINT_PREEMPHASIS     32113
+// samples converted from a signal_t per get_data() call
+#define FIXED_POINT_READ_CHUNK      64
+
+/**
+ * log2(1 + i / 256) in Q16
+ */
+static const uint16_t log2_table[256] = {
+        0,   369,   736,  1102,  1466,  1829,  2190,  2551,  2909,  3267,  3623,  3978,
+     4331,  4683,  5034,  5384,  5732,  6079,  6425,  6769,  7112,  7454,  7795,  8134,
+     8473,  8810,  9146,  9480,  9814, 10146, 10477, 10807, 11136, 11464, 11791, 12116,
+    12440, 12764, 13086, 13407, 13727, 14046, 14363, 14680, 14996, 15310, 15624, 15937,
+    16248, 16559, 16868, 17177, 17484, 17791, 18096, 18401, 18704, 19007, 19308, 19609,
+    19909, 20207, 20505, 20802, 21098, 21393, 21687, 21980, 22272, 22564, 22854, 23144,
+    23433, 23720, 24007, 24293, 24579, 24863, 25146, 25429, 25711, 25992, 26272, 26551,
+    26830, 27108, 27384, 27660, 27936, 28210, 28484, 28757, 29029, 29300, 29571, 29840,
+    30109, 30378, 30645, 30912, 31178, 31443, 31707, 31971, 32234, 32496, 32758, 33019,
+    33279, 33538, 33797, 34055, 34312, 34569, 34825, 35080, 35334, 35588, 35841, 36094,
+    36346, 36597, 36847, 37097, 37346, 37595, 37842, 38090, 38336, 38582, 38827, 39072,
+    39316, 39559, 39802, 40044, 40286, 40527, 40767, 41006, 41246, 41484, 41722, 41959,
+    42196, 42432, 42667, 42902, 43137, 43370, 43603, 43836, 44068, 44300, 44530, 44761,
+    44990, 45220, 45448, 45676, 45904, 46131, 46357, 46583, 46809, 47034, 47258, 47482,
+    47705, 47928, 48150, 48372, 48593, 48813, 49034, 49253, 49472, 49691, 49909, 50127,
+    50344, 50560, 50776, 50992, 51207, 51422, 51636, 51850, 52063, 52276, 52488, 52700,
+    52911, 53122, 53332, 53542, 53751, 53960, 54169, 54377, 54584, 54791, 54998, 55204,
+    55410, 55615, 55820, 56025, 56229, 56432, 56635, 56838, 57040, 57242, 57443, 57644,
+    57845, 58045, 58245, 58444, 58643, 58841, 59039, 59237, 59434, 59631, 59827, 60023,
+    60219, 60414, 60609, 60803, 60997, 61190, 61384, 61576, 61769, 61961, 62152, 62343,
+    62534, 62725, 62915, 63104, 63294, 63483, 63671, 63859, 64047, 64234, 64421, 64608,
+    64794, 64980, 65166, 65351,
+};
+
+// log2(1e-10) in Q16, numpy::zero_handling() replaces zeros with 1e-10
+#define FIXED_POINT_LOG2_ZERO       (-2177059)
+// log2(1e-30) in Q16, the normalization clamps to 1e-30
+#define FIXED_POINT_LOG2_MIN        (-6531176)
+
+/**
+ * log2(value) in Q16, value > 0. Table lookup on the top 8 bits of the mantissa,
+ * linear interpolation on the next 8.
+ */
+static inline int32_t log2_q16(uint64_t value)
+{
+    const int exponent = 63 - __builtin_clzll(value);
+    const uint32_t mantissa = exponent >= 16 ?
+        (uint32_t)(value >> (exponent - 16)) : (uint32_t)(value << (16 - exponent));
+    const uint32_t ix = (mantissa >> 8) & 0xff;
+    const uint32_t frac = mantissa & 0xff;
+    const int32_t lo = log2_table[ix];
+    const int32_t hi = ix == 255 ? 65536 : log2_table[ix + 1];
+    return (exponent << 16) + lo + (((hi - lo) * (int32_t)frac + 128) >> 8);
+}
+
+static inline int bit_length(uint64_t value)
+{
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+/**
+ * Mel filterbank of feature::mfe() (SPARSE_FILTERBANK_MEL_BINS) with Q15 weights,
+ * FIXED_POINT_WEIGHT_ONE is 1.0
+ */
+typedef struct {
+    uint16_t num_filters;
+    uint16_t fft_length;
+    uint32_t sampling_frequency;
+    uint32_t low_frequency;
+    uint32_t high_frequency;
+    uint16_t version;
+
+    uint16_t *start;        // first power spectrum bin of every filter
+    uint16_t *count;        // number of weights of every filter
+    uint16_t *weights;      // filter after filter
+    int count_bits;         // bits of the largest count
+    size_t bytes;
+} fixed_filterbank_t;
+
+static fixed_filterbank_t *fixed_filterbank_create(const fixed_point_features_config_t *config)
+{
+    const uint16_t num_filters = config->num_filters;
+    const uint16_t coefficients = config->fft_length / 2 + 1;
+
+    uint16_t *bins = (uint16_t *)ei_calloc(num_filters + 2, sizeof(uint16_t));
+    if (!bins) {
+        return nullptr;
+    }
+    ei_unique_ptr_t bins_ptr(bins, ei_free);
+
+    if (feature::calculate_mel_bins(bins, num_filters, config->fft_length, config->sampling_frequency,
+            config->low_frequency, config->high_frequency, config->version) != EIDSP_OK) {
+        return nullptr;
+    }
+
+    // the weights of a filter run from its left edge to its right edge (see sparse_filterbank.cpp)
+    size_t weights_size = 0;
+    for (uint16_t ix = 0; ix < num_filters; ix++) {
+        if (bins[ix + 2] >= coefficients || bins[ix] > bins[ix + 1] || bins[ix + 1] > bins[ix + 2]) {
+            ei_printf("ERR: Mel filter %d out of range\n", (int)ix);
+            return nullptr;
+        }
+        weights_size += bins[ix + 2] - bins[ix] + 1;
+    }
+
+    const size_t bytes = sizeof(fixed_filterbank_t) + (2 * num_filters + weights_size) * sizeof(uint16_t);
+    fixed_filterbank_t *filterbank = (fixed_filterbank_t *)ei_calloc(1, bytes);
+    if (!filterbank) {
+        return nullptr;
+    }
+    ei_dsp_register_alloc(bytes, filterbank);
+
+    filterbank->num_filters = num_filters;
+    filterbank->fft_length = config->fft_length;
+    filterbank->sampling_frequency = config->sampling_frequency;
+    filterbank->low_frequency = config->low_frequency;
+    filterbank->high_frequency = config->high_frequency;
+    filterbank->version = config->version;
+    filterbank->bytes = bytes;
+    filterbank->start = (uint16_t *)(filterbank + 1);
+    filterbank->count = filterbank->start + num_filters;
+    filterbank->weights = filterbank->count + num_filters;
+
+    uint16_t *w = filterbank->weights;
+    for (uint16_t filter = 0; filter < num_filters; filter++) {
+        const uint32_t left = bins[filter];
+        const uint32_t middle = bins[filter + 1];
+        const uint32_t right = bins[filter + 2];
+
+        // same triangle as feature::mfe(), rounded to Q15. The edges are zero
+        // (unless they're the middle), so they're skipped.
+        uint32_t first = left == middle ? middle : left + 1;
+        uint32_t last = right == middle ? middle : right - 1;
+        filterbank->start[filter] = (uint16_t)first;
+        filterbank->count[filter] = (uint16_t)(last - first + 1);
+        for (uint32_t bin = first; bin <= last; bin++) {
+            uint32_t weight = FIXED_POINT_WEIGHT_ONE;
+            if (bin < middle) {
+                weight = ((bin - left) * FIXED_POINT_WEIGHT_ONE + (middle - left) / 2) / (middle - left);
+            }
+            else if (bin > middle) {
+                weight = ((right - bin) * FIXED_POINT_WEIGHT_ONE + (right - middle) / 2) / (right - middle);
+            }
+            *w++ = (uint16_t)weight;
+        }
+        const int bits = bit_length(filterbank->count[filter]);
+        filterbank->count_bits = bits > filterbank->count_bits ? bits : filterbank->count_bits;
+    }
+
+    return filterbank;
+}
+
+static fixed_filterbank_t *fixed_filterbanks[EIDSP_FILTERBANK_MAX_CACHED];
+
+static void fixed_filterbank_free(void *ptr)
+{
+    fixed_filterbank_t *filterbank = (fixed_filterbank_t *)ptr;
+    if (!filterbank) {
+        return;
+    }
+    ei_dsp_register_free(filterbank->bytes, filterbank);
+    ei_free(filterbank);
+}
+
+// call with an EiDspCacheLock held
+static const fixed_filterbank_t *fixed_filterbank_find(const fixed_point_features_config_t *config)
+{
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        const fixed_filterbank_t *fb = fixed_filterbanks[ix];
+        if (fb && fb->num_filters == config->num_filters && fb->fft_length == config->fft_length &&
+            fb->sampling_frequency == config->sampling_frequency &&
+            fb->low_frequency == config->low_frequency && fb->high_frequency == config->high_frequency &&
+            fb->version == config->version) {
+            return fb;
+        }
+    }
+    return nullptr;
+}
+
+static const fixed_filterbank_t *fixed_filterbank_get(const fixed_point_features_config_t *config)
+{
+    EiDspCacheLock lock;
+
+    const fixed_filterbank_t *fb = fixed_filterbank_find(config);
+    if (fb) {
+        return fb;
+    }
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        if (!fixed_filterbanks[ix]) {
+            fixed_filterbanks[ix] = fixed_filterbank_create(config);
+            return fixed_filterbanks[ix];
+        }
+    }
+    return nullptr;
+}
+
+void fixed_point_features_clear()
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        fixed_filterbank_free(fixed_filterbanks[ix]);
+        fixed_filterbanks[ix] = nullptr;
+    }
+}
+
+/**
+ * int16 samples, from a buffer (or the typed view of a signal_t, see
+ * ei_signal_view.h) or converted from a signal_t
+ */
+typedef struct {
+    signal_t *signal;
+    signal_view_t view;
+    size_t length;
+} sample_source_t;
+
+static int read_samples(const sample_source_t *source, size_t offset, size_t length, int16_t *out)
+{
+    if (offset + length > source->length) {
+        EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+    }
+    if (source->view.format == SIGNAL_VIEW_INT16) {
+        // at most two runs, when the window wraps around a ring buffer
+        while (length > 0) {
+            const uint8_t *in;
+            size_t count = signal_view_span(&source->view, offset, &in);
+            count = count < length ? count : length;
+            memcpy(out, in, count * sizeof(int16_t));
+            out += count;
+            offset += count;
+            length -= count;
+        }
+        return EIDSP_OK;
+    }
+
+    float chunk[FIXED_POINT_READ_CHUNK];
+    while (length > 0) {
+        const size_t count = length < FIXED_POINT_READ_CHUNK ? length : FIXED_POINT_READ_CHUNK;
+        int ret = source->signal->get_data(offset, count, chunk);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        for (size_t ix = 0; ix < count; ix++) {
+            const float v = chunk[ix];
+            *out++ = v >= 32767.0f ? 32767 : v <= -32768.0f ? -32768 : (int16_t)lrintf(v);
+        }
+        offset += count;
+        length -= count;
+    }
+    return EIDSP_OK;
+}
+
+static int no_data(size_t offset, size_t length, float *out_ptr)
+{
+    (void)offset;
+    (void)length;
+    (void)out_ptr;
+    return EIDSP_OUT_OF_BOUNDS;
+}
+
+bool fixed_point_features_supported(const fixed_point_features_config_t *config)
+{
+    if (config->version < 3 || config->fft_length < 8 || (config->fft_length & (config->fft_length - 1)) != 0) {
+        return false;
+    }
+    if (config->noise_floor_db == 12) {
+        return false;
+    }
+    if (config->type == FIXED_POINT_MFE) {
+        return config->version <= 4 && config->num_filters > 0;
+    }
+    return config->type == FIXED_POINT_SPECTROGRAM;
+}
+
+size_t fixed_point_features_scratch_bytes(const fixed_point_features_config_t *config)
+{
+    // FFT buffer (re-used for the power spectrum), one row of log2 values and one chunk of samples
+    const size_t coefficients = config->fft_length / 2 + 1;
+    const size_t row = config->type == FIXED_POINT_MFE ? config->num_filters : coefficients;
+    return (config->fft_length + 2) * sizeof(int32_t) + row * sizeof(int32_t) +
+        FIXED_POINT_READ_CHUNK * sizeof(int16_t);
+}
+
+size_t fixed_point_features_plan_bytes(const fixed_point_features_config_t *config)
+{
+    size_t bytes = 0;
+    const fft::rfft_fixed_plan_t *plan = fft::rfft_fixed_get_plan(config->fft_length);
+    if (plan) {
+        bytes += fft::rfft_fixed_plan_bytes(plan);
+    }
+    if (config->type == FIXED_POINT_MFE) {
+        EiDspCacheLock lock;
+        const fixed_filterbank_t *fb = fixed_filterbank_find(config);
+        if (fb) {
+            bytes += fb->bytes;
+        }
+    }
+    return bytes;
+}
+
+static int run_fixed_point_features(const fixed_point_features_config_t *config, const sample_source_t *source,
+    matrix_i8_t *out, float scale, int32_t zero_point)
+{
+    if (!fixed_point_features_supported(config)) {
+        EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+    }
+    if (scale <= 0.0f || source->length == 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+
+    const bool mfe = config->type == FIXED_POINT_MFE;
+    const size_t n_fft = config->fft_length;
+    const size_t coefficients = n_fft / 2 + 1;
+    const size_t cols = mfe ? config->num_filters : coefficients;
+
+    // same frames as the float blocks
+    signal_t frames_signal;
+    frames_signal.total_length = source->length;
+    frames_signal.get_data = &no_data;
+    stack_frames_info_t frames = { 0 };
+    frames.signal = &frames_signal;
+    int ret = processing::stack_frames(&frames, config->sampling_frequency, config->frame_length,
+        config->frame_stride, false, config->version);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+    if (frames.frame_length <= 0) {
+        EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+    }
+    if (frames.frame_ixs.size() * cols != out->rows * out->cols) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    const fft::rfft_fixed_plan_t *plan = fft::rfft_fixed_get_plan(n_fft);
+    fft::rfft_fixed_plan_t *temp_plan = nullptr;
+    if (!plan) {
+        temp_plan = fft::rfft_fixed_plan_create(n_fft);
+        EI_ERR_AND_RETURN_ON_NULL(temp_plan, EIDSP_OUT_OF_MEM);
+        plan = temp_plan;
+    }
+    ei_unique_ptr_t temp_plan_ptr(temp_plan, [](void *ptr){ fft::rfft_fixed_plan_free((fft::rfft_fixed_plan_t *)ptr); });
+
+    const fixed_filterbank_t *filterbank = nullptr;
+    fixed_filterbank_t *temp_filterbank = nullptr;
+    if (mfe) {
+        filterbank = fixed_filterbank_get(config);
+        if (!filterbank) {
+            temp_filterbank = fixed_filterbank_create(config);
+            EI_ERR_AND_RETURN_ON_NULL(temp_filterbank, EIDSP_OUT_OF_MEM);
+            filterbank = temp_filterbank;
+        }
+    }
+    ei_unique_ptr_t temp_filterbank_ptr(temp_filterbank, fixed_filterbank_free);
+
+    const size_t scratch_bytes = fixed_point_features_scratch_bytes(config);
+    uint8_t *scratch = (uint8_t *)ei_malloc(scratch_bytes);
+    EI_ERR_AND_RETURN_ON_NULL(scratch, EIDSP_OUT_OF_MEM);
+    ei_unique_ptr_t scratch_ptr(scratch, ei_free);
+    int32_t *data = (int32_t *)scratch;
+    int32_t *log2_row = data + n_fft + 2;
+    int16_t *chunk = (int16_t *)(log2_row + cols);
+
+    // The normalization is affine in log2(x): the MFE maps to q = round(f * 256)
+    // (quantized through a table afterwards), the spectrogram straight to the
+    // model input steps. log2 in Q16 times a in Q16, plus b in Q32.
+    const double noise = (double)-config->noise_floor_db;
+    const double unit = mfe ? 256.0 : 1.0 / (double)scale;
+    const int64_t map_a = llround(10.0 * log10(2.0) / (noise + 12.0) * unit * 65536.0);
+    const int64_t map_b = llround(noise / (noise + 12.0) * unit * 4294967296.0);
+
+    int8_t mfe_table[257];
+    int32_t spectrogram_max = INT32_MAX;
+    if (mfe) {
+        for (int q = 0; q <= 256; q++) {
+            const int32_t v = (int32_t)round(((float)q / 256.0f) / scale) + zero_point;
+            mfe_table[q] = (int8_t)(v < -128 ? -128 : v > 127 ? 127 : v);
+        }
+    }
+    else if (config->version == 3) {
+        spectrogram_max = (int32_t)round(1.0f / scale);
+    }
+
+    const int input_bits = fft::rfft_fixed_input_bits(n_fft);
+    const int log2_n = 30 - input_bits;
+    const size_t frame_length = (size_t)frames.frame_length < n_fft ? (size_t)frames.frame_length : n_fft;
+    int8_t *output = out->buffer;
+
+    for (size_t frame = 0; frame < frames.frame_ixs.size(); frame++) {
+        const size_t offset = frames.frame_ixs[frame];
+        if (offset + frame_length > source->length) {
+            EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+        }
+
+        // frame with the preemphasis of the MFE blocks (in Q15, the sample before
+        // the first one is the last sample of the signal), value = data * 2^exponent
+        int16_t prev = 0;
+        if (mfe) {
+            ret = read_samples(source, offset == 0 ? source->length - 1 : offset - 1, 1, &prev);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+        int exponent = mfe ? -30 : (config->version == 3 ? -15 : 0);
+        uint32_t peak = 0;
+        for (size_t ix = 0; ix < frame_length; ix += FIXED_POINT_READ_CHUNK) {
+            const size_t count = frame_length - ix < FIXED_POINT_READ_CHUNK ? frame_length - ix : FIXED_POINT_READ_CHUNK;
+            ret = read_samples(source, offset + ix, count, chunk);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+            for (size_t c = 0; c < count; c++) {
+                int32_t v = chunk[c];
+                if (mfe) {
+                    v = v * 32768 - FIXED_POINT_PREEMPHASIS * (int32_t)prev;
+                    prev = chunk[c];
+                }
+                data[ix + c] = v;
+                const uint32_t mag = v < 0 ? (uint32_t)-(int64_t)v : (uint32_t)v;
+                peak = mag > peak ? mag : peak;
+            }
+        }
+        // spectrogram v3 only scales frames that aren't within [-1, 1] already
+        if (!mfe && config->version == 3 && peak <= 1) {
+            exponent = 0;
+        }
+
+        // block exponent, scale the frame to the input bound of the FFT
+        const int shift = peak == 0 ? 0 : bit_length(peak) - input_bits;
+        if (shift > 0) {
+            const int32_t half = 1 << (shift - 1);
+            for (size_t ix = 0; ix < frame_length; ix++) {
+                data[ix] = (data[ix] + half) >> shift;
+            }
+        }
+        else if (shift < 0) {
+            for (size_t ix = 0; ix < frame_length; ix++) {
+                data[ix] = data[ix] * (1 << -shift);
+            }
+        }
+        exponent += shift;
+        memset(data + frame_length, 0, (n_fft - frame_length) * sizeof(int32_t));
+
+        ret = fft::rfft_fixed_execute(plan, data);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        // power spectrum |X|^2 (64 bits), stored over the FFT output
+        uint64_t max_power = 0;
+        for (size_t k = 0; k < coefficients; k++) {
+            const int64_t re = data[2 * k], im = data[2 * k + 1];
+            const uint64_t power = (uint64_t)(re * re) + (uint64_t)(im * im);
+            memcpy(data + 2 * k, &power, sizeof(power));
+            max_power = power > max_power ? power : max_power;
+        }
+        // log2 of the float power spectrum = log2(power) + power_exponent
+        int32_t power_exponent = 2 * exponent - log2_n;
+
+        if (mfe) {
+            // keep the accumulators within 64 bits
+            int power_shift = bit_length(max_power) + 15 + filterbank->count_bits - 64;
+            power_shift = power_shift > 0 ? power_shift : 0;
+            power_exponent += power_shift - 15;
+            const uint16_t *w = filterbank->weights;
+            for (size_t filter = 0; filter < cols; filter++) {
+                const int32_t *p = data + 2 * filterbank->start[filter];
+                const size_t count = filterbank->count[filter];
+                uint64_t acc = 0;
+                for (size_t ix = 0; ix < count; ix++) {
+                    uint64_t power;
+                    memcpy(&power, p + 2 * ix, sizeof(power));
+                    acc += (power >> power_shift) * w[ix];
+                }
+                w += count;
+                log2_row[filter] = acc == 0 ? FIXED_POINT_LOG2_ZERO : log2_q16(acc) + power_exponent * 65536;
+            }
+        }
+        else {
+            for (size_t k = 0; k < coefficients; k++) {
+                uint64_t power;
+                memcpy(&power, data + 2 * k, sizeof(power));
+                log2_row[k] = power == 0 ? FIXED_POINT_LOG2_ZERO : log2_q16(power) + power_exponent * 65536;
+            }
+        }
+
+        for (size_t ix = 0; ix < cols; ix++) {
+            const int32_t l = log2_row[ix] < FIXED_POINT_LOG2_MIN ? FIXED_POINT_LOG2_MIN : log2_row[ix];
+            int64_t q = ((int64_t)l * map_a + map_b + ((int64_t)1 << 31)) >> 32;
+            if (q < 0) {
+                q = 0;
+            }
+            if (mfe) {
+                *output++ = mfe_table[q > 256 ? 256 : q];
+            }
+            else {
+                q = q > spectrogram_max ? spectrogram_max : q;
+                q += zero_point;
+                *output++ = (int8_t)(q < -128 ? -128 : q > 127 ? 127 : q);
+            }
+        }
+    }
+
+    return EIDSP_OK;
+}
+
+int fixed_point_features(const fixed_point_features_config_t *config, signal_t *signal, matrix_i8_t *out,
+    float scale, int32_t zero_point)
+{
+    sample_source_t source;
+    source.signal = signal;
+    source.length = signal->total_length;
+    // raw int16 PCM (signal_from_int16() / signal_from_int16_ring()), read in place
+    if (signal_has_view(signal, SIGNAL_VIEW_INT16) && signal->view.axes == 1 && !signal->view.axis_scale) {
+        source.view = signal->view;
+    }
+    return run_fixed_point_features(config, &source, out, scale, zero_point);
+}
+
+int fixed_point_features(const fixed_point_features_config_t *config, const int16_t *samples, size_t length,
+    matrix_i8_t *out, float scale, int32_t zero_point)
+{
+    sample_source_t source;
+    source.signal = nullptr;
+    source.view.format = SIGNAL_VIEW_INT16;
+    source.view.data = samples;
+    source.view.length = length;
+    source.length = length;
+    return run_fixed_point_features(config, &source, out, scale, zero_point);
+}
+
+} // namespace speechpy
+} // namespace ei
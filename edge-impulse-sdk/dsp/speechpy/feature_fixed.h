@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SPEECHPY_FEATURE_FIXED_H_
+#define _EIDSP_SPEECHPY_FEATURE_FIXED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../config.hpp"
+#include "../numpy_types.h"
+
+namespace ei {
+namespace speechpy {
+
+typedef enum {
+    // feature::mfe() + processing::mfe_normalization(), version 3 and up
+    FIXED_POINT_MFE = 0,
+    // feature::spectrogram() + processing::spectrogram_normalization(), version 3 and up
+    FIXED_POINT_SPECTROGRAM = 1,
+} fixed_point_features_type_t;
+
+typedef struct {
+    fixed_point_features_type_t type;
+    uint32_t sampling_frequency;
+    float frame_length;
+    float frame_stride;
+    uint16_t fft_length;            // power of two
+    uint16_t num_filters;           // MFE only
+    uint32_t low_frequency;         // MFE only
+    uint32_t high_frequency;        // MFE only
+    int noise_floor_db;
+    uint16_t version;
+} fixed_point_features_config_t;
+
+/**
+ * Whether the config can run through fixed_point_features(). MFE before version 3
+ * (cmvnw), MFCC and spectrogram before version 3 (normalize) are float only, and
+ * the FFT length has to be a power of two.
+ */
+bool fixed_point_features_supported(const fixed_point_features_config_t *config);
+
+/**
+ * Normalized MFE or spectrogram features, quantized straight to the input of an
+ * int8 model, without any float math per sample.
+ *
+ * Samples are int16 PCM: a signal_t from signal_from_int16() or
+ * signal_from_int16_ring() (mono, no axis scale) is read in place, any other
+ * signal_t is rounded and saturated to int16. Frames go through the integer
+ * preemphasis (MFE, Q15 coefficient), a fixed point FFT (fft/ei_rfft_fixed.h)
+ * with one block exponent per frame, a 64 bit power spectrum, Q15 mel weights
+ * and a table based log2 (max. error 3e-6).
+ * Compared to the float features quantized with the same scale / zero point, an
+ * output differs by at most one step (the float path rounds at slightly
+ * different points).
+ * This saves the float feature matrix, not time: on an FPU target the float path
+ * is as fast or faster (see app_benchmark), so only use it when memory is short.
+ *
+ * @param out Rows * cols matches calculate_mfe_buffer_size() (frames x filters for
+ *     MFE, frames x (fft_length / 2 + 1) for the spectrogram), any shape
+ * @param scale Quantization scale of the model input
+ * @param zero_point Quantization zero point of the model input
+ * @returns EIDSP_OK if OK
+ */
+int fixed_point_features(const fixed_point_features_config_t *config, signal_t *signal, matrix_i8_t *out,
+    float scale, int32_t zero_point);
+
+/**
+ * fixed_point_features() over an int16 buffer
+ */
+int fixed_point_features(const fixed_point_features_config_t *config, const int16_t *samples, size_t length,
+    matrix_i8_t *out, float scale, int32_t zero_point);
+
+/**
+ * Heap used by fixed_point_features() while it runs, in bytes (without the
+ * cached FFT plan and mel weights, see fixed_point_features_plan_bytes())
+ */
+size_t fixed_point_features_scratch_bytes(const fixed_point_features_config_t *config);
+
+/**
+ * Heap used by the cached FFT plan and mel weights of a config, in bytes
+ * (0 if not created yet)
+ */
+size_t fixed_point_features_plan_bytes(const fixed_point_features_config_t *config);
+
+/**
+ * Free all cached mel weights
+ */
+void fixed_point_features_clear();
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_FEATURE_FIXED_H_
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SPEECHPY_FEATURE_STREAM_H_
+#define _EIDSP_SPEECHPY_FEATURE_STREAM_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "../../porting/ei_classifier_porting.h"
+#include "../numpy.hpp"
+#include "../returntypes.hpp"
+#include "feature.hpp"
+#include "processing.hpp"
+#include "sparse_filterbank.h"
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Streaming MFE / MFCC for continuous audio. Samples are pushed as they arrive
+ * and the overlap with the next frame is kept between calls, so every STFT
+ * frame is computed exactly once. The sparse mel filterbank and the FFT buffers
+ * are allocated once in init(), and every finished frame is written as one feature
+ * row into a ring buffer (the feature window of the classifier).
+ *
+ * The rows are identical to feature::mfe() / feature::mfcc() (with dc
+ * elimination) over the same samples, when the frame length and stride are
+ * whole numbers of samples.
+ */
+class feature_stream {
+public:
+    feature_stream() {
+        memset(&_config, 0, sizeof(_config));
+    }
+
+    ~feature_stream() {
+        free_buffers();
+    }
+
+    /**
+     * Allocate the stream state. Frame length and stride (in samples) are truncated, as
+     * in the per slice functions (extract_mfcc_per_slice_features() etc.), so the
+     * frames line up with theirs
+     * @param sampling_frequency Sampling frequency in Hz
+     * @param frame_length Frame length in seconds
+     * @param frame_stride Frame stride in seconds, cannot be larger than frame_length
+     * @param num_filters Number of mel filters
+     * @param fft_length Number of FFT points
+     * @param low_frequency Lowest band edge of the mel filters (Hz)
+     * @param high_frequency Highest band edge of the mel filters (Hz), 0 for sampling_frequency / 2
+     * @param num_cepstral 0 for MFE rows (num_filters values), otherwise the number of MFCC coefficients
+     * @param version Implementation version of the block (2 or higher)
+     * @returns EIDSP_OK if OK
+     */
+    int init(uint32_t sampling_frequency, float frame_length, float frame_stride,
+        uint16_t num_filters, uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t num_cepstral, uint16_t version)
+    {
+        free_buffers();
+
+        const size_t frame_length_values = sampling_frequency * frame_length;
+        const size_t frame_stride_values = sampling_frequency * frame_stride;
+
+        if (frame_length_values == 0 || frame_stride_values == 0 || num_filters == 0 || fft_length == 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        if (frame_stride_values > frame_length_values) {
+            ei_printf("ERR: frame_length (");
+            ei_printf_float(frame_length);
+            ei_printf(") cannot be lower than frame_stride (");
+            ei_printf_float(frame_stride);
+            ei_printf(") for continuous classification\n");
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        if (num_cepstral > num_filters) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        _frame_length = frame_length_values;
+        _frame_stride = frame_stride_values;
+        _num_filters = num_filters;
+        _fft_length = fft_length;
+        _num_cepstral = num_cepstral;
+        _power_size = fft_length / 2 + 1;
+
+        _frame = (float*)ei_calloc(_frame_length * sizeof(float), 1);
+        _fft_input = (float*)ei_calloc(_fft_length * sizeof(float), 1);
+        _fft_output = (fft_complex_t*)ei_calloc(_power_size * sizeof(fft_complex_t), 1);
+        _power = (float*)ei_calloc(_power_size * sizeof(float), 1);
+        _mel = (float*)ei_calloc(_num_filters * sizeof(float), 1);
+        _filterbank = sparse_filterbank_create(SPARSE_FILTERBANK_MEL_BINS, num_filters, fft_length,
+            sampling_frequency, low_frequency, high_frequency, version);
+        if (!_frame || !_fft_input || !_fft_output || !_power || !_mel || !_filterbank) {
+            free_buffers();
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        _config.sampling_frequency = sampling_frequency;
+        _config.frame_length = frame_length;
+        _config.frame_stride = frame_stride;
+        _config.num_filters = num_filters;
+        _config.fft_length = fft_length;
+        _config.low_frequency = low_frequency;
+        _config.high_frequency = high_frequency;
+        _config.num_cepstral = num_cepstral;
+        _config.version = version;
+
+        reset();
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Whether init() was called with these parameters
+     */
+    bool matches(uint32_t sampling_frequency, float frame_length, float frame_stride,
+        uint16_t num_filters, uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t num_cepstral, uint16_t version) const
+    {
+        return _frame &&
+            _config.sampling_frequency == sampling_frequency &&
+            _config.frame_length == frame_length &&
+            _config.frame_stride == frame_stride &&
+            _config.num_filters == num_filters &&
+            _config.fft_length == fft_length &&
+            _config.low_frequency == low_frequency &&
+            _config.high_frequency == high_frequency &&
+            _config.num_cepstral == num_cepstral &&
+            _config.version == version;
+    }
+
+    /**
+     * Drop the partial frame and start writing at the first ring row again
+     */
+    void reset() {
+        _frame_ix = 0;
+        _ring_head = 0;
+    }
+
+    /**
+     * Push samples through the stream, every completed frame writes one row
+     * @param signal Samples to read
+     * @param offset Offset of the first sample in signal
+     * @param length Number of samples to read
+     * @param ring Ring buffer of ring_rows * row_size() values
+     * @param ring_rows Number of rows in the ring buffer
+     * @param rows_written Incremented for every row written (can be nullptr)
+     * @returns EIDSP_OK if OK
+     */
+    int push(signal_t *signal, size_t offset, size_t length, float *ring, size_t ring_rows,
+        size_t *rows_written)
+    {
+        if (!_frame) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        if (ring_rows == 0) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        while (length > 0) {
+            size_t n = _frame_length - _frame_ix;
+            if (n > length) {
+                n = length;
+            }
+
+            int ret = signal->get_data(offset, n, _frame + _frame_ix);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+            _frame_ix += n;
+            offset += n;
+            length -= n;
+
+            if (_frame_ix < _frame_length) {
+                break;
+            }
+
+            ret = process_frame(ring + (_ring_head * row_size()));
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+            _ring_head = (_ring_head + 1) % ring_rows;
+            if (rows_written) {
+                (*rows_written)++;
+            }
+
+            // keep the overlap for the next frame
+            memmove(_frame, _frame + _frame_stride, (_frame_length - _frame_stride) * sizeof(float));
+            _frame_ix = _frame_length - _frame_stride;
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Copy a ring buffer written by push() into a linear feature window, oldest row first
+     * @param ring Ring buffer of ring_rows * row_size() values
+     * @param ring_rows Number of rows in the ring buffer
+     * @param out Out buffer of ring_rows * row_size() values
+     */
+    void copy_window(const float *ring, size_t ring_rows, float *out) const {
+        const size_t head = _ring_head % ring_rows;
+        const size_t head_values = head * row_size();
+        const size_t ring_values = ring_rows * row_size();
+
+        memcpy(out, ring + head_values, (ring_values - head_values) * sizeof(float));
+        memcpy(out + (ring_values - head_values), ring, head_values * sizeof(float));
+    }
+
+    /**
+     * Number of values in a feature row
+     */
+    size_t row_size() const {
+        return _num_cepstral > 0 ? _num_cepstral : _num_filters;
+    }
+
+    size_t frame_length() const {
+        return _frame_length;
+    }
+
+    size_t frame_stride() const {
+        return _frame_stride;
+    }
+
+private:
+    /**
+     * MFE (or MFCC) row of the frame in _frame
+     */
+    int process_frame(float *row) {
+        int ret = numpy::power_spectrum(_frame, _frame_length, _power, _power_size, _fft_length,
+            _fft_input, _fft_output);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        float energy = numpy::sum(_power, _power_size);
+        if (energy == 0) {
+            energy = 1e-10;
+        }
+
+        sparse_filterbank_apply(_filterbank, _power, _mel);
+        numpy::zero_handling(_mel, _num_filters);
+
+        if (_num_cepstral == 0) {
+            memcpy(row, _mel, _num_filters * sizeof(float));
+            return EIDSP_OK;
+        }
+
+        for (size_t ix = 0; ix < _num_filters; ix++) {
+            _mel[ix] = numpy::log(_mel[ix]);
+        }
+
+        ret = numpy::dct2(_mel, _num_filters, DCT_NORMALIZATION_ORTHO);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        // replace first cepstral coefficient with log of frame energy for DC elimination
+        _mel[0] = numpy::log(energy);
+
+        memcpy(row, _mel, _num_cepstral * sizeof(float));
+
+        return EIDSP_OK;
+    }
+
+    void free_buffers() {
+        ei_free(_frame);
+        ei_free(_fft_input);
+        ei_free(_fft_output);
+        ei_free(_power);
+        ei_free(_mel);
+        sparse_filterbank_free(_filterbank);
+
+        _frame = nullptr;
+        _fft_input = nullptr;
+        _fft_output = nullptr;
+        _power = nullptr;
+        _mel = nullptr;
+        _filterbank = nullptr;
+    }
+
+    struct {
+        uint32_t sampling_frequency;
+        float frame_length;
+        float frame_stride;
+        uint16_t num_filters;
+        uint16_t fft_length;
+        uint32_t low_frequency;
+        uint32_t high_frequency;
+        uint16_t num_cepstral;
+        uint16_t version;
+    } _config;
+
+    size_t _frame_length = 0;
+    size_t _frame_stride = 0;
+    size_t _frame_ix = 0;
+    size_t _ring_head = 0;
+    size_t _power_size = 0;
+    uint16_t _num_filters = 0;
+    uint16_t _fft_length = 0;
+    uint16_t _num_cepstral = 0;
+
+    float *_frame = nullptr;
+    float *_fft_input = nullptr;
+    fft_complex_t *_fft_output = nullptr;
+    float *_power = nullptr;
+    float *_mel = nullptr;
+    sparse_filterbank_t *_filterbank = nullptr;
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_FEATURE_STREAM_H_
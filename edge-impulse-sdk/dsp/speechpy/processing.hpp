@@ -39,7 +39,7 @@ namespace speechpy {
 // one stack frame returned by stack_frames
 typedef struct ei_stack_frames_info {
     signal_t *signal;
-    ei_vector<uint32_t> frame_ixs;
+    ei_scratch_vector<uint32_t> frame_ixs;
     int frame_length;
 } stack_frames_info_t;
 
@@ -55,8 +55,8 @@ public:
         preemphasis(ei_signal_t *signal, int shift, float cof, bool rescale)
             : _signal(signal), _shift(shift), _cof(cof), _rescale(rescale)
         {
-            _prev_buffer = (float*)ei_dsp_calloc(shift * sizeof(float), 1);
-            _end_of_signal_buffer = (float*)ei_dsp_calloc(shift * sizeof(float), 1);
+            _prev_buffer = (float*)ei_dsp_scratch_calloc(shift * sizeof(float));
+            _end_of_signal_buffer = (float*)ei_dsp_scratch_calloc(shift * sizeof(float));
             _next_offset_should_be = 0;
 
             if (shift < 0) {
@@ -132,12 +132,17 @@ public:
         }
 
         ~preemphasis() {
-            if (_prev_buffer) {
-                ei_dsp_free(_prev_buffer, _shift * sizeof(float));
-            }
-            if (_end_of_signal_buffer) {
-                ei_dsp_free(_end_of_signal_buffer, _shift * sizeof(float));
-            }
+            ei_dsp_scratch_free(_end_of_signal_buffer);
+            ei_dsp_scratch_free(_prev_buffer);
+        }
+
+        // lives for one DSP block run, so from the scratch arena as well
+        void* operator new(size_t size) noexcept {
+            return ei_dsp_scratch_calloc(size);
+        }
+
+        void operator delete(void* ptr) {
+            ei_dsp_scratch_free(ptr);
         }
 
 private:
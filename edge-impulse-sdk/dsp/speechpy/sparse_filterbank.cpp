@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+
+#include "edge-impulse-sdk/dsp/speechpy/sparse_filterbank.h"
+
+#include <string.h>
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include "edge-impulse-sdk/dsp/speechpy/feature.hpp"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace speechpy {
+
+#if EIDSP_SPARSE_FILTERBANK_INT16
+typedef int16_t sparse_filterbank_weight_t;
+#define SPARSE_FILTERBANK_Q15_ONE 32767.0f
+#else
+typedef float sparse_filterbank_weight_t;
+#endif
+
+struct sparse_filterbank {
+    // config
+    sparse_filterbank_type_t type;
+    uint16_t num_filters;
+    uint16_t fft_length;
+    uint32_t sampling_frequency;
+    uint32_t low_frequency;
+    uint32_t high_frequency;
+    uint16_t version;
+
+    uint16_t *start;                        // first power spectrum bin of every filter
+    uint16_t *count;                        // number of weights of every filter
+    sparse_filterbank_weight_t *weights;    // filter after filter
+    size_t weights_size;
+    size_t bytes;
+    bool scratch;                           // on the DSP scratch arena, not the heap
+};
+
+/**
+ * Dense weights of one filter, coefficients (fft_length / 2 + 1) values
+ */
+typedef struct {
+    sparse_filterbank_type_t type;
+    uint16_t coefficients;
+    matrix_t *dense;                        // SPARSE_FILTERBANK_SPEECHPY
+    quantized_matrix_t *dense_quantized;    // SPARSE_FILTERBANK_SPEECHPY with EIDSP_QUANTIZE_FILTERBANK
+    uint16_t *bins;                         // SPARSE_FILTERBANK_MEL_BINS
+} filter_source_t;
+
+static void filter_row(const filter_source_t *source, uint16_t filter, float *row)
+{
+    if (source->type == SPARSE_FILTERBANK_SPEECHPY) {
+#if EIDSP_QUANTIZE_FILTERBANK
+        const uint8_t *q = source->dense_quantized->buffer + filter * source->coefficients;
+        for (size_t bin = 0; bin < source->coefficients; bin++) {
+            // zeros are skipped by numpy::dot_by_row() on the quantized matrix
+            row[bin] = q[bin] ? numpy::dequantize_zero_one(q[bin]) : 0.0f;
+        }
+#else
+        memcpy(row, source->dense->buffer + filter * source->coefficients, source->coefficients * sizeof(float));
+#endif
+        return;
+    }
+
+    // same weights as feature::mfe() has always calculated per frame
+    memset(row, 0, source->coefficients * sizeof(float));
+    const size_t left = source->bins[filter];
+    const size_t middle = source->bins[filter + 1];
+    const size_t right = source->bins[filter + 2];
+
+    row[middle] = 1.0f;
+    for (size_t bin = left + 1; bin < right; bin++) {
+        if (bin < middle) {
+            row[bin] = (static_cast<float>(bin) - left) / (middle - left);
+        }
+        if (bin > middle) {
+            row[bin] = (right - static_cast<float>(bin)) / (right - middle);
+        }
+    }
+}
+
+sparse_filterbank_t *sparse_filterbank_create(sparse_filterbank_type_t type, uint16_t num_filters,
+    uint16_t fft_length, uint32_t sampling_frequency, uint32_t low_frequency, uint32_t high_frequency,
+    uint16_t version, bool scratch)
+{
+    if (num_filters == 0 || fft_length < 2 || sampling_frequency == 0) {
+        return nullptr;
+    }
+
+    const uint16_t coefficients = fft_length / 2 + 1;
+
+    filter_source_t source;
+    memset(&source, 0, sizeof(source));
+    source.type = type;
+    source.coefficients = coefficients;
+
+    // the dense filterbank (or the bins) only lives while the sparse one is built
+    const uint16_t dense_rows = type == SPARSE_FILTERBANK_SPEECHPY ? num_filters : 0;
+#if EIDSP_QUANTIZE_FILTERBANK
+    EiDspScratchBuffer dense_scratch(dense_rows * coefficients * sizeof(uint8_t));
+    quantized_matrix_t dense(dense_rows, coefficients, &numpy::dequantize_zero_one,
+        (uint8_t *)dense_scratch.buffer);
+    source.dense_quantized = &dense;
+#else
+    EiDspScratchBuffer dense_scratch(dense_rows * coefficients * sizeof(float));
+    matrix_t dense(dense_rows, coefficients, (float *)dense_scratch.buffer);
+    source.dense = &dense;
+#endif
+    // mel bins, then the first bin and the count of every filter
+    EiDspScratchBuffer bins_scratch(((num_filters + 2) + 2 * num_filters) * sizeof(uint16_t));
+    if (!bins_scratch.buffer) {
+        return nullptr;
+    }
+    source.bins = (uint16_t *)bins_scratch.buffer;
+    uint16_t *first = source.bins + (num_filters + 2);
+    uint16_t *count = first + num_filters;
+
+    if (type == SPARSE_FILTERBANK_SPEECHPY) {
+        if (!dense.buffer ||
+            feature::filterbanks(&dense, num_filters, coefficients, sampling_frequency,
+                low_frequency, high_frequency) != EIDSP_OK) {
+            return nullptr;
+        }
+    }
+    else {
+        if (feature::calculate_mel_bins(source.bins, num_filters, fft_length, sampling_frequency,
+                low_frequency, high_frequency, version) != EIDSP_OK) {
+            return nullptr;
+        }
+        for (uint16_t ix = 0; ix < num_filters; ix++) {
+            if (source.bins[ix + 2] >= coefficients || source.bins[ix] > source.bins[ix + 1] ||
+                source.bins[ix + 1] > source.bins[ix + 2]) {
+                ei_printf("ERR: Mel filter %d out of range\n", (int)ix);
+                return nullptr;
+            }
+        }
+    }
+
+    EiDspScratchBuffer row_scratch(coefficients * sizeof(float));
+    matrix_t row(1, coefficients, (float *)row_scratch.buffer);
+    if (!row.buffer) {
+        return nullptr;
+    }
+
+    // pass 1: non-zero range of every filter
+    size_t weights_size = 0;
+    for (uint16_t filter = 0; filter < num_filters; filter++) {
+        filter_row(&source, filter, row.buffer);
+
+        size_t lo = 0;
+        while (lo < coefficients && row.buffer[lo] == 0.0f) {
+            lo++;
+        }
+        size_t hi = coefficients;
+        while (hi > lo && row.buffer[hi - 1] == 0.0f) {
+            hi--;
+        }
+
+        first[filter] = lo < coefficients ? lo : 0;
+        count[filter] = hi - lo;
+        weights_size += hi - lo;
+    }
+
+    // pass 2: one allocation for the whole filterbank
+    const size_t bytes = sizeof(sparse_filterbank_t) + 2 * num_filters * sizeof(uint16_t) +
+        weights_size * sizeof(sparse_filterbank_weight_t) + sizeof(sparse_filterbank_weight_t);
+    sparse_filterbank_t *filterbank = (sparse_filterbank_t *)(scratch ? ei_dsp_scratch_calloc(bytes) :
+        ei_calloc(1, bytes));
+    if (!filterbank) {
+        return nullptr;
+    }
+    ei_dsp_register_alloc(bytes, filterbank);
+
+    filterbank->type = type;
+    filterbank->num_filters = num_filters;
+    filterbank->fft_length = fft_length;
+    filterbank->sampling_frequency = sampling_frequency;
+    filterbank->low_frequency = low_frequency;
+    filterbank->high_frequency = high_frequency;
+    filterbank->version = version;
+    filterbank->weights_size = weights_size;
+    filterbank->bytes = bytes;
+    filterbank->scratch = scratch;
+
+    uint8_t *ptr = (uint8_t *)(filterbank + 1);
+    // weights first, they have the largest alignment
+    ptr += (alignof(sparse_filterbank_weight_t) - ((uintptr_t)ptr % alignof(sparse_filterbank_weight_t))) %
+        alignof(sparse_filterbank_weight_t);
+    filterbank->weights = (sparse_filterbank_weight_t *)ptr;
+    ptr += weights_size * sizeof(sparse_filterbank_weight_t);
+    filterbank->start = (uint16_t *)ptr;
+    ptr += num_filters * sizeof(uint16_t);
+    filterbank->count = (uint16_t *)ptr;
+
+    sparse_filterbank_weight_t *w = filterbank->weights;
+    for (uint16_t filter = 0; filter < num_filters; filter++) {
+        filter_row(&source, filter, row.buffer);
+
+        filterbank->start[filter] = first[filter];
+        filterbank->count[filter] = count[filter];
+        for (size_t ix = 0; ix < count[filter]; ix++) {
+            const float weight = row.buffer[first[filter] + ix];
+#if EIDSP_SPARSE_FILTERBANK_INT16
+            *w++ = (int16_t)(weight * SPARSE_FILTERBANK_Q15_ONE + 0.5f);
+#else
+            *w++ = weight;
+#endif
+        }
+    }
+
+    return filterbank;
+}
+
+void sparse_filterbank_free(sparse_filterbank_t *filterbank)
+{
+    if (!filterbank) {
+        return;
+    }
+    ei_dsp_register_free(filterbank->bytes, filterbank);
+    if (filterbank->scratch) {
+        ei_dsp_scratch_free(filterbank);
+    }
+    else {
+        ei_free(filterbank);
+    }
+}
+
+static sparse_filterbank_t *filterbanks[EIDSP_FILTERBANK_MAX_CACHED];
+
+const sparse_filterbank_t *sparse_filterbank_get(sparse_filterbank_type_t type, uint16_t num_filters,
+    uint16_t fft_length, uint32_t sampling_frequency, uint32_t low_frequency, uint32_t high_frequency,
+    uint16_t version)
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        const sparse_filterbank_t *fb = filterbanks[ix];
+        if (fb && fb->type == type && fb->num_filters == num_filters && fb->fft_length == fft_length &&
+            fb->sampling_frequency == sampling_frequency && fb->low_frequency == low_frequency &&
+            fb->high_frequency == high_frequency &&
+            (type == SPARSE_FILTERBANK_SPEECHPY || fb->version == version)) {
+            return fb;
+        }
+    }
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        if (!filterbanks[ix]) {
+            filterbanks[ix] = sparse_filterbank_create(type, num_filters, fft_length, sampling_frequency,
+                low_frequency, high_frequency, version);
+            return filterbanks[ix];
+        }
+    }
+    return nullptr;
+}
+
+void sparse_filterbank_clear()
+{
+    EiDspCacheLock lock;
+
+    for (size_t ix = 0; ix < EIDSP_FILTERBANK_MAX_CACHED; ix++) {
+        sparse_filterbank_free(filterbanks[ix]);
+        filterbanks[ix] = nullptr;
+    }
+}
+
+void sparse_filterbank_apply(const sparse_filterbank_t *filterbank, const float *power_spectrum, float *out)
+{
+    const sparse_filterbank_weight_t *w = filterbank->weights;
+
+    for (size_t filter = 0; filter < filterbank->num_filters; filter++) {
+        const float *p = power_spectrum + filterbank->start[filter];
+        const size_t count = filterbank->count[filter];
+
+        float acc = 0.0f;
+        for (size_t ix = 0; ix < count; ix++) {
+            acc += p[ix] * static_cast<float>(w[ix]);
+        }
+#if EIDSP_SPARSE_FILTERBANK_INT16
+        acc *= 1.0f / SPARSE_FILTERBANK_Q15_ONE;
+#endif
+        out[filter] = acc;
+        w += count;
+    }
+}
+
+size_t sparse_filterbank_bytes(const sparse_filterbank_t *filterbank)
+{
+    return filterbank->bytes;
+}
+
+} // namespace speechpy
+} // namespace ei
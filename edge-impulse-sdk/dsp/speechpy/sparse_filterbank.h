@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef _EIDSP_SPEECHPY_SPARSE_FILTERBANK_H_
+#define _EIDSP_SPEECHPY_SPARSE_FILTERBANK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../config.hpp"
+
+// number of mel filterbank configs that are kept between calls, other configs
+// get a temporary filterbank for every call
+#ifndef EIDSP_FILTERBANK_MAX_CACHED
+#define EIDSP_FILTERBANK_MAX_CACHED     2
+#endif // EIDSP_FILTERBANK_MAX_CACHED
+
+namespace ei {
+namespace speechpy {
+
+typedef enum {
+    // triangles of feature::filterbanks(), used by feature::mfe_v3()
+    SPARSE_FILTERBANK_SPEECHPY = 0,
+    // triangles on the bins of feature::calculate_mel_bins(), used by feature::mfe()
+    SPARSE_FILTERBANK_MEL_BINS = 1,
+} sparse_filterbank_type_t;
+
+/**
+ * Mel filterbank without the zeros: every filter is a run of weights that
+ * starts at some power spectrum bin. The weights are float, or Q15 with
+ * EIDSP_SPARSE_FILTERBANK_INT16.
+ */
+typedef struct sparse_filterbank sparse_filterbank_t;
+
+/**
+ * Build the filterbank for a config. low_frequency / high_frequency are used
+ * as passed for SPARSE_FILTERBANK_SPEECHPY, version is only used for
+ * SPARSE_FILTERBANK_MEL_BINS (see calculate_mel_bins()).
+ * @param scratch Allocate the filterbank on the DSP scratch arena, for one that only
+ *                lives for the current run
+ * @returns nullptr when out of memory or the config is invalid
+ */
+sparse_filterbank_t *sparse_filterbank_create(sparse_filterbank_type_t type, uint16_t num_filters,
+    uint16_t fft_length, uint32_t sampling_frequency, uint32_t low_frequency, uint32_t high_frequency,
+    uint16_t version, bool scratch = false);
+
+void sparse_filterbank_free(sparse_filterbank_t *filterbank);
+
+/**
+ * Cached filterbank for a config, created on first use. nullptr when out of memory,
+ * the config is invalid or all EIDSP_FILTERBANK_MAX_CACHED slots are taken by other configs.
+ */
+const sparse_filterbank_t *sparse_filterbank_get(sparse_filterbank_type_t type, uint16_t num_filters,
+    uint16_t fft_length, uint32_t sampling_frequency, uint32_t low_frequency, uint32_t high_frequency,
+    uint16_t version);
+
+/**
+ * Free all cached filterbanks
+ */
+void sparse_filterbank_clear();
+
+/**
+ * Filter one power spectrum frame
+ * @param power_spectrum fft_length / 2 + 1 values
+ * @param out num_filters values
+ */
+void sparse_filterbank_apply(const sparse_filterbank_t *filterbank, const float *power_spectrum, float *out);
+
+/**
+ * Heap used by the filterbank, in bytes
+ */
+size_t sparse_filterbank_bytes(const sparse_filterbank_t *filterbank);
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_SPARSE_FILTERBANK_H_
@@ -33,6 +33,8 @@
 
 #include "../config.hpp"
 #include "feature.hpp"
+#include "feature_fixed.h"
+#include "feature_stream.hpp"
 #include "functions.hpp"
 #include "processing.hpp"
 
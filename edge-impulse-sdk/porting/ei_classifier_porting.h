@@ -35,6 +35,7 @@
 #ifndef _EI_CLASSIFIER_PORTING_H_
 #define _EI_CLASSIFIER_PORTING_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include "edge-impulse-sdk/dsp/returntypes.h"
@@ -48,6 +49,24 @@ extern "C" {
 EI_IMPULSE_ERROR ei_run_impulse_check_canceled();
 void ei_serial_set_baudrate(int baudrate);
 
+/**
+ * Clocks and samples of the timing backends, see EI_PORTING_HAS_TIMER_SAMPLE
+ */
+typedef enum {
+    EI_TIMER_CLOCK_WALL = 0,            // CLOCK_MONOTONIC, includes I/O waits
+    EI_TIMER_CLOCK_THREAD_CPU = 1,      // CLOCK_THREAD_CPUTIME_ID
+    EI_TIMER_CLOCK_PROCESS_CPU = 2,     // CLOCK_PROCESS_CPUTIME_ID, sums all threads
+} ei_timer_clock_t;
+
+typedef struct {
+    uint64_t wall_us;
+    uint64_t thread_cpu_us;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cache_misses;
+    bool counters_valid;                // cycles, instructions and cache_misses are set
+} ei_timer_sample_t;
+
 /* Public functions -------------------------------------------------------- */
 
 /**
@@ -361,6 +380,91 @@ void ei_free(void *ptr);
 #define EI_PORTING_MINGW32      0
 #endif
 #endif
+
+// Count the ei_malloc() / ei_calloc() / ei_free() calls (ESP-IDF and POSIX ports)
+#ifndef EI_PORTING_HEAP_STATS
+#define EI_PORTING_HEAP_STATS           0
+#endif
+
+#if EI_PORTING_HEAP_STATS == 1 && (EI_PORTING_ESPRESSIF == 1 || EI_PORTING_POSIX == 1)
+/**
+ * Heap calls of the calling thread so far: every ei_malloc(), ei_calloc() and
+ * ei_free() of a non-null pointer counts as one, so the difference around a
+ * steady-state run_classifier() shows whether it still touches the heap.
+ */
+uint32_t ei_heap_calls(void);
+#endif
+
+// Ports that implement the cancellation of the asynchronous classifier's worker
+#ifndef EI_PORTING_HAS_CANCEL_WORKER
+#if EI_PORTING_ESPRESSIF == 1 || EI_PORTING_POSIX == 1
+#define EI_PORTING_HAS_CANCEL_WORKER    1
+#else
+#define EI_PORTING_HAS_CANCEL_WORKER    0
+#endif
+#endif
+
+#if EI_PORTING_HAS_CANCEL_WORKER == 1
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+extern "C" {
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+/**
+ * Cancellation of the job running on the asynchronous classifier's worker
+ * (classifier/ei_run_classifier_async.h). Once the worker has registered itself,
+ * ei_run_impulse_check_canceled() returns EI_IMPULSE_CANCELED on that thread
+ * (and only there) while a request is pending.
+ */
+void ei_run_impulse_cancel_set_worker(void);
+void ei_run_impulse_cancel_request(bool cancel);
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+}
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+#endif // EI_PORTING_HAS_CANCEL_WORKER == 1
+
+// Ports that implement ei_read_timer_sample()
+#ifndef EI_PORTING_HAS_TIMER_SAMPLE
+#if EI_PORTING_POSIX == 1
+#define EI_PORTING_HAS_TIMER_SAMPLE     1
+#else
+#define EI_PORTING_HAS_TIMER_SAMPLE     0
+#endif
+#endif
+
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+extern "C" {
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+/**
+ * Timing backends (POSIX port). ei_read_timer_us() reads the clock selected with
+ * ei_timer_set_clock(), the monotonic wall-clock by default
+ * (EI_PORTING_POSIX_TIMER_CLOCK). ei_read_timer_sample() reads all clocks at once,
+ * plus the hardware counters of the calling thread once they're enabled on that
+ * thread with ei_timer_enable_counters() (Linux perf_event_open, this fails when
+ * perf_event_paranoid or a container doesn't allow it).
+ */
+void ei_timer_set_clock(ei_timer_clock_t clock);
+bool ei_timer_enable_counters(bool enable);
+void ei_read_timer_sample(ei_timer_sample_t *sample);
+#if defined(__cplusplus) && EI_C_LINKAGE == 1
+}
+#endif // defined(__cplusplus) && EI_C_LINKAGE == 1
+
+/**
+ * Add the time and counters since 'start' (from ei_read_timer_sample()) to 'total'
+ */
+static inline void ei_timer_sample_accumulate(const ei_timer_sample_t *start, ei_timer_sample_t *total) {
+    ei_timer_sample_t now;
+    ei_read_timer_sample(&now);
+    total->wall_us += now.wall_us - start->wall_us;
+    total->thread_cpu_us += now.thread_cpu_us - start->thread_cpu_us;
+    total->counters_valid = start->counters_valid && now.counters_valid;
+    if (total->counters_valid) {
+        total->cycles += now.cycles - start->cycles;
+        total->instructions += now.instructions - start->instructions;
+        total->cache_misses += now.cache_misses - start->cache_misses;
+    }
+}
+#endif // EI_PORTING_HAS_TIMER_SAMPLE == 1
 // End load porting layer depending on target
 
 // Additional configuration for specific architecture for Armv8.1-M architecture ie CM55 and CM85
@@ -16,6 +16,17 @@
 
 #include <stdint.h>
 
+/**
+ * @brief storage class of the kernels' scratch buffer pointers
+ * Edge Impulse: when a node is split across both cores each task sets its own
+ * scratch buffer, so the pointers have to be task local.
+ */
+#if defined(EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE) && (EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1)
+#define ESP_NN_SCRATCH_STORAGE static __thread
+#else
+#define ESP_NN_SCRATCH_STORAGE static
+#endif
+
 /**
  * @brief structure to club data dims
  * this structure can be used for input, output and filter
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <cstring>
+#include <atomic>
 // Include FreeRTOS for delay
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -52,7 +53,21 @@
 
 #define EI_WEAK_FN __attribute__((weak))
 
+static std::atomic<TaskHandle_t> cancel_worker(NULL);
+static std::atomic<bool> cancel_requested(false);
+
+void ei_run_impulse_cancel_set_worker(void) {
+    cancel_worker = xTaskGetCurrentTaskHandle();
+}
+
+void ei_run_impulse_cancel_request(bool cancel) {
+    cancel_requested = cancel;
+}
+
 EI_WEAK_FN EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
+    if (cancel_requested && cancel_worker == xTaskGetCurrentTaskHandle()) {
+        return EI_IMPULSE_CANCELED;
+    }
     return EI_IMPULSE_OK;
 }
 
@@ -95,9 +110,23 @@ __attribute__((weak)) void ei_printf_float(float f) {
     ei_printf("%f", f);
 }
 
+#if EI_PORTING_HEAP_STATS == 1
+// per thread, so other tasks don't show up in the count of an inference
+static thread_local uint32_t heap_calls = 0;
+
+uint32_t ei_heap_calls(void) {
+    return heap_calls;
+}
+
+#define EI_COUNT_HEAP_CALL() (heap_calls++)
+#else
+#define EI_COUNT_HEAP_CALL() (void)0
+#endif // EI_PORTING_HEAP_STATS == 1
+
 // we use alligned alloc instead of regular malloc
 // due to https://github.com/espressif/esp-nn/issues/7
 __attribute__((weak)) void *ei_malloc(size_t size) {
+    EI_COUNT_HEAP_CALL();
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 1)
     return aligned_alloc(16, size);
@@ -110,6 +139,7 @@ __attribute__((weak)) void *ei_malloc(size_t size) {
 }
 
 __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
+    EI_COUNT_HEAP_CALL();
 #if defined(CONFIG_IDF_TARGET_ESP32S3)
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 1)
     return aligned_alloc(16, nitems * size);
@@ -128,7 +158,9 @@ __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
-
+    if (ptr) {
+        EI_COUNT_HEAP_CALL();
+    }
     free(ptr);
 }
 
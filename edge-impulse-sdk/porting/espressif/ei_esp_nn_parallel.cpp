@@ -0,0 +1,253 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../ei_classifier_porting.h"
+#if EI_PORTING_ESPRESSIF == 1
+
+#include "ei_esp_nn_parallel.h"
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+static TaskHandle_t worker_task = NULL;
+static SemaphoreHandle_t worker_done = NULL;
+static SemaphoreHandle_t worker_lock = NULL;
+static volatile ei_esp_nn_parallel_job_t worker_job_fn = NULL;
+static void * volatile worker_job_arg = NULL;
+
+static void *worker_scratch = NULL;
+static size_t worker_scratch_size = 0;
+
+static void worker_loop(void *arg)
+{
+    (void)arg;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        worker_job_fn(worker_job_arg);
+        xSemaphoreGive(worker_done);
+    }
+}
+
+#if !CONFIG_FREERTOS_UNICORE
+static void worker_destroy(void)
+{
+    if (worker_done) {
+        vSemaphoreDelete(worker_done);
+        worker_done = NULL;
+    }
+    if (worker_lock) {
+        vSemaphoreDelete(worker_lock);
+        worker_lock = NULL;
+    }
+}
+#endif // !CONFIG_FREERTOS_UNICORE
+
+static bool worker_create(void)
+{
+#if CONFIG_FREERTOS_UNICORE
+    return false;
+#else
+    worker_done = xSemaphoreCreateBinary();
+    worker_lock = xSemaphoreCreateMutex();
+    if (!worker_done || !worker_lock) {
+        ei_printf("ERR: Failed to create ESP-NN worker semaphores\n");
+        worker_destroy();
+        return false;
+    }
+
+    // pin the worker to the core we're not running on, at our own priority
+    BaseType_t worker_core = xPortGetCoreID() == 0 ? 1 : 0;
+    BaseType_t res = xTaskCreatePinnedToCore(worker_loop, "ei_esp_nn",
+        EI_ESP_NN_PARALLEL_TASK_STACK_SIZE, NULL, uxTaskPriorityGet(NULL),
+        &worker_task, worker_core);
+    if (res != pdPASS) {
+        ei_printf("ERR: Failed to start ESP-NN worker task\n");
+        worker_task = NULL;
+        worker_destroy();
+        return false;
+    }
+    return true;
+#endif // CONFIG_FREERTOS_UNICORE
+}
+
+/**
+ * Start the worker on first use. The static is initialized exactly once, also
+ * when two tasks get here at the same time; a failure is latched, so the layers
+ * keep running on a single core instead of retrying on every Eval.
+ */
+static bool worker_start(void)
+{
+    static const bool started = worker_create();
+    return started;
+}
+
+bool ei_esp_nn_plan_row_split(int input_ht, int output_ht, int filter_ht, int stride_ht,
+                              int pad_ht, int64_t macs, ei_esp_nn_row_split_t *split)
+{
+    memset(split, 0, sizeof(ei_esp_nn_row_split_t));
+
+    if (macs < EI_ESP_NN_PARALLEL_MIN_MACS || output_ht < 2) {
+        return false;
+    }
+
+    const int split_row = (output_ht + 1) / 2;
+
+    // first input row the worker needs, it has to be past the top padding
+    // as the worker runs without it
+    const int worker_in_row = split_row * stride_ht - pad_ht;
+    if (worker_in_row <= 0 || worker_in_row >= input_ht) {
+        return false;
+    }
+
+    int local_in_rows = (split_row - 1) * stride_ht - pad_ht + filter_ht;
+    if (local_in_rows > input_ht) {
+        local_in_rows = input_ht;
+    }
+
+    const int worker_out_rows = output_ht - split_row;
+    const int worker_rows = (worker_out_rows - 1) * stride_ht + filter_ht;
+    int worker_in_rows = input_ht - worker_in_row;
+    int worker_pad_rows = 0;
+    if (worker_in_rows > worker_rows) {
+        worker_in_rows = worker_rows;
+    } else {
+        // rows the worker reads past the end of the tensor are the bottom padding
+        worker_pad_rows = worker_rows - worker_in_rows;
+    }
+
+    split->split_row = split_row;
+    split->local_in_rows = local_in_rows;
+    split->worker_in_row = worker_in_row;
+    split->worker_in_rows = worker_in_rows;
+    split->worker_pad_rows = worker_pad_rows;
+    split->worker_out_rows = worker_out_rows;
+    return true;
+}
+
+size_t ei_esp_nn_window_size(const ei_esp_nn_row_split_t *split, int input_wd,
+                             int channels, int pad_wd)
+{
+    const size_t offset = (size_t)split->worker_in_row * input_wd * channels;
+    if (pad_wd == 0 && split->worker_pad_rows == 0 && (offset & 15) == 0) {
+        return 0;
+    }
+    return (size_t)(split->worker_in_rows + split->worker_pad_rows) *
+        (input_wd + 2 * pad_wd) * channels;
+}
+
+const int8_t *ei_esp_nn_build_window(const ei_esp_nn_row_split_t *split, const int8_t *input,
+                                     int input_wd, int channels, int pad_wd,
+                                     int8_t pad_value, int8_t *window)
+{
+    const size_t row_bytes = (size_t)input_wd * channels;
+    const int8_t *rows = input + (size_t)split->worker_in_row * row_bytes;
+    if (pad_wd == 0 && split->worker_pad_rows == 0 && (((uintptr_t)rows) & 15) == 0) {
+        return rows;
+    }
+    if (!window) {
+        return NULL;
+    }
+
+    // a zero-point input contributes nothing, same as the padding ESP-NN would add
+    const size_t pad_bytes = (size_t)pad_wd * channels;
+    int8_t *out = window;
+    for (int y = 0; y < split->worker_in_rows; y++) {
+        memset(out, pad_value, pad_bytes);
+        out += pad_bytes;
+        memcpy(out, rows, row_bytes);
+        out += row_bytes;
+        rows += row_bytes;
+        memset(out, pad_value, pad_bytes);
+        out += pad_bytes;
+    }
+    memset(out, pad_value, (size_t)split->worker_pad_rows * (row_bytes + 2 * pad_bytes));
+    return window;
+}
+
+bool ei_esp_nn_parallel_reserve(size_t bytes)
+{
+    if (bytes <= worker_scratch_size) {
+        return true;
+    }
+
+    if (worker_scratch) {
+        ei_free(worker_scratch);
+    }
+    // ei_malloc is 16-byte aligned on the S3, which the ESP-NN kernels rely on
+    worker_scratch = ei_malloc(bytes);
+    if (!worker_scratch) {
+        worker_scratch_size = 0;
+        return false;
+    }
+    worker_scratch_size = bytes;
+    return true;
+}
+
+void *ei_esp_nn_parallel_scratch(void)
+{
+    return worker_scratch;
+}
+
+bool ei_esp_nn_parallel_run(ei_esp_nn_parallel_job_t worker_job, void *worker_arg,
+                            ei_esp_nn_parallel_job_t local_job, void *local_arg)
+{
+    if (!worker_start()) {
+        return false;
+    }
+
+    // someone else (another impulse on another task) owns the worker
+    if (xSemaphoreTake(worker_lock, 0) != pdTRUE) {
+        return false;
+    }
+
+    worker_job_fn = worker_job;
+    worker_job_arg = worker_arg;
+    xTaskNotifyGive(worker_task);
+
+    local_job(local_arg);
+
+    xSemaphoreTake(worker_done, portMAX_DELAY);
+    xSemaphoreGive(worker_lock);
+    return true;
+}
+
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+
+#endif // EI_PORTING_ESPRESSIF == 1
@@ -0,0 +1,149 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EI_ESP_NN_PARALLEL_H_
+#define _EI_ESP_NN_PARALLEL_H_
+
+/**
+ * Dual-core execution of the ESP-NN convolution kernels.
+ *
+ * A CONV_2D / DEPTHWISE_CONV_2D node is split along its output rows: the
+ * calling task computes the top rows, a persistent worker task pinned to the
+ * other core computes the bottom rows. The worker gets its own ESP-NN scratch
+ * buffer (the scratch pointers in ESP-NN are task local when this mode is
+ * enabled), and a window of the input with all of its padding materialized as
+ * zero-point values, so both halves produce exactly the same bytes as a single
+ * call over the whole tensor.
+ *
+ * Opt-in with EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE=1.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE
+#define EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE      0
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE
+
+// Nodes with less multiply-accumulates than this stay on a single core,
+// the wake-up and join of the worker costs more than it saves
+#ifndef EI_ESP_NN_PARALLEL_MIN_MACS
+#define EI_ESP_NN_PARALLEL_MIN_MACS                       (256 * 1024)
+#endif // EI_ESP_NN_PARALLEL_MIN_MACS
+
+// The spectral analysis axes (EIDSP_SPECTRAL_MULTICORE) run the FFT, the
+// filters and their error printf on the worker as well, 1 KB deep on x86-64
+// and roughly twice that with the windowed Xtensa frames, so give it more room
+#ifndef EI_ESP_NN_PARALLEL_TASK_STACK_SIZE
+#if defined(EIDSP_SPECTRAL_MULTICORE) && EIDSP_SPECTRAL_MULTICORE == 1
+#define EI_ESP_NN_PARALLEL_TASK_STACK_SIZE                6144
+#else
+#define EI_ESP_NN_PARALLEL_TASK_STACK_SIZE                4096
+#endif
+#endif // EI_ESP_NN_PARALLEL_TASK_STACK_SIZE
+
+typedef void (*ei_esp_nn_parallel_job_t)(void *arg);
+
+/**
+ * How a node is split between the calling task ("local") and the worker.
+ * Row indices are in the coordinate system of the unpadded input tensor.
+ */
+typedef struct {
+    int split_row;          // first output row computed by the worker, 0 if not split
+    int local_in_rows;      // input rows the local half reads, starting at row 0
+    int worker_in_row;      // first input row the worker half reads
+    int worker_in_rows;     // input rows the worker reads from the tensor
+    int worker_pad_rows;    // zero-point rows appended below the worker window
+    int worker_out_rows;    // output rows computed by the worker
+} ei_esp_nn_row_split_t;
+
+/**
+ * @brief      Decide whether (and where) a node is split across both cores
+ *
+ * @param[in]  input_ht   Input height
+ * @param[in]  output_ht  Output height
+ * @param[in]  filter_ht  Filter height
+ * @param[in]  stride_ht  Vertical stride
+ * @param[in]  pad_ht     Top padding as passed to ESP-NN
+ * @param[in]  macs       Multiply-accumulates of the whole node
+ * @param[out] split      Filled in when the function returns true
+ *
+ * @return     false if the node should run on a single core
+ */
+bool ei_esp_nn_plan_row_split(int input_ht, int output_ht, int filter_ht, int stride_ht,
+                              int pad_ht, int64_t macs, ei_esp_nn_row_split_t *split);
+
+/**
+ * @brief      Bytes of worker scratch needed for the input window of a split node
+ *             (0 if the worker can read straight from the input tensor).
+ *             The window is `input_wd + 2 * pad_wd` wide and
+ *             `worker_in_rows + worker_pad_rows` high, the worker then runs
+ *             the kernel without padding.
+ */
+size_t ei_esp_nn_window_size(const ei_esp_nn_row_split_t *split, int input_wd,
+                             int channels, int pad_wd);
+
+/**
+ * @brief      Return a pointer to the worker's input rows, copying them into
+ *             `window` and filling the padding with `pad_value` if needed
+ *
+ * @return     NULL if a copy is needed but `window` is NULL
+ */
+const int8_t *ei_esp_nn_build_window(const ei_esp_nn_row_split_t *split, const int8_t *input,
+                                     int input_wd, int channels, int pad_wd,
+                                     int8_t pad_value, int8_t *window);
+
+/**
+ * @brief      Grow the worker scratch buffer to at least `bytes`.
+ *             Called from the kernels' Prepare, never shrinks.
+ *
+ * @return     false if the buffer could not be allocated (the node then runs single core)
+ */
+bool ei_esp_nn_parallel_reserve(size_t bytes);
+
+/**
+ * @brief      16-byte aligned scratch buffer owned by the worker
+ */
+void *ei_esp_nn_parallel_scratch(void);
+
+/**
+ * @brief      Run `worker_job` on the other core and `local_job` on the calling
+ *             task, returns when both are done. Lazily starts the worker task.
+ *
+ * @return     false if no worker is available, nothing has been run in that case
+ */
+bool ei_esp_nn_parallel_run(ei_esp_nn_parallel_job_t worker_job, void *worker_arg,
+                            ei_esp_nn_parallel_job_t local_job, void *local_arg);
+
+#endif // _EI_ESP_NN_PARALLEL_H_
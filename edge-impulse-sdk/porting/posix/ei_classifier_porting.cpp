@@ -42,8 +42,37 @@
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <atomic>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// Clock behind ei_read_timer_us(), see ei_timer_clock_t
+#ifndef EI_PORTING_POSIX_TIMER_CLOCK
+#define EI_PORTING_POSIX_TIMER_CLOCK    EI_TIMER_CLOCK_WALL
+#endif
+
+static pthread_t cancel_worker;             // published by cancel_worker_set
+static std::atomic<bool> cancel_worker_set(false);
+static std::atomic<bool> cancel_requested(false);
+
+void ei_run_impulse_cancel_set_worker(void) {
+    cancel_worker = pthread_self();
+    cancel_worker_set = true;
+}
+
+void ei_run_impulse_cancel_request(bool cancel) {
+    cancel_requested = cancel;
+}
 
 __attribute__((weak)) EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
+    if (cancel_requested && cancel_worker_set && pthread_equal(cancel_worker, pthread_self())) {
+        return EI_IMPULSE_CANCELED;
+    }
     return EI_IMPULSE_OK;
 }
 
@@ -55,16 +84,19 @@ __attribute__((weak)) EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
     return EI_IMPULSE_OK;
 }
 
-uint64_t ei_read_timer_ms() {
-    return ei_read_timer_us() / 1000;
-}
+static volatile ei_timer_clock_t timer_clock = EI_PORTING_POSIX_TIMER_CLOCK;
 
-uint64_t ei_read_timer_us() {
-    uint64_t us; // Milliseconds
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1 && defined(__linux__)
+// cycles (group leader), instructions and cache misses of the calling thread
+static thread_local int perf_fds[3] = { -1, -1, -1 };
+#endif
+
+static uint64_t read_clock_us(clockid_t clock_id) {
+    uint64_t us; // Microseconds
     uint64_t s;  // Seconds
     struct timespec spec;
 
-    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &spec);
+    clock_gettime(clock_id, &spec);
 
     s  = spec.tv_sec;
     us = round(spec.tv_nsec / 1.0e3); // Convert nanoseconds to micros
@@ -76,6 +108,85 @@ uint64_t ei_read_timer_us() {
     return (s * 1000000) + us;
 }
 
+#if EI_PORTING_HAS_TIMER_SAMPLE == 1
+void ei_timer_set_clock(ei_timer_clock_t clock) {
+    timer_clock = clock;
+}
+
+bool ei_timer_enable_counters(bool enable) {
+#if defined(__linux__)
+    for (int ix = 2; ix >= 0; ix--) {
+        if (perf_fds[ix] >= 0) {
+            close(perf_fds[ix]);
+            perf_fds[ix] = -1;
+        }
+    }
+    if (!enable) {
+        return true;
+    }
+
+    const uint64_t configs[3] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (int ix = 0; ix < 3; ix++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[ix];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = ix == 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // pid 0, cpu -1: this thread on any CPU
+        perf_fds[ix] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, ix == 0 ? -1 : perf_fds[0], 0);
+        if (perf_fds[ix] < 0) {
+            ei_timer_enable_counters(false);
+            return false;
+        }
+    }
+    ioctl(perf_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+void ei_read_timer_sample(ei_timer_sample_t *sample) {
+    memset(sample, 0, sizeof(ei_timer_sample_t));
+#if defined(__linux__)
+    if (perf_fds[0] >= 0) {
+        uint64_t values[4]; // nr, cycles, instructions, cache misses
+        if (read(perf_fds[0], values, sizeof(values)) == (ssize_t)sizeof(values) && values[0] == 3) {
+            sample->cycles = values[1];
+            sample->instructions = values[2];
+            sample->cache_misses = values[3];
+            sample->counters_valid = true;
+        }
+    }
+#endif
+    sample->thread_cpu_us = read_clock_us(CLOCK_THREAD_CPUTIME_ID);
+    sample->wall_us = read_clock_us(CLOCK_MONOTONIC);
+}
+#endif // EI_PORTING_HAS_TIMER_SAMPLE == 1
+
+uint64_t ei_read_timer_ms() {
+    return ei_read_timer_us() / 1000;
+}
+
+uint64_t ei_read_timer_us() {
+    switch (timer_clock) {
+        case EI_TIMER_CLOCK_THREAD_CPU:
+            return read_clock_us(CLOCK_THREAD_CPUTIME_ID);
+        case EI_TIMER_CLOCK_PROCESS_CPU:
+            return read_clock_us(CLOCK_PROCESS_CPUTIME_ID);
+        case EI_TIMER_CLOCK_WALL:
+        default:
+            return read_clock_us(CLOCK_MONOTONIC);
+    }
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
     va_list myargs;
     va_start(myargs, format);
@@ -97,15 +208,33 @@ __attribute__((weak)) char ei_getchar(void)
     return getchar();
 }
 
+#if EI_PORTING_HEAP_STATS == 1
+// per thread, so other tasks don't show up in the count of an inference
+static thread_local uint32_t heap_calls = 0;
+
+uint32_t ei_heap_calls(void) {
+    return heap_calls;
+}
+
+#define EI_COUNT_HEAP_CALL() (heap_calls++)
+#else
+#define EI_COUNT_HEAP_CALL() (void)0
+#endif // EI_PORTING_HEAP_STATS == 1
+
 __attribute__((weak)) void *ei_malloc(size_t size) {
+    EI_COUNT_HEAP_CALL();
     return malloc(size);
 }
 
 __attribute__((weak)) void *ei_calloc(size_t nitems, size_t size) {
+    EI_COUNT_HEAP_CALL();
     return calloc(nitems, size);
 }
 
 __attribute__((weak)) void ei_free(void *ptr) {
+    if (ptr) {
+        EI_COUNT_HEAP_CALL();
+    }
     free(ptr);
 }
 
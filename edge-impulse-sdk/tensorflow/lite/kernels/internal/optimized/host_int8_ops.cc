@@ -0,0 +1,934 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../../../../../classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/host_int8_ops.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EI_HOST_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define EI_HOST_SIMD_NEON 1
+#endif
+
+// Limits of the on-stack scratch buffers, larger nodes run on the reference kernels
+#define EI_HOST_SIMD_MAX_CHANNELS   1024
+#define EI_HOST_SIMD_MAX_PATCH      16384
+#define EI_HOST_SIMD_MAX_TAPS       64
+
+// The vector requantization implements the double rounding
+// MultiplyByQuantizedMultiplier() only
+#if TFLITE_SINGLE_ROUNDING
+#define EI_HOST_SIMD_REQUANT(fn)    RequantScalar
+#else
+#define EI_HOST_SIMD_REQUANT(fn)    fn
+#endif  // TFLITE_SINGLE_ROUNDING
+
+namespace tflite {
+namespace optimized_host {
+namespace {
+
+// Per output channel requantization, MultiplyByQuantizedMultiplier() with the
+// shift split into its left and right part
+struct Requant {
+  const int32_t* bias;
+  const int32_t* multiplier;
+  const int32_t* shift;
+  const int32_t* left_shift;
+  const int32_t* right_shift;
+  int32_t output_offset;
+  int32_t activation_min;
+  int32_t activation_max;
+};
+
+struct Kernels {
+  const char* name;
+  // out[j] = sum_k patch[k] * filters[j * depth + k], for 0 <= j < count
+  void (*dot)(const int8_t* patch, const int8_t* filters, int depth, int count,
+              int32_t* out);
+  // acc[c] = sum_t (inputs[t][c] + input_offset) * filters[t][c]
+  void (*depthwise)(const int8_t* const* inputs, const int8_t* const* filters,
+                    int taps, int channels, int32_t input_offset, int32_t* acc);
+  // out[c] = clamp(MultiplyByQuantizedMultiplier(acc[c] + bias[c]) + offset)
+  void (*requant)(const int32_t* acc, int channels, const Requant& rq,
+                  int8_t* out);
+  // elementwise ADD, returns how many elements were processed
+  int (*add)(int size, const ArithmeticParams& params, const int8_t* input1,
+             const int8_t* input2, int8_t* output);
+};
+
+inline int8_t RequantOne(int32_t acc, int c, const Requant& rq) {
+  int32_t v = MultiplyByQuantizedMultiplier(acc + rq.bias[c], rq.multiplier[c],
+                                            rq.shift[c]);
+  v += rq.output_offset;
+  v = std::max(v, rq.activation_min);
+  v = std::min(v, rq.activation_max);
+  return static_cast<int8_t>(v);
+}
+
+void RequantScalar(const int32_t* acc, int channels, const Requant& rq,
+                   int8_t* out) {
+  for (int c = 0; c < channels; c++) {
+    out[c] = RequantOne(acc[c], c, rq);
+  }
+}
+
+inline int8_t AddOne(int8_t input1, int8_t input2,
+                     const ArithmeticParams& params) {
+  const int32_t shifted_input1_val =
+      (params.input1_offset + input1) * (1 << params.left_shift);
+  const int32_t shifted_input2_val =
+      (params.input2_offset + input2) * (1 << params.left_shift);
+  const int32_t scaled_input1_val =
+      MultiplyByQuantizedMultiplierSmallerThanOneExp(
+          shifted_input1_val, params.input1_multiplier, params.input1_shift);
+  const int32_t scaled_input2_val =
+      MultiplyByQuantizedMultiplierSmallerThanOneExp(
+          shifted_input2_val, params.input2_multiplier, params.input2_shift);
+  const int32_t raw_output =
+      MultiplyByQuantizedMultiplierSmallerThanOneExp(
+          scaled_input1_val + scaled_input2_val, params.output_multiplier,
+          params.output_shift) +
+      params.output_offset;
+  return static_cast<int8_t>(
+      std::min(params.quantized_activation_max,
+               std::max(params.quantized_activation_min, raw_output)));
+}
+
+#if EI_HOST_SIMD_X86 == 1
+
+// SaturatingRoundingDoublingHighMul is floor((a * b + 2^30) / 2^31) for every
+// input except a == b == INT32_MIN, which can't occur here as the multipliers
+// are positive. Even and odd lanes go through _mm_mul_epi32 separately.
+__attribute__((target("sse4.1"))) inline __m128i SrdhmSse41(__m128i a,
+                                                            __m128i b) {
+  const __m128i nudge = _mm_set1_epi64x(1LL << 30);
+  const __m128i even = _mm_add_epi64(_mm_mul_epi32(a, b), nudge);
+  const __m128i odd = _mm_add_epi64(
+      _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), nudge);
+  return _mm_blend_epi16(_mm_srli_epi64(even, 31),
+                         _mm_slli_epi64(_mm_srli_epi64(odd, 31), 32), 0xCC);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i RoundingDivideByPOTSse41(
+    __m128i x, int exponent) {
+  const __m128i mask = _mm_set1_epi32(static_cast<int32_t>((1u << exponent) - 1));
+  const __m128i remainder = _mm_and_si128(x, mask);
+  const __m128i threshold =
+      _mm_add_epi32(_mm_srai_epi32(mask, 1), _mm_srli_epi32(x, 31));
+  const __m128i shifted = _mm_sra_epi32(x, _mm_cvtsi32_si128(exponent));
+  return _mm_sub_epi32(shifted, _mm_cmpgt_epi32(remainder, threshold));
+}
+
+__attribute__((target("sse4.1"))) inline int32_t HorizontalSumSse41(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i LoadInt8x8Sse41(
+    const int8_t* ptr) {
+  return _mm_cvtepi8_epi16(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+__attribute__((target("sse4.1"))) void DotSse41(const int8_t* patch,
+                                                const int8_t* filters,
+                                                int depth, int count,
+                                                int32_t* out) {
+  for (int j = 0; j < count; j += 4) {
+    // the last group repeats the last filter, its extra results are dropped
+    const int8_t* f[4];
+    for (int i = 0; i < 4; i++) {
+      f[i] = filters + static_cast<size_t>(std::min(j + i, count - 1)) * depth;
+    }
+    __m128i acc[4] = {_mm_setzero_si128(), _mm_setzero_si128(),
+                      _mm_setzero_si128(), _mm_setzero_si128()};
+    int k = 0;
+    for (; k + 8 <= depth; k += 8) {
+      const __m128i p = LoadInt8x8Sse41(patch + k);
+      for (int i = 0; i < 4; i++) {
+        acc[i] = _mm_add_epi32(
+            acc[i], _mm_madd_epi16(p, LoadInt8x8Sse41(f[i] + k)));
+      }
+    }
+    int32_t sums[4];
+    for (int i = 0; i < 4; i++) {
+      sums[i] = HorizontalSumSse41(acc[i]);
+    }
+    for (; k < depth; k++) {
+      for (int i = 0; i < 4; i++) {
+        sums[i] += patch[k] * f[i][k];
+      }
+    }
+    for (int i = 0; i < 4 && j + i < count; i++) {
+      out[j + i] = sums[i];
+    }
+  }
+}
+
+__attribute__((target("sse4.1"))) void DepthwiseSse41(
+    const int8_t* const* inputs, const int8_t* const* filters, int taps,
+    int channels, int32_t input_offset, int32_t* acc) {
+  // (input + offset) is at most 9 bits and the filter 8 bits, so the product
+  // fits in 16 bits
+  const __m128i offset = _mm_set1_epi16(static_cast<int16_t>(input_offset));
+  int c = 0;
+  for (; c + 8 <= channels; c += 8) {
+    __m128i acc_lo = _mm_setzero_si128();
+    __m128i acc_hi = _mm_setzero_si128();
+    for (int t = 0; t < taps; t++) {
+      const __m128i x = _mm_add_epi16(LoadInt8x8Sse41(inputs[t] + c), offset);
+      const __m128i prod = _mm_mullo_epi16(x, LoadInt8x8Sse41(filters[t] + c));
+      acc_lo = _mm_add_epi32(acc_lo, _mm_cvtepi16_epi32(prod));
+      acc_hi = _mm_add_epi32(acc_hi,
+                             _mm_cvtepi16_epi32(_mm_srli_si128(prod, 8)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + c), acc_lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + c + 4), acc_hi);
+  }
+  for (; c < channels; c++) {
+    int32_t sum = 0;
+    for (int t = 0; t < taps; t++) {
+      sum += (inputs[t][c] + input_offset) * filters[t][c];
+    }
+    acc[c] = sum;
+  }
+}
+
+__attribute__((target("sse4.1"))) int AddSse41(int size,
+                                               const ArithmeticParams& params,
+                                               const int8_t* input1,
+                                               const int8_t* input2,
+                                               int8_t* output) {
+  const __m128i left_shift = _mm_cvtsi32_si128(params.left_shift);
+  const __m128i offset1 = _mm_set1_epi32(params.input1_offset);
+  const __m128i offset2 = _mm_set1_epi32(params.input2_offset);
+  const __m128i multiplier1 = _mm_set1_epi32(params.input1_multiplier);
+  const __m128i multiplier2 = _mm_set1_epi32(params.input2_multiplier);
+  const __m128i output_multiplier = _mm_set1_epi32(params.output_multiplier);
+  const __m128i output_offset = _mm_set1_epi32(params.output_offset);
+  const __m128i act_min = _mm_set1_epi32(params.quantized_activation_min);
+  const __m128i act_max = _mm_set1_epi32(params.quantized_activation_max);
+
+  int i = 0;
+  for (; i + 4 <= size; i += 4) {
+    int32_t raw1, raw2;
+    memcpy(&raw1, input1 + i, sizeof(raw1));
+    memcpy(&raw2, input2 + i, sizeof(raw2));
+    __m128i a = _mm_add_epi32(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(raw1)), offset1);
+    __m128i b = _mm_add_epi32(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(raw2)), offset2);
+    a = RoundingDivideByPOTSse41(
+        SrdhmSse41(_mm_sll_epi32(a, left_shift), multiplier1),
+        -params.input1_shift);
+    b = RoundingDivideByPOTSse41(
+        SrdhmSse41(_mm_sll_epi32(b, left_shift), multiplier2),
+        -params.input2_shift);
+    __m128i v = RoundingDivideByPOTSse41(
+        SrdhmSse41(_mm_add_epi32(a, b), output_multiplier),
+        -params.output_shift);
+    v = _mm_add_epi32(v, output_offset);
+    v = _mm_min_epi32(_mm_max_epi32(v, act_min), act_max);
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packs_epi16(v, v);
+    const int32_t packed = _mm_cvtsi128_si32(v);
+    memcpy(output + i, &packed, sizeof(packed));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline __m256i SrdhmAvx2(__m256i a,
+                                                         __m256i b) {
+  const __m256i nudge = _mm256_set1_epi64x(1LL << 30);
+  const __m256i even = _mm256_add_epi64(_mm256_mul_epi32(a, b), nudge);
+  const __m256i odd = _mm256_add_epi64(
+      _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)),
+      nudge);
+  return _mm256_blend_epi32(_mm256_srli_epi64(even, 31),
+                            _mm256_slli_epi64(_mm256_srli_epi64(odd, 31), 32),
+                            0xAA);
+}
+
+// RoundingDivideByPOT with a per lane exponent
+__attribute__((target("avx2"))) inline __m256i RoundingDivideByPOTAvx2(
+    __m256i x, __m256i exponent) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i mask = _mm256_sub_epi32(_mm256_sllv_epi32(one, exponent), one);
+  const __m256i remainder = _mm256_and_si256(x, mask);
+  const __m256i threshold =
+      _mm256_add_epi32(_mm256_srai_epi32(mask, 1), _mm256_srli_epi32(x, 31));
+  const __m256i shifted = _mm256_srav_epi32(x, exponent);
+  return _mm256_sub_epi32(shifted, _mm256_cmpgt_epi32(remainder, threshold));
+}
+
+__attribute__((target("avx2"))) inline int32_t HorizontalSumAvx2(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+
+__attribute__((target("avx2"))) inline __m256i LoadInt8x16Avx2(
+    const int8_t* ptr) {
+  return _mm256_cvtepi8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+}
+
+__attribute__((target("avx2"))) inline void StoreInt8x8Avx2(__m256i v,
+                                                            int8_t* ptr) {
+  const __m128i v16 = _mm_packs_epi32(_mm256_castsi256_si128(v),
+                                      _mm256_extracti128_si256(v, 1));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), _mm_packs_epi16(v16, v16));
+}
+
+__attribute__((target("avx2"))) void DotAvx2(const int8_t* patch,
+                                             const int8_t* filters, int depth,
+                                             int count, int32_t* out) {
+  for (int j = 0; j < count; j += 4) {
+    const int8_t* f[4];
+    for (int i = 0; i < 4; i++) {
+      f[i] = filters + static_cast<size_t>(std::min(j + i, count - 1)) * depth;
+    }
+    __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                      _mm256_setzero_si256(), _mm256_setzero_si256()};
+    int k = 0;
+    for (; k + 16 <= depth; k += 16) {
+      const __m256i p = LoadInt8x16Avx2(patch + k);
+      for (int i = 0; i < 4; i++) {
+        acc[i] = _mm256_add_epi32(
+            acc[i], _mm256_madd_epi16(p, LoadInt8x16Avx2(f[i] + k)));
+      }
+    }
+    int32_t sums[4];
+    for (int i = 0; i < 4; i++) {
+      sums[i] = HorizontalSumAvx2(acc[i]);
+    }
+    for (; k < depth; k++) {
+      for (int i = 0; i < 4; i++) {
+        sums[i] += patch[k] * f[i][k];
+      }
+    }
+    for (int i = 0; i < 4 && j + i < count; i++) {
+      out[j + i] = sums[i];
+    }
+  }
+}
+
+__attribute__((target("avx2"))) void DepthwiseAvx2(
+    const int8_t* const* inputs, const int8_t* const* filters, int taps,
+    int channels, int32_t input_offset, int32_t* acc) {
+  const __m256i offset = _mm256_set1_epi16(static_cast<int16_t>(input_offset));
+  int c = 0;
+  for (; c + 16 <= channels; c += 16) {
+    __m256i acc_lo = _mm256_setzero_si256();
+    __m256i acc_hi = _mm256_setzero_si256();
+    for (int t = 0; t < taps; t++) {
+      const __m256i x = _mm256_add_epi16(LoadInt8x16Avx2(inputs[t] + c), offset);
+      const __m256i prod = _mm256_mullo_epi16(x, LoadInt8x16Avx2(filters[t] + c));
+      acc_lo = _mm256_add_epi32(
+          acc_lo, _mm256_cvtepi16_epi32(_mm256_castsi256_si128(prod)));
+      acc_hi = _mm256_add_epi32(
+          acc_hi, _mm256_cvtepi16_epi32(_mm256_extracti128_si256(prod, 1)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + c), acc_lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + c + 8), acc_hi);
+  }
+  const __m128i offset8 = _mm256_castsi256_si128(offset);
+  for (; c + 8 <= channels; c += 8) {
+    __m128i acc_lo = _mm_setzero_si128();
+    __m128i acc_hi = _mm_setzero_si128();
+    for (int t = 0; t < taps; t++) {
+      const __m128i x = _mm_add_epi16(LoadInt8x8Sse41(inputs[t] + c), offset8);
+      const __m128i prod = _mm_mullo_epi16(x, LoadInt8x8Sse41(filters[t] + c));
+      acc_lo = _mm_add_epi32(acc_lo, _mm_cvtepi16_epi32(prod));
+      acc_hi = _mm_add_epi32(acc_hi,
+                             _mm_cvtepi16_epi32(_mm_srli_si128(prod, 8)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + c), acc_lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + c + 4), acc_hi);
+  }
+  for (; c < channels; c++) {
+    int32_t sum = 0;
+    for (int t = 0; t < taps; t++) {
+      sum += (inputs[t][c] + input_offset) * filters[t][c];
+    }
+    acc[c] = sum;
+  }
+}
+
+__attribute__((target("avx2"))) void RequantAvx2(const int32_t* acc,
+                                                 int channels,
+                                                 const Requant& rq,
+                                                 int8_t* out) {
+  const __m256i output_offset = _mm256_set1_epi32(rq.output_offset);
+  const __m256i act_min = _mm256_set1_epi32(rq.activation_min);
+  const __m256i act_max = _mm256_set1_epi32(rq.activation_max);
+  int c = 0;
+  for (; c + 8 <= channels; c += 8) {
+    __m256i v = _mm256_add_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + c)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rq.bias + c)));
+    v = _mm256_sllv_epi32(
+        v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rq.left_shift + c)));
+    v = SrdhmAvx2(
+        v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rq.multiplier + c)));
+    v = RoundingDivideByPOTAvx2(
+        v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rq.right_shift + c)));
+    v = _mm256_add_epi32(v, output_offset);
+    v = _mm256_min_epi32(_mm256_max_epi32(v, act_min), act_max);
+    StoreInt8x8Avx2(v, out + c);
+  }
+  for (; c < channels; c++) {
+    out[c] = RequantOne(acc[c], c, rq);
+  }
+}
+
+__attribute__((target("avx2"))) int AddAvx2(int size,
+                                            const ArithmeticParams& params,
+                                            const int8_t* input1,
+                                            const int8_t* input2,
+                                            int8_t* output) {
+  const __m256i left_shift = _mm256_set1_epi32(params.left_shift);
+  const __m256i offset1 = _mm256_set1_epi32(params.input1_offset);
+  const __m256i offset2 = _mm256_set1_epi32(params.input2_offset);
+  const __m256i multiplier1 = _mm256_set1_epi32(params.input1_multiplier);
+  const __m256i multiplier2 = _mm256_set1_epi32(params.input2_multiplier);
+  const __m256i shift1 = _mm256_set1_epi32(-params.input1_shift);
+  const __m256i shift2 = _mm256_set1_epi32(-params.input2_shift);
+  const __m256i output_multiplier = _mm256_set1_epi32(params.output_multiplier);
+  const __m256i output_shift = _mm256_set1_epi32(-params.output_shift);
+  const __m256i output_offset = _mm256_set1_epi32(params.output_offset);
+  const __m256i act_min = _mm256_set1_epi32(params.quantized_activation_min);
+  const __m256i act_max = _mm256_set1_epi32(params.quantized_activation_max);
+
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256i a = _mm256_add_epi32(
+        _mm256_cvtepi8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input1 + i))),
+        offset1);
+    __m256i b = _mm256_add_epi32(
+        _mm256_cvtepi8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input2 + i))),
+        offset2);
+    a = RoundingDivideByPOTAvx2(
+        SrdhmAvx2(_mm256_sllv_epi32(a, left_shift), multiplier1), shift1);
+    b = RoundingDivideByPOTAvx2(
+        SrdhmAvx2(_mm256_sllv_epi32(b, left_shift), multiplier2), shift2);
+    __m256i v = RoundingDivideByPOTAvx2(
+        SrdhmAvx2(_mm256_add_epi32(a, b), output_multiplier), output_shift);
+    v = _mm256_add_epi32(v, output_offset);
+    v = _mm256_min_epi32(_mm256_max_epi32(v, act_min), act_max);
+    StoreInt8x8Avx2(v, output + i);
+  }
+  return i;
+}
+
+const Kernels kSse41Kernels = {"sse4.1", DotSse41, DepthwiseSse41,
+                               RequantScalar, AddSse41};
+const Kernels kAvx2Kernels = {"avx2", DotAvx2, DepthwiseAvx2,
+                              EI_HOST_SIMD_REQUANT(RequantAvx2), AddAvx2};
+
+const Kernels* FindKernels(const char* name) {
+  __builtin_cpu_init();
+  if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+    return &kAvx2Kernels;
+  }
+  if (strcmp(name, "sse4.1") == 0 && __builtin_cpu_supports("sse4.1")) {
+    return &kSse41Kernels;
+  }
+  return nullptr;
+}
+
+const Kernels* DetectKernels() {
+  const Kernels* kernels = FindKernels("avx2");
+  return kernels ? kernels : FindKernels("sse4.1");
+}
+
+#elif EI_HOST_SIMD_NEON == 1
+
+inline int32x4_t RoundingDivideByPOTNeon(int32x4_t x, int32x4_t exponent) {
+  const int32x4_t one = vdupq_n_s32(1);
+  const int32x4_t mask = vsubq_s32(vshlq_s32(one, exponent), one);
+  const int32x4_t remainder = vandq_s32(x, mask);
+  const int32x4_t threshold = vaddq_s32(
+      vshrq_n_s32(mask, 1),
+      vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(x), 31)));
+  const int32x4_t shifted = vshlq_s32(x, vnegq_s32(exponent));
+  return vsubq_s32(shifted,
+                   vreinterpretq_s32_u32(vcgtq_s32(remainder, threshold)));
+}
+
+inline void StoreInt8x8Neon(int32x4_t lo, int32x4_t hi, int8_t* ptr) {
+  vst1_s8(ptr, vqmovn_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))));
+}
+
+void DotNeon(const int8_t* patch, const int8_t* filters, int depth, int count,
+             int32_t* out) {
+  for (int j = 0; j < count; j += 4) {
+    const int8_t* f[4];
+    for (int i = 0; i < 4; i++) {
+      f[i] = filters + static_cast<size_t>(std::min(j + i, count - 1)) * depth;
+    }
+    int32x4_t acc[4] = {vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0),
+                        vdupq_n_s32(0)};
+    int k = 0;
+    for (; k + 16 <= depth; k += 16) {
+      const int8x16_t p = vld1q_s8(patch + k);
+      for (int i = 0; i < 4; i++) {
+        // int8 * int8 products fit in int16, pairwise accumulate into int32
+        const int8x16_t w = vld1q_s8(f[i] + k);
+        acc[i] = vpadalq_s16(acc[i], vmull_s8(vget_low_s8(p), vget_low_s8(w)));
+        acc[i] = vpadalq_s16(acc[i], vmull_high_s8(p, w));
+      }
+    }
+    int32_t sums[4];
+    for (int i = 0; i < 4; i++) {
+      sums[i] = vaddvq_s32(acc[i]);
+    }
+    for (; k < depth; k++) {
+      for (int i = 0; i < 4; i++) {
+        sums[i] += patch[k] * f[i][k];
+      }
+    }
+    for (int i = 0; i < 4 && j + i < count; i++) {
+      out[j + i] = sums[i];
+    }
+  }
+}
+
+void DepthwiseNeon(const int8_t* const* inputs, const int8_t* const* filters,
+                   int taps, int channels, int32_t input_offset,
+                   int32_t* acc) {
+  // (input + offset) is at most 9 bits and the filter 8 bits, so the product
+  // fits in 16 bits
+  const int16x8_t offset = vdupq_n_s16(static_cast<int16_t>(input_offset));
+  int c = 0;
+  for (; c + 8 <= channels; c += 8) {
+    int32x4_t acc_lo = vdupq_n_s32(0);
+    int32x4_t acc_hi = vdupq_n_s32(0);
+    for (int t = 0; t < taps; t++) {
+      const int16x8_t x = vaddq_s16(vmovl_s8(vld1_s8(inputs[t] + c)), offset);
+      const int16x8_t prod = vmulq_s16(x, vmovl_s8(vld1_s8(filters[t] + c)));
+      acc_lo = vaddw_s16(acc_lo, vget_low_s16(prod));
+      acc_hi = vaddw_high_s16(acc_hi, prod);
+    }
+    vst1q_s32(acc + c, acc_lo);
+    vst1q_s32(acc + c + 4, acc_hi);
+  }
+  for (; c < channels; c++) {
+    int32_t sum = 0;
+    for (int t = 0; t < taps; t++) {
+      sum += (inputs[t][c] + input_offset) * filters[t][c];
+    }
+    acc[c] = sum;
+  }
+}
+
+void RequantNeon(const int32_t* acc, int channels, const Requant& rq,
+                 int8_t* out) {
+  const int32x4_t output_offset = vdupq_n_s32(rq.output_offset);
+  const int32x4_t act_min = vdupq_n_s32(rq.activation_min);
+  const int32x4_t act_max = vdupq_n_s32(rq.activation_max);
+  int c = 0;
+  for (; c + 8 <= channels; c += 8) {
+    int32x4_t v[2];
+    for (int h = 0; h < 2; h++) {
+      const int o = c + h * 4;
+      int32x4_t x = vaddq_s32(vld1q_s32(acc + o), vld1q_s32(rq.bias + o));
+      x = vshlq_s32(x, vld1q_s32(rq.left_shift + o));
+      // vqrdmulh is exactly SaturatingRoundingDoublingHighMul
+      x = vqrdmulhq_s32(x, vld1q_s32(rq.multiplier + o));
+      x = RoundingDivideByPOTNeon(x, vld1q_s32(rq.right_shift + o));
+      x = vaddq_s32(x, output_offset);
+      v[h] = vminq_s32(vmaxq_s32(x, act_min), act_max);
+    }
+    StoreInt8x8Neon(v[0], v[1], out + c);
+  }
+  for (; c < channels; c++) {
+    out[c] = RequantOne(acc[c], c, rq);
+  }
+}
+
+int AddNeon(int size, const ArithmeticParams& params, const int8_t* input1,
+            const int8_t* input2, int8_t* output) {
+  const int32x4_t left_shift = vdupq_n_s32(params.left_shift);
+  const int32x4_t offset1 = vdupq_n_s32(params.input1_offset);
+  const int32x4_t offset2 = vdupq_n_s32(params.input2_offset);
+  const int32x4_t multiplier1 = vdupq_n_s32(params.input1_multiplier);
+  const int32x4_t multiplier2 = vdupq_n_s32(params.input2_multiplier);
+  const int32x4_t shift1 = vdupq_n_s32(-params.input1_shift);
+  const int32x4_t shift2 = vdupq_n_s32(-params.input2_shift);
+  const int32x4_t output_multiplier = vdupq_n_s32(params.output_multiplier);
+  const int32x4_t output_shift = vdupq_n_s32(-params.output_shift);
+  const int32x4_t output_offset = vdupq_n_s32(params.output_offset);
+  const int32x4_t act_min = vdupq_n_s32(params.quantized_activation_min);
+  const int32x4_t act_max = vdupq_n_s32(params.quantized_activation_max);
+
+  int i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const int16x8_t in1 = vmovl_s8(vld1_s8(input1 + i));
+    const int16x8_t in2 = vmovl_s8(vld1_s8(input2 + i));
+    int32x4_t v[2];
+    for (int h = 0; h < 2; h++) {
+      int32x4_t a = vaddq_s32(
+          vmovl_s16(h == 0 ? vget_low_s16(in1) : vget_high_s16(in1)), offset1);
+      int32x4_t b = vaddq_s32(
+          vmovl_s16(h == 0 ? vget_low_s16(in2) : vget_high_s16(in2)), offset2);
+      a = RoundingDivideByPOTNeon(
+          vqrdmulhq_s32(vshlq_s32(a, left_shift), multiplier1), shift1);
+      b = RoundingDivideByPOTNeon(
+          vqrdmulhq_s32(vshlq_s32(b, left_shift), multiplier2), shift2);
+      int32x4_t x = RoundingDivideByPOTNeon(
+          vqrdmulhq_s32(vaddq_s32(a, b), output_multiplier), output_shift);
+      x = vaddq_s32(x, output_offset);
+      v[h] = vminq_s32(vmaxq_s32(x, act_min), act_max);
+    }
+    StoreInt8x8Neon(v[0], v[1], output + i);
+  }
+  return i;
+}
+
+const Kernels kNeonKernels = {"neon", DotNeon, DepthwiseNeon,
+                              EI_HOST_SIMD_REQUANT(RequantNeon), AddNeon};
+
+const Kernels* FindKernels(const char* name) {
+  return strcmp(name, "neon") == 0 ? &kNeonKernels : nullptr;
+}
+
+const Kernels* DetectKernels() { return &kNeonKernels; }
+
+#else
+
+const Kernels* FindKernels(const char* name) { return nullptr; }
+
+const Kernels* DetectKernels() { return nullptr; }
+
+#endif
+
+const Kernels** ActiveKernels() {
+  static const Kernels* kernels = DetectKernels();
+  return &kernels;
+}
+
+const Kernels* GetKernels() { return *ActiveKernels(); }
+
+// Fills the per channel requantization parameters, `bias` has to hold
+// `channels` entries and already contain any accumulator correction
+void PrepareRequant(int channels, const int32_t* output_multiplier,
+                    const int32_t* output_shift, int32_t* left_shift,
+                    int32_t* right_shift, Requant* rq) {
+  for (int c = 0; c < channels; c++) {
+    left_shift[c] = output_shift[c] > 0 ? output_shift[c] : 0;
+    right_shift[c] = output_shift[c] > 0 ? 0 : -output_shift[c];
+  }
+  rq->multiplier = output_multiplier;
+  rq->shift = output_shift;
+  rq->left_shift = left_shift;
+  rq->right_shift = right_shift;
+}
+
+}  // namespace
+
+const char* SimdName() {
+  const Kernels* kernels = GetKernels();
+  return kernels ? kernels->name : "none";
+}
+
+bool SelectSimd(const char* name) {
+  if (strcmp(name, "none") == 0) {
+    *ActiveKernels() = nullptr;
+    return true;
+  }
+  const Kernels* kernels = FindKernels(name);
+  if (!kernels) {
+    return false;
+  }
+  *ActiveKernels() = kernels;
+  return true;
+}
+
+bool ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const int8_t* filter_data, const int32_t* bias_data,
+                    const RuntimeShape& output_shape,
+                    int8_t* output_data) {
+  const Kernels* kernels = GetKernels();
+  if (!kernels || params.dilation_width_factor != 1 ||
+      params.dilation_height_factor != 1) {
+    return false;
+  }
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int patch_size = filter_height * filter_width * input_depth;
+
+  // grouped convolutions stay on the reference kernel
+  if (filter_shape.Dims(3) != input_depth ||
+      output_depth > EI_HOST_SIMD_MAX_CHANNELS ||
+      patch_size > EI_HOST_SIMD_MAX_PATCH) {
+    return false;
+  }
+
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t input_offset = params.input_offset;
+
+  // The dot products run on the raw int8 input, the input offset is folded
+  // into the bias: sum(f * (x + offset)) = sum(f * x) + offset * sum(f).
+  // Padding is filled with the input zero point, which then contributes 0.
+  int32_t bias[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t left_shift[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t right_shift[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t acc[EI_HOST_SIMD_MAX_CHANNELS];
+  int8_t patch[EI_HOST_SIMD_MAX_PATCH];
+
+  for (int oc = 0; oc < output_depth; oc++) {
+    const int8_t* filter = filter_data + static_cast<size_t>(oc) * patch_size;
+    int32_t filter_sum = 0;
+    for (int k = 0; k < patch_size; k++) {
+      filter_sum += filter[k];
+    }
+    bias[oc] = (bias_data ? bias_data[oc] : 0) + input_offset * filter_sum;
+  }
+
+  Requant rq;
+  rq.bias = bias;
+  rq.output_offset = params.output_offset;
+  rq.activation_min = params.quantized_activation_min;
+  rq.activation_max = params.quantized_activation_max;
+  PrepareRequant(output_depth, output_multiplier, output_shift, left_shift,
+                 right_shift, &rq);
+
+  const bool direct = filter_height == 1 && filter_width == 1 &&
+                      pad_height == 0 && pad_width == 0;
+  const int8_t pad_value = static_cast<int8_t>(-input_offset);
+  const size_t pixel_bytes = static_cast<size_t>(input_depth);
+  const size_t filter_row_bytes = filter_width * pixel_bytes;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        const int8_t* in_patch;
+
+        if (direct) {
+          in_patch = input_data +
+                     Offset(input_shape, batch, in_y_origin, in_x_origin, 0);
+        } else {
+          // im2col of a single output pixel
+          int8_t* dst = patch;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              memset(dst, pad_value, filter_row_bytes);
+            } else if (in_x_origin >= 0 &&
+                       in_x_origin + filter_width <= input_width) {
+              memcpy(dst,
+                     input_data +
+                         Offset(input_shape, batch, in_y, in_x_origin, 0),
+                     filter_row_bytes);
+            } else {
+              for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+                const int in_x = in_x_origin + filter_x;
+                int8_t* dst_px = dst + filter_x * pixel_bytes;
+                if (in_x < 0 || in_x >= input_width) {
+                  memset(dst_px, pad_value, pixel_bytes);
+                } else {
+                  memcpy(dst_px,
+                         input_data + Offset(input_shape, batch, in_y, in_x, 0),
+                         pixel_bytes);
+                }
+              }
+            }
+            dst += filter_row_bytes;
+          }
+          in_patch = patch;
+        }
+
+        kernels->dot(in_patch, filter_data, patch_size, output_depth, acc);
+        kernels->requant(
+            acc, output_depth, rq,
+            output_data + Offset(output_shape, batch, out_y, out_x, 0));
+      }
+    }
+  }
+  return true;
+}
+
+bool DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const int32_t* bias_data,
+    const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  const Kernels* kernels = GetKernels();
+  if (!kernels || params.depth_multiplier != 1 ||
+      params.dilation_width_factor != 1 || params.dilation_height_factor != 1) {
+    return false;
+  }
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int channels = MatchingDim(filter_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  if (input_shape.Dims(3) != channels ||
+      channels > EI_HOST_SIMD_MAX_CHANNELS ||
+      filter_height * filter_width > EI_HOST_SIMD_MAX_TAPS) {
+    return false;
+  }
+
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+
+  int32_t bias[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t left_shift[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t right_shift[EI_HOST_SIMD_MAX_CHANNELS];
+  int32_t acc[EI_HOST_SIMD_MAX_CHANNELS];
+  const int8_t* tap_inputs[EI_HOST_SIMD_MAX_TAPS];
+  const int8_t* tap_filters[EI_HOST_SIMD_MAX_TAPS];
+
+  for (int c = 0; c < channels; c++) {
+    bias[c] = bias_data ? bias_data[c] : 0;
+  }
+
+  Requant rq;
+  rq.bias = bias;
+  rq.output_offset = params.output_offset;
+  rq.activation_min = params.quantized_activation_min;
+  rq.activation_max = params.quantized_activation_max;
+  PrepareRequant(channels, output_multiplier, output_shift, left_shift,
+                 right_shift, &rq);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+
+        // taps outside of the image are left out, like the reference kernel
+        int taps = 0;
+        for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+          const int in_y = in_y_origin + filter_y;
+          if (in_y < 0 || in_y >= input_height) {
+            continue;
+          }
+          for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+            const int in_x = in_x_origin + filter_x;
+            if (in_x < 0 || in_x >= input_width) {
+              continue;
+            }
+            tap_inputs[taps] =
+                input_data + Offset(input_shape, batch, in_y, in_x, 0);
+            tap_filters[taps] =
+                filter_data + Offset(filter_shape, 0, filter_y, filter_x, 0);
+            taps++;
+          }
+        }
+
+        kernels->depthwise(tap_inputs, tap_filters, taps, channels,
+                           params.input_offset, acc);
+        kernels->requant(
+            acc, channels, rq,
+            output_data + Offset(output_shape, batch, out_y, out_x, 0));
+      }
+    }
+  }
+  return true;
+}
+
+bool Add(const ArithmeticParams& params, const RuntimeShape& input1_shape,
+         const int8_t* input1_data, const RuntimeShape& input2_shape,
+         const int8_t* input2_data, const RuntimeShape& output_shape,
+         int8_t* output_data) {
+#if TFLITE_SINGLE_ROUNDING
+  // the vector code implements the double rounding requantization only
+  return false;
+#else
+  const Kernels* kernels = GetKernels();
+  if (!kernels) {
+    return false;
+  }
+  const int shifts[] = {-params.input1_shift, -params.input2_shift,
+                        -params.output_shift, params.left_shift};
+  for (int shift : shifts) {
+    if (shift < 0 || shift > 31) {
+      return false;
+    }
+  }
+
+  const int size =
+      MatchingElementsSize(input1_shape, input2_shape, output_shape);
+  int i = kernels->add(size, params, input1_data, input2_data, output_data);
+  for (; i < size; i++) {
+    output_data[i] = AddOne(input1_data[i], input2_data[i], params);
+  }
+  return true;
+#endif  // TFLITE_SINGLE_ROUNDING
+}
+
+}  // namespace optimized_host
+}  // namespace tflite
+
+#endif  // EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
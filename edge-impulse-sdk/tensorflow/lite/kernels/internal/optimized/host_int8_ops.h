@@ -0,0 +1,85 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_HOST_INT8_OPS_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_HOST_INT8_OPS_H_
+
+// Vectorized int8 kernels for the reference kernel path when running on a
+// desktop / Linux host (x86 with SSE4.1 or AVX2, aarch64 with NEON).
+//
+// The functions take the same arguments as their reference_integer_ops
+// counterparts (minus the bias shape, the bias has one entry per output
+// channel) and produce bit-exact results. They return false, without
+// touching the output, when the CPU or the node configuration is not supported;
+// the caller then runs the reference kernel.
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace optimized_host {
+
+// Name of the instruction set picked at runtime ("avx2", "sse4.1", "neon" or "none")
+const char* SimdName();
+
+// Forces the instruction set ("avx2", "sse4.1", "neon" or "none" for the
+// reference kernels), for the correctness harness in main/app_benchmark.cpp.
+// Returns false when the CPU doesn't support it. Not safe while kernels run.
+bool SelectSimd(const char* name);
+
+bool ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const int8_t* filter_data, const int32_t* bias_data,
+                    const RuntimeShape& output_shape,
+                    int8_t* output_data);
+
+bool DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const int32_t* bias_data,
+    const RuntimeShape& output_shape,
+    int8_t* output_data);
+
+// Elementwise ADD without broadcast (reference_integer_ops::Add)
+bool Add(const ArithmeticParams& params, const RuntimeShape& input1_shape,
+         const int8_t* input1_data, const RuntimeShape& input2_shape,
+         const int8_t* input2_data, const RuntimeShape& output_shape,
+         int8_t* output_data);
+
+}  // namespace optimized_host
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_HOST_INT8_OPS_H_
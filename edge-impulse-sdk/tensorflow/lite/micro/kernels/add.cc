@@ -1272,6 +1272,9 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/host_int8_ops.h"
+#endif
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/process_broadcast_shapes.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
@@ -1340,6 +1343,17 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
             tflite::micro::GetTensorShape(output),
             tflite::micro::GetTensorData<int8_t>(output));
       } else {
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+        if (optimized_host::Add(
+                op_params, tflite::micro::GetTensorShape(input1),
+                tflite::micro::GetTensorData<int8_t>(input1),
+                tflite::micro::GetTensorShape(input2),
+                tflite::micro::GetTensorData<int8_t>(input2),
+                tflite::micro::GetTensorShape(output),
+                tflite::micro::GetTensorData<int8_t>(output))) {
+          break;
+        }
+#endif
         reference_integer_ops::Add(
             op_params, tflite::micro::GetTensorShape(input1),
             tflite::micro::GetTensorData<int8_t>(input1),
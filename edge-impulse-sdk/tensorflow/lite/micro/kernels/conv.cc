@@ -1703,6 +1703,7 @@ limitations under the License.
 
 #if ESP_NN
 #include "edge-impulse-sdk/porting/espressif/ESP-NN/include/esp_nn.h"
+#include "edge-impulse-sdk/porting/espressif/ei_esp_nn_parallel.h"
 #endif
 
 
@@ -1715,9 +1716,157 @@ struct NodeData {
   OpDataConv op_data;
 #if ESP_NN
   int buffer_idx;
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+  ei_esp_nn_row_split_t split;
 #endif
+#endif
+};
+
+#if ESP_NN && EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+struct ConvJob {
+  data_dims_t input_dims;
+  const int8_t* input_data;
+  data_dims_t filter_dims;
+  const int8_t* filter_data;
+  const int32_t* bias_data;
+  data_dims_t output_dims;
+  int8_t* output_data;
+  conv_params_t conv_params;
+  const quant_data_t* quant_data;
+  void* scratch_buf;
+  // worker only, the input window is built on the worker's core
+  const ei_esp_nn_row_split_t* split;
+  const int8_t* full_input_data;
+  int input_width;
+  int pad_width;
+  int8_t* window;
 };
 
+void RunConvJob(void* arg) {
+  ConvJob* job = static_cast<ConvJob*>(arg);
+  if (job->split) {
+    job->input_data = ei_esp_nn_build_window(
+        job->split, job->full_input_data, job->input_width,
+        job->input_dims.channels, job->pad_width,
+        static_cast<int8_t>(-job->conv_params.in_offset), job->window);
+  }
+  esp_nn_set_conv_scratch_buf(job->scratch_buf);
+  esp_nn_conv_s8(&job->input_dims, job->input_data, &job->filter_dims,
+                 job->filter_data, job->bias_data, &job->output_dims,
+                 job->output_data, &job->conv_params, job->quant_data);
+}
+
+// Dimensions the worker runs the kernel with: the padded input window
+// and the bottom output rows, without padding.
+void GetWorkerDims(const ei_esp_nn_row_split_t& split,
+                   const data_dims_t& input_dims, const data_dims_t& output_dims,
+                   const conv_params_t& conv_params,
+                   data_dims_t* worker_input_dims, data_dims_t* worker_output_dims,
+                   conv_params_t* worker_conv_params) {
+  *worker_input_dims = input_dims;
+  worker_input_dims->width = input_dims.width + 2 * conv_params.padding.width;
+  worker_input_dims->height = split.worker_in_rows + split.worker_pad_rows;
+  *worker_output_dims = output_dims;
+  worker_output_dims->height = split.worker_out_rows;
+  *worker_conv_params = conv_params;
+  worker_conv_params->padding = {0, 0};
+}
+
+// Decides whether the node is split across both cores. Grows the arena
+// scratch size if the local half needs more than the whole node, and
+// reserves the worker's scratch (outside of the arena).
+void PlanParallelConv(NodeData* data, const TfLiteConvParams& params,
+                      int batches, const data_dims_t& input_dims,
+                      const data_dims_t& filter_dims,
+                      const data_dims_t& output_dims,
+                      const conv_params_t& conv_params,
+                      int* scratch_buf_size) {
+  ei_esp_nn_row_split_t* split = &data->split;
+  split->split_row = 0;
+  if (batches != 1 || params.dilation_width_factor != 1 ||
+      params.dilation_height_factor != 1) {
+    return;
+  }
+
+  const int64_t macs = static_cast<int64_t>(output_dims.width) *
+                       output_dims.height * output_dims.channels *
+                       filter_dims.width * filter_dims.height *
+                       input_dims.channels;
+  if (!ei_esp_nn_plan_row_split(input_dims.height, output_dims.height,
+                                filter_dims.height, conv_params.stride.height,
+                                conv_params.padding.height, macs, split)) {
+    return;
+  }
+
+  // fewer rows may select another ESP-NN path with other scratch needs
+  data_dims_t local_input_dims = input_dims;
+  local_input_dims.height = split->local_in_rows;
+  data_dims_t local_output_dims = output_dims;
+  local_output_dims.height = split->split_row;
+  const int local_size = esp_nn_get_conv_scratch_size(
+      &local_input_dims, &filter_dims, &local_output_dims, &conv_params);
+  if (local_size > *scratch_buf_size) {
+    *scratch_buf_size = local_size;
+  }
+
+  data_dims_t worker_input_dims, worker_output_dims;
+  conv_params_t worker_conv_params;
+  GetWorkerDims(*split, input_dims, output_dims, conv_params,
+                &worker_input_dims, &worker_output_dims, &worker_conv_params);
+  const size_t window_size = ei_esp_nn_window_size(
+      split, input_dims.width, input_dims.channels, conv_params.padding.width);
+  const size_t worker_size =
+      ((window_size + 15) & ~15) +
+      esp_nn_get_conv_scratch_size(&worker_input_dims, &filter_dims,
+                                   &worker_output_dims, &worker_conv_params);
+  if (!ei_esp_nn_parallel_reserve(worker_size)) {
+    split->split_row = 0;
+  }
+}
+
+// Runs the top rows on this core and the bottom rows on the other one.
+// Returns false (without touching the output) if the worker is unavailable.
+bool EvalParallelConv(const ei_esp_nn_row_split_t& split,
+                      const data_dims_t& input_dims, const int8_t* input_data,
+                      const data_dims_t& filter_dims, const int8_t* filter_data,
+                      const int32_t* bias_data, const data_dims_t& output_dims,
+                      int8_t* output_data, const conv_params_t& conv_params,
+                      const quant_data_t* quant_data, void* scratch_buf) {
+  ConvJob local = {};
+  local.input_dims = input_dims;
+  local.input_dims.height = split.local_in_rows;
+  local.input_data = input_data;
+  local.filter_dims = filter_dims;
+  local.filter_data = filter_data;
+  local.bias_data = bias_data;
+  local.output_dims = output_dims;
+  local.output_dims.height = split.split_row;
+  local.output_data = output_data;
+  local.conv_params = conv_params;
+  local.quant_data = quant_data;
+  local.scratch_buf = scratch_buf;
+
+  ConvJob worker = local;
+  GetWorkerDims(split, input_dims, output_dims, conv_params,
+                &worker.input_dims, &worker.output_dims, &worker.conv_params);
+  worker.output_data = output_data + split.split_row * output_dims.width *
+                                         output_dims.channels;
+  worker.split = &split;
+  worker.full_input_data = input_data;
+  worker.input_width = input_dims.width;
+  worker.pad_width = conv_params.padding.width;
+
+  int8_t* worker_scratch =
+      static_cast<int8_t*>(ei_esp_nn_parallel_scratch());
+  const size_t window_size = ei_esp_nn_window_size(
+      &split, input_dims.width, input_dims.channels, conv_params.padding.width);
+  worker.window = window_size > 0 ? worker_scratch : nullptr;
+  worker.scratch_buf = worker_scratch + ((window_size + 15) & ~15);
+
+  return ei_esp_nn_parallel_run(RunConvJob, &worker, RunConvJob, &local);
+}
+#endif
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
   return context->AllocatePersistentBuffer(context, sizeof(NodeData));
@@ -1805,6 +1954,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
     int scratch_buf_size = esp_nn_get_conv_scratch_size(
         &input_dims, &filter_dims, &output_dims, &conv_params);
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+    PlanParallelConv(data, params, input->dims->data[0], input_dims,
+                     filter_dims, output_dims, conv_params, &scratch_buf_size);
+#endif
     if (scratch_buf_size > 0) {
       TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
         context, scratch_buf_size, &data->buffer_idx));
@@ -1905,6 +2058,17 @@ inline void EvalQuantizedPerChannel(
                                 .mult = data.op_data.per_channel_output_multiplier
                               };
 
+#if EI_CLASSIFIER_TFLITE_ENABLE_ESP_NN_MULTICORE == 1
+    if (batch_size == 1 && data.split.split_row > 0 &&
+        EvalParallelConv(data.split, input_dims, input_data, filter_dims,
+                         tflite::micro::GetTensorData<int8_t>(filter),
+                         tflite::micro::GetTensorData<int32_t>(bias),
+                         output_dims, output_data, conv_params, &quant_data,
+                         scratch_buf)) {
+      return;
+    }
+#endif
+
     for (int i_batch = 0; i_batch < batch_size; i_batch++) {
       esp_nn_conv_s8(&input_dims, input_data + i_batch * input_size,
                      &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
@@ -2059,6 +2223,9 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/portable_tensor_utils.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/conv.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/host_int8_ops.h"
+#endif
 #include "edge-impulse-sdk/tensorflow/lite/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_util.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
@@ -2180,6 +2347,21 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           break;
         }
         case kTfLiteInt8: {
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+          if (optimized_host::ConvPerChannel(
+                  ConvParamsQuantized(params, data),
+                  data.per_channel_output_multiplier,
+                  data.per_channel_output_shift,
+                  tflite::micro::GetTensorShape(input),
+                  tflite::micro::GetTensorData<int8_t>(input),
+                  tflite::micro::GetTensorShape(filter),
+                  tflite::micro::GetTensorData<int8_t>(filter),
+                  tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                  tflite::micro::GetTensorShape(output),
+                  tflite::micro::GetTensorData<int8_t>(output))) {
+            break;
+          }
+#endif
           reference_integer_ops::ConvPerChannel(
               ConvParamsQuantized(params, data),
               data.per_channel_output_multiplier, data.per_channel_output_shift,
@@ -0,0 +1,153 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/memory_plan_cache.h"
+
+#include <cstring>
+
+namespace tflite {
+
+MicroMemoryPlanCache::MicroMemoryPlanCache(uint8_t* buffer,
+                                           size_t buffer_size)
+    : buffer_(buffer), buffer_size_(buffer_size) {
+  Clear();
+}
+
+uint32_t MicroMemoryPlanCache::HashModel(const uint8_t* model,
+                                         size_t model_size) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < model_size; ++i) {
+    hash ^= model[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void MicroMemoryPlanCache::SetModelHash(uint32_t model_hash) {
+  model_hash_ = model_hash;
+  has_model_hash_ = true;
+  if (header() != nullptr && header()->model_hash != model_hash) {
+    Clear();
+  }
+}
+
+bool MicroMemoryPlanCache::Load(const uint8_t* data, size_t size) {
+  Clear();
+  if (data == nullptr || size < sizeof(MemoryPlanCacheHeader) ||
+      size > buffer_size_) {
+    return false;
+  }
+  MemoryPlanCacheHeader loaded;
+  memcpy(&loaded, data, sizeof(loaded));
+  if (loaded.magic != kMagic || loaded.version != kVersion ||
+      size != sizeof(MemoryPlanCacheHeader) +
+                  loaded.buffer_count * sizeof(MemoryPlanCacheEntry) ||
+      (has_model_hash_ && loaded.model_hash != model_hash_)) {
+    return false;
+  }
+  memcpy(buffer_, data, size);
+  return true;
+}
+
+void MicroMemoryPlanCache::Clear() {
+  if (buffer_ != nullptr && buffer_size_ >= sizeof(uint32_t)) {
+    memset(buffer_, 0, sizeof(uint32_t));
+  }
+}
+
+const MemoryPlanCacheHeader* MicroMemoryPlanCache::header() const {
+  if (buffer_ == nullptr || buffer_size_ < sizeof(MemoryPlanCacheHeader)) {
+    return nullptr;
+  }
+  const MemoryPlanCacheHeader* h =
+      reinterpret_cast<const MemoryPlanCacheHeader*>(buffer_);
+  return h->magic == kMagic ? h : nullptr;
+}
+
+bool MicroMemoryPlanCache::IsValid() const {
+  return has_model_hash_ && header() != nullptr &&
+         header()->model_hash == model_hash_;
+}
+
+size_t MicroMemoryPlanCache::size() const {
+  if (header() == nullptr) {
+    return 0;
+  }
+  return sizeof(MemoryPlanCacheHeader) +
+         header()->buffer_count * sizeof(MemoryPlanCacheEntry);
+}
+
+const MemoryPlanCacheEntry* MicroMemoryPlanCache::entries() const {
+  return reinterpret_cast<const MemoryPlanCacheEntry*>(
+      buffer_ + sizeof(MemoryPlanCacheHeader));
+}
+
+bool MicroMemoryPlanCache::BeginRecord(size_t tensor_count,
+                                       size_t scratch_buffer_count,
+                                       size_t buffer_count) {
+  Clear();
+  if (!has_model_hash_ || buffer_ == nullptr ||
+      buffer_size_ < sizeof(MemoryPlanCacheHeader) +
+                         buffer_count * sizeof(MemoryPlanCacheEntry)) {
+    return false;
+  }
+  MemoryPlanCacheHeader* h = reinterpret_cast<MemoryPlanCacheHeader*>(buffer_);
+  h->version = kVersion;
+  h->model_hash = model_hash_;
+  h->tensor_count = tensor_count;
+  h->scratch_buffer_count = scratch_buffer_count;
+  h->buffer_count = buffer_count;
+  h->head_usage = 0;
+  record_index_ = 0;
+  return true;
+}
+
+void MicroMemoryPlanCache::RecordEntry(size_t allocation_index, size_t bytes,
+                                       size_t offset, uint32_t node) {
+  MemoryPlanCacheEntry* entry = reinterpret_cast<MemoryPlanCacheEntry*>(
+      buffer_ + sizeof(MemoryPlanCacheHeader)) + record_index_++;
+  entry->allocation_index = allocation_index;
+  entry->bytes = bytes;
+  entry->offset = offset;
+  entry->node = node;
+}
+
+void MicroMemoryPlanCache::FinishRecord(size_t head_usage) {
+  MemoryPlanCacheHeader* h = reinterpret_cast<MemoryPlanCacheHeader*>(buffer_);
+  h->head_usage = head_usage;
+  // only mark the plan as valid once it's complete
+  h->magic = kMagic;
+}
+
+}  // namespace tflite
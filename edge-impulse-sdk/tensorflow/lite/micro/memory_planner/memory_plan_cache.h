@@ -0,0 +1,124 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MEMORY_PLAN_CACHE_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MEMORY_PLAN_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tflite {
+
+// Serialized layout of a committed memory plan: a header followed by one
+// entry per planned buffer, in allocation info order (all tensors of all
+// subgraphs, then the scratch buffers).
+struct MemoryPlanCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t model_hash;
+  uint32_t tensor_count;
+  uint32_t scratch_buffer_count;
+  uint32_t buffer_count;
+  uint32_t head_usage;
+};
+
+struct MemoryPlanCacheEntry {
+  uint32_t allocation_index;
+  uint32_t bytes;
+  uint32_t offset;
+  // (subgraph << 16) | node that requested a scratch buffer, kNoNode for
+  // tensors
+  uint32_t node;
+};
+
+// Holds the memory plan (head buffer offsets of all non-persistent tensors and
+// scratch buffers) of one model, so MicroAllocator can skip the lifetime
+// analysis and the memory planner on later AllocateTensors() calls. The plan
+// is keyed by a hash of the model flatbuffer and is only used if the tensor
+// and scratch buffer sizes requested by the kernels still match. The
+// serialized form (data() / size()) can be stored, e.g. in flash, and loaded
+// back with Load() after a reboot.
+//
+// The buffer is owned by the caller, has to be 4-byte aligned and must outlive
+// the cache.
+class MicroMemoryPlanCache {
+ public:
+  static constexpr uint32_t kMagic = 0x504d4654;  // "TFMP"
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kNoNode = 0xffffffff;
+
+  MicroMemoryPlanCache(uint8_t* buffer, size_t buffer_size);
+
+  // FNV-1a hash over the model flatbuffer.
+  static uint32_t HashModel(const uint8_t* model, size_t model_size);
+
+  // Sets the hash of the model that's about to be allocated. A stored plan of
+  // another model is dropped.
+  void SetModelHash(uint32_t model_hash);
+
+  // Copies a previously serialized plan into the cache. Returns false (and
+  // leaves the cache empty) if the blob is malformed, doesn't fit, or belongs
+  // to another model than the one set with SetModelHash().
+  bool Load(const uint8_t* data, size_t size);
+
+  // Drops the stored plan.
+  void Clear();
+
+  // True if a plan for the current model is stored.
+  bool IsValid() const;
+
+  // Serialized plan, only meaningful if IsValid().
+  const uint8_t* data() const { return buffer_; }
+  size_t size() const;
+
+  // Used by MicroAllocator.
+  const MemoryPlanCacheHeader* header() const;
+  const MemoryPlanCacheEntry* entries() const;
+  bool BeginRecord(size_t tensor_count, size_t scratch_buffer_count,
+                   size_t buffer_count);
+  void RecordEntry(size_t allocation_index, size_t bytes, size_t offset,
+                   uint32_t node);
+  void FinishRecord(size_t head_usage);
+
+ private:
+  uint8_t* buffer_;
+  size_t buffer_size_;
+  uint32_t model_hash_ = 0;
+  bool has_model_hash_ = false;
+  size_t record_index_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MEMORY_PLAN_CACHE_H_
@@ -828,51 +828,71 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
         subgraph, allocations[subgraph_idx].tensors, offline_planner_offsets));
   }
 
-  TF_LITE_ENSURE_STATUS(
-      builder.InitializeAllocationInfo(offline_planner_offsets, allocations));
+  // A cached plan skips the lifetime analysis and the planner below, the
+  // offline plan from the model metadata always takes precedence.
+  const bool use_plan_cache =
+      memory_plan_cache_ != nullptr && offline_planner_offsets == nullptr;
+  used_cached_memory_plan_ =
+      use_plan_cache && memory_plan_cache_->IsValid() &&
+      ApplyCachedMemoryPlan(model, allocations, scratch_buffer_handles,
+                            &head_usage) == kTfLiteOk;
+
+  if (used_cached_memory_plan_) {
+    builder.FreeAllocationInfo();
+  } else {
+    TF_LITE_ENSURE_STATUS(
+        builder.InitializeAllocationInfo(offline_planner_offsets, allocations));
+
+    internal::ScratchBufferRequest* scratch_buffer_requests =
+        GetScratchBufferRequests();
+    TF_LITE_ENSURE_STATUS(builder.MarkAllocationLifetimes(
+        0, scratch_buffer_requests, scratch_buffer_handles, allocations));
+    int allocation_info_count = builder.AllocationCount();
+    AllocationInfo* allocation_info = builder.Finish();
+
+    // Remaining arena size that memory planner can use for calculating offsets.
+    size_t remaining_arena_size =
+        non_persistent_buffer_allocator_->GetAvailableMemory(
+            MicroArenaBufferAlignment());
+    uint8_t* planner_arena = non_persistent_buffer_allocator_->AllocateTemp(
+        remaining_arena_size, MicroArenaBufferAlignment());
+
+    if (planner_arena == nullptr) {
+      return kTfLiteError;
+    }
 
-  internal::ScratchBufferRequest* scratch_buffer_requests =
-      GetScratchBufferRequests();
-  TF_LITE_ENSURE_STATUS(builder.MarkAllocationLifetimes(
-      0, scratch_buffer_requests, scratch_buffer_handles, allocations));
-  int allocation_info_count = builder.AllocationCount();
-  AllocationInfo* allocation_info = builder.Finish();
-
-  // Remaining arena size that memory planner can use for calculating offsets.
-  size_t remaining_arena_size =
-      non_persistent_buffer_allocator_->GetAvailableMemory(
-          MicroArenaBufferAlignment());
-  uint8_t* planner_arena = non_persistent_buffer_allocator_->AllocateTemp(
-      remaining_arena_size, MicroArenaBufferAlignment());
-
-  if (planner_arena == nullptr) {
-    return kTfLiteError;
-  }
+    memory_planner_->Init(planner_arena, remaining_arena_size);
+    TF_LITE_ENSURE_STATUS(
+        CreatePlan(memory_planner_, allocation_info, allocation_info_count));
 
-  memory_planner_->Init(planner_arena, remaining_arena_size);
-  TF_LITE_ENSURE_STATUS(
-      CreatePlan(memory_planner_, allocation_info, allocation_info_count));
+    // Commit the plan.
+    TF_LITE_ENSURE_STATUS(
+        CommitPlan(memory_planner_,
+                   non_persistent_buffer_allocator_->GetOverlayMemoryAddress(),
+                   allocation_info, allocation_info_count));
 
-  // Commit the plan.
-  TF_LITE_ENSURE_STATUS(
-      CommitPlan(memory_planner_,
-                 non_persistent_buffer_allocator_->GetOverlayMemoryAddress(),
-                 allocation_info, allocation_info_count));
+#ifdef TF_LITE_SHOW_MEMORY_USE
+    memory_planner_->PrintMemoryPlan();
+#endif
+    head_usage = memory_planner_->GetMaximumMemorySize();
+
+    if (use_plan_cache) {
+      RecordMemoryPlan(allocation_info, allocation_info_count,
+                       allocation_info_count - scratch_buffer_request_count_,
+                       head_usage);
+    }
+
+    builder.FreeAllocationInfo();
+    non_persistent_buffer_allocator_->DeallocateTemp(planner_arena);
+  }
 
   // Reset all temp allocations used above:
-  builder.FreeAllocationInfo();
-  non_persistent_buffer_allocator_->DeallocateTemp(planner_arena);
   TF_LITE_ENSURE_STATUS(
       non_persistent_buffer_allocator_->ResetTempAllocations());
   TF_LITE_ENSURE_STATUS(
       non_persistent_buffer_allocator_->DeallocateResizableBuffer(
           scratch_buffer_head_));
 
-#ifdef TF_LITE_SHOW_MEMORY_USE
-  memory_planner_->PrintMemoryPlan();
-#endif
-  head_usage = memory_planner_->GetMaximumMemorySize();
-
   // The head is used to store memory plans for one model at a time during the
   // model preparation stage, and is re-purposed to store scratch buffer handles
   // during model invocation. The head must be as large as the greater of the
@@ -891,6 +911,140 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::ApplyCachedMemoryPlan(
+    const Model* model, SubgraphAllocations* allocations,
+    ScratchBufferHandle* scratch_buffer_handles, size_t* head_usage) {
+  const MemoryPlanCacheHeader* header = memory_plan_cache_->header();
+  const MemoryPlanCacheEntry* entries = memory_plan_cache_->entries();
+  if (header->scratch_buffer_count != scratch_buffer_request_count_ ||
+      header->head_usage >
+          non_persistent_buffer_allocator_->GetAvailableMemory(
+              MicroArenaBufferAlignment())) {
+    return kTfLiteError;
+  }
+
+  // The plan is only valid if exactly the same buffers need allocating, with
+  // the same sizes (kernels may request different scratch buffers than when
+  // the plan was made).
+  size_t entry_idx = 0;
+  size_t allocation_idx = 0;
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    TfLiteEvalTensor* eval_tensors = allocations[subgraph_idx].tensors;
+    for (size_t i = 0; i < subgraph->tensors()->size();
+         ++i, ++allocation_idx) {
+      size_t bytes = 0;
+      TF_LITE_ENSURE_STATUS(
+          TfLiteEvalTensorByteLength(&eval_tensors[i], &bytes));
+      const bool needs_allocating = (eval_tensors[i].data.data == nullptr) &&
+                                    (!subgraph->tensors()->Get(i)->is_variable()) &&
+                                    (bytes != 0);
+      if (!needs_allocating) {
+        continue;
+      }
+      if (entry_idx >= header->buffer_count ||
+          entries[entry_idx].allocation_index != allocation_idx ||
+          entries[entry_idx].bytes != bytes) {
+        return kTfLiteError;
+      }
+      entry_idx++;
+    }
+  }
+  if (allocation_idx != header->tensor_count) {
+    return kTfLiteError;
+  }
+
+  internal::ScratchBufferRequest* scratch_buffer_requests =
+      GetScratchBufferRequests();
+  for (size_t i = 0; i < scratch_buffer_request_count_; i++) {
+    const internal::ScratchBufferRequest& request = scratch_buffer_requests[i];
+    const uint32_t node = (static_cast<uint32_t>(request.subgraph_idx) << 16) |
+                          static_cast<uint32_t>(request.node_idx);
+    if (entry_idx >= header->buffer_count ||
+        entries[entry_idx].allocation_index != header->tensor_count + i ||
+        entries[entry_idx].bytes != request.bytes ||
+        entries[entry_idx].node != node) {
+      return kTfLiteError;
+    }
+    entry_idx++;
+  }
+  if (entry_idx != header->buffer_count) {
+    return kTfLiteError;
+  }
+  for (size_t i = 0; i < header->buffer_count; i++) {
+    if (entries[i].offset +
+            AlignSizeUp(entries[i].bytes, MicroArenaBufferAlignment()) >
+        header->head_usage) {
+      return kTfLiteError;
+    }
+  }
+
+  // Commit the plan.
+  uint8_t* head = non_persistent_buffer_allocator_->GetOverlayMemoryAddress();
+  entry_idx = 0;
+  allocation_idx = 0;
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    TfLiteEvalTensor* eval_tensors = allocations[subgraph_idx].tensors;
+    for (size_t i = 0; i < subgraph->tensors()->size();
+         ++i, ++allocation_idx) {
+      if (entry_idx < header->buffer_count &&
+          entries[entry_idx].allocation_index == allocation_idx) {
+        eval_tensors[i].data.data = head + entries[entry_idx].offset;
+        entry_idx++;
+      }
+    }
+  }
+  for (size_t i = 0; i < scratch_buffer_request_count_; i++) {
+    scratch_buffer_handles[i].data = head + entries[entry_idx].offset;
+    entry_idx++;
+  }
+
+  *head_usage = header->head_usage;
+  return kTfLiteOk;
+}
+
+void MicroAllocator::RecordMemoryPlan(const AllocationInfo* allocation_info,
+                                      size_t allocation_info_count,
+                                      size_t tensor_count, size_t head_usage) {
+  size_t buffer_count = 0;
+  for (size_t i = 0; i < allocation_info_count; ++i) {
+    if (allocation_info[i].needs_allocating) {
+      buffer_count++;
+    }
+  }
+  if (!memory_plan_cache_->BeginRecord(tensor_count,
+                                       allocation_info_count - tensor_count,
+                                       buffer_count)) {
+    MicroPrintf("Memory plan cache too small for %d buffers", buffer_count);
+    return;
+  }
+
+  const uint8_t* head =
+      non_persistent_buffer_allocator_->GetOverlayMemoryAddress();
+  internal::ScratchBufferRequest* scratch_buffer_requests =
+      GetScratchBufferRequests();
+  for (size_t i = 0; i < allocation_info_count; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (!current->needs_allocating) {
+      continue;
+    }
+    uint32_t node = MicroMemoryPlanCache::kNoNode;
+    if (i >= tensor_count) {
+      const internal::ScratchBufferRequest& request =
+          scratch_buffer_requests[i - tensor_count];
+      node = (static_cast<uint32_t>(request.subgraph_idx) << 16) |
+             static_cast<uint32_t>(request.node_idx);
+    }
+    memory_plan_cache_->RecordEntry(
+        i, current->bytes,
+        static_cast<const uint8_t*>(*current->output_ptr) - head, node);
+  }
+  memory_plan_cache_->FinishRecord(head_usage);
+}
+
 TfLiteStatus MicroAllocator::AllocateScratchBufferHandles(
     ScratchBufferHandle** scratch_buffer_handles, size_t handle_count) {
   TFLITE_DCHECK(scratch_buffer_handles != nullptr);
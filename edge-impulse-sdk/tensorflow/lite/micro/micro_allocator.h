@@ -22,6 +22,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/micro/single_arena_buffer_allocator.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/compatibility.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/flatbuffer_utils.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/memory_plan_cache.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/flatbuffer_conversions_bridge.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
@@ -86,6 +87,8 @@ struct SubgraphAllocations {
   TfLiteEvalTensor* tensors;
 };
 
+struct AllocationInfo;
+
 // Allocator responsible for allocating memory for all intermediate tensors
 // necessary to invoke a model.
 //
@@ -228,6 +231,17 @@ class MicroAllocator {
 
   TfLiteBridgeBuiltinDataAllocator* GetBuiltinDataAllocator();
 
+  // Uses (and fills) a cached memory plan in FinishModelAllocation(). If the
+  // cache holds a plan that matches the model, the lifetime analysis and the
+  // memory planner are skipped. Models with an offline memory plan are always
+  // planned from their metadata. Pass nullptr to stop using the cache.
+  void SetMemoryPlanCache(MicroMemoryPlanCache* cache) {
+    memory_plan_cache_ = cache;
+  }
+
+  // Returns true if the last FinishModelAllocation() used a cached plan.
+  bool used_cached_memory_plan() const { return used_cached_memory_plan_; }
+
  protected:
   MicroAllocator(SingleArenaBufferAllocator* memory_allocator,
                  MicroMemoryPlanner* memory_planner);
@@ -281,6 +295,19 @@ class MicroAllocator {
       const Model* model, SubgraphAllocations* allocations,
       ScratchBufferHandle* scratch_buffer_handles);
 
+  // Points the eval tensors and scratch buffer handles at the offsets stored
+  // in memory_plan_cache_. Returns kTfLiteError without touching anything if
+  // the cached plan doesn't match the buffers the model needs.
+  TfLiteStatus ApplyCachedMemoryPlan(const Model* model,
+                                     SubgraphAllocations* allocations,
+                                     ScratchBufferHandle* scratch_buffer_handles,
+                                     size_t* head_usage);
+
+  // Stores the plan that was just committed in memory_plan_cache_.
+  void RecordMemoryPlan(const AllocationInfo* allocation_info,
+                        size_t allocation_info_count, size_t tensor_count,
+                        size_t head_usage);
+
   // Allocates an array of ScratchBufferHandle structs in the tail section for a
   // given number of handles.
   virtual TfLiteStatus AllocateScratchBufferHandles(
@@ -318,6 +345,9 @@ class MicroAllocator {
   // to ensure that multi-tenant allocations can share the head for buffers.
   size_t max_head_buffer_usage_ = 0;
 
+  MicroMemoryPlanCache* memory_plan_cache_ = nullptr;
+  bool used_cached_memory_plan_ = false;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -164,6 +164,18 @@ class MicroInterpreter {
   // arena_used_bytes() + 16.
   size_t arena_used_bytes() const { return allocator_.used_bytes(); }
 
+  // Lets AllocateTensors() reuse (or record) the memory plan in `cache`
+  // instead of planning the arena from scratch, see MicroMemoryPlanCache.
+  // Needs to be called before AllocateTensors().
+  void SetMemoryPlanCache(MicroMemoryPlanCache* cache) {
+    allocator_.SetMemoryPlanCache(cache);
+  }
+
+  // Returns true if AllocateTensors() used the cached memory plan.
+  bool used_cached_memory_plan() const {
+    return allocator_.used_cached_memory_plan();
+  }
+
  protected:
   const MicroAllocator& allocator() const { return allocator_; }
   const TfLiteContext& context() const { return context_; }
@@ -0,0 +1,2235 @@
+#include "app_benchmark.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/classifier/ei_constants.h"
+#include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
+#include "edge-impulse-sdk/classifier/inferencing_engines/anomaly_kmeans.h"
+#include "edge-impulse-sdk/dsp/fft/ei_rfft.h"
+#include "edge-impulse-sdk/dsp/filter/ei_filter_bank.h"
+#include "edge-impulse-sdk/dsp/image/processing.hpp"
+#include "edge-impulse-sdk/dsp/spectral/filters.hpp"
+#include "edge-impulse-sdk/dsp/spectral/wavelet.hpp"
+#include "edge-impulse-sdk/dsp/speechpy/feature_fixed.h"
+#include "edge-impulse-sdk/dsp/speechpy/sparse_filterbank.h"
+#include "edge-impulse-sdk/dsp/kissfft/kiss_fftr.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/quantization_util.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/optimized/host_int8_ops.h"
+#include "tflite-model/tflite_learn_66_compiled.h"
+#endif
+#if defined(ESP_NN)
+#include "edge-impulse-sdk/porting/espressif/ESP-NN/include/esp_nn.h"
+#endif
+
+// every layer variant runs for at least this long (and at most 100 times)
+#define BENCHMARK_MIN_TIME_US   200000
+#define BENCHMARK_MAX_RUNS      100
+
+typedef enum {
+    BENCH_CONV,
+    BENCH_DEPTHWISE,
+    BENCH_ADD
+} bench_op_t;
+
+typedef enum {
+    BENCH_ACT_NONE,
+    BENCH_ACT_RELU,
+    BENCH_ACT_RELU6
+} bench_act_t;
+
+typedef struct {
+    int node;           // node index in tflite_learn_66
+    bench_op_t op;
+    int in_h, in_w, in_c;
+    int out_h, out_w, out_c;
+    int filter;         // square filter size
+    int stride;
+    int pad;            // top/left padding as computed by TFLM for the node
+    bench_act_t act;
+} bench_layer_t;
+
+// The compute nodes of tflite_learn_66 (FOMO MobileNetV2 0.1, 160x160x3 input), taken from
+// tensorData[] and the builtin data of tflNodes[] in tflite-model/tflite_learn_66_compiled.cpp.
+// PAD and SOFTMAX nodes are left out.
+static const bench_layer_t model_layers[] = {
+    {  0, BENCH_CONV,      160, 160,  3, 80, 80, 16, 3, 2, 0, BENCH_ACT_RELU6 },
+    {  1, BENCH_DEPTHWISE,  80,  80, 16, 80, 80, 16, 3, 1, 1, BENCH_ACT_RELU6 },
+    {  2, BENCH_CONV,       80,  80, 16, 80, 80,  8, 1, 1, 0, BENCH_ACT_NONE },
+    {  3, BENCH_CONV,       80,  80,  8, 80, 80, 48, 1, 1, 0, BENCH_ACT_RELU6 },
+    {  5, BENCH_DEPTHWISE,  81,  81, 48, 40, 40, 48, 3, 2, 0, BENCH_ACT_RELU6 },
+    {  6, BENCH_CONV,       40,  40, 48, 40, 40,  8, 1, 1, 0, BENCH_ACT_NONE },
+    {  7, BENCH_CONV,       40,  40,  8, 40, 40, 48, 1, 1, 0, BENCH_ACT_RELU6 },
+    {  8, BENCH_DEPTHWISE,  40,  40, 48, 40, 40, 48, 3, 1, 1, BENCH_ACT_RELU6 },
+    {  9, BENCH_CONV,       40,  40, 48, 40, 40,  8, 1, 1, 0, BENCH_ACT_NONE },
+    { 10, BENCH_ADD,        40,  40,  8, 40, 40,  8, 0, 0, 0, BENCH_ACT_NONE },
+    { 11, BENCH_CONV,       40,  40,  8, 40, 40, 48, 1, 1, 0, BENCH_ACT_RELU6 },
+    { 13, BENCH_DEPTHWISE,  41,  41, 48, 20, 20, 48, 3, 2, 0, BENCH_ACT_RELU6 },
+    { 14, BENCH_CONV,       20,  20, 48, 20, 20, 16, 1, 1, 0, BENCH_ACT_NONE },
+    { 15, BENCH_CONV,       20,  20, 16, 20, 20, 96, 1, 1, 0, BENCH_ACT_RELU6 },
+    { 16, BENCH_DEPTHWISE,  20,  20, 96, 20, 20, 96, 3, 1, 1, BENCH_ACT_RELU6 },
+    { 17, BENCH_CONV,       20,  20, 96, 20, 20, 16, 1, 1, 0, BENCH_ACT_NONE },
+    { 18, BENCH_ADD,        20,  20, 16, 20, 20, 16, 0, 0, 0, BENCH_ACT_NONE },
+    { 19, BENCH_CONV,       20,  20, 16, 20, 20, 96, 1, 1, 0, BENCH_ACT_RELU6 },
+    { 20, BENCH_DEPTHWISE,  20,  20, 96, 20, 20, 96, 3, 1, 1, BENCH_ACT_RELU6 },
+    { 21, BENCH_CONV,       20,  20, 96, 20, 20, 16, 1, 1, 0, BENCH_ACT_NONE },
+    { 22, BENCH_ADD,        20,  20, 16, 20, 20, 16, 0, 0, 0, BENCH_ACT_NONE },
+    { 23, BENCH_CONV,       20,  20, 16, 20, 20, 96, 1, 1, 0, BENCH_ACT_RELU6 },
+    { 24, BENCH_CONV,       20,  20, 96, 20, 20, 32, 1, 1, 0, BENCH_ACT_RELU },
+    { 25, BENCH_CONV,       20,  20, 32, 20, 20,  3, 1, 1, 0, BENCH_ACT_NONE },
+};
+
+// randomized tensors and quantization parameters of a single layer
+typedef struct {
+    const bench_layer_t *layer;
+    int8_t *input;
+    int8_t *input2;     // second ADD operand
+    int8_t *filter;
+    int32_t *bias;
+    int32_t *multiplier;
+    int32_t *shift;
+    int32_t input_offset;
+    int32_t output_offset;
+    int32_t act_min;
+    int32_t act_max;
+    tflite::ArithmeticParams add_params;
+} bench_data_t;
+
+typedef bool (*bench_run_fn)(const bench_data_t *data, int8_t *output);
+
+typedef struct {
+    const char *name;
+    bench_run_fn run;
+} bench_variant_t;
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t rng_next()
+{
+    // xorshift32, reproducible on every platform
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int32_t rng_range(int32_t min, int32_t max)
+{
+    return min + (int32_t)(rng_next() % (uint32_t)(max - min + 1));
+}
+
+static void rng_fill(int8_t *buf, size_t size)
+{
+    for (size_t ix = 0; ix < size; ix++) {
+        buf[ix] = (int8_t)rng_next();
+    }
+}
+
+/**
+ * Time a benchmarked operation: one warm-up run, then as many runs as fit in
+ * BENCHMARK_MIN_TIME_US, between 1 and max_runs
+ * @param run Returns false if the operation can't run (e.g. an unsupported variant)
+ * @returns Average time per run in ns, 0 if the warm-up run failed
+ */
+template <typename F>
+static uint64_t bench_time_ns(F run, uint32_t max_runs = BENCHMARK_MAX_RUNS)
+{
+    uint64_t start = ei_read_timer_us();
+    if (!run()) {
+        return 0;
+    }
+    uint64_t first_us = ei_read_timer_us() - start;
+
+    uint32_t runs = first_us > 0 ? (uint32_t)(BENCHMARK_MIN_TIME_US / first_us) : max_runs;
+    if (runs < 1) {
+        runs = 1;
+    }
+    if (runs > max_runs) {
+        runs = max_runs;
+    }
+
+    start = ei_read_timer_us();
+    for (uint32_t ix = 0; ix < runs; ix++) {
+        run();
+    }
+    uint64_t avg_ns = (ei_read_timer_us() - start) * 1000 / runs;
+    return avg_ns > 0 ? avg_ns : 1;
+}
+
+// average time per run in us, at least 1 so 0 still means the run failed
+template <typename F>
+static uint64_t bench_time_us(F run, uint32_t max_runs = BENCHMARK_MAX_RUNS)
+{
+    uint64_t avg_ns = bench_time_ns(run, max_runs);
+    return avg_ns == 0 ? 0 : avg_ns < 1000 ? 1 : avg_ns / 1000;
+}
+
+/**
+ * The buffers of one benchmark, zero filled, freed together when the set goes
+ * out of scope. ok() tells whether all of them were allocated.
+ */
+class bench_buffers {
+public:
+    ~bench_buffers()
+    {
+        for (size_t ix = 0; ix < count; ix++) {
+            ei_free(buffers[ix]);
+        }
+    }
+
+    template <typename T>
+    T *alloc(size_t elements)
+    {
+        void *ptr = NULL;
+        if (count < sizeof(buffers) / sizeof(buffers[0])) {
+            ptr = ei_calloc(elements > 0 ? elements : 1, sizeof(T));
+        }
+        if (ptr) {
+            buffers[count++] = ptr;
+        }
+        else {
+            failed = true;
+        }
+        return (T *)ptr;
+    }
+
+    bool ok() const
+    {
+        return !failed;
+    }
+
+private:
+    void *buffers[10] = { };
+    size_t count = 0;
+    bool failed = false;
+};
+
+static size_t input_size(const bench_layer_t *l)
+{
+    return (size_t)l->in_h * l->in_w * l->in_c;
+}
+
+static size_t output_size(const bench_layer_t *l)
+{
+    return (size_t)l->out_h * l->out_w * l->out_c;
+}
+
+static size_t filter_size(const bench_layer_t *l)
+{
+    switch (l->op) {
+        case BENCH_CONV: return (size_t)l->out_c * l->filter * l->filter * l->in_c;
+        case BENCH_DEPTHWISE: return (size_t)l->filter * l->filter * l->in_c;
+        default: return 0;
+    }
+}
+
+static uint64_t layer_macs(const bench_layer_t *l)
+{
+    switch (l->op) {
+        case BENCH_CONV: return (uint64_t)output_size(l) * l->filter * l->filter * l->in_c;
+        case BENCH_DEPTHWISE: return (uint64_t)output_size(l) * l->filter * l->filter;
+        default: return output_size(l);
+    }
+}
+
+static tflite::RuntimeShape shape4(int d0, int d1, int d2, int d3)
+{
+    const int32_t dims[4] = { d0, d1, d2, d3 };
+    return tflite::RuntimeShape(4, dims);
+}
+
+static bool bench_data_init(const bench_layer_t *l, bench_data_t *data)
+{
+    memset(data, 0, sizeof(bench_data_t));
+    data->layer = l;
+    data->input = (int8_t *)ei_malloc(input_size(l));
+    data->input2 = l->op == BENCH_ADD ? (int8_t *)ei_malloc(input_size(l)) : nullptr;
+    data->filter = l->op != BENCH_ADD ? (int8_t *)ei_malloc(filter_size(l)) : nullptr;
+    data->bias = (int32_t *)ei_malloc(l->out_c * sizeof(int32_t));
+    data->multiplier = (int32_t *)ei_malloc(l->out_c * sizeof(int32_t));
+    data->shift = (int32_t *)ei_malloc(l->out_c * sizeof(int32_t));
+    if (!data->input || (l->op == BENCH_ADD && !data->input2) ||
+        (l->op != BENCH_ADD && !data->filter) || !data->bias || !data->multiplier || !data->shift) {
+        return false;
+    }
+
+    rng_fill(data->input, input_size(l));
+    if (data->input2) {
+        rng_fill(data->input2, input_size(l));
+    }
+    if (data->filter) {
+        rng_fill(data->filter, filter_size(l));
+        // symmetric int8 weights, like the converter produces
+        for (size_t ix = 0; ix < filter_size(l); ix++) {
+            if (data->filter[ix] == -128) {
+                data->filter[ix] = -127;
+            }
+        }
+    }
+
+    const int taps = l->op == BENCH_CONV ? l->filter * l->filter * l->in_c : l->filter * l->filter;
+    for (int ix = 0; ix < l->out_c; ix++) {
+        data->bias[ix] = rng_range(-2000, 2000) * 8;
+        // effective scale keeps the accumulator spread over the int8 output range
+        const double scale = (double)rng_range(50, 400) / (10000.0 * (taps > 0 ? taps : 1));
+        int shift;
+        tflite::QuantizeMultiplier(scale, &data->multiplier[ix], &shift);
+        data->shift[ix] = shift;
+    }
+
+    data->input_offset = rng_range(-127, 128);
+    if (l->act == BENCH_ACT_NONE) {
+        data->output_offset = rng_range(-20, 20);
+        data->act_min = -128;
+        data->act_max = 127;
+    }
+    else {
+        data->output_offset = -128;
+        data->act_min = -128;
+        data->act_max = 127;
+    }
+
+    if (l->op == BENCH_ADD) {
+        // same derivation as PrepareAdd() in the TFLM ADD kernel
+        tflite::ArithmeticParams *p = &data->add_params;
+        const double input1_scale = rng_range(10, 100) / 1000.0;
+        const double input2_scale = rng_range(10, 100) / 1000.0;
+        const double output_scale = rng_range(20, 200) / 1000.0;
+        const double twice_max_input_scale = 2 * (input1_scale > input2_scale ? input1_scale : input2_scale);
+        p->left_shift = 20;
+        p->input1_offset = data->input_offset;
+        p->input2_offset = rng_range(-127, 128);
+        p->output_offset = data->output_offset;
+        tflite::QuantizeMultiplierSmallerThanOneExp(input1_scale / twice_max_input_scale,
+            &p->input1_multiplier, &p->input1_shift);
+        tflite::QuantizeMultiplierSmallerThanOneExp(input2_scale / twice_max_input_scale,
+            &p->input2_multiplier, &p->input2_shift);
+        tflite::QuantizeMultiplierSmallerThanOneExp(
+            twice_max_input_scale / ((1 << p->left_shift) * output_scale),
+            &p->output_multiplier, &p->output_shift);
+        p->quantized_activation_min = data->act_min;
+        p->quantized_activation_max = data->act_max;
+    }
+    return true;
+}
+
+static void bench_data_free(bench_data_t *data)
+{
+    ei_free(data->input);
+    ei_free(data->input2);
+    ei_free(data->filter);
+    ei_free(data->bias);
+    ei_free(data->multiplier);
+    ei_free(data->shift);
+}
+
+static tflite::ConvParams conv_params(const bench_data_t *data)
+{
+    const bench_layer_t *l = data->layer;
+    tflite::ConvParams params = {};
+    params.input_offset = data->input_offset;
+    params.output_offset = data->output_offset;
+    params.stride_width = l->stride;
+    params.stride_height = l->stride;
+    params.dilation_width_factor = 1;
+    params.dilation_height_factor = 1;
+    params.padding_values.width = l->pad;
+    params.padding_values.height = l->pad;
+    params.quantized_activation_min = data->act_min;
+    params.quantized_activation_max = data->act_max;
+    return params;
+}
+
+static tflite::DepthwiseParams depthwise_params(const bench_data_t *data)
+{
+    const bench_layer_t *l = data->layer;
+    tflite::DepthwiseParams params = {};
+    params.input_offset = data->input_offset;
+    params.output_offset = data->output_offset;
+    params.stride_width = l->stride;
+    params.stride_height = l->stride;
+    params.dilation_width_factor = 1;
+    params.dilation_height_factor = 1;
+    params.padding_values.width = l->pad;
+    params.padding_values.height = l->pad;
+    params.depth_multiplier = 1;
+    params.quantized_activation_min = data->act_min;
+    params.quantized_activation_max = data->act_max;
+    return params;
+}
+
+static bool run_reference(const bench_data_t *data, int8_t *output)
+{
+    const bench_layer_t *l = data->layer;
+    const tflite::RuntimeShape input_shape = shape4(1, l->in_h, l->in_w, l->in_c);
+    const tflite::RuntimeShape output_shape = shape4(1, l->out_h, l->out_w, l->out_c);
+    const int32_t bias_dims[1] = { l->out_c };
+    const tflite::RuntimeShape bias_shape(1, bias_dims);
+
+    switch (l->op) {
+        case BENCH_CONV:
+            tflite::reference_integer_ops::ConvPerChannel(conv_params(data),
+                data->multiplier, data->shift, input_shape, data->input,
+                shape4(l->out_c, l->filter, l->filter, l->in_c), data->filter,
+                bias_shape, data->bias, output_shape, output);
+            return true;
+        case BENCH_DEPTHWISE:
+            tflite::reference_integer_ops::DepthwiseConvPerChannel(depthwise_params(data),
+                data->multiplier, data->shift, input_shape, data->input,
+                shape4(1, l->filter, l->filter, l->out_c), data->filter,
+                bias_shape, data->bias, output_shape, output);
+            return true;
+        case BENCH_ADD:
+            tflite::reference_integer_ops::Add(data->add_params, input_shape, data->input,
+                input_shape, data->input2, output_shape, output);
+            return true;
+    }
+    return false;
+}
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+static bool run_host_simd(const bench_data_t *data, int8_t *output)
+{
+    const bench_layer_t *l = data->layer;
+    const tflite::RuntimeShape input_shape = shape4(1, l->in_h, l->in_w, l->in_c);
+    const tflite::RuntimeShape output_shape = shape4(1, l->out_h, l->out_w, l->out_c);
+
+    switch (l->op) {
+        case BENCH_CONV:
+            return tflite::optimized_host::ConvPerChannel(conv_params(data),
+                data->multiplier, data->shift, input_shape, data->input,
+                shape4(l->out_c, l->filter, l->filter, l->in_c), data->filter,
+                data->bias, output_shape, output);
+        case BENCH_DEPTHWISE:
+            return tflite::optimized_host::DepthwiseConvPerChannel(depthwise_params(data),
+                data->multiplier, data->shift, input_shape, data->input,
+                shape4(1, l->filter, l->filter, l->out_c), data->filter,
+                data->bias, output_shape, output);
+        case BENCH_ADD:
+            return tflite::optimized_host::Add(data->add_params, input_shape, data->input,
+                input_shape, data->input2, output_shape, output);
+    }
+    return false;
+}
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+
+#if defined(ESP_NN)
+typedef void (*esp_nn_conv_fn)(const data_dims_t *, const int8_t *, const data_dims_t *,
+    const int8_t *, const int32_t *, const data_dims_t *, int8_t *, const conv_params_t *,
+    const quant_data_t *);
+typedef void (*esp_nn_dw_conv_fn)(const data_dims_t *, const int8_t *, const data_dims_t *,
+    const int8_t *, const int32_t *, const data_dims_t *, int8_t *, const dw_conv_params_t *,
+    const quant_data_t *);
+typedef int (*esp_nn_conv_scratch_size_fn)(const data_dims_t *, const data_dims_t *,
+    const data_dims_t *, const conv_params_t *);
+typedef int (*esp_nn_dw_conv_scratch_size_fn)(const data_dims_t *, const data_dims_t *,
+    const data_dims_t *, const dw_conv_params_t *);
+typedef void (*esp_nn_set_scratch_fn)(const void *);
+typedef void (*esp_nn_add_fn)(const int8_t *, const int8_t *, const int32_t, const int32_t,
+    const int32_t, const int32_t, const int32_t, const int32_t, const int32_t, int8_t *,
+    const int32_t, const int32_t, const int32_t, const int32_t, const int32_t, const int32_t);
+
+typedef struct {
+    esp_nn_conv_fn conv;
+    esp_nn_conv_scratch_size_fn conv_scratch_size;
+    esp_nn_set_scratch_fn conv_set_scratch;
+    esp_nn_dw_conv_fn dw_conv;
+    esp_nn_dw_conv_scratch_size_fn dw_conv_scratch_size;
+    esp_nn_set_scratch_fn dw_conv_set_scratch;
+    esp_nn_add_fn add;  // NULL if the flavour has no ADD of its own
+} esp_nn_flavour_t;
+
+static const esp_nn_flavour_t esp_nn_ansi = {
+    esp_nn_conv_s8_ansi, esp_nn_get_conv_scratch_size_ansi, esp_nn_set_conv_scratch_buf_ansi,
+    esp_nn_depthwise_conv_s8_ansi, esp_nn_get_depthwise_conv_scratch_size_ansi,
+    esp_nn_set_depthwise_conv_scratch_buf_ansi, esp_nn_add_elementwise_s8_ansi
+};
+
+static const esp_nn_flavour_t esp_nn_opt = {
+    esp_nn_conv_s8_opt, esp_nn_get_conv_scratch_size_opt, esp_nn_set_conv_scratch_buf_opt,
+    esp_nn_depthwise_conv_s8_opt, esp_nn_get_depthwise_conv_scratch_size_opt,
+    esp_nn_set_depthwise_conv_scratch_buf_opt, NULL
+};
+
+#if defined(ARCH_ESP32_S3) || defined(ARCH_ESP32_P4)
+// what the TFLM kernels call on this chip (assembly kernels on the S3)
+static const esp_nn_flavour_t esp_nn_chip = {
+    esp_nn_conv_s8, esp_nn_get_conv_scratch_size, esp_nn_set_conv_scratch_buf,
+    esp_nn_depthwise_conv_s8, esp_nn_get_depthwise_conv_scratch_size,
+    esp_nn_set_depthwise_conv_scratch_buf, esp_nn_add_elementwise_s8
+};
+#endif
+
+// ESP-NN scratch of the layer being timed, allocated on the first run and freed after the layer
+static void *esp_nn_scratch = NULL;
+
+static bool run_esp_nn(const esp_nn_flavour_t *flavour, const bench_data_t *data, int8_t *output)
+{
+    const bench_layer_t *l = data->layer;
+    const data_dims_t input_dims = { l->in_w, l->in_h, l->in_c, 1 };
+    const data_dims_t output_dims = { l->out_w, l->out_h, l->out_c, 1 };
+    const data_dims_t filter_dims = { l->filter, l->filter, 0, 0 };
+    const quant_data_t quant_data = { data->shift, data->multiplier };
+
+    switch (l->op) {
+        case BENCH_CONV: {
+            const conv_params_t params = {
+                data->input_offset, data->output_offset, { l->stride, l->stride },
+                { l->pad, l->pad }, { 1, 1 }, { data->act_min, data->act_max }
+            };
+            if (!esp_nn_scratch) {
+                const int size = flavour->conv_scratch_size(&input_dims, &filter_dims,
+                    &output_dims, &params);
+                esp_nn_scratch = ei_malloc(size > 0 ? size : 16);
+                if (!esp_nn_scratch) {
+                    return false;
+                }
+            }
+            flavour->conv_set_scratch(esp_nn_scratch);
+            flavour->conv(&input_dims, data->input, &filter_dims, data->filter, data->bias,
+                &output_dims, output, &params, &quant_data);
+            return true;
+        }
+        case BENCH_DEPTHWISE: {
+            const dw_conv_params_t params = {
+                data->input_offset, data->output_offset, 1, { l->stride, l->stride },
+                { l->pad, l->pad }, { 1, 1 }, { data->act_min, data->act_max }
+            };
+            if (!esp_nn_scratch) {
+                const int size = flavour->dw_conv_scratch_size(&input_dims, &filter_dims,
+                    &output_dims, &params);
+                esp_nn_scratch = ei_malloc(size > 0 ? size : 16);
+                if (!esp_nn_scratch) {
+                    return false;
+                }
+            }
+            flavour->dw_conv_set_scratch(esp_nn_scratch);
+            flavour->dw_conv(&input_dims, data->input, &filter_dims, data->filter, data->bias,
+                &output_dims, output, &params, &quant_data);
+            return true;
+        }
+        case BENCH_ADD: {
+            if (!flavour->add) {
+                return false;
+            }
+            const tflite::ArithmeticParams *p = &data->add_params;
+            flavour->add(data->input, data->input2, p->input1_offset, p->input2_offset,
+                p->input1_multiplier, p->input2_multiplier, p->input1_shift, p->input2_shift,
+                p->left_shift, output, p->output_offset, p->output_multiplier, p->output_shift,
+                p->quantized_activation_min, p->quantized_activation_max,
+                (int32_t)input_size(l));
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool run_esp_nn_ansi(const bench_data_t *data, int8_t *output)
+{
+    return run_esp_nn(&esp_nn_ansi, data, output);
+}
+
+static bool run_esp_nn_opt(const bench_data_t *data, int8_t *output)
+{
+    return run_esp_nn(&esp_nn_opt, data, output);
+}
+
+#if defined(ARCH_ESP32_S3) || defined(ARCH_ESP32_P4)
+static bool run_esp_nn_chip(const bench_data_t *data, int8_t *output)
+{
+    return run_esp_nn(&esp_nn_chip, data, output);
+}
+#endif
+#endif // ESP_NN
+
+// the reference kernel has to be first, the others are checked against it
+static const bench_variant_t variants[] = {
+    { "reference", run_reference },
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+    { "host-simd", run_host_simd },
+#endif
+#if defined(ESP_NN)
+    { "esp-nn-ansi", run_esp_nn_ansi },
+    { "esp-nn-opt", run_esp_nn_opt },
+#if defined(ARCH_ESP32_S3)
+    { "esp-nn-s3", run_esp_nn_chip },
+#elif defined(ARCH_ESP32_P4)
+    { "esp-nn-p4", run_esp_nn_chip },
+#endif
+#endif // ESP_NN
+};
+
+#define VARIANT_COUNT (sizeof(variants) / sizeof(variants[0]))
+
+static const char *op_name(bench_op_t op)
+{
+    switch (op) {
+        case BENCH_CONV: return "CONV_2D";
+        case BENCH_DEPTHWISE: return "DEPTHWISE_CONV_2D";
+        case BENCH_ADD: return "ADD";
+    }
+    return "?";
+}
+
+/**
+ * Time one variant on one layer
+ * @returns average time per run in us, 0 if the variant doesn't support the layer
+ */
+static uint64_t time_variant(const bench_variant_t *variant, const bench_data_t *data, int8_t *output)
+{
+    return bench_time_us([&]() { return variant->run(data, output); });
+}
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+#define HOST_SIMD_CASES         300
+
+static const char *host_simd_isas[] = { "avx2", "sse4.1", "neon" };
+
+// Random CONV_2D / DEPTHWISE_CONV_2D / ADD geometry, odd channel counts and small
+// images included, so the vector tails and the padded borders get exercised
+static void host_simd_random_layer(bench_layer_t *l)
+{
+    static const int filters[] = { 1, 3, 5 };
+
+    memset(l, 0, sizeof(bench_layer_t));
+    l->node = -1;
+    l->op = (bench_op_t)rng_range(BENCH_CONV, BENCH_ADD);
+    l->act = (bench_act_t)rng_range(BENCH_ACT_NONE, BENCH_ACT_RELU6);
+    l->in_c = rng_range(1, 70);
+
+    if (l->op == BENCH_ADD) {
+        l->in_h = rng_range(1, 24);
+        l->in_w = rng_range(1, 24);
+        l->out_h = l->in_h;
+        l->out_w = l->in_w;
+        l->out_c = l->in_c;
+        return;
+    }
+
+    l->filter = filters[rng_range(0, 2)];
+    l->stride = rng_range(1, 2);
+    l->pad = rng_range(0, l->filter / 2);
+    l->in_h = rng_range(l->filter, 24);
+    l->in_w = rng_range(l->filter, 24);
+    l->out_h = (l->in_h + 2 * l->pad - l->filter) / l->stride + 1;
+    l->out_w = (l->in_w + 2 * l->pad - l->filter) / l->stride + 1;
+    l->out_c = l->op == BENCH_CONV ? rng_range(1, 70) : l->in_c;
+}
+
+/**
+ * Correctness harness of the host SIMD kernels: every instruction set the CPU
+ * supports runs the same randomized layers as the reference kernels, and the
+ * outputs must match byte for byte.
+ */
+static void benchmark_host_simd_harness()
+{
+    const char *detected = tflite::optimized_host::SimdName();
+
+    ei_printf("Host SIMD correctness, %u random layers per instruction set (detected: %s)\n",
+        (unsigned)HOST_SIMD_CASES, detected);
+    ei_printf("isa      cases  fallback  mismatches  check\n");
+
+    for (size_t isa = 0; isa < sizeof(host_simd_isas) / sizeof(host_simd_isas[0]); isa++) {
+        if (!tflite::optimized_host::SelectSimd(host_simd_isas[isa])) {
+            continue;
+        }
+
+        // same layers for every instruction set
+        rng_state = 0x2545f491;
+        uint32_t fallback = 0;
+        uint32_t mismatches = 0;
+
+        for (uint32_t ix = 0; ix < HOST_SIMD_CASES; ix++) {
+            bench_layer_t l;
+            host_simd_random_layer(&l);
+
+            bench_buffers buffers;
+            bench_data_t data;
+            int8_t *expected = buffers.alloc<int8_t>(output_size(&l));
+            int8_t *output = buffers.alloc<int8_t>(output_size(&l));
+            if (!bench_data_init(&l, &data) || !buffers.ok()) {
+                ei_printf("ERR: Failed to allocate buffers for the host SIMD harness\n");
+                bench_data_free(&data);
+                tflite::optimized_host::SelectSimd(detected);
+                return;
+            }
+
+            run_reference(&data, expected);
+            if (!run_host_simd(&data, output)) {
+                fallback++;
+            }
+            else if (memcmp(expected, output, output_size(&l)) != 0) {
+                mismatches++;
+            }
+            bench_data_free(&data);
+        }
+
+        ei_printf("%-8s %5u  %8u  %10u  %s\n", host_simd_isas[isa], (unsigned)HOST_SIMD_CASES,
+            (unsigned)fallback, (unsigned)mismatches, mismatches == 0 ? "ok" : "MISMATCH");
+    }
+
+    tflite::optimized_host::SelectSimd(detected);
+}
+
+// tflite_learn_66_init() wants an aligned allocation, tflite_learn_66_reset() frees it
+static void *eon_aligned_alloc(size_t alignment, size_t size)
+{
+    uint8_t *raw = (uint8_t *)ei_malloc(size + alignment + sizeof(void *));
+    if (!raw) {
+        return NULL;
+    }
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void *) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void **)aligned)[-1] = raw;
+    return (void *)aligned;
+}
+
+static void eon_aligned_free(void *ptr)
+{
+    if (ptr) {
+        ei_free(((void **)ptr)[-1]);
+    }
+}
+
+/**
+ * Whole model throughput: the EON compiled tflite_learn_66 on a random input,
+ * with the reference kernels and with every supported instruction set. The
+ * outputs are compared with the reference run. Must not run while the
+ * classifier has the model initialized.
+ */
+static void benchmark_host_simd_model()
+{
+    const char *detected = tflite::optimized_host::SimdName();
+
+    if (tflite_learn_66_init(eon_aligned_alloc) != kTfLiteOk) {
+        ei_printf("ERR: Failed to initialize tflite_learn_66\n");
+        return;
+    }
+
+    TfLiteTensor input;
+    TfLiteTensor output;
+    tflite_learn_66_input(0, &input);
+    tflite_learn_66_output(0, &output);
+
+    bench_buffers buffers;
+    int8_t *frame = buffers.alloc<int8_t>(input.bytes);
+    int8_t *expected = buffers.alloc<int8_t>(output.bytes);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate model buffers\n");
+        tflite_learn_66_reset(eon_aligned_free);
+        return;
+    }
+
+    rng_state = 0x2545f491;
+    rng_fill(frame, input.bytes);
+
+    // the arena reuses the input tensor for later activations, so refill it every run
+    auto invoke = [&]() {
+        memcpy(input.data.int8, frame, input.bytes);
+        return tflite_learn_66_invoke() == kTfLiteOk;
+    };
+
+    ei_printf("Model throughput, tflite_learn_66 (EON) on a random input\n");
+    ei_printf("isa       time_us  frames/s  speedup  check\n");
+
+    tflite::optimized_host::SelectSimd("none");
+    const uint64_t reference_us = bench_time_us(invoke, 20);
+    if (reference_us == 0) {
+        ei_printf("ERR: Failed to invoke tflite_learn_66\n");
+        tflite::optimized_host::SelectSimd(detected);
+        tflite_learn_66_reset(eon_aligned_free);
+        return;
+    }
+    memcpy(expected, output.data.int8, output.bytes);
+    ei_printf("%-8s %8llu %9.1f  %6.2fx  ref\n", "none", (unsigned long long)reference_us,
+        1000000.0 / (double)reference_us, 1.0);
+
+    for (size_t isa = 0; isa < sizeof(host_simd_isas) / sizeof(host_simd_isas[0]); isa++) {
+        if (!tflite::optimized_host::SelectSimd(host_simd_isas[isa])) {
+            continue;
+        }
+        memset(output.data.int8, 0, output.bytes);
+        const uint64_t us = bench_time_us(invoke, 20);
+        const bool match = us > 0 && memcmp(expected, output.data.int8, output.bytes) == 0;
+        ei_printf("%-8s %8llu %9.1f  %6.2fx  %s\n", host_simd_isas[isa], (unsigned long long)us,
+            us > 0 ? 1000000.0 / (double)us : 0.0, us > 0 ? (double)reference_us / (double)us : 0.0,
+            match ? "ok" : "MISMATCH");
+    }
+
+    tflite::optimized_host::SelectSimd(detected);
+    tflite_learn_66_reset(eon_aligned_free);
+}
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+
+// Camera frame and model input of the app (HQVGA, see app_model.cpp)
+#define IMAGE_FRAME_WIDTH       240
+#define IMAGE_FRAME_HEIGHT      176
+#define IMAGE_MODEL_SIZE        160
+
+typedef struct {
+    uint8_t *frame;         // RGB888 frame
+    uint8_t *raw;           // YUV422 / RGB565 frame
+    uint8_t *square;        // center crop with the aspect ratio of the model
+    uint8_t *output;        // largest output, RGB888 frame
+    uint8_t *resize_scratch; // resize_image_with_scratch() rows of the model input
+} image_bench_data_t;
+
+typedef struct {
+    const char *name;
+    const char *geometry;
+    uint32_t pixels;        // output pixels per run
+    size_t output_size;
+    // reference (scalar) or optimized implementation
+    void (*run)(const image_bench_data_t *data, bool optimized);
+} image_bench_t;
+
+static void image_run_crop(const image_bench_data_t *data, bool optimized)
+{
+    // a single implementation (row memmove)
+    (void)optimized;
+    ei::image::processing::crop_image_rgb888_packed(data->frame, IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT,
+        (IMAGE_FRAME_WIDTH - IMAGE_FRAME_HEIGHT) / 2, 0, data->output, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT);
+}
+
+static void image_run_resize(const image_bench_data_t *data, bool optimized)
+{
+    // the optimized one with a reused scratch buffer, as the per frame callers run it
+    if (optimized) {
+        ei::image::processing::resize_image_with_scratch(data->square, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT,
+            data->output, IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE, ei::image::processing::RGB888_B_SIZE,
+            data->resize_scratch);
+    }
+    else {
+        ei::image::processing::resize_image_reference(data->square, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT,
+            data->output, IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE, ei::image::processing::RGB888_B_SIZE);
+    }
+}
+
+static void image_run_crop_and_interpolate(const image_bench_data_t *data, bool optimized)
+{
+    // the app path: crop and resize in place
+    memcpy(data->output, data->frame, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 3);
+    if (optimized) {
+        ei::image::processing::crop_and_interpolate_rgb888(data->output, IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT,
+            data->output, IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE);
+    }
+    else {
+        ei::image::processing::crop_image_rgb888_packed(data->output, IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT,
+            (IMAGE_FRAME_WIDTH - IMAGE_FRAME_HEIGHT) / 2, 0, data->output, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT);
+        ei::image::processing::resize_image_reference(data->output, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT,
+            data->output, IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE, ei::image::processing::RGB888_B_SIZE);
+    }
+}
+
+static void image_run_yuv422(const image_bench_data_t *data, bool optimized)
+{
+    (optimized ? ei::image::processing::yuv422_to_rgb888 : ei::image::processing::yuv422_to_rgb888_reference)(
+        data->output, data->raw, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2,
+        ei::image::processing::BIG_ENDIAN_ORDER);
+}
+
+static void image_run_rgb565(const image_bench_data_t *data, bool optimized)
+{
+    (optimized ? ei::image::processing::rgb565_to_rgb888 : ei::image::processing::rgb565_to_rgb888_reference)(
+        data->output, data->raw, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2, true);
+}
+
+static void image_stream_row(const uint8_t *row, int y, void *user_data)
+{
+    uint8_t *output = (uint8_t *)user_data;
+    memcpy(output + y * IMAGE_MODEL_SIZE * 3, row, IMAGE_MODEL_SIZE * 3);
+}
+
+static void image_run_rgb565_crop_and_interpolate(const image_bench_data_t *data, bool optimized)
+{
+    if (optimized) {
+        // fused, row by row (as used by run_classifier_image_source)
+        ei::image::processing::resize_stream_t *stream = ei::image::processing::resize_stream_create(
+            IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT, ei::image::processing::IMAGE_FORMAT_RGB565,
+            IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE, EI_CLASSIFIER_RESIZE_FIT_SHORTEST, image_stream_row, data->output);
+        if (stream) {
+            ei::image::processing::resize_stream_push_rows(stream, data->raw, IMAGE_FRAME_HEIGHT);
+            ei::image::processing::resize_stream_free(stream);
+        }
+    }
+    else {
+        ei::image::processing::rgb565_to_rgb888_reference(
+            data->output, data->raw, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2, true);
+        ei::image::processing::crop_image_rgb888_packed(data->output, IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT,
+            (IMAGE_FRAME_WIDTH - IMAGE_FRAME_HEIGHT) / 2, 0, data->output, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT);
+        ei::image::processing::resize_image_reference(data->output, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT,
+            data->output, IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE, ei::image::processing::RGB888_B_SIZE);
+    }
+}
+
+static const image_bench_t image_benchmarks[] = {
+    { "crop", "240x176->176x176", IMAGE_FRAME_HEIGHT * IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT * IMAGE_FRAME_HEIGHT * 3,
+        image_run_crop },
+    { "resize", "176x176->160x160", IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE * 3,
+        image_run_resize },
+    { "crop+resize", "240x176->160x160", IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE * 3,
+        image_run_crop_and_interpolate },
+    { "yuv422->rgb888", "240x176", IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 3,
+        image_run_yuv422 },
+    { "rgb565->rgb888", "240x176", IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 3,
+        image_run_rgb565 },
+    { "rgb565 stream", "240x176->160x160", IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE, IMAGE_MODEL_SIZE * IMAGE_MODEL_SIZE * 3,
+        image_run_rgb565_crop_and_interpolate },
+};
+
+static uint64_t time_image(const image_bench_t *bench, const image_bench_data_t *data, bool optimized)
+{
+    return bench_time_us([&]() { bench->run(data, optimized); return true; });
+}
+
+/**
+ * Throughput of the image preprocessing (crop, resize, colour conversion) on the
+ * camera frame -> model input geometry of the app, reference vs optimized
+ */
+static void benchmark_image()
+{
+    const size_t frame_size = IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 3;
+    bench_buffers buffers;
+    image_bench_data_t data;
+    data.frame = buffers.alloc<uint8_t>(frame_size);
+    data.raw = buffers.alloc<uint8_t>(IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2);
+    data.square = buffers.alloc<uint8_t>(IMAGE_FRAME_HEIGHT * IMAGE_FRAME_HEIGHT * 3);
+    data.output = buffers.alloc<uint8_t>(frame_size);
+    data.resize_scratch = buffers.alloc<uint8_t>(ei::image::processing::resize_image_scratch_size(
+        IMAGE_MODEL_SIZE, ei::image::processing::RGB888_B_SIZE));
+    uint8_t *expected = buffers.alloc<uint8_t>(frame_size);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate image buffers\n");
+        return;
+    }
+
+    rng_fill((int8_t *)data.frame, frame_size);
+    rng_fill((int8_t *)data.raw, IMAGE_FRAME_WIDTH * IMAGE_FRAME_HEIGHT * 2);
+    ei::image::processing::crop_image_rgb888_packed(data.frame, IMAGE_FRAME_WIDTH, IMAGE_FRAME_HEIGHT,
+        (IMAGE_FRAME_WIDTH - IMAGE_FRAME_HEIGHT) / 2, 0, data.square, IMAGE_FRAME_HEIGHT, IMAGE_FRAME_HEIGHT);
+
+    ei_printf("Image benchmark, optimized functions use %s\n", ei::image::processing::get_image_kernels_name());
+    ei_printf("function          geometry          reference_us optimized_us  speedup  MPix/s  check\n");
+
+    for (size_t ix = 0; ix < sizeof(image_benchmarks) / sizeof(image_benchmarks[0]); ix++) {
+        const image_bench_t *bench = &image_benchmarks[ix];
+
+        memset(data.output, 0, frame_size);
+        const uint64_t reference_us = time_image(bench, &data, false);
+        memcpy(expected, data.output, bench->output_size);
+
+        memset(data.output, 0, frame_size);
+        const uint64_t optimized_us = time_image(bench, &data, true);
+        const bool match = memcmp(expected, data.output, bench->output_size) == 0;
+
+        ei_printf("%-17s %-17s %12llu %12llu %7.2fx %7.1f  %s\n", bench->name, bench->geometry,
+            (unsigned long long)reference_us, (unsigned long long)optimized_us,
+            (double)reference_us / (double)optimized_us, (double)bench->pixels / (double)optimized_us,
+            match ? "ok" : "MISMATCH");
+    }
+}
+
+// anomaly samples scored per timed run, consecutive samples alternate between clusters
+#define ANOMALY_SAMPLES         32
+
+static const uint16_t anomaly_axes[] = { 4, 16, 33, 64, 128, 256 };
+static const uint16_t anomaly_clusters[] = { 8, 32, 64 };
+
+static float rng_float(float min, float max)
+{
+    return min + (max - min) * (float)(rng_next() & 0xffff) / 65535.0f;
+}
+
+typedef struct {
+    ei_learning_block_config_anomaly_kmeans_t config;
+    ei_classifier_anom_cluster_t *clusters;
+    float *centroids;
+    float *scale;
+    float *mean;
+    float *samples;         // ANOMALY_SAMPLES x axes, unscaled
+    float *features;        // scratch for the reference path
+} anomaly_bench_data_t;
+
+static float anomaly_run(anomaly_bench_data_t *data, ei_kmeans_plan_t *plan, bool optimized, float *scores)
+{
+    const size_t axes = data->config.anom_axes_size;
+    float sum = 0.0f;
+    for (size_t sx = 0; sx < ANOMALY_SAMPLES; sx++) {
+        float score;
+        if (optimized) {
+            memcpy(plan->input, data->samples + sx * axes, axes * sizeof(float));
+            score = kmeans_plan_score(plan);
+        }
+        else {
+            memcpy(data->features, data->samples + sx * axes, axes * sizeof(float));
+            standard_scaler(data->features, data->scale, data->mean, axes);
+            score = get_min_distance_to_cluster(data->features, axes, data->clusters,
+                data->config.anom_cluster_count);
+        }
+        scores[sx] = score;
+        sum += score;
+    }
+    return sum;
+}
+
+static uint64_t time_anomaly(anomaly_bench_data_t *data, ei_kmeans_plan_t *plan, bool optimized, float *scores)
+{
+    // a single run is short, so allow many more of them than for the layers; per
+    // sample, in ns so the small geometries still show a difference
+    return bench_time_ns([&]() { anomaly_run(data, plan, optimized, scores); return true; },
+        100 * BENCHMARK_MAX_RUNS) / ANOMALY_SAMPLES;
+}
+
+/**
+ * K-means anomaly scoring over a sweep of feature dimensions and cluster counts,
+ * standard_scaler() + get_min_distance_to_cluster() vs kmeans_plan_score()
+ */
+static void benchmark_anomaly()
+{
+    ei_printf("Anomaly benchmark, optimized distance kernel is %s\n", kmeans_kernels_name());
+    ei_printf("axes clusters  reference_ns optimized_ns  speedup  skipped  max_diff  check\n");
+
+    for (size_t ax = 0; ax < sizeof(anomaly_axes) / sizeof(anomaly_axes[0]); ax++) {
+        for (size_t cx = 0; cx < sizeof(anomaly_clusters) / sizeof(anomaly_clusters[0]); cx++) {
+            const uint16_t axes = anomaly_axes[ax];
+            const uint16_t clusters = anomaly_clusters[cx];
+
+            bench_buffers buffers;
+            anomaly_bench_data_t data;
+            memset(&data, 0, sizeof(data));
+            data.clusters = buffers.alloc<ei_classifier_anom_cluster_t>(clusters);
+            data.centroids = buffers.alloc<float>(clusters * axes);
+            data.scale = buffers.alloc<float>(axes);
+            data.mean = buffers.alloc<float>(axes);
+            data.samples = buffers.alloc<float>(ANOMALY_SAMPLES * axes);
+            data.features = buffers.alloc<float>(axes);
+            float *expected = buffers.alloc<float>(2 * ANOMALY_SAMPLES);
+            if (!buffers.ok()) {
+                ei_printf("ERR: Failed to allocate anomaly buffers\n");
+                return;
+            }
+            float *scores = expected + ANOMALY_SAMPLES;
+
+            for (size_t ix = 0; ix < axes; ix++) {
+                data.scale[ix] = rng_float(0.5f, 2.0f);
+                data.mean[ix] = rng_float(-1.0f, 1.0f);
+            }
+            for (size_t kx = 0; kx < clusters; kx++) {
+                data.clusters[kx].centroid = data.centroids + kx * axes;
+                data.clusters[kx].max_error = rng_float(0.5f, 1.5f);
+                for (size_t ix = 0; ix < axes; ix++) {
+                    data.centroids[kx * axes + ix] = rng_float(-2.0f, 2.0f);
+                }
+            }
+            // samples near a random cluster, the last quarter far away (anomalous)
+            for (size_t sx = 0; sx < ANOMALY_SAMPLES; sx++) {
+                const float *centroid = data.centroids + (rng_next() % clusters) * axes;
+                const float noise = sx < ANOMALY_SAMPLES * 3 / 4 ? 0.3f : 3.0f;
+                for (size_t ix = 0; ix < axes; ix++) {
+                    const float v = centroid[ix] + rng_float(-noise, noise);
+                    data.samples[sx * axes + ix] = v * data.scale[ix] + data.mean[ix];
+                }
+            }
+
+            data.config.implementation_version = 1;
+            data.config.anom_axes_size = axes;
+            data.config.anom_clusters = data.clusters;
+            data.config.anom_cluster_count = clusters;
+            data.config.anom_scale = data.scale;
+            data.config.anom_mean = data.mean;
+
+            ei_kmeans_plan_t plan;
+            if (!kmeans_plan_init(&plan, &data.config)) {
+                ei_printf("ERR: Failed to allocate anomaly plan\n");
+            }
+            else {
+                const uint64_t reference_ns = time_anomaly(&data, &plan, false, expected);
+                const uint64_t optimized_ns = time_anomaly(&data, &plan, true, scores);
+
+                // one more counted pass for the share of distances that were cut short
+                plan.skipped = 0;
+                anomaly_run(&data, &plan, true, scores);
+
+                float max_diff = 0.0f;
+                for (size_t sx = 0; sx < ANOMALY_SAMPLES; sx++) {
+                    const float diff = fabsf(expected[sx] - scores[sx]);
+                    max_diff = diff > max_diff ? diff : max_diff;
+                }
+
+                ei_printf("%4u %8u %13llu %12llu %7.2fx %7.1f%% %9.2e  %s\n", axes, clusters,
+                    (unsigned long long)reference_ns, (unsigned long long)optimized_ns,
+                    (double)reference_ns / (double)(optimized_ns > 0 ? optimized_ns : 1),
+                    100.0 * (double)plan.skipped / (double)(clusters * ANOMALY_SAMPLES),
+                    (double)max_diff, max_diff < 1e-3f ? "ok" : "MISMATCH");
+                kmeans_plan_free(&plan);
+            }
+        }
+    }
+}
+
+static const uint16_t fft_sizes[] = { 128, 256, 512, 1024, 2048, 4096 };
+
+typedef struct {
+    size_t n_fft;
+    const float *signal;
+    float *input;               // scratch, both transforms clobber their input
+    ei::fft_complex_t *output;
+} fft_bench_data_t;
+
+static int fft_run(const fft_bench_data_t *data, bool optimized)
+{
+    memcpy(data->input, data->signal, data->n_fft * sizeof(float));
+    if (optimized) {
+        return ei::fft::rfft(data->input, data->output, data->n_fft);
+    }
+
+    // what numpy::software_rfft did before: a kissfft config for every call
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(data->n_fft, 0, NULL, NULL, NULL);
+    if (!cfg) {
+        return -1;
+    }
+    kiss_fftr(cfg, data->input, (kiss_fft_cpx *)data->output);
+    kiss_fftr_free(cfg);
+    return 0;
+}
+
+static uint64_t time_fft(const fft_bench_data_t *data, bool optimized)
+{
+    // in ns, the small sizes take only a few us
+    return bench_time_ns([&]() { return fft_run(data, optimized) == 0; }, 100 * BENCHMARK_MAX_RUNS);
+}
+
+/**
+ * Real FFT for the n_fft sizes of the audio and spectral blocks,
+ * kissfft with a config per call vs the cached ei::fft plans
+ */
+static void benchmark_fft()
+{
+    const size_t max_fft = fft_sizes[sizeof(fft_sizes) / sizeof(fft_sizes[0]) - 1];
+    bench_buffers buffers;
+    fft_bench_data_t data;
+    float *signal = buffers.alloc<float>(max_fft);
+    data.input = buffers.alloc<float>(max_fft);
+    data.output = buffers.alloc<ei::fft_complex_t>(max_fft / 2 + 1);
+    ei::fft_complex_t *expected = buffers.alloc<ei::fft_complex_t>(max_fft / 2 + 1);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate FFT buffers\n");
+        return;
+    }
+    for (size_t ix = 0; ix < max_fft; ix++) {
+        signal[ix] = (float)rng_range(-32768, 32767) / 32768.0f;
+    }
+    data.signal = signal;
+
+    ei_printf("FFT benchmark, optimized butterflies use %s\n", ei::fft::rfft_kernels_name());
+    ei_printf("n_fft  reference_ns optimized_ns  speedup  max_rel_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(fft_sizes) / sizeof(fft_sizes[0]); ix++) {
+        data.n_fft = fft_sizes[ix];
+        const size_t bins = data.n_fft / 2 + 1;
+
+        const uint64_t reference_ns = time_fft(&data, false);
+        memcpy(expected, data.output, bins * sizeof(ei::fft_complex_t));
+        const uint64_t optimized_ns = time_fft(&data, true);
+        // every size gets the first plan slot
+        ei::fft::rfft_clear_plans();
+
+        if (reference_ns == 0 || optimized_ns == 0) {
+            ei_printf("%5u  failed to run\n", (unsigned)data.n_fft);
+            continue;
+        }
+
+        float max_mag = 0.0f;
+        float max_diff = 0.0f;
+        for (size_t bx = 0; bx < bins; bx++) {
+            const float mag = sqrtf(expected[bx].r * expected[bx].r + expected[bx].i * expected[bx].i);
+            const float diff = fmaxf(fabsf(expected[bx].r - data.output[bx].r),
+                fabsf(expected[bx].i - data.output[bx].i));
+            max_mag = mag > max_mag ? mag : max_mag;
+            max_diff = diff > max_diff ? diff : max_diff;
+        }
+        const float rel_diff = max_mag > 0.0f ? max_diff / max_mag : max_diff;
+
+        ei_printf("%5u %13llu %12llu %7.2fx %13.2e  %s\n", (unsigned)data.n_fft,
+            (unsigned long long)reference_ns, (unsigned long long)optimized_ns,
+            (double)reference_ns / (double)optimized_ns, (double)rel_diff,
+            rel_diff < 1e-5f ? "ok" : "MISMATCH");
+    }
+}
+
+typedef struct {
+    uint16_t num_filters;
+    uint16_t fft_length;
+} filterbank_bench_config_t;
+
+static const filterbank_bench_config_t filterbank_configs[] = {
+    { 40, 256 }, { 40, 512 }, { 64, 512 }, { 64, 1024 },
+};
+
+#define FILTERBANK_FREQUENCY    16000
+#define FILTERBANK_FRAMES       64
+
+typedef struct {
+    const filterbank_bench_config_t *config;
+    uint16_t coefficients;
+    const float *power;         // FILTERBANK_FRAMES power spectrum frames
+    float *out;                 // FILTERBANK_FRAMES * num_filters
+#if EIDSP_QUANTIZE_FILTERBANK
+    ei::quantized_matrix_t *dense;
+#else
+    ei::matrix_t *dense;
+#endif
+    const uint16_t *bins;
+    const ei::speechpy::sparse_filterbank_t *sparse;
+} filterbank_bench_data_t;
+
+typedef enum {
+    FILTERBANK_DENSE,           // feature::mfe_v3() before: dense (transposed) matrix, numpy::dot_by_row()
+    FILTERBANK_BINS,            // feature::mfe() before: triangle weights calculated for every frame
+    FILTERBANK_SPARSE,
+} filterbank_variant_t;
+
+static void filterbank_run(const filterbank_bench_data_t *data, filterbank_variant_t variant)
+{
+    const uint16_t num_filters = data->config->num_filters;
+
+    for (size_t frame = 0; frame < FILTERBANK_FRAMES; frame++) {
+        const float *power = data->power + frame * data->coefficients;
+        float *out = data->out + frame * num_filters;
+
+        if (variant == FILTERBANK_DENSE) {
+            ei::matrix_t out_matrix(FILTERBANK_FRAMES, num_filters, data->out);
+            memset(out, 0, num_filters * sizeof(float));
+            ei::numpy::dot_by_row(frame, (float *)power, data->coefficients, data->dense, &out_matrix);
+        }
+        else if (variant == FILTERBANK_BINS) {
+            for (size_t i = 0; i < num_filters; i++) {
+                size_t left = data->bins[i];
+                size_t middle = data->bins[i + 1];
+                size_t right = data->bins[i + 2];
+                out[i] = power[middle];
+                for (size_t bin = left + 1; bin < right; bin++) {
+                    if (bin < middle) {
+                        out[i] += ((static_cast<float>(bin) - left) / (middle - left)) * power[bin];
+                    }
+                    if (bin > middle) {
+                        out[i] += ((right - static_cast<float>(bin)) / (right - middle)) * power[bin];
+                    }
+                }
+            }
+        }
+        else {
+            ei::speechpy::sparse_filterbank_apply(data->sparse, power, out);
+        }
+    }
+}
+
+static uint64_t time_filterbank(const filterbank_bench_data_t *data, filterbank_variant_t variant)
+{
+    // ns per frame
+    return bench_time_ns([&]() { filterbank_run(data, variant); return true; },
+        100 * BENCHMARK_MAX_RUNS) / FILTERBANK_FRAMES;
+}
+
+static float filterbank_max_rel_diff(const float *expected, const float *actual, size_t size)
+{
+    float max_diff = 0.0f;
+    for (size_t ix = 0; ix < size; ix++) {
+        const float diff = fabsf(expected[ix] - actual[ix]) / (fabsf(expected[ix]) > 1e-20f ? fabsf(expected[ix]) : 1.0f);
+        max_diff = diff > max_diff ? diff : max_diff;
+    }
+    return max_diff;
+}
+
+/**
+ * Mel filterbank per frame: the dense matrix of feature::mfe_v3() and the
+ * per frame weights of feature::mfe() vs the cached sparse filterbank
+ */
+static void benchmark_filterbank()
+{
+    ei_printf("Mel filterbank benchmark, %s weights, %d Hz\n",
+        EIDSP_SPARSE_FILTERBANK_INT16 ? "Q15" : "float", FILTERBANK_FREQUENCY);
+    ei_printf("filters n_fft  source  old_bytes sparse_bytes  old_ns/frame sparse_ns/frame  speedup  max_rel_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(filterbank_configs) / sizeof(filterbank_configs[0]); ix++) {
+        const filterbank_bench_config_t *config = &filterbank_configs[ix];
+        const uint16_t coefficients = config->fft_length / 2 + 1;
+
+        bench_buffers buffers;
+        float *power = buffers.alloc<float>(FILTERBANK_FRAMES * coefficients);
+        float *expected = buffers.alloc<float>(FILTERBANK_FRAMES * config->num_filters);
+        float *out = buffers.alloc<float>(FILTERBANK_FRAMES * config->num_filters);
+        uint16_t *bins = buffers.alloc<uint16_t>(config->num_filters + 2);
+#if EIDSP_QUANTIZE_FILTERBANK
+        ei::quantized_matrix_t dense(config->num_filters, coefficients, &ei::numpy::dequantize_zero_one);
+        const size_t dense_bytes = config->num_filters * coefficients * sizeof(uint8_t);
+#else
+        ei::matrix_t dense(config->num_filters, coefficients);
+        const size_t dense_bytes = config->num_filters * coefficients * sizeof(float);
+#endif
+        if (!buffers.ok() || !dense.buffer) {
+            ei_printf("ERR: Failed to allocate filterbank buffers\n");
+            return;
+        }
+        for (size_t px = 0; px < FILTERBANK_FRAMES * coefficients; px++) {
+            power[px] = (float)rng_range(0, 1 << 20) / 1024.0f;
+        }
+
+        // both sources with the default low / high frequency of their MFE version
+        ei::speechpy::feature::filterbanks(&dense, config->num_filters, coefficients, FILTERBANK_FREQUENCY,
+            300, FILTERBANK_FREQUENCY / 2, true);
+        ei::speechpy::feature::calculate_mel_bins(bins, config->num_filters, config->fft_length,
+            FILTERBANK_FREQUENCY, 0, 0, 4);
+
+        ei::speechpy::sparse_filterbank_t *sparse_speechpy = ei::speechpy::sparse_filterbank_create(
+            ei::speechpy::SPARSE_FILTERBANK_SPEECHPY, config->num_filters, config->fft_length,
+            FILTERBANK_FREQUENCY, 300, FILTERBANK_FREQUENCY / 2, 2);
+        ei::speechpy::sparse_filterbank_t *sparse_bins = ei::speechpy::sparse_filterbank_create(
+            ei::speechpy::SPARSE_FILTERBANK_MEL_BINS, config->num_filters, config->fft_length,
+            FILTERBANK_FREQUENCY, 0, 0, 4);
+
+        filterbank_bench_data_t data = { config, coefficients, power, expected, &dense, bins, NULL };
+
+        for (int source = 0; source < 2; source++) {
+            const ei::speechpy::sparse_filterbank_t *sparse = source == 0 ? sparse_speechpy : sparse_bins;
+            const filterbank_variant_t old_variant = source == 0 ? FILTERBANK_DENSE : FILTERBANK_BINS;
+            const size_t old_bytes = source == 0 ? dense_bytes : (config->num_filters + 2) * sizeof(uint16_t);
+            if (!sparse) {
+                ei_printf("%7u %5u  failed to create the sparse filterbank\n",
+                    (unsigned)config->num_filters, (unsigned)config->fft_length);
+                continue;
+            }
+
+            data.out = expected;
+            const uint64_t old_ns = time_filterbank(&data, old_variant);
+            data.out = out;
+            data.sparse = sparse;
+            const uint64_t sparse_ns = time_filterbank(&data, FILTERBANK_SPARSE);
+
+            const float max_diff = filterbank_max_rel_diff(expected, out, FILTERBANK_FRAMES * config->num_filters);
+            ei_printf("%7u %5u  %-6s %10u %12u %13llu %15llu %7.2fx %13.2e  %s\n",
+                (unsigned)config->num_filters, (unsigned)config->fft_length, source == 0 ? "dense" : "bins",
+                (unsigned)old_bytes, (unsigned)ei::speechpy::sparse_filterbank_bytes(sparse),
+                (unsigned long long)old_ns, (unsigned long long)sparse_ns,
+                (double)old_ns / (double)(sparse_ns > 0 ? sparse_ns : 1), (double)max_diff,
+                max_diff < (EIDSP_SPARSE_FILTERBANK_INT16 ? 1e-3f : 1e-5f) ? "ok" : "MISMATCH");
+        }
+
+        ei::speechpy::sparse_filterbank_free(sparse_speechpy);
+        ei::speechpy::sparse_filterbank_free(sparse_bins);
+    }
+}
+
+#define FILTER_SAMPLES          1024
+#define FILTER_FREQUENCY        100
+
+static const uint8_t filter_channels[] = { 1, 3, 6 };
+
+typedef enum {
+    FILTER_BUTTERWORTH_ROWS = 0,    // spectral::filters::butterworth_highpass() per row, used by the DSP blocks
+    FILTER_BUTTERWORTH_BANK,        // opt-in float bank
+} filter_variant_t;
+
+typedef struct {
+    size_t channels;
+    const float *signal;            // one row of FILTER_SAMPLES per channel
+    float *output;
+    ei::filter::iir_bank_t *iir;
+} filter_bench_data_t;
+
+static void filter_run(const filter_bench_data_t *data, filter_variant_t variant)
+{
+    switch (variant) {
+        case FILTER_BUTTERWORTH_ROWS:
+            for (size_t c = 0; c < data->channels; c++) {
+                ei::spectral::filters::butterworth_highpass(8, FILTER_FREQUENCY, 3.0f,
+                    data->signal + c * FILTER_SAMPLES, data->output + c * FILTER_SAMPLES, FILTER_SAMPLES);
+            }
+            break;
+        case FILTER_BUTTERWORTH_BANK:
+            ei::filter::iir_reset(data->iir);
+            ei::filter::iir_run(data->iir, data->signal, FILTER_SAMPLES, 1,
+                data->output, FILTER_SAMPLES, 1, FILTER_SAMPLES);
+            break;
+    }
+}
+
+// thousand samples per second per channel
+static uint64_t time_filter(const filter_bench_data_t *data, filter_variant_t variant)
+{
+    uint64_t avg_ns = bench_time_ns([&]() { filter_run(data, variant); return true; });
+    return (uint64_t)FILTER_SAMPLES * 1000000 / (avg_ns > 0 ? avg_ns : 1);
+}
+
+static float filter_max_rel_diff(const float *expected, const float *actual, size_t size)
+{
+    float max_abs = 0.0f;
+    float max_diff = 0.0f;
+    for (size_t ix = 0; ix < size; ix++) {
+        const float diff = fabsf(expected[ix] - actual[ix]);
+        max_abs = fabsf(expected[ix]) > max_abs ? fabsf(expected[ix]) : max_abs;
+        max_diff = diff > max_diff ? diff : max_diff;
+    }
+    return max_abs > 0.0f ? max_diff / max_abs : max_diff;
+}
+
+/**
+ * IIR filter bank vs filtering one row (axis) at a time: the order 8
+ * Butterworth high pass of the spectral block, in samples/s per channel
+ */
+static void benchmark_filters()
+{
+    const size_t max_channels = filter_channels[sizeof(filter_channels) / sizeof(filter_channels[0]) - 1];
+    bench_buffers buffers;
+    float *signal = buffers.alloc<float>(max_channels * FILTER_SAMPLES);
+    float *expected = buffers.alloc<float>(max_channels * FILTER_SAMPLES);
+    float *output = buffers.alloc<float>(max_channels * FILTER_SAMPLES);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate filter buffers\n");
+        return;
+    }
+    for (size_t ix = 0; ix < max_channels * FILTER_SAMPLES; ix++) {
+        signal[ix] = (float)rng_range(-32768, 32767) / 4096.0f;
+    }
+
+    ei_printf("Filter benchmark, %s lanes, %d samples per channel\n",
+        ei::filter::filter_kernels_name(), FILTER_SAMPLES);
+    ei_printf("filter            channels  per_row_ksps  bank_ksps  speedup  max_rel_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(filter_channels) / sizeof(filter_channels[0]); ix++) {
+        filter_bench_data_t data = { filter_channels[ix], signal, expected, NULL };
+        data.iir = ei::filter::iir_create_butterworth(8, FILTER_FREQUENCY, 3.0f, true, data.channels);
+        if (!data.iir) {
+            ei_printf("ERR: Failed to create the IIR filter bank\n");
+            continue;
+        }
+        const uint64_t rows_ksps = time_filter(&data, FILTER_BUTTERWORTH_ROWS);
+        data.output = output;
+        const uint64_t bank_ksps = time_filter(&data, FILTER_BUTTERWORTH_BANK);
+        ei::filter::iir_free(data.iir);
+
+        // the bank sums in float, the per row filter in double
+        const float max_diff = filter_max_rel_diff(expected, output, data.channels * FILTER_SAMPLES);
+        ei_printf("butterworth hp 8  %8u %13llu %10llu %7.2fx %13.2e  %s\n",
+            (unsigned)data.channels, (unsigned long long)rows_ksps, (unsigned long long)bank_ksps,
+            (double)bank_ksps / (double)(rows_ksps > 0 ? rows_ksps : 1), (double)max_diff,
+            max_diff < 1e-4f ? "ok" : "MISMATCH");
+    }
+}
+
+#define SPECTRAL_AXES           3
+#define SPECTRAL_FREQUENCY      100
+#define SPECTRAL_SAMPLES        200
+
+typedef struct {
+    const char *name;
+    ei_dsp_config_spectral_analysis_t config;
+} spectral_bench_t;
+
+// FFT spectral analysis, the versions that share their per axis work through feature::run_axes()
+static const spectral_bench_t spectral_benchmarks[] = {
+    { "v1 none", { 0, 1, SPECTRAL_AXES, 1.0f, 1, "none", 3.0f, 6, "FFT", 128, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", true, false, 1, "", false } },
+    { "v1 low", { 0, 1, SPECTRAL_AXES, 1.0f, 1, "low", 8.0f, 6, "FFT", 128, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", true, false, 1, "", false } },
+    { "v2 high", { 0, 2, SPECTRAL_AXES, 1.0f, 1, "high", 3.0f, 4, "FFT", 64, 3, 0.1f, "", true, false, 1, "", false } },
+    { "v3 low", { 0, 3, SPECTRAL_AXES, 1.0f, 1, "low", 20.0f, 8, "FFT", 128, 3, 0.1f, "", true, true, 1, "", false } },
+    { "v4 low", { 0, 4, SPECTRAL_AXES, 1.0f, 1, "low", 20.0f, 6, "FFT", 256, 3, 0.1f, "", true, true, 1, "", false } },
+    { "v4 none", { 0, 4, SPECTRAL_AXES, 1.0f, 1, "none", 3.0f, 6, "FFT", 128, 3, 0.1f, "", false, false, 1, "", false } },
+};
+
+static size_t spectral_features_per_axis(const ei_dsp_config_spectral_analysis_t *config)
+{
+    if (config->implementation_version == 1) {
+        size_t edges = 1;
+        for (const char *c = config->spectral_power_edges; *c; c++) {
+            edges += *c == ',';
+        }
+        return ei::spectral::feature::calculate_spectral_buffer_size(true, config->spectral_peaks_count, edges);
+    }
+
+    size_t start_bin = 1;
+    size_t stop_bin = config->fft_length / 2 + 1;
+    if (strcmp(config->filter_type, "none") != 0) {
+        ei::spectral::feature::get_start_stop_bin(SPECTRAL_FREQUENCY, config->fft_length, config->filter_cutoff,
+            &start_bin, &stop_bin, strcmp(config->filter_type, "high") == 0);
+    }
+    return 3 + (config->implementation_version == 4 ? 2 : 0) + (stop_bin - start_bin);
+}
+
+/**
+ * Spectral analysis of an interleaved signal, all axes in one call (per_axis) or
+ * one call per axis (serial), the features of every axis are concatenated
+ */
+static int spectral_run(const spectral_bench_t *bench, const float *signal, float *input, float *features,
+    bool per_axis)
+{
+    ei_dsp_config_spectral_analysis_t config = bench->config;
+    const size_t n_axis_features = spectral_features_per_axis(&config);
+    const size_t axes = per_axis ? SPECTRAL_AXES : 1;
+    config.axes = axes;
+
+    for (size_t first = 0; first < SPECTRAL_AXES; first += axes) {
+        for (size_t ix = 0; ix < SPECTRAL_SAMPLES; ix++) {
+            for (size_t ax = 0; ax < axes; ax++) {
+                input[ix * axes + ax] = signal[ix * SPECTRAL_AXES + first + ax];
+            }
+        }
+        ei::matrix_t input_matrix(SPECTRAL_SAMPLES, axes, input);
+        ei::matrix_t output_matrix(1, axes * n_axis_features, features + first * n_axis_features);
+
+        int ret;
+        switch (config.implementation_version) {
+            case 1:
+                ret = ei::spectral::feature::extract_spectral_analysis_features_v1(&input_matrix, &output_matrix,
+                    &config, SPECTRAL_FREQUENCY);
+                break;
+            case 2:
+                ret = ei::spectral::feature::extract_spectral_analysis_features_v2(&input_matrix, &output_matrix,
+                    &config, SPECTRAL_FREQUENCY);
+                break;
+            case 3:
+                ret = ei::spectral::feature::extract_spectral_analysis_features_v3(&input_matrix, &output_matrix,
+                    &config, SPECTRAL_FREQUENCY);
+                break;
+            default:
+                ret = ei::spectral::feature::extract_spectral_analysis_features_v4(&input_matrix, &output_matrix,
+                    &config, SPECTRAL_FREQUENCY);
+                break;
+        }
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static uint64_t time_spectral(const spectral_bench_t *bench, const float *signal, float *input, float *features,
+    bool per_axis)
+{
+    return bench_time_us([&]() { return spectral_run(bench, signal, input, features, per_axis) == 0; });
+}
+
+/**
+ * Spectral analysis v1-v4 over all axes at once (one shared FFT per axis, the
+ * axes split over both cores with EIDSP_SPECTRAL_MULTICORE) vs one axis at a
+ * time, time per window. The features have to be identical.
+ */
+static void benchmark_spectral()
+{
+    const size_t max_features = SPECTRAL_AXES * 256;
+    bench_buffers buffers;
+    float *signal = buffers.alloc<float>(SPECTRAL_SAMPLES * SPECTRAL_AXES);
+    float *input = buffers.alloc<float>(SPECTRAL_SAMPLES * SPECTRAL_AXES);
+    float *expected = buffers.alloc<float>(max_features);
+    float *features = buffers.alloc<float>(max_features);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate spectral buffers\n");
+        return;
+    }
+    for (size_t ix = 0; ix < SPECTRAL_SAMPLES * SPECTRAL_AXES; ix++) {
+        signal[ix] = (float)rng_range(-32768, 32767) / 4096.0f;
+    }
+
+    ei_printf("Spectral analysis benchmark, %d axes of %d samples at %d Hz\n",
+        SPECTRAL_AXES, SPECTRAL_SAMPLES, SPECTRAL_FREQUENCY);
+    ei_printf("block    features  serial_us  per_axis_us  speedup  max_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(spectral_benchmarks) / sizeof(spectral_benchmarks[0]); ix++) {
+        const spectral_bench_t *bench = &spectral_benchmarks[ix];
+        const size_t n_features = SPECTRAL_AXES * spectral_features_per_axis(&bench->config);
+
+        memset(expected, 0, max_features * sizeof(float));
+        memset(features, 0, max_features * sizeof(float));
+        const uint64_t serial_us = time_spectral(bench, signal, input, expected, false);
+        const uint64_t per_axis_us = time_spectral(bench, signal, input, features, true);
+        if (serial_us == 0 || per_axis_us == 0 || n_features > max_features) {
+            ei_printf("%-8s  failed to run\n", bench->name);
+            continue;
+        }
+
+        float max_diff = 0.0f;
+        for (size_t fx = 0; fx < n_features; fx++) {
+            const float diff = fabsf(expected[fx] - features[fx]);
+            max_diff = diff > max_diff ? diff : max_diff;
+        }
+
+        ei_printf("%-8s %9u %10llu %12llu %7.2fx %9.2e  %s\n", bench->name, (unsigned)n_features,
+            (unsigned long long)serial_us, (unsigned long long)per_axis_us,
+            (double)serial_us / (double)per_axis_us, (double)max_diff, max_diff == 0.0f ? "ok" : "MISMATCH");
+    }
+}
+
+#define WAVELET_AXES            3
+#define WAVELET_FREQUENCY       100
+
+static const uint16_t wavelet_lengths[] = { 128, 512, 2048 };
+static const uint8_t wavelet_levels[] = { 1, 2, 4, 6 };
+
+typedef struct {
+    const char *name;
+    const float *dec_lo;    // decomposition filters as in wavelet_coeff.hpp
+    const float *dec_hi;
+    size_t length;
+} wavelet_bench_filter_t;
+
+static const wavelet_bench_filter_t wavelet_filters[] = {
+    { "haar", ei::spectral::haar[0].data(), ei::spectral::haar[1].data(), ei::spectral::haar[0].size() },
+    { "db4", ei::spectral::db4[0].data(), ei::spectral::db4[1].data(), ei::spectral::db4[0].size() },
+    { "sym8", ei::spectral::sym8[0].data(), ei::spectral::sym8[1].data(), ei::spectral::sym8[0].size() },
+};
+
+typedef struct {
+    const wavelet_bench_filter_t *filter;
+    size_t length;
+    int level;
+    const float *signal;    // length x WAVELET_AXES, interleaved like the raw signal
+    float *input;           // copy the block transposes in place
+    float *features;
+} wavelet_bench_data_t;
+
+/**
+ * Histogram of x over nbins equal bins between its min and max, as wavelet.hpp
+ * computed it before the engine
+ */
+static void wavelet_reference_histo(const ei::fvec &x, size_t nbins, ei::fvec &h, bool normalize = false)
+{
+    float min = *std::min_element(x.begin(), x.end());
+    float max = *std::max_element(x.begin(), x.end());
+    float step = (max - min) / nbins;
+    h.resize(nbins);
+    for (size_t i = 0; i < x.size(); i++) {
+        size_t bin = (x[i] - min) / step;
+        if (bin >= nbins)
+            bin = nbins - 1;
+        h[bin]++;
+    }
+    if (normalize) {
+        float s = ei::numpy::sum(h.data(), h.size());
+        for (size_t i = 0; i < nbins; i++) {
+            h[i] /= s;
+        }
+    }
+}
+
+/**
+ * Features of one set of coefficients as wavelet.hpp computed them before the
+ * engine: a sorted copy for the percentiles and one pass per statistic
+ */
+static void wavelet_reference_stats(const ei::fvec &y, float *features)
+{
+    ei::fvec h;
+    wavelet_reference_histo(y, 100, h, true);
+    float entropy = 0.0f;
+    for (size_t i = 0; i < h.size(); i++) {
+        if (h[i] > 0.0f) {
+            entropy -= h[i] * log(h[i]);
+        }
+    }
+
+    ei::matrix_t x(1, y.size(), const_cast<float *>(y.data()));
+    ei::matrix_t out(1, 1);
+    ei::numpy::mean(&x, &out);
+    const float mean = out.buffer[0];
+
+    size_t zc = 0;
+    size_t mc = 0;
+    for (size_t i = 1; i < y.size(); i++) {
+        zc += y[i] * y[i - 1] < 0;
+        mc += (y[i] - mean) * (y[i - 1] - mean) < 0;
+    }
+
+    ei::fvec sorted = y;
+    std::sort(sorted.begin(), sorted.end());
+    const float percentiles[] = { 0.05f, 0.25f, 0.75f, 0.95f, 0.5f };
+
+    features[0] = entropy;
+    features[1] = zc / (float)y.size();
+    features[2] = mc / (float)y.size();
+    for (size_t p = 0; p < 5; p++) {
+        features[3 + p] = sorted[(size_t)((percentiles[p] * (sorted.size() - 1)) + 0.5)];
+    }
+    features[8] = mean;
+    ei::numpy::stdev(&x, &out);
+    features[9] = out.buffer[0];
+    features[10] = ei::numpy::variance(const_cast<float *>(y.data()), y.size());
+    ei::numpy::rms(&x, &out);
+    features[11] = out.buffer[0];
+    ei::numpy::skew(&x, &out);
+    features[12] = out.buffer[0];
+    ei::numpy::kurtosis(&x, &out);
+    features[13] = out.buffer[0];
+}
+
+// one DWT level with a padded copy and fresh output vectors, as before the engine
+static void wavelet_reference_dwt(const float *x, size_t nx, const wavelet_bench_filter_t *filter,
+    ei::fvec &a, ei::fvec &d)
+{
+    const size_t nh = filter->length;
+    ei::fvec x_padded(nx + nh * 2 - 2);
+    for (size_t i = 0; i < nh - 2; i++)
+        x_padded[i] = x[nh - 3 - i];
+    for (size_t i = 0; i < nx; i++)
+        x_padded[i + nh - 2] = x[i];
+    for (size_t i = 0; i < nh; i++)
+        x_padded[i + nx + nh - 2] = x[nx - 1 - i];
+
+    const size_t ny = (nx + nh - 1) / 2;
+    a.resize(ny);
+    d.resize(ny);
+    for (size_t i = 0; i < ny; i++) {
+        float sa = 0.0f;
+        float sd = 0.0f;
+        for (size_t k = 0; k < nh; k++) {
+            sa += x_padded[2 * i + k] * filter->dec_lo[nh - 1 - k];
+        }
+        for (size_t k = 0; k < nh; k++) {
+            sd += x_padded[2 * i + k] * filter->dec_hi[nh - 1 - k];
+        }
+        a[i] = sa;
+        d[i] = sd;
+    }
+    ei::numpy::underflow_handling(d.data(), d.size());
+    ei::numpy::underflow_handling(a.data(), a.size());
+}
+
+static int wavelet_run(const wavelet_bench_data_t *data, bool engine)
+{
+    static const char *filter_none = "none";
+    static const char *analysis_wavelet = "Wavelet";
+    const size_t per_axis = (data->level + 1) * 14;
+
+    memcpy(data->input, data->signal, data->length * WAVELET_AXES * sizeof(float));
+    ei::matrix_t input(data->length, WAVELET_AXES, data->input);
+    ei::matrix_t features(1, WAVELET_AXES * per_axis, data->features);
+
+    if (engine) {
+        ei_dsp_config_spectral_analysis_t config;
+        memset(&config, 0, sizeof(config));
+        config.axes = WAVELET_AXES;
+        config.scale_axes = 1.0f;
+        config.filter_type = filter_none;
+        config.analysis_type = analysis_wavelet;
+        config.wavelet_level = data->level;
+        config.wavelet = data->filter->name;
+        return ei::spectral::wavelet::extract_wavelet_features(&input, &features, &config, WAVELET_FREQUENCY);
+    }
+
+    ei::numpy::transpose_in_place(&input);
+    int ret = ei::spectral::processing::subtract_mean(&input);
+    if (ret != 0) {
+        return ret;
+    }
+    for (size_t row = 0; row < WAVELET_AXES; row++) {
+        float *out = data->features + row * per_axis;
+        ei::fvec a(input.get_row_ptr(row), input.get_row_ptr(row) + data->length);
+        ei::fvec d;
+        // details from the first level go last, the approximation of the last level first
+        for (int l = 0; l < data->level; l++) {
+            wavelet_reference_dwt(a.data(), a.size(), data->filter, a, d);
+            wavelet_reference_stats(d, out + (data->level - l) * 14);
+        }
+        wavelet_reference_stats(a, out);
+    }
+    return 0;
+}
+
+static uint64_t time_wavelet(const wavelet_bench_data_t *data, bool engine)
+{
+    return bench_time_us([&]() { return wavelet_run(data, engine) == 0; });
+}
+
+/**
+ * Wavelet spectral analysis (3 axes) over window lengths and decomposition
+ * levels: the per level vector implementation with sorted percentiles vs the
+ * engine in spectral/wavelet.hpp, time per window
+ */
+static void benchmark_wavelet()
+{
+    const size_t max_length = wavelet_lengths[sizeof(wavelet_lengths) / sizeof(wavelet_lengths[0]) - 1];
+    const size_t max_features = WAVELET_AXES * (wavelet_levels[sizeof(wavelet_levels) / sizeof(wavelet_levels[0]) - 1] + 1) * 14;
+    bench_buffers buffers;
+    float *signal = buffers.alloc<float>(max_length * WAVELET_AXES);
+    float *input = buffers.alloc<float>(max_length * WAVELET_AXES);
+    float *expected = buffers.alloc<float>(max_features);
+    float *features = buffers.alloc<float>(max_features);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate wavelet buffers\n");
+        return;
+    }
+    for (size_t ix = 0; ix < max_length * WAVELET_AXES; ix++) {
+        signal[ix] = (float)rng_range(-32768, 32767) / 4096.0f;
+    }
+
+    ei_printf("Wavelet benchmark, %d axes\n", WAVELET_AXES);
+    ei_printf("length level wavelet  features  vector_us  engine_us  speedup  max_rel_diff  check\n");
+
+    for (size_t lx = 0; lx < sizeof(wavelet_lengths) / sizeof(wavelet_lengths[0]); lx++) {
+        for (size_t vx = 0; vx < sizeof(wavelet_levels) / sizeof(wavelet_levels[0]); vx++) {
+            // the block needs 32 samples per coefficient of the last level
+            if (wavelet_lengths[lx] < (32 << wavelet_levels[vx])) {
+                continue;
+            }
+            for (size_t fx = 0; fx < sizeof(wavelet_filters) / sizeof(wavelet_filters[0]); fx++) {
+                wavelet_bench_data_t data = { &wavelet_filters[fx], wavelet_lengths[lx], wavelet_levels[vx],
+                    signal, input, expected };
+                const size_t n_features = WAVELET_AXES * (data.level + 1) * 14;
+                const uint64_t vector_us = time_wavelet(&data, false);
+                data.features = features;
+                const uint64_t engine_us = time_wavelet(&data, true);
+                if (vector_us == 0 || engine_us == 0) {
+                    ei_printf("%6u %5d %-8s  failed to run\n", (unsigned)data.length, data.level, data.filter->name);
+                    continue;
+                }
+
+                const float max_diff = filter_max_rel_diff(expected, features, n_features);
+                ei_printf("%6u %5d %-8s %9u %10llu %10llu %7.2fx %13.2e  %s\n", (unsigned)data.length, data.level,
+                    data.filter->name, (unsigned)n_features, (unsigned long long)vector_us,
+                    (unsigned long long)engine_us, (double)vector_us / (double)engine_us, (double)max_diff,
+                    max_diff < 1e-5f ? "ok" : "MISMATCH");
+            }
+        }
+    }
+}
+
+#define AUDIO_FREQUENCY         16000
+#define AUDIO_WINDOW_MS         1000
+#define AUDIO_SLICE_MS          250
+#define AUDIO_SECONDS           2
+
+// a keyword spotting style MFE and MFCC block, 1 s window classified every 250 ms
+static ei_dsp_config_mfe_t audio_mfe_config = {
+    0, 4, 1, NULL, 0, 0.02f, 0.01f, 40, 256, 0, 0, 101, -52
+};
+static ei_dsp_config_mfcc_t audio_mfcc_config = {
+    0, 4, 1, NULL, 0, 13, 0.02f, 0.01f, 32, 256, 101, 0, 0, 0.98f, 1
+};
+
+typedef struct {
+    const char *name;
+    ei_model_dsp_t block;
+    size_t n_features;
+} audio_bench_t;
+
+typedef struct {
+    const float *audio;
+    float *window;
+} audio_bench_data_t;
+
+static int audio_run(const audio_bench_t *bench, const audio_bench_data_t *data, bool streamed)
+{
+    const size_t slice_samples = AUDIO_FREQUENCY * AUDIO_SLICE_MS / 1000;
+    const size_t slices = (AUDIO_FREQUENCY * AUDIO_SECONDS) / slice_samples;
+
+    ei_dsp_clear_continuous_audio_state();
+
+    for (size_t ix = 0; ix < slices; ix++) {
+        ei::signal_t slice;
+        ei::numpy::signal_from_buffer(data->audio + ix * slice_samples, slice_samples, &slice);
+
+        ei::matrix_t window(1, bench->n_features, data->window);
+        matrix_size_t written;
+        int ret;
+        if (streamed) {
+            ret = extract_audio_stream_features(bench, &slice, &window, &bench->block, AUDIO_FREQUENCY, &written);
+        }
+        else if (bench->block.extract_fn == extract_mfcc_features) {
+            ret = extract_mfcc_per_slice_features(&slice, &window, bench->block.config, AUDIO_FREQUENCY, &written);
+        }
+        else {
+            ret = extract_mfe_per_slice_features(&slice, &window, bench->block.config, AUDIO_FREQUENCY, &written);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static uint64_t time_audio(const audio_bench_t *bench, const audio_bench_data_t *data, bool streamed)
+{
+    return bench_time_us([&]() { return audio_run(bench, data, streamed) == 0; });
+}
+
+/**
+ * Continuous MFE / MFCC, the per slice extraction vs the feature stream,
+ * in CPU time per second of audio
+ */
+static void benchmark_audio_stream()
+{
+    audio_bench_t benchmarks[2];
+    memset(benchmarks, 0, sizeof(benchmarks));
+
+    benchmarks[0].name = "MFE";
+    benchmarks[0].block.extract_fn = extract_mfe_features;
+    benchmarks[0].block.config = &audio_mfe_config;
+    matrix_size_t mfe_size = ei::speechpy::feature::calculate_mfe_buffer_size(
+        AUDIO_FREQUENCY * AUDIO_WINDOW_MS / 1000, AUDIO_FREQUENCY, audio_mfe_config.frame_length,
+        audio_mfe_config.frame_stride, audio_mfe_config.num_filters, audio_mfe_config.implementation_version);
+    benchmarks[0].n_features = mfe_size.rows * mfe_size.cols;
+
+    benchmarks[1].name = "MFCC";
+    benchmarks[1].block.extract_fn = extract_mfcc_features;
+    benchmarks[1].block.config = &audio_mfcc_config;
+    matrix_size_t mfcc_size = ei::speechpy::feature::calculate_mfcc_buffer_size(
+        AUDIO_FREQUENCY * AUDIO_WINDOW_MS / 1000, AUDIO_FREQUENCY, audio_mfcc_config.frame_length,
+        audio_mfcc_config.frame_stride, audio_mfcc_config.num_cepstral, audio_mfcc_config.implementation_version);
+    benchmarks[1].n_features = mfcc_size.rows * mfcc_size.cols;
+
+    const size_t audio_samples = AUDIO_FREQUENCY * AUDIO_SECONDS;
+    const size_t max_features = mfe_size.rows * mfe_size.cols > mfcc_size.rows * mfcc_size.cols ?
+        mfe_size.rows * mfe_size.cols : mfcc_size.rows * mfcc_size.cols;
+
+    bench_buffers buffers;
+    float *audio = buffers.alloc<float>(audio_samples);
+    float *window = buffers.alloc<float>(max_features);
+    float *expected = buffers.alloc<float>(max_features);
+    float *streamed = buffers.alloc<float>(max_features);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate audio buffers\n");
+        return;
+    }
+    for (size_t ix = 0; ix < audio_samples; ix++) {
+        audio[ix] = (float)rng_range(-32768, 32767);
+    }
+
+    audio_bench_data_t data = { audio, window };
+
+    ei_printf("Continuous audio benchmark, %d ms slices of a %d ms window at %d Hz\n",
+        AUDIO_SLICE_MS, AUDIO_WINDOW_MS, AUDIO_FREQUENCY);
+    ei_printf("block  features  slice_us/s_audio  stream_us/s_audio  speedup  max_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(benchmarks) / sizeof(benchmarks[0]); ix++) {
+        const audio_bench_t *bench = &benchmarks[ix];
+
+        memset(window, 0, bench->n_features * sizeof(float));
+        const uint64_t slice_us = time_audio(bench, &data, false);
+        memcpy(expected, window, bench->n_features * sizeof(float));
+
+        memset(window, 0, bench->n_features * sizeof(float));
+        const uint64_t stream_us = time_audio(bench, &data, true);
+        // the streamed window is a ring buffer
+        ei_dsp_copy_audio_stream_window(bench, bench->block.config, window, bench->n_features, streamed);
+        ei_dsp_clear_continuous_audio_state();
+
+        if (slice_us == 0 || stream_us == 0) {
+            ei_printf("%-5s  failed to run\n", bench->name);
+            continue;
+        }
+
+        float max_diff = 0.0f;
+        for (size_t fx = 0; fx < bench->n_features; fx++) {
+            const float diff = fabsf(expected[fx] - streamed[fx]);
+            max_diff = diff > max_diff ? diff : max_diff;
+        }
+
+        ei_printf("%-5s %9u %17llu %18llu %7.2fx %9.2e  %s\n", bench->name, (unsigned)bench->n_features,
+            (unsigned long long)(slice_us / AUDIO_SECONDS), (unsigned long long)(stream_us / AUDIO_SECONDS),
+            (double)slice_us / (double)stream_us, (double)max_diff, max_diff == 0.0f ? "ok" : "MISMATCH");
+    }
+}
+
+// an MFE (audio_mfe_config) and a spectrogram block over the 1 s window, int8 input
+static ei_dsp_config_spectrogram_t audio_spectrogram_config = {
+    0, 4, 1, NULL, 0, 0.02f, 0.01f, 256, -52, false
+};
+#define FIXED_POINT_SCALE       (1.0f / 256.0f)
+#define FIXED_POINT_ZERO_POINT  (-128)
+
+typedef struct {
+    const char *name;
+    ei_model_dsp_t block;
+    ei::speechpy::fixed_point_features_config_t fixed;
+    size_t n_features;
+} fixed_point_bench_t;
+
+typedef struct {
+    const float *audio;
+    const int16_t *audio_i16;
+    float *features;
+    int8_t *quantized;
+} fixed_point_bench_data_t;
+
+static int fixed_point_run(const fixed_point_bench_t *bench, const fixed_point_bench_data_t *data, bool fixed)
+{
+    const size_t samples = AUDIO_FREQUENCY * AUDIO_WINDOW_MS / 1000;
+    ei::matrix_i8_t quantized(1, bench->n_features, data->quantized);
+    if (fixed) {
+        return ei::speechpy::fixed_point_features(&bench->fixed, data->audio_i16, samples, &quantized,
+            FIXED_POINT_SCALE, FIXED_POINT_ZERO_POINT);
+    }
+
+    // float features, then quantized like the input tensor of the model
+    ei::signal_t signal;
+    ei::numpy::signal_from_buffer(data->audio, samples, &signal);
+    ei::matrix_t features(1, bench->n_features, data->features);
+    int ret = bench->block.extract_fn(&signal, &features, bench->block.config, AUDIO_FREQUENCY);
+    if (ret != 0) {
+        return ret;
+    }
+    for (size_t ix = 0; ix < bench->n_features; ix++) {
+        int32_t v = (int32_t)roundf(data->features[ix] / FIXED_POINT_SCALE) + FIXED_POINT_ZERO_POINT;
+        data->quantized[ix] = (int8_t)(v < -128 ? -128 : v > 127 ? 127 : v);
+    }
+    return 0;
+}
+
+static uint64_t time_fixed_point(const fixed_point_bench_t *bench, const fixed_point_bench_data_t *data, bool fixed)
+{
+    return bench_time_us([&]() { return fixed_point_run(bench, data, fixed) == 0; });
+}
+
+/**
+ * MFE / spectrogram of an int8 model: the float features quantized to the
+ * input vs the fixed point features (speechpy/feature_fixed.h), time per
+ * window and the features buffer in bytes
+ */
+static void benchmark_fixed_point_audio()
+{
+    const size_t samples = AUDIO_FREQUENCY * AUDIO_WINDOW_MS / 1000;
+    fixed_point_bench_t benchmarks[2];
+    memset(benchmarks, 0, sizeof(benchmarks));
+
+    benchmarks[0].name = "MFE";
+    benchmarks[0].block.extract_fn = extract_mfe_features;
+    benchmarks[0].block.config = &audio_mfe_config;
+    benchmarks[0].fixed.type = ei::speechpy::FIXED_POINT_MFE;
+    benchmarks[0].fixed.fft_length = audio_mfe_config.fft_length;
+    benchmarks[0].fixed.num_filters = audio_mfe_config.num_filters;
+    benchmarks[0].fixed.low_frequency = audio_mfe_config.low_frequency;
+    benchmarks[0].fixed.high_frequency = audio_mfe_config.high_frequency;
+    benchmarks[0].fixed.frame_length = audio_mfe_config.frame_length;
+    benchmarks[0].fixed.frame_stride = audio_mfe_config.frame_stride;
+    benchmarks[0].fixed.noise_floor_db = audio_mfe_config.noise_floor_db;
+    benchmarks[0].fixed.version = audio_mfe_config.implementation_version;
+    matrix_size_t mfe_size = ei::speechpy::feature::calculate_mfe_buffer_size(samples, AUDIO_FREQUENCY,
+        audio_mfe_config.frame_length, audio_mfe_config.frame_stride, audio_mfe_config.num_filters,
+        audio_mfe_config.implementation_version);
+    benchmarks[0].n_features = mfe_size.rows * mfe_size.cols;
+
+    benchmarks[1].name = "Spect";
+    benchmarks[1].block.extract_fn = extract_spectrogram_features;
+    benchmarks[1].block.config = &audio_spectrogram_config;
+    benchmarks[1].fixed.type = ei::speechpy::FIXED_POINT_SPECTROGRAM;
+    benchmarks[1].fixed.fft_length = audio_spectrogram_config.fft_length;
+    benchmarks[1].fixed.frame_length = audio_spectrogram_config.frame_length;
+    benchmarks[1].fixed.frame_stride = audio_spectrogram_config.frame_stride;
+    benchmarks[1].fixed.noise_floor_db = audio_spectrogram_config.noise_floor_db;
+    benchmarks[1].fixed.version = audio_spectrogram_config.implementation_version;
+    matrix_size_t spectrogram_size = ei::speechpy::feature::calculate_mfe_buffer_size(samples, AUDIO_FREQUENCY,
+        audio_spectrogram_config.frame_length, audio_spectrogram_config.frame_stride,
+        audio_spectrogram_config.fft_length / 2 + 1, audio_spectrogram_config.implementation_version);
+    benchmarks[1].n_features = spectrogram_size.rows * spectrogram_size.cols;
+
+    const size_t max_features = benchmarks[0].n_features > benchmarks[1].n_features ?
+        benchmarks[0].n_features : benchmarks[1].n_features;
+
+    bench_buffers buffers;
+    float *audio = buffers.alloc<float>(samples);
+    int16_t *audio_i16 = buffers.alloc<int16_t>(samples);
+    float *features = buffers.alloc<float>(max_features);
+    int8_t *expected = buffers.alloc<int8_t>(max_features);
+    int8_t *quantized = buffers.alloc<int8_t>(max_features);
+    if (!buffers.ok()) {
+        ei_printf("ERR: Failed to allocate fixed point audio buffers\n");
+        return;
+    }
+    // noise from full scale down to a few LSB, in 1000 sample steps
+    for (size_t ix = 0; ix < samples; ix++) {
+        const int32_t amplitude = 32767 >> ((ix / 1000) % 14);
+        audio_i16[ix] = (int16_t)rng_range(-amplitude, amplitude);
+        audio[ix] = (float)audio_i16[ix];
+    }
+
+    fixed_point_bench_data_t data = { audio, audio_i16, features, NULL };
+
+    ei_printf("Fixed point audio features benchmark, %d ms window at %d Hz, int8 input\n",
+        AUDIO_WINDOW_MS, AUDIO_FREQUENCY);
+    ei_printf("block  features  float_us  fixed_us  speedup  float_bytes int8_bytes scratch_bytes outputs_diff  check\n");
+
+    for (size_t ix = 0; ix < sizeof(benchmarks) / sizeof(benchmarks[0]); ix++) {
+        fixed_point_bench_t *bench = &benchmarks[ix];
+        bench->fixed.sampling_frequency = AUDIO_FREQUENCY;
+
+        data.quantized = expected;
+        const uint64_t float_us = time_fixed_point(bench, &data, false);
+        data.quantized = quantized;
+        const uint64_t fixed_us = time_fixed_point(bench, &data, true);
+        if (float_us == 0 || fixed_us == 0) {
+            ei_printf("%-5s  failed to run\n", bench->name);
+            continue;
+        }
+
+        uint32_t diff = 0;
+        int max_steps = 0;
+        for (size_t fx = 0; fx < bench->n_features; fx++) {
+            const int steps = abs((int)expected[fx] - (int)quantized[fx]);
+            diff += steps != 0;
+            max_steps = steps > max_steps ? steps : max_steps;
+        }
+
+        ei_printf("%-5s %9u %9llu %9llu %7.2fx %12u %10u %13u %12u  %s\n", bench->name, (unsigned)bench->n_features,
+            (unsigned long long)float_us, (unsigned long long)fixed_us, (double)float_us / (double)fixed_us,
+            (unsigned)(bench->n_features * sizeof(float)), (unsigned)bench->n_features,
+            (unsigned)ei::speechpy::fixed_point_features_scratch_bytes(&bench->fixed), (unsigned)diff,
+            max_steps <= 1 ? "ok" : "MISMATCH");
+    }
+}
+
+#if EI_CLASSIFIER_TRACE == 1
+#define TRACE_PAIRS             10000
+
+static void trace_count_bytes(const void *, size_t len, void *ctx)
+{
+    *(size_t *)ctx += len;
+}
+
+static uint64_t time_trace_pairs(bool enabled)
+{
+    ei_trace_enable(enabled);
+    uint64_t start = ei_read_timer_us();
+    for (int ix = 0; ix < TRACE_PAIRS; ix++) {
+        EI_TRACE_SCOPE("bench", (int16_t)(ix & 0x7fff));
+    }
+    uint64_t us = ei_read_timer_us() - start;
+    ei_trace_enable(false);
+    return us;
+}
+
+/**
+ * Cost of a begin / end event pair with the trace disabled at runtime and
+ * enabled, and of exporting a full ring
+ */
+static void benchmark_trace()
+{
+    const bool was_enabled = ei_trace_enabled;
+    ei_trace_clear();
+
+    const uint64_t disabled_us = time_trace_pairs(false);
+    const uint64_t enabled_us = time_trace_pairs(true);
+
+    uint32_t recorded, dropped;
+    ei_trace_stats(&recorded, &dropped);
+
+    size_t json_bytes = 0;
+    uint64_t start = ei_read_timer_us();
+    size_t events = ei_trace_export_chrome_json(&trace_count_bytes, &json_bytes);
+    const uint64_t json_us = ei_read_timer_us() - start;
+
+    size_t binary_bytes = 0;
+    start = ei_read_timer_us();
+    ei_trace_export_binary(&trace_count_bytes, &binary_bytes);
+    const uint64_t binary_us = ei_read_timer_us() - start;
+
+    ei_printf("Trace benchmark, %d begin/end pairs, ring of %d events\n", TRACE_PAIRS, EI_TRACE_RING_EVENTS);
+    ei_printf("disabled  %8.1f ns/pair\n", (double)disabled_us * 1000.0 / TRACE_PAIRS);
+    ei_printf("enabled   %8.1f ns/pair (%u recorded, %u overwritten)\n",
+        (double)enabled_us * 1000.0 / TRACE_PAIRS, (unsigned)recorded, (unsigned)dropped);
+    ei_printf("export    %u events: json %u bytes in %llu us, binary %u bytes in %llu us\n",
+        (unsigned)events, (unsigned)json_bytes, (unsigned long long)json_us,
+        (unsigned)binary_bytes, (unsigned long long)binary_us);
+
+    ei_trace_clear();
+    ei_trace_enable(was_enabled);
+}
+#endif // EI_CLASSIFIER_TRACE == 1
+
+void app_benchmark_main()
+{
+    uint64_t total_us[VARIANT_COUNT] = { 0 };
+    uint32_t mismatches[VARIANT_COUNT] = { 0 };
+    bool complete[VARIANT_COUNT];
+    for (size_t v = 0; v < VARIANT_COUNT; v++) {
+        complete[v] = true;
+    }
+
+    ei_printf("Kernel benchmark, %u layers of tflite_learn_66\n",
+        (unsigned)(sizeof(model_layers) / sizeof(model_layers[0])));
+    ei_printf("node op                shape           variant         time_us   GOP/s    MB/s  check\n");
+
+    for (size_t ix = 0; ix < sizeof(model_layers) / sizeof(model_layers[0]); ix++) {
+        const bench_layer_t *l = &model_layers[ix];
+
+        bench_buffers buffers;
+        bench_data_t data;
+        int8_t *expected = buffers.alloc<int8_t>(output_size(l));
+        int8_t *output = buffers.alloc<int8_t>(output_size(l));
+        if (!bench_data_init(l, &data) || !buffers.ok()) {
+            ei_printf("ERR: Failed to allocate buffers for node %d\n", l->node);
+            bench_data_free(&data);
+            return;
+        }
+
+        const uint64_t macs = layer_macs(l);
+        const uint64_t bytes = input_size(l) * (l->op == BENCH_ADD ? 2 : 1) + filter_size(l) +
+            output_size(l);
+
+        for (size_t v = 0; v < VARIANT_COUNT; v++) {
+            int8_t *out = v == 0 ? expected : output;
+            memset(out, 0, output_size(l));
+
+            const uint64_t us = time_variant(&variants[v], &data, out);
+#if defined(ESP_NN)
+            ei_free(esp_nn_scratch);
+            esp_nn_scratch = NULL;
+#endif
+            if (us == 0) {
+                complete[v] = false;
+                continue;
+            }
+
+            uint32_t diff = 0;
+            if (v > 0) {
+                for (size_t o = 0; o < output_size(l); o++) {
+                    diff += out[o] != expected[o];
+                }
+                mismatches[v] += diff;
+            }
+            total_us[v] += us;
+
+            ei_printf("%4d %-17s %3dx%3dx%-3d->%-3d %-13s %9llu %7.3f %7.1f  %s",
+                l->node, op_name(l->op), l->in_h, l->in_w, l->in_c, l->out_c,
+                variants[v].name, (unsigned long long)us,
+                (double)(2 * macs) / ((double)us * 1000.0), (double)bytes / (double)us,
+                v == 0 ? "ref" : diff == 0 ? "ok" : "MISMATCH");
+            if (diff > 0) {
+                ei_printf(" (%u bytes)", (unsigned)diff);
+            }
+            ei_printf("\n");
+        }
+
+        bench_data_free(&data);
+    }
+
+    ei_printf("Totals:\n");
+    for (size_t v = 0; v < VARIANT_COUNT; v++) {
+        ei_printf("  %-13s %9llu us%s, %u mismatching bytes\n", variants[v].name,
+            (unsigned long long)total_us[v], complete[v] ? "" : " (not all layers supported)",
+            (unsigned)mismatches[v]);
+    }
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_HOST_SIMD == 1
+    benchmark_host_simd_harness();
+    benchmark_host_simd_model();
+#endif
+
+    benchmark_image();
+    benchmark_anomaly();
+    benchmark_fft();
+    benchmark_filterbank();
+    benchmark_filters();
+    benchmark_spectral();
+    benchmark_wavelet();
+    benchmark_audio_stream();
+    benchmark_fixed_point_audio();
+#if EI_CLASSIFIER_TRACE == 1
+    benchmark_trace();
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef _APP_BENCHMARK_H_
+#define _APP_BENCHMARK_H_
+
+/**
+ * Kernel micro-benchmark over the CONV_2D, DEPTHWISE_CONV_2D and ADD layers
+ * of the deployed model (tflite_learn_66), with randomized quantized data.
+ *
+ * Every kernel variant available on the current platform (TFLM reference,
+ * host SIMD, ESP-NN ansi / generic optimized / chip specific) runs each
+ * layer; the time, GOP/s, MB/s and a byte-for-byte check against the
+ * reference kernel are printed. With the host SIMD kernels, every instruction
+ * set the CPU supports is also checked against the reference kernels on
+ * randomized layer geometries, and the whole EON compiled model is timed
+ * (frames/s) with each of them. The image preprocessing (crop, resize,
+ * YUV422/RGB565 conversion, and the row streamed RGB565 crop + resize) is
+ * timed the same way on the 240x176 camera frame to 160x160 model input
+ * geometry. K-means anomaly scoring is swept over feature dimensions and
+ * cluster counts, the real FFT over n_fft 128..4096, the sparse mel
+ * filterbank against the dense one for 40/64 filters, and the IIR filter
+ * bank against per axis filtering (samples/s per channel), the wavelet
+ * spectral analysis over window lengths and levels against the per level
+ * vector implementation it replaced. Continuous MFE and
+ * MFCC (per slice extraction vs the feature stream) are reported in CPU time
+ * per second of audio, and the float MFE / spectrogram quantized to an int8
+ * input against the fixed point features per window. With EI_CLASSIFIER_TRACE the cost of a trace event pair
+ * (disabled and enabled) and of the trace export is printed too. Only uses the
+ * SDK porting layer, so the same file also builds and runs on a host.
+ */
+
+void app_benchmark_main();
+
+#endif
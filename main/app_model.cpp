@@ -1,4 +1,5 @@
 #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
 #include "esp_camera.h"
 #include "esp_err.h"
 #include "esp_log.h"
@@ -58,25 +59,85 @@ static uint32_t inference_delay;
 
 static float confidence_level = 0.5;
 
-static int ei_camera_get_data(size_t offset, size_t length, float *out_ptr)
+#if CONFIG_EI_TRACE
+static uint32_t traced_inferences = 0;
+
+typedef struct {
+    uint8_t *buffer;
+    size_t len;
+    size_t size;
+} trace_dump_t;
+
+static void trace_dump_write(const void *data, size_t len, void *ctx)
 {
-    // we already have a RGB888 buffer, so recalculate offset into pixel index
-    size_t pixel_ix = offset * 3;
-    size_t pixels_left = length;
-    size_t out_ptr_ix = 0;
-
-    while (pixels_left != 0) {
-        out_ptr[out_ptr_ix] = (snapshot_buf[pixel_ix] << 16) + (snapshot_buf[pixel_ix + 1] << 8) + snapshot_buf[pixel_ix + 2];
-
-        // go to the next pixel
-        out_ptr_ix++;
-        pixel_ix+=3;
-        pixels_left--;
+    trace_dump_t *dump = (trace_dump_t*)ctx;
+    if (dump->buffer == nullptr) {
+        return;
+    }
+    if (dump->len + len > dump->size) {
+        size_t size = dump->size * 2 > dump->len + len ? dump->size * 2 : dump->len + len;
+        uint8_t *buffer = (uint8_t*)realloc(dump->buffer, size);
+        if (buffer == nullptr) {
+            free(dump->buffer);
+            dump->buffer = nullptr;
+            return;
+        }
+        dump->buffer = buffer;
+        dump->size = size;
+    }
+    memcpy(dump->buffer + dump->len, data, len);
+    dump->len += len;
+}
+
+/**
+ * Export the recorded events in the binary trace format and publish them
+ * over MQTT, or print them base64 encoded between EI_TRACE_BEGIN / EI_TRACE_END
+ * markers (decode with trace_to_chrome.py), then start a new trace.
+ */
+static void dump_trace()
+{
+    trace_dump_t dump = { (uint8_t*)malloc(4096), 0, 4096 };
+    uint32_t recorded, dropped;
+    ei_trace_stats(&recorded, &dropped);
+
+    ei_trace_enable(false);
+    size_t events = ei_trace_export_binary(&trace_dump_write, &dump);
+    ei_trace_clear();
+    ei_trace_enable(true);
+
+    if (dump.buffer == nullptr) {
+        ei_printf("ERR: Failed to allocate trace buffer\n");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Trace: %u events (%u dropped), %u bytes",
+        (unsigned)events, (unsigned)dropped, (unsigned)dump.len);
+
+#if CONFIG_EI_TRACE_MQTT
+    if (is_mqtt_connected() && publish_trace(dump.buffer, dump.len) == ESP_OK) {
+        free(dump.buffer);
+        return;
     }
+#endif
 
-    // and done!
-    return 0;
+    size_t base64_size = 4 * ((dump.len + 2) / 3) + 1;
+    char *base64 = (char*)malloc(base64_size);
+    int base64_len = base64 ? base64_encode_buffer((const char*)dump.buffer, dump.len, base64, base64_size) : -1;
+    if (base64_len < 0) {
+        ei_printf("ERR: Failed to encode trace as base64 (%d)\n", base64_len);
+    }
+    else {
+        ei_printf("EI_TRACE_BEGIN\n");
+        for (int ix = 0; ix < base64_len; ix += 76) {
+            int line_len = base64_len - ix < 76 ? base64_len - ix : 76;
+            ei_printf("%.*s\n", line_len, base64 + ix);
+        }
+        ei_printf("EI_TRACE_END\n");
+    }
+    free(base64);
+    free(dump.buffer);
 }
+#endif // CONFIG_EI_TRACE
 
 void init_model() {
     ESPCamModel* cam = ESPCamModel::get_camera();
@@ -96,11 +157,19 @@ void init_model() {
     ESP_LOGI(TAG, "Frame size: %d", EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
     ESP_LOGI(TAG, "No. of classes: %d", sizeof(ei_classifier_inferencing_categories) / sizeof(ei_classifier_inferencing_categories[0]));
 
+    // keep the model arena between frames, a steady-state inference does not touch the heap
+    inference_tflite_keep_alive(true);
+
     inference_delay = 50;
     last_inference_ts = ei_read_timer_ms();
     state = INFERENCE_WAITING;
     ei_printf("Starting inferencing in %d seconds...\n", inference_delay / 1000);
 
+#if CONFIG_EI_TRACE
+    ei_trace_set_thread_name("model");
+    ei_trace_enable(true);
+#endif
+
     while(true) {
         run_model();
         vTaskDelay( 10 / portTICK_PERIOD_MS );
@@ -139,11 +208,14 @@ esp_err_t run_model() {
 
     ei_printf("Taking photo...\n");
 
+    EI_TRACE_SCOPE_VAR(capture_trace, "capture", -1);
     if(camera->camera_capture_jpeg(&jpeg_img, &jpeg_img_size, nullptr) == false) {
         ei_printf("ERR: Failed to take a snapshot!\n");
         return ESP_FAIL;
     }
 
+    EI_TRACE_SCOPE_END(capture_trace);
+
     snapshot_buf = (uint8_t*)ei_malloc(snapshot_buf_size);
 
     // check if allocation was successful
@@ -153,6 +225,7 @@ esp_err_t run_model() {
     }
 
     // no need to do anything here
+    EI_TRACE_SCOPE_VAR(decode_trace, "decode", -1);
     if(camera->to_rgb888(jpeg_img, jpeg_img_size, PIXFORMAT_JPEG, snapshot_buf) == false) {
         ei_printf("ERR: Failed to decode image\n");
         ei_free(snapshot_buf);
@@ -161,10 +234,12 @@ esp_err_t run_model() {
     }
     ei_free(jpeg_img);
     jpeg_img_size = 0;
+    EI_TRACE_SCOPE_END(decode_trace);
 
     int64_t fr_start = esp_timer_get_time();
 
     // resize
+    EI_TRACE_SCOPE_VAR(resize_trace, "resize", -1);
     ei::image::processing::crop_and_interpolate_rgb888(
         snapshot_buf,
         fb_resolution.width,
@@ -174,12 +249,14 @@ esp_err_t run_model() {
         snapshot_resolution.height);
 
     int64_t fr_end = esp_timer_get_time();
+    EI_TRACE_SCOPE_END(resize_trace);
 
     if (debug_mode) {
         ei_printf("Time resizing: %d\n", (uint32_t)((fr_end - fr_start)/1000));
     }
 
     // encode as base64
+    EI_TRACE_SCOPE_VAR(encode_trace, "encode", -1);
 
     // configure encoder
     jpeg_enc_config_t jpeg_enc_cfg = DEFAULT_JPEG_ENC_CONFIG();
@@ -236,15 +313,30 @@ esp_err_t run_model() {
         free(outbuf);
     }
     out_len = 0;
+    EI_TRACE_SCOPE_END(encode_trace);
 
+    // the image block reads the RGB888 snapshot in place
     ei::signal_t signal;
-    signal.total_length = EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT;
-    signal.get_data = &ei_camera_get_data;
+    ei::signal_from_rgb888(snapshot_buf, EI_CLASSIFIER_INPUT_WIDTH * EI_CLASSIFIER_INPUT_HEIGHT, &signal);
 
     // run the impulse: DSP, neural network and the Anomaly algorithm
     ei_impulse_result_t result = { 0 };
 
+#if EI_PORTING_HEAP_STATS == 1
+    const uint32_t heap_calls_start = ei_heap_calls();
+#endif
     EI_IMPULSE_ERROR ei_error = run_classifier(&signal, &result, false);
+#if EI_PORTING_HEAP_STATS == 1
+    // the first inference sizes the workspace and the arenas, after that it must be 0
+    static uint32_t heap_check_runs = 0;
+    const uint32_t heap_calls = ei_heap_calls() - heap_calls_start;
+    if (heap_check_runs++ > 0 && heap_calls > 0) {
+        ei_printf("WARN: run_classifier() made %u heap calls\n", (unsigned)heap_calls);
+    }
+    else if (debug_mode) {
+        ei_printf("run_classifier() heap calls: %u\n", (unsigned)heap_calls);
+    }
+#endif
     if (ei_error != EI_IMPULSE_OK) {
         ei_printf("ERR: Failed to run impulse (%d)\n", ei_error);
         ei_free(snapshot_buf);
@@ -282,6 +374,7 @@ esp_err_t run_model() {
     msg.bbox_len = result.bounding_boxes_count;
 
     if(is_mqtt_connected()) {
+        EI_TRACE_SCOPE("publish", -1);
         publish_message(msg);
     }
     if(base64_img_out != nullptr) {
@@ -301,6 +394,13 @@ esp_err_t run_model() {
     last_inference_ts = ei_read_timer_ms();
     state = INFERENCE_WAITING;
 
+#if CONFIG_EI_TRACE
+    if (++traced_inferences >= CONFIG_EI_TRACE_DUMP_INTERVAL) {
+        traced_inferences = 0;
+        dump_trace();
+    }
+#endif
+
     if(continuous_mode == false) {
         ei_printf("Starting inferencing in %d seconds...\n", inference_delay / 1000);
     }
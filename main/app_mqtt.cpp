@@ -17,6 +17,7 @@ static const char *TAG = "AIoT: AutoEye";
 static const char *MQTT_BROKER_URI = "mqtt://10.124.3.160";
 static const int MQTT_BROKER_PORT = 1883;
 static const char *MQTT_TOPIC = "aiot/data";
+static const char *MQTT_TRACE_TOPIC = "aiot/trace";
 static const char *MQTT_USERNAME = "aiot";
 static const char *MQTT_PASSWORD = "aiot";
 static bool mqtt_connected = false;
@@ -152,6 +153,18 @@ esp_err_t publish_message(const MQTTMessage &msg) {
     return ESP_OK;
 }
 
+esp_err_t publish_trace(const uint8_t *data, size_t len) {
+    if(!mqtt_connected) {
+        return ESP_FAIL;
+    }
+    int msg_id = esp_mqtt_client_publish(client, MQTT_TRACE_TOPIC, (const char*)data, len, 0, 0);
+    if(msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish trace (%d bytes)", (int)len);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 void app_mqtt_main() {
 
     // Set timezone to China Standard Time
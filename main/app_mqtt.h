@@ -18,6 +18,7 @@ struct MQTTMessage {
 
 void app_mqtt_main();
 esp_err_t publish_message(const MQTTMessage &msg);
+esp_err_t publish_trace(const uint8_t *data, size_t len);
 bool is_mqtt_connected();
 
 #endif
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "app_mqtt.h"
 #include "app_model.h"
 #include "app_ota.h"
+#include "app_benchmark.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -27,5 +28,8 @@ extern "C" void app_main(void) {
     app_wifi_main();
     app_mqtt_main();
     // check_for_update();
+#if CONFIG_EI_KERNEL_BENCHMARK
+    app_benchmark_main();
+#endif
     init_model();
 }
\ No newline at end of file
@@ -36,6 +36,7 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_trace.h"
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -127,6 +128,13 @@ enum used_operators_e {
   OP_CONV_2D, OP_DEPTHWISE_CONV_2D, OP_PAD, OP_ADD, OP_SOFTMAX,  OP_LAST
 };
 
+#if EI_CLASSIFIER_TRACE == 1
+// trace event names, in used_operators_e order
+static const char *used_op_names[OP_LAST] = {
+  "CONV_2D", "DEPTHWISE_CONV_2D", "PAD", "ADD", "SOFTMAX",
+};
+#endif
+
 struct TensorInfo_t { // subset of TfLiteTensor used for initialization from constant memory
   TfLiteAllocationType allocation_type;
   TfLiteType type;
@@ -1542,7 +1550,9 @@ TfLiteStatus tflite_learn_66_invoke() {
   for (size_t i = 0; i < 27; ++i) {
     ResetTensors();
 
+    EI_TRACE_BEGIN(used_op_names[used_ops[i]], (int16_t)i);
     TfLiteStatus status = registrations[used_ops[i]].invoke(&ctx, &tflNodes[i]);
+    EI_TRACE_END(used_op_names[used_ops[i]], (int16_t)i);
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -0,0 +1,103 @@
+import sys
+import json
+import base64
+import struct
+
+# Converts a trace dumped by the firmware (CONFIG_EI_TRACE) to Chrome trace JSON,
+# open the result in chrome://tracing or https://ui.perfetto.dev
+#
+# Input is either a serial console log (the base64 dump between the EI_TRACE_BEGIN
+# and EI_TRACE_END lines, every dump in the log is converted) or a raw binary
+# payload as published on the aiot/trace MQTT topic.
+#
+#   python3 trace_to_chrome.py console.log trace.json
+
+
+def read_dumps(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data.startswith(b'EITR'):
+        return [data]
+
+    dumps = []
+    lines = None
+    for line in data.decode('utf-8', errors='ignore').splitlines():
+        line = line.strip()
+        if line.endswith('EI_TRACE_BEGIN'):
+            lines = []
+        elif line.endswith('EI_TRACE_END') and lines is not None:
+            dumps.append(base64.b64decode(''.join(lines)))
+            lines = None
+        elif lines is not None:
+            lines.append(line)
+    return dumps
+
+
+def decode(dump, pid):
+    if dump[0:4] != b'EITR' or dump[4] != 1:
+        raise ValueError('not a version 1 trace dump')
+
+    threads = dump[5]
+    name_count = struct.unpack_from('<H', dump, 6)[0]
+    offset = 8
+
+    names = []
+    for _ in range(name_count):
+        length = dump[offset]
+        names.append(dump[offset + 1:offset + 1 + length].decode('utf-8'))
+        offset += 1 + length
+
+    events = []
+    for _ in range(threads):
+        tid, thread_name, count = struct.unpack_from('<BBI', dump, offset)
+        offset += 6
+        if thread_name != 0xff:
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': tid,
+                           'args': {'name': names[thread_name]}})
+
+        # the device timer is 32 bits, unwrap it per thread
+        high = 0
+        prev = None
+        for _ in range(count):
+            ts, name, arg, phase = struct.unpack_from('<IHhB', dump, offset)
+            offset += 9
+            if phase == 0:
+                # overwritten while the device exported the trace
+                continue
+            if prev is not None and ts < prev:
+                high += 1 << 32
+            prev = ts
+
+            event = {
+                'name': names[name] if name < len(names) else '?',
+                'ph': chr(phase),
+                'ts': high + ts,
+                'pid': pid,
+                'tid': tid,
+            }
+            if arg >= 0:
+                event['args'] = {'ix': arg}
+            events.append(event)
+    return events
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('Usage: python3 trace_to_chrome.py <console log or binary dump> <output.json>')
+        sys.exit(1)
+
+    dumps = read_dumps(sys.argv[1])
+    if len(dumps) == 0:
+        print('No trace found in', sys.argv[1])
+        sys.exit(1)
+
+    trace_events = []
+    for ix, dump in enumerate(dumps):
+        # one process per dump, so the dumps don't overlap in the viewer
+        trace_events.extend(decode(dump, ix + 1))
+
+    with open(sys.argv[2], 'w') as f:
+        json.dump({'displayTimeUnit': 'ms', 'traceEvents': trace_events}, f)
+
+    print('Wrote', len(trace_events), 'events from', len(dumps), 'dump(s) to', sys.argv[2])